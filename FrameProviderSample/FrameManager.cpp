@@ -13,14 +13,19 @@
 
 namespace MediaFoundationProvider {
 
+// Time a removed device's provider is kept alive waiting for the device to return, in 100 nanosecond units
+// USB glitches and selective suspend typically bring the same device back within a couple of seconds
+static const INT64 ProviderGracePeriod = 5 * 10000000LL;
+
 SampleFrameProviderManager::SampleFrameProviderManager() :
     _providerMap(ref new Platform::Collections::Map<Platform::String^, WDPP::IPerceptionFrameProvider^>(std::less<Platform::String^>())),
-    _controlGroup(nullptr),
-    _faceAuthGroup(nullptr),
     _deviceWatcher(nullptr),
+    _executor(std::make_shared<WorkStealingExecutor>()),
     _destructorCalled(false)
 
 {
+    // The executor's workers are started as devices arrive, see ProvisionExecutorWorkers
+
     // Create a DeviceWatcher to enumerate and select the target video device and also signal when changes to this device occur
     // A different query method is used for DEBUG and RELEASE build configurations
 
@@ -97,11 +102,13 @@ SampleFrameProviderManager::~SampleFrameProviderManager()
         _deviceWatcher = nullptr;
     }
 
-    ReleaseProvider();
+    ReleaseAllProviders();
 }
 
 WDPP::IPerceptionFrameProvider^ SampleFrameProviderManager::GetFrameProvider(WDPP::PerceptionFrameProviderInfo^ providerInfo)
 {
+    auto lock = _connectionLocker.Lock();
+
     if (providerInfo != nullptr && _providerMap->HasKey(providerInfo->Id))
     {
         return _providerMap->Lookup(providerInfo->Id);
@@ -124,17 +131,59 @@ void SampleFrameProviderManager::DeviceRemovedEventHandler(WDE::DeviceWatcher^ s
 {
     auto lock = _destructionLocker.Lock();
 
-    ReleaseProvider();
+    // Only the removed device is affected, providers of other devices keep streaming
+    // The removal may be brief, so the provider is parked rather than released right away
+    if (!_destructorCalled)
+    {
+        ParkProvider(args->Id);
+    }
 }
 
 void SampleFrameProviderManager::CreateProvider(Platform::String^ targetDeviceId)
 {
     auto lock = _connectionLocker.Lock();
 
+    const std::wstring deviceKey(targetDeviceId->Data());
+
+    // If the device returns while its provider is parked, rebind the provider to it and resume streaming
+    // The DeviceWatcher may also report a device that is already connected; keep the existing provider in that case
+    auto existingRegistration = _registrations.find(deviceKey);
+    if (existingRegistration != _registrations.end())
+    {
+        ProviderRegistration& registration = existingRegistration->second;
+        if (registration.GraceTimer == nullptr)
+        {
+            return;
+        }
+
+        registration.GraceTimer->Cancel();
+        registration.GraceTimer = nullptr;
+
+        if (registration.Provider->Resume(targetDeviceId))
+        {
+            return;
+        }
+
+        // The device couldn't be reopened as before, start over with a new provider
+        ReleaseProvider(targetDeviceId);
+    }
+
+    // Each device gets its own registration, so several sensors can be hosted side by side
+    // The registration is filled in as the objects are registered, allowing ReleaseProvider to undo a partial registration
+    const UINT32 workerSlot = AcquireWorkerSlot();
+    ProviderRegistration& registration = _registrations[deviceKey];
+    registration.WorkerSlot = workerSlot;
+
+    ProvisionExecutorWorkers();
+
     try
     {
         // Initialize our IFrameProvider object and add it to the Manager's internal map
-        SampleFrameProvider^ provider = ref new SampleFrameProvider(targetDeviceId);
+        // Every provider owns its capture pipeline; spread their frame reading work items across processors
+        SampleFrameProvider^ provider = ref new SampleFrameProvider(targetDeviceId, _executor);
+        provider->SetWorkerAffinity(registration.WorkerSlot);
+
+        registration.Provider = provider;
         _providerMap->Insert(provider->FrameProviderInfo->Id, provider);
         
         // Register our Provider object with the service
@@ -143,11 +192,11 @@ void SampleFrameProviderManager::CreateProvider(Platform::String^ targetDeviceId
         // Initialize a ControlGroup object which allows the clients to set/change properties on the Provider
         auto controllerModeIds = ref new Platform::Collections::Vector<Platform::String^>();
         controllerModeIds->Append(provider->FrameProviderInfo->Id);
-        _controlGroup = ref new WDPP::PerceptionControlGroup(controllerModeIds->GetView());
-        WDPP::PerceptionFrameProviderManagerService::RegisterControlGroup(this, _controlGroup);
+        registration.ControlGroup = ref new WDPP::PerceptionControlGroup(controllerModeIds->GetView());
+        WDPP::PerceptionFrameProviderManagerService::RegisterControlGroup(this, registration.ControlGroup);
 
         // Perform the steps necessary to register our Provider for FaceAuthentication
-        // Create a list of all Providers that can support FaceAuthentication; only a single Provider in this implementation
+        // Create a list of all Providers that can support FaceAuthentication; each device has its own group
         auto faceAuthProviderIds = ref new Platform::Collections::Vector<Platform::String^>();
         faceAuthProviderIds->Append(provider->FrameProviderInfo->Id);
 
@@ -161,25 +210,101 @@ void SampleFrameProviderManager::CreateProvider(Platform::String^ targetDeviceId
             &SampleFrameProviderManager::StopFaceAuthentication);
 
         // Create a FaceAuthentication group containing our Providers list and event handlers
-        _faceAuthGroup = ref new WDPP::PerceptionFaceAuthenticationGroup(
+        registration.FaceAuthGroup = ref new WDPP::PerceptionFaceAuthenticationGroup(
             faceAuthProviderIds->GetView(),
             startFaceAuthHandler,
             stopFaceAuthHandler);
 
         // Finally register our FaceAuthentication group with the service
-        WDPP::PerceptionFrameProviderManagerService::RegisterFaceAuthenticationGroup(this, _faceAuthGroup);
+        WDPP::PerceptionFrameProviderManagerService::RegisterFaceAuthenticationGroup(this, registration.FaceAuthGroup);
     }
     catch (Platform::Exception^ ex)
     {
-        // Clean up Provider and Group objects if something goes wrong
-        ReleaseProvider();
+        // Clean up Provider and Group objects of this device if something goes wrong
+        ReleaseProvider(targetDeviceId);
     }
 }
 
-void SampleFrameProviderManager::ReleaseProvider()
+void SampleFrameProviderManager::ReleaseProvider(Platform::String^ targetDeviceId)
 {
     auto lock = _connectionLocker.Lock();
 
+    auto registration = _registrations.find(std::wstring(targetDeviceId->Data()));
+    if (registration != _registrations.end())
+    {
+        UnregisterProvider(registration->second);
+        _registrations.erase(registration);
+    }
+}
+
+void SampleFrameProviderManager::ParkProvider(Platform::String^ targetDeviceId)
+{
+    auto lock = _connectionLocker.Lock();
+
+    auto existingRegistration = _registrations.find(std::wstring(targetDeviceId->Data()));
+    if (existingRegistration == _registrations.end() || existingRegistration->second.GraceTimer != nullptr)
+    {
+        return;
+    }
+
+    // The provider stays registered with the service, reported as unavailable, and keeps its pipeline resources
+    ProviderRegistration& registration = existingRegistration->second;
+    registration.Provider->Suspend();
+
+    // Release the provider for good if the device doesn't return within the grace period
+    // NOTE: The timer only holds a weak reference, the manager may be destroyed before it fires
+    Platform::WeakReference weakThis(this);
+    Windows::Foundation::TimeSpan gracePeriod = { ProviderGracePeriod };
+
+    registration.GraceTimer = WST::ThreadPoolTimer::CreateTimer(
+        ref new WST::TimerElapsedHandler([weakThis, targetDeviceId](WST::ThreadPoolTimer^ timer)
+    {
+        SampleFrameProviderManager^ manager = weakThis.Resolve<SampleFrameProviderManager>();
+        if (manager != nullptr)
+        {
+            manager->ReleaseParkedProvider(targetDeviceId, timer);
+        }
+    }), gracePeriod);
+}
+
+void SampleFrameProviderManager::ReleaseParkedProvider(Platform::String^ targetDeviceId, WST::ThreadPoolTimer^ graceTimer)
+{
+    auto destructionLock = _destructionLocker.Lock();
+
+    if (_destructorCalled) return;
+
+    auto lock = _connectionLocker.Lock();
+
+    // Only release the provider if it's still parked by this timer, the device may have returned in the meantime
+    auto existingRegistration = _registrations.find(std::wstring(targetDeviceId->Data()));
+    if (existingRegistration != _registrations.end() && existingRegistration->second.GraceTimer == graceTimer)
+    {
+        existingRegistration->second.GraceTimer = nullptr;
+        ReleaseProvider(targetDeviceId);
+    }
+}
+
+void SampleFrameProviderManager::ReleaseAllProviders()
+{
+    auto lock = _connectionLocker.Lock();
+
+    for (auto& registration : _registrations)
+    {
+        if (registration.second.GraceTimer != nullptr)
+        {
+            registration.second.GraceTimer->Cancel();
+            registration.second.GraceTimer = nullptr;
+        }
+
+        UnregisterProvider(registration.second);
+    }
+
+    _registrations.clear();
+    _providerMap->Clear();
+}
+
+void SampleFrameProviderManager::UnregisterProvider(ProviderRegistration& registration)
+{
     // NOTE: When SensorDataService unloads a given FrameProvider, it directly Closes (aka Disposes) the IPerceptionFrameProvider object before
     // Closing the IPerceptionFrameProviderManager object that created it. This means, any references to the FrameProvider object are now invalid 
     // and any API calls made using this Provider, e.g. UnregisterControlGroup, will throw an InvalidArgumentException.
@@ -188,44 +313,82 @@ void SampleFrameProviderManager::ReleaseProvider()
     if (!_destructorCalled)
     {
         // Unregister the FaceAuthentication group
-        if (_faceAuthGroup != nullptr)
+        if (registration.FaceAuthGroup != nullptr)
         {
-            WDPP::PerceptionFrameProviderManagerService::UnregisterFaceAuthenticationGroup(this, _faceAuthGroup);
-            _faceAuthGroup = nullptr;
+            WDPP::PerceptionFrameProviderManagerService::UnregisterFaceAuthenticationGroup(this, registration.FaceAuthGroup);
         }
 
         // Unregister the ControlGroup
-        if (_controlGroup != nullptr)
+        if (registration.ControlGroup != nullptr)
         {
-            WDPP::PerceptionFrameProviderManagerService::UnregisterControlGroup(this, _controlGroup);
-            _controlGroup = nullptr;
+            WDPP::PerceptionFrameProviderManagerService::UnregisterControlGroup(this, registration.ControlGroup);
         }
 
         // Unregister our Provider object and release it
-        if (_providerMap->Size > 0)
+        if (registration.Provider != nullptr)
         {
-            auto firstItem = _providerMap->First();
-            WDPP::PerceptionFrameProviderInfo^ providerInfo = firstItem->Current->Value->FrameProviderInfo;
+            WDPP::PerceptionFrameProviderInfo^ providerInfo = registration.Provider->FrameProviderInfo;
             if (providerInfo != nullptr)
             {
                 WDPP::PerceptionFrameProviderManagerService::UnregisterFrameProviderInfo(this, providerInfo);
-            }
 
-            _providerMap->Clear();
+                if (_providerMap->HasKey(providerInfo->Id))
+                {
+                    _providerMap->Remove(providerInfo->Id);
+                }
+            }
         }
     }
-    else
-    {
-        _faceAuthGroup = nullptr;
-        _controlGroup = nullptr;
-        _providerMap->Clear();
-    }
+
+    registration.FaceAuthGroup = nullptr;
+    registration.ControlGroup = nullptr;
+    registration.Provider = nullptr;
 
     //
     // TODO: Add any other device specific shutdown code
     //
 }
 
+void SampleFrameProviderManager::ProvisionExecutorWorkers()
+{
+    // Each provider converts up to _conversionWorkers frames at once, so the executor gets that many workers per
+    // registered device, up to one per processor
+    // Workers aren't removed when a device goes away, its provider is usually parked and comes back
+    const UINT32 workerCount = (std::min)(static_cast<UINT32>(_registrations.size()) * SampleFrameProvider::_conversionWorkers, WorkStealingExecutor::GetDefaultWorkerCount());
+
+    if (!_executor->IsRunning())
+    {
+        _executor->Start(workerCount);
+    }
+    else if (workerCount > _executor->GetWorkerCount())
+    {
+        _executor->AddWorkers(workerCount - _executor->GetWorkerCount());
+    }
+}
+
+UINT32 SampleFrameProviderManager::AcquireWorkerSlot()
+{
+    // Use the lowest slot not taken by another device, so a device that is removed and added again gets the same slot back
+    UINT32 workerSlot = 0;
+    bool slotInUse = true;
+
+    while (slotInUse)
+    {
+        slotInUse = false;
+        for (const auto& registration : _registrations)
+        {
+            slotInUse = slotInUse || (registration.second.WorkerSlot == workerSlot);
+        }
+
+        if (slotInUse)
+        {
+            workerSlot++;
+        }
+    }
+
+    return workerSlot;
+}
+
 bool SampleFrameProviderManager::StartFaceAuthentication(WDPP::PerceptionFaceAuthenticationGroup^ group)
 {
     // Sensor specific functionality
@@ -13,6 +13,16 @@
 
 namespace MediaFoundationProvider {
 
+// Everything the manager registered with the service for a single device
+struct ProviderRegistration
+{
+    SampleFrameProvider^ Provider;
+    WDPP::PerceptionControlGroup^ ControlGroup;
+    WDPP::PerceptionFaceAuthenticationGroup^ FaceAuthGroup;
+    UINT32 WorkerSlot;      // Selects the ideal processor of the provider's frame reading work items
+    WST::ThreadPoolTimer^ GraceTimer;   // Set while the device is removed and the provider is parked
+};
+
 public ref class SampleFrameProviderManager sealed : public WDPP::IPerceptionFrameProviderManager
 {
 public:
@@ -27,7 +37,13 @@ private:
 
     // Internal methods
     void CreateProvider(Platform::String^ targetDeviceId);
-    void ReleaseProvider();
+    void ReleaseProvider(Platform::String^ targetDeviceId);
+    void ParkProvider(Platform::String^ targetDeviceId);
+    void ReleaseParkedProvider(Platform::String^ targetDeviceId, WST::ThreadPoolTimer^ graceTimer);
+    void ReleaseAllProviders();
+    void UnregisterProvider(ProviderRegistration& registration);
+    UINT32 AcquireWorkerSlot();
+    void ProvisionExecutorWorkers();
 
     // Face Authentication event handlers
     bool StartFaceAuthentication(WDPP::PerceptionFaceAuthenticationGroup^ group);
@@ -39,9 +55,9 @@ private:
 
     // Class fields
     Platform::Collections::Map<Platform::String^, WDPP::IPerceptionFrameProvider^>^ _providerMap;
-    WDPP::PerceptionControlGroup^ _controlGroup;
-    WDPP::PerceptionFaceAuthenticationGroup^ _faceAuthGroup;
+    std::map<std::wstring, ProviderRegistration> _registrations;     // Keyed by the DeviceWatcher's device ID
     WDE::DeviceWatcher^ _deviceWatcher;
+    std::shared_ptr<WorkStealingExecutor> _executor;        // Shared by every provider instead of a thread pool per provider
     WRLW::CriticalSection _connectionLocker;
     WRLW::CriticalSection _destructionLocker;
 
@@ -16,16 +16,76 @@ using namespace Microsoft::WRL;
 
 namespace MediaFoundationProvider {
 
-SampleFrameProvider::SampleFrameProvider(Platform::String^ targetDeviceId) :
-    _readFrameCallbackToken(),
+// Optional values under the provider's registry key used to record the device's frames, replay a recording
+// or generate synthetic frames for load tests
+static const WCHAR ProviderSettingsKey[] = L"Software\\Microsoft\\Analog\\Providers\\MediaFoundation";
+static const WCHAR ReplayPathValue[] = L"ReplayPath";
+static const WCHAR ReplayPacedValue[] = L"ReplayPaced";
+static const WCHAR RecordingPathValue[] = L"RecordingPath";
+static const WCHAR SyntheticFramesValue[] = L"SyntheticFrames";
+static const WCHAR SyntheticFormatValue[] = L"SyntheticFormat";
+static const WCHAR SyntheticWidthValue[] = L"SyntheticWidth";
+static const WCHAR SyntheticHeightValue[] = L"SyntheticHeight";
+static const WCHAR SyntheticFrameRateValue[] = L"SyntheticFrameRate";
+static const WCHAR SyntheticPacedValue[] = L"SyntheticPaced";
+static const WCHAR PacedDeliveryValue[] = L"PacedDelivery";
+static const WCHAR AutoExposureValue[] = L"AutoExposure";
+
+static std::wstring ReadProviderSetting(_In_ LPCWSTR valueName)
+{
+    WCHAR value[MAX_PATH];
+    DWORD valueSize = sizeof(value);
+
+    const LSTATUS status = RegGetValueW(HKEY_LOCAL_MACHINE, ProviderSettingsKey, valueName, RRF_RT_REG_SZ, nullptr, value, &valueSize);
+    return (status == ERROR_SUCCESS) ? std::wstring(value) : std::wstring();
+}
+
+static DWORD ReadProviderSetting(_In_ LPCWSTR valueName, DWORD defaultValue)
+{
+    DWORD value;
+    DWORD valueSize = sizeof(value);
+
+    const LSTATUS status = RegGetValueW(HKEY_LOCAL_MACHINE, ProviderSettingsKey, valueName, RRF_RT_REG_DWORD, nullptr, &value, &valueSize);
+    return (status == ERROR_SUCCESS) ? value : defaultValue;
+}
+
+SampleFrameProvider::SampleFrameProvider(Platform::String^ targetDeviceId, const std::shared_ptr<WorkStealingExecutor>& executor) :
     _availablityChangedCallbackToken(),
     _providerInfo(nullptr),
     _frameAllocator(nullptr),
     _properties(nullptr),
-    _mediaCapture(nullptr)
+    _mediaCapture(nullptr),
+    _executor(executor),
+    _parallelPipeline(_framePipeline),
+    _streamStarts(0),
+    _conversionStreamStarts(0),
+    _activeProfile(),
+    _frameSourceAttached(false),
+    _publishedFrames(0),
+    _throughputWindowStart(0),
+    _releaseAtCadence(false),
+    _releaseTimer(nullptr),
+    _pacedFrameHead(0),
+    _pacedFrameCount(0),
+    _releasing(false),
+    _timingReportTime(0),
+    _pendingPairFrame(nullptr),
+    _mediaCaptureReady(Concurrency::task_from_result()),
+    _mediaCaptureInitializations(0),
+    _autoExposureEnabled(false),
+    _autoExposureRequested(false),
+    _exposureUpdatePending(0),
+    _suspended(false),
+    _resumeStreaming(false),
+    _removalTime(0)
 {
     _properties = ref new WFC::PropertySet();
 
+    _activeIlluminationEnabledKey = WDP::KnownPerceptionInfraredFrameSourceProperties::ActiveIlluminationEnabled;
+    _isMirroredKey = WDP::KnownPerceptionVideoFrameSourceProperties::IsMirrored;
+    _trueValue = true;
+    _falseValue = false;
+
     if (targetDeviceId == nullptr)
     {
         throw ref new Platform::InvalidArgumentException("targetDeviceId parameter wasn't specified");
@@ -36,23 +96,57 @@ SampleFrameProvider::SampleFrameProvider(Platform::String^ targetDeviceId) :
     const HRESULT hr = _mediaWrapper.Initialize(targetDeviceId->Data());
     ThrowIfFailed(hr, L"Failed to initialize MediaFoundation");
 
-    // Initialize MediaCapture in order to acquire a VideoDeviceController object later
-    // NOTE: We are not using MediaCapture to stream frames (using MediaFoundation's IMFSourceReader)
-    // but in order to access extended camera properties, e.g. ExposureCompensation, we must utilize
-    // VideoDeviceController, which is only obtained through a MediaCapture instance
-    WMC::MediaCaptureInitializationSettings^ initSettings = ref new WMC::MediaCaptureInitializationSettings();
-    _mediaCapture = ref new WMC::MediaCapture();
+    // Using the video mode selected by MediaWrapper, set essential video Properties for this FrameProvider
+    InitializeSourceVideoProperties();
 
-    // Connect MediaCapture to the same device in MediaFoundation initialization
-    initSettings->VideoDeviceId = targetDeviceId;
-    initSettings->StreamingCaptureMode = WMC::StreamingCaptureMode::Video;
+    // Without MFT0 every frame would be reported as illuminated, so the lit/unlit phase of interleaved sensors is
+    // inferred from the frames' brightness instead
+    _framePipeline.SetIlluminationDetection(IsIlluminationInterleaved());
 
-    // Provider doesn't need to be asynchronous, just wait for initialization to complete
-    auto initTask = Concurrency::create_task(_mediaCapture->InitializeAsync(initSettings));
-    initTask.wait();
+    // Converted frames are published as soon as they're ready rather than when the next frame is read; the publish
+    // stage awaits them for the provider's lifetime
+    _parallelPipeline.SetFrameReadyProc(&SampleFrameProvider::OnFrameConverted, reinterpret_cast<void*>(this));
+    _parallelPipeline.SetInputReleasedProc(&SampleFrameProvider::OnFrameInputReleased, reinterpret_cast<void*>(this));
+    PublishFramesAsync();
 
-    // Using the video mode selected by MediaWrapper, set essential video Properties for this FrameProvider
-    InitializeSourceVideoProperties();
+    // Either replay a recording or generate synthetic frames in place of the device's frames or record the device's frames, if configured
+    const std::wstring replayPath = ReadProviderSetting(ReplayPathValue);
+    const std::wstring recordingDirectory = ReadProviderSetting(RecordingPathValue);
+    if (!replayPath.empty())
+    {
+        InitializeFrameReplay(replayPath.c_str(), ReadProviderSetting(ReplayPacedValue, 1) != 0);
+    }
+    else if (ReadProviderSetting(SyntheticFramesValue, 0) != 0)
+    {
+        InitializeSyntheticFrames();
+    }
+    else if (!recordingDirectory.empty())
+    {
+        InitializeFrameRecording(recordingDirectory.c_str());
+    }
+
+    _releaseAtCadence = ReadProviderSetting(PacedDeliveryValue, 0) != 0;
+    if (_releaseAtCadence)
+    {
+        _releaseTimer = CreateThreadpoolTimer(&SampleFrameProvider::OnReleaseTimer, reinterpret_cast<void*>(this), nullptr);
+        if (_releaseTimer == nullptr)
+        {
+            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()), L"Failed to create the frame release timer");
+        }
+    }
+
+    // Adjust the device's exposure from the frames' brightness if configured; not while frames come from elsewhere
+    // The controller needs the device's exposure range, so it's set up once MediaCapture is initialized
+    if (ReadProviderSetting(AutoExposureValue, 0) != 0 && !_frameSourceAttached)
+    {
+        auto lock = _pipelineLock.Lock();
+        _autoExposureRequested = true;
+    }
+
+    // Initialize MediaCapture in order to acquire a VideoDeviceController object later
+    // Started once _autoExposureRequested is final, since the initialization may complete on another thread right away
+    // NOTE: This doesn't wait for the initialization, the provider is registered and streams in the meantime
+    _mediaCaptureReady = InitializeMediaCaptureAsync(targetDeviceId);
 
     // Fill ProviderInfo properties from MediaFoundation values
     _providerInfo = ref new WDPP::PerceptionFrameProviderInfo();
@@ -62,18 +156,6 @@ SampleFrameProvider::SampleFrameProvider(Platform::String^ targetDeviceId) :
     _providerInfo->FrameKind = WDPP::KnownPerceptionFrameKind::Infrared; 
     _providerInfo->Hidden = false;
     
-    // Subscribe to MediaFoundationWrapper's ReadFrame event, which is fired when a new sample is acquired from MediaFoundation
-    // In response, this class will copy out the frame data and publish it to the Service
-    _mediaWrapper.SubscribeReadFrame(Callback<ABI::Windows::System::Threading::IWorkItemHandler>([this](ABI::Windows::Foundation::IAsyncAction* /*asyncAction*/)
-    {
-        WDPP::PerceptionFrame^ outputFrame = this->CopyMediaSampleToPerceptionFrame();
-        if (outputFrame != nullptr)
-        {
-            WDPP::PerceptionFrameProviderManagerService::PublishFrameForProvider(this, outputFrame);
-        }
-        return S_OK;
-    }).Get(), &_readFrameCallbackToken);
-        
     // Subscribe to MediaFoundationWrapper's AvailableChanged event, which is fired when we lose connectivity with the device
     // In response, publish the new Availablity state to the Service
     _mediaWrapper.SubscribeAvailableChanged(Callback<ABI::Windows::System::Threading::IWorkItemHandler>([this](ABI::Windows::Foundation::IAsyncAction* /*asyncAction*/)
@@ -86,13 +168,29 @@ SampleFrameProvider::SampleFrameProvider(Platform::String^ targetDeviceId) :
 
 SampleFrameProvider::~SampleFrameProvider()
 {
+    // The capture stage runs on the wrapper's read work item and the workers publish through this object, so both
+    // must be done before its members are destroyed
+    _mediaWrapper.Shutdown();
+    StopFrameConversion();
+
+    if (_releaseTimer != nullptr)
+    {
+        CloseThreadpoolTimer(_releaseTimer);
+    }
 }
 
 void SampleFrameProvider::Start()
 {
-    if (!_mediaWrapper.IsRunning())
+    auto lock = _pipelineLock.Lock();
+
+    // The device is temporarily gone; streaming begins once it's back
+    if (_suspended)
+    {
+        _resumeStreaming = true;
+    }
+    else if (!_mediaWrapper.IsRunning())
     {
-        HRESULT hr = _mediaWrapper.Start();
+        HRESULT hr = StartReadingFrames();
         ThrowIfFailed(hr, L"Failed to start reading frames from MediaFoundation");
 
         UpdateSourceVideoProperties();
@@ -101,7 +199,13 @@ void SampleFrameProvider::Start()
 
 void SampleFrameProvider::Stop()
 {
-    if (_mediaWrapper.IsRunning())
+    auto lock = _pipelineLock.Lock();
+
+    if (_suspended)
+    {
+        _resumeStreaming = false;
+    }
+    else if (_mediaWrapper.IsRunning())
     {
         HRESULT hr = _mediaWrapper.Stop(false);
         ThrowIfFailed(hr, "Failed to stop reading frames from MediaFoundation");
@@ -112,12 +216,21 @@ void SampleFrameProvider::SetProperty(WDPP::PerceptionPropertyChangeRequest^ req
 {
     WDP::PerceptionFrameSourcePropertyChangeStatus status;
 
-    // This implementation of IFrameProvider supports only a single video profile and so changing profiles isn't supported.
-    // If IFrameProvider were to support multiple profiles, then functionality to reinitialize the device using the new
-    // valus needs to be added here.
+    // Changing the video profile switches the media type of the running device in place; see ApplyVideoProfile
     if (request->Name == WDP::KnownPerceptionVideoFrameSourceProperties::VideoProfile)
     {
-        status = WDP::PerceptionFrameSourcePropertyChangeStatus::PropertyNotSupported;
+        VideoSourceDescription^ requestedProfile = nullptr;
+
+        // The requested value must be a PropertySet describing a video profile
+        try
+        {
+            requestedProfile = ref new VideoSourceDescription(safe_cast<WFC::IPropertySet^>(request->Value));
+        }
+        catch (Platform::Exception^) { ; }
+
+        status = (requestedProfile != nullptr) ?
+            ApplyVideoProfile(requestedProfile) :
+            WDP::PerceptionFrameSourcePropertyChangeStatus::ValueOutOfRange;
     }
     else if ((request->Name == WDP::KnownPerceptionVideoFrameSourceProperties::SupportedVideoProfiles) ||
         (request->Name == WDP::KnownPerceptionVideoFrameSourceProperties::AvailableVideoProfiles))
@@ -126,31 +239,125 @@ void SampleFrameProvider::SetProperty(WDPP::PerceptionPropertyChangeRequest^ req
     }
     else if (request->Name == WDP::KnownPerceptionInfraredFrameSourceProperties::ExposureCompensation)
     {
-        float requestedValue = safe_cast<float>(request->Value);
+        Concurrency::task<void> mediaCaptureReady;
 
-        if (!IsExposureCompensationSupported())
+        // Explicitly requested values take precedence over automatic exposure for the rest of the session
         {
-            status = WDP::PerceptionFrameSourcePropertyChangeStatus::PropertyNotSupported;
+            auto lock = _pipelineLock.Lock();
+            _autoExposureEnabled = false;
+            _autoExposureRequested = false;
+            mediaCaptureReady = _mediaCaptureReady;
         }
-        else if (SetExposureCompensation(requestedValue))
+
+        // The request is completed once the device applied the value, rather than blocking the service's thread
+        // until then; a value requested while MediaCapture is still initializing is applied once it's done
+        CompletePropertyRequestAsync(request, mediaCaptureReady);
+        return;
+    }
+    else
+    {
+        _properties->Insert(request->Name, request->Value);
+        status = WDP::PerceptionFrameSourcePropertyChangeStatus::Accepted;
+    }
+
+    request->Status = status;
+}
+
+void SampleFrameProvider::Suspend()
+{
+    auto lock = _pipelineLock.Lock();
+
+    if (_suspended) return;
+
+    InterlockedExchange64(&_removalTime, MFGetSystemTime());
+
+    // Stop reading frames and release the device objects, which are invalid once the device is removed
+    // Everything else, i.e. MediaFoundation, the frame allocator and the conversion kernel, stays as it is for Resume
+    _resumeStreaming = _mediaWrapper.IsRunning();
+    _mediaWrapper.Detach();
+    _mediaCapture = nullptr;
+    _suspended = true;
+
+    WDPP::PerceptionFrameProviderManagerService::UpdateAvailabilityForProvider(this, false);
+}
+
+bool SampleFrameProvider::Resume(Platform::String^ targetDeviceId)
+{
+    auto lock = _pipelineLock.Lock();
+
+    if (!_suspended) return true;
+
+    const MFTIME resumeStartTime = MFGetSystemTime();
+
+    // Reopen the device; its capabilities are still known so neither device nor media type enumeration is needed
+    HRESULT hr = _mediaWrapper.Reattach(targetDeviceId->Data());
+
+    // Restore the profile that was active before the device was removed
+    // NOTE: A replayed or synthetic frame source keeps its own profile regardless of the device's profiles
+    if (SUCCEEDED(hr) && !_frameSourceAttached)
+    {
+        MediaDeviceCapabilities capabilities = _mediaWrapper.GetCapabilities();
+        UINT32 profileIndex = 0;
+
+        while (profileIndex < capabilities.Profiles.size() &&
+            memcmp(&capabilities.Profiles[profileIndex], &_activeProfile, sizeof(_activeProfile)) != 0)
+        {
+            profileIndex++;
+        }
+
+        if (profileIndex == capabilities.Profiles.size())
         {
-            // Attempt to set the new value to the device and if successful update Property value
-            // NOTE: requestedValue passed by reference since value is modified if outside min/max range
-            _properties->Insert(request->Name, requestedValue);
-            status = WDP::PerceptionFrameSourcePropertyChangeStatus::Accepted;
+            // The device no longer offers the profile, e.g. its driver changed; continue with its preferred profile
+            try
+            {
+                ConfigureFramePipeline(capabilities.Profiles[capabilities.SelectedProfileIndex]);
+            }
+            catch (Platform::Exception^ ex)
+            {
+                hr = ex->HResult;
+            }
+        }
+        else if (profileIndex != capabilities.SelectedProfileIndex)
+        {
+            hr = _mediaWrapper.SetMediaProfile(profileIndex);
+        }
+    }
+
+    // The exposure control is only available again once MediaCapture is initialized, streaming resumes right away
+    if (SUCCEEDED(hr))
+    {
+        _mediaCaptureReady = InitializeMediaCaptureAsync(targetDeviceId);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        _suspended = false;
+
+        if (_resumeStreaming)
+        {
+            hr = StartReadingFrames();
+            if (SUCCEEDED(hr))
+            {
+                UpdateSourceVideoProperties();
+            }
         }
         else
         {
-            status = WDP::PerceptionFrameSourcePropertyChangeStatus::ValueOutOfRange;
+            // Nothing to measure until the service starts the provider again
+            InterlockedExchange64(&_removalTime, 0);
         }
     }
-    else
+
+    TraceDiagnostic(L"SampleFrameProvider: reattaching to the device took %lld ms, hr = 0x%08X\n",
+        (MFGetSystemTime() - resumeStartTime) / 10000,
+        hr);
+
+    if (SUCCEEDED(hr))
     {
-        _properties->Insert(request->Name, request->Value);
-        status = WDP::PerceptionFrameSourcePropertyChangeStatus::Accepted;
+        WDPP::PerceptionFrameProviderManagerService::UpdateAvailabilityForProvider(this, _mediaWrapper.IsAvailable());
     }
 
-    request->Status = status;
+    return SUCCEEDED(hr);
 }
 
 bool SampleFrameProvider::Available::get()
@@ -168,155 +375,531 @@ WFC::IPropertySet^ SampleFrameProvider::Properties::get()
     return _properties;
 }
 
-VideoSourceDescription^ SampleFrameProvider::CreateVideoDescriptionFromMediaSource()
+VideoSourceDescription^ SampleFrameProvider::CreateVideoDescriptionFromProfile(const MediaProfileDescriptor& profile)
 {
-    ComPtr<IMFMediaType> sourceAttributes;
-    UINT32 numerator;
-    UINT32 denominator;
-
-    sourceAttributes = _mediaWrapper.GetSourceAttributes();
-
-    // Verify source media format is YUY2
-    GUID guidType;
-    HRESULT hr = sourceAttributes->GetGUID(MF_MT_SUBTYPE, &guidType);
-    ThrowIfFailed(hr, L"Failed to read video frame type from source media");
-    
-    if (!IsEqualGUID(MFVideoFormat_YUY2, guidType))
+    if (profile.PixelAspectDenominator == 0 || profile.FrameRateNumerator == 0 || profile.FrameRateDenominator == 0)
     {
-        ThrowIfFailed(E_INVALID_PROTOCOL_FORMAT, L"Source media must return YUY2 format");
+        ThrowIfFailed(E_INVALID_PROTOCOL_FORMAT, L"Source media reported an invalid aspect ratio or frame rate");
     }
 
-    // Get the size (width/heigh) of each frame
-    UINT32 width;
-    UINT32 height;
-    hr = MFGetAttributeSize(sourceAttributes.Get(), MF_MT_FRAME_SIZE, &width, &height);
-    ThrowIfFailed(hr, L"Failed to read frame size from source media");
-
     // Get the aspect ratio of each frame
-    hr = MFGetAttributeRatio(sourceAttributes.Get(), MF_MT_PIXEL_ASPECT_RATIO, &numerator, &denominator);
-    ThrowIfFailed(hr, L"Failed to read pixel aspect ratio from source media");
-    double aspectRatio = static_cast<double>(numerator) / static_cast<double>(denominator);
-
-    // Get the frame rate
-    hr = MFGetAttributeRatio(sourceAttributes.Get(), MF_MT_FRAME_RATE_RANGE_MAX, &numerator, &denominator);
-    ThrowIfFailed(hr, L"Failed to read frame rate from source media");
+    double aspectRatio = static_cast<double>(profile.PixelAspectNumerator) / static_cast<double>(profile.PixelAspectDenominator);
 
     // Convert framerate to Timespan with ticks of 100 nanoseconds each
-    double workingVar = static_cast<double>(numerator) / static_cast<double>(denominator);
+    double workingVar = static_cast<double>(profile.FrameRateNumerator) / static_cast<double>(profile.FrameRateDenominator);
     workingVar = (1.0e7 / workingVar) + 0.5;
     Windows::Foundation::TimeSpan frameDuration = Windows::Foundation::TimeSpan{ static_cast<INT64>(workingVar) };
 
     // NOTE: Only 8-bit IR is supported and if the sensor outputs IR at a higher bit depth it must be down sampled
-    // For sensors that output YUY2 frames, the image must be manually converted to the Gray8
+    // For sensors that output YUY2 or NV12 frames, the image must be manually converted to the Gray8
     VideoSourceDescription^ videoProfile = ref new VideoSourceDescription(
         Windows::Graphics::Imaging::BitmapPixelFormat::Gray8,
         Windows::Graphics::Imaging::BitmapAlphaMode::Ignore,
-        width,
-        height,
+        profile.Width,
+        profile.Height,
         aspectRatio,
         frameDuration);
 
     return videoProfile;
 }
 
-WDPP::PerceptionFrame^ SampleFrameProvider::CopyMediaSampleToPerceptionFrame()
+VideoSourceDescription^ SampleFrameProvider::ConfigureFramePipeline(const MediaProfileDescriptor& profile)
+{
+    VideoSourceDescription^ videoProfile = CreateVideoDescriptionFromProfile(profile);
+
+    // The conversion workers use the current kernel and frame allocator, the next frame read restarts them
+    StopFrameConversion();
+
+    // Initialize FrameAllocator object according to the video frame parameters acquired from MediaFoundation
+    // The allocated Gray8 frames only depend on the frame size, so the existing frame pool is kept if the size didn't change
+    const FrameLayout& currentLayout = _framePipeline.GetSourceLayout();
+    const bool sizeChanged = (currentLayout.Width != profile.Width || currentLayout.Height != profile.Height);
+
+    // Select the kernel converting the source format into Gray8
+    // Frames are tightly packed since the source buffers are accessed through IMFMediaBuffer::Lock
+    const FramePixelFormat sourceFormat = MediaDeviceManager::GetFramePixelFormat(profile.Subtype);
+    if (!_framePipeline.Configure(GetPackedFrameLayout(sourceFormat, profile.Width, profile.Height)))
+    {
+        ThrowIfFailed(E_INVALID_PROTOCOL_FORMAT, L"Source media format can't be converted to Gray8");
+    }
+
+    if (_frameAllocator == nullptr || sizeChanged)
+    {
+        _frameBufferCache.Clear();
+
+        _frameAllocator = ref new WDPP::PerceptionVideoFrameAllocator(
+            _allocatedFrameCount, /*Num requested frames*/
+            videoProfile->BitmapPixelFormat,
+            videoProfile->PixelSize,
+            videoProfile->BitmapAlphaMode);
+    }
+
+    // A frame held for pairing belongs to the previous profile
+    // NOTE: Frames aren't being read or converted while the pipeline is configured
+    _illuminationPairer.SetFrameInterval(videoProfile->FrameDuration.Duration);
+    _illuminationPairer.Reset();
+    _pendingPairFrame = nullptr;
+
+    _activeProfile = profile;
+
+    // IFrameProvider objects are required to expose the current video profile data via their Properties
+    _properties->Insert(
+        WDP::KnownPerceptionVideoFrameSourceProperties::VideoProfile,
+        videoProfile->AsPropertySet());
+
+    return videoProfile;
+}
+
+WDP::PerceptionFrameSourcePropertyChangeStatus SampleFrameProvider::ApplyVideoProfile(VideoSourceDescription^ requestedProfile)
 {
-    WDPP::PerceptionFrame^ outputFrame = nullptr;
-    ComPtr<IMFSample> mediaSample;
+    auto lock = _pipelineLock.Lock();
+
+    // The profile of a replayed or synthetic frame source is fixed
+    if (_frameSourceAttached)
+    {
+        return WDP::PerceptionFrameSourcePropertyChangeStatus::PropertyReadOnly;
+    }
+
+    // Find the highest ranked device profile producing the requested video mode
+    MediaDeviceCapabilities capabilities = _mediaWrapper.GetCapabilities();
+    UINT32 profileIndex = 0;
+
+    while (profileIndex < capabilities.Profiles.size() &&
+        !CreateVideoDescriptionFromProfile(capabilities.Profiles[profileIndex])->IsSameVideoMode(requestedProfile))
+    {
+        profileIndex++;
+    }
+
+    if (profileIndex == capabilities.Profiles.size())
+    {
+        return WDP::PerceptionFrameSourcePropertyChangeStatus::ValueOutOfRange;
+    }
+    else if (profileIndex == capabilities.SelectedProfileIndex)
+    {
+        return WDP::PerceptionFrameSourcePropertyChangeStatus::Accepted;
+    }
+
+    const MFTIME switchStartTime = MFGetSystemTime();
+    const bool wasRunning = _mediaWrapper.IsRunning();
 
-    if (_frameAllocator == nullptr) return nullptr;
+    bool pipelineConfigured = true;
 
-    HRESULT hr = _mediaWrapper.GetCurrentFrameResult();
+    // Drain the pipeline: stop reading frames and let SetMediaProfile wait for the read task to exit
+    // before the new media type is set on the existing reader
+    HRESULT hr = wasRunning ? _mediaWrapper.Stop(true) : S_OK;
     if (SUCCEEDED(hr))
     {
-        mediaSample = _mediaWrapper.GetCurrentFrame();
-        if (SUCCEEDED(hr))
+        hr = _mediaWrapper.SetMediaProfile(profileIndex);
+    }
+
+    // Rebuild the conversion kernel and frame allocator for the new profile
+    if (SUCCEEDED(hr))
+    {
+        try
+        {
+            ConfigureFramePipeline(capabilities.Profiles[profileIndex]);
+        }
+        catch (Platform::Exception^ ex)
         {
-            outputFrame = _frameAllocator->AllocateFrame();
+            hr = ex->HResult;
         }
+
+        // The device already uses the new media type, so switch it back along with the pipeline, i.e. _activeProfile,
+        // the conversion kernel and the frame allocator
+        if (FAILED(hr))
+        {
+            HRESULT restoreResult = _mediaWrapper.SetMediaProfile(capabilities.SelectedProfileIndex);
+            if (SUCCEEDED(restoreResult))
+            {
+                try
+                {
+                    ConfigureFramePipeline(capabilities.Profiles[capabilities.SelectedProfileIndex]);
+                }
+                catch (Platform::Exception^ ex)
+                {
+                    restoreResult = ex->HResult;
+                }
+            }
+
+            // Frames can't be converted without a pipeline, the provider stays stopped until a profile is applied
+            pipelineConfigured = SUCCEEDED(restoreResult);
+        }
+    }
+
+    // Resume streaming, with the previous profile if the switch failed
+    if (wasRunning && pipelineConfigured && !_mediaWrapper.IsRunning())
+    {
+        const HRESULT startResult = StartReadingFrames();
+        if (SUCCEEDED(startResult))
+        {
+            UpdateSourceVideoProperties();
+        }
+        hr = SUCCEEDED(hr) ? startResult : hr;
     }
 
-    if (mediaSample != nullptr && outputFrame != nullptr)
+    TraceDiagnostic(L"SampleFrameProvider: switching to video profile %ux%u took %lld ms, hr = 0x%08X\n",
+        capabilities.Profiles[profileIndex].Width,
+        capabilities.Profiles[profileIndex].Height,
+        (MFGetSystemTime() - switchStartTime) / 10000,
+        hr);
+
+    return SUCCEEDED(hr) ?
+        WDP::PerceptionFrameSourcePropertyChangeStatus::Accepted :
+        WDP::PerceptionFrameSourcePropertyChangeStatus::Unknown;
+}
+
+HRESULT SampleFrameProvider::StartReadingFrames()
+{
+    // Frames still being converted were read before the provider stopped, SubmitCapturedFrame drops them
+    InterlockedIncrement(&_streamStarts);
+
+    // The capture stage runs until the wrapper is stopped; Start fails while the previous one is still exiting
+    HRESULT hr = _mediaWrapper.Start();
+    if (SUCCEEDED(hr))
     {
-        ComPtr<IMFMediaBuffer> sampleBuffer;
-        hr = mediaSample->GetBufferByIndex(0, sampleBuffer.GetAddressOf());
+        CaptureFramesAsync();
+    }
+    return hr;
+}
 
-        // Lock the source and destination buffers to perform the copy
+Concurrency::task<void> SampleFrameProvider::CaptureFramesAsync()
+{
+    // Capture stage: each frame is handed to the conversion workers on the wrapper's read work item, which keeps
+    // reading the device as soon as this coroutine awaits the next frame
+    // NOTE: The coroutine's frame is allocated once per stream, awaiting a frame doesn't allocate
+    for (;;)
+    {
+        const HRESULT hr = co_await _mediaWrapper.ReadFrameAsync();
+        if (hr == E_ABORT) break;
+
+        // A failed read, e.g. of a removed device, is reported through the AvailableChanged event
         if (SUCCEEDED(hr))
         {
-            BYTE* srcBuffer;
-            DWORD srcLength;
-            BYTE* destBuffer;
-            UINT32 destLength;
+            try
+            {
+                SubmitCapturedFrame();
+            }
+            catch (Platform::Exception^) { ; }
+        }
+    }
+}
 
-            MemoryBufferByteAccess destByteAccess;
-            hr = destByteAccess.GetBuffer(reinterpret_cast<IInspectable*>(outputFrame->FrameData), &destBuffer, &destLength);
-            
-            if (SUCCEEDED(hr))
+Concurrency::task<void> SampleFrameProvider::PublishFramesAsync()
+{
+    // Publish stage: the conversion workers resume this coroutine with each converted frame in capture order, see
+    // OnFrameConverted; it awaits the next frame for as long as the provider exists
+    for (;;)
+    {
+        const ParallelFrame frame = co_await _convertedFrames.NextFrameAsync();
+
+        try
+        {
+            PublishConvertedFrame(frame);
+        }
+        catch (Platform::Exception^) { ; }
+    }
+}
+
+void SampleFrameProvider::SubmitCapturedFrame()
+{
+    // NOTE: Only called on the frame reading thread
+    CapturedFrame capturedFrame;
+    LockedFrameSample capturedSample;
+    const MFTIME arrivalTime = MFGetSystemTime();
+
+    if (_frameAllocator == nullptr || !_framePipeline.IsConfigured()) return;
+
+    // ConfigureFramePipeline stops the conversion, it's restarted here so only this thread submits frames
+    const LONG streamStarts = _streamStarts;
+    if (!_parallelPipeline.IsRunning() || streamStarts != _conversionStreamStarts)
+    {
+        StopFrameConversion();
+        if (!_parallelPipeline.Start(_conversionWorkers, _executor.get(), false)) return;
+        _conversionStreamStarts = streamStarts;
+    }
+
+    // The device's sample stays locked until its slot converted it, so the frame is read in place rather than copied;
+    // a frame that isn't submitted is unlocked when capturedSample goes out of scope
+    HRESULT hr = _mediaWrapper.TakeCurrentFrame(&capturedFrame, &capturedSample);
+    if (SUCCEEDED(hr))
+    {
+        hr = (capturedFrame.Data != nullptr) ? S_OK : E_NOT_VALID_STATE;
+    }
+
+    // If every slot is still busy the frames arrive faster than they're converted, so this one is dropped rather than
+    // holding up the device; a lit or unlit frame left without its partner is dropped by the IlluminationPairer
+    if (SUCCEEDED(hr) && !_parallelPipeline.CanSubmit())
+    {
+        hr = MF_E_SAMPLEALLOCATOR_EMPTY;
+    }
+
+    WDPP::PerceptionFrame^ outputFrame = SUCCEEDED(hr) ? _frameAllocator->AllocateFrame() : nullptr;
+    if (outputFrame == nullptr) return;
+
+    BYTE* destBuffer;
+    UINT32 destLength;
+
+    // The allocator recycles its frames, so the buffer access of a frame is only created the first time it's used
+    hr = _frameBufferCache.GetBuffer(reinterpret_cast<IInspectable*>(outputFrame->FrameData), &destBuffer, &destLength);
+
+    // Convert the source image data into Gray8 right in the output frame using the kernel selected for the source
+    // format; the conversion fails if the buffers don't hold exactly one frame of the negotiated size
+    // The slot's frame is set first since the frame may be converted and published before Submit returns
+    if (SUCCEEDED(hr))
+    {
+        const UINT32 slot = _parallelPipeline.GetNextSlot();
+        _convertingFrames[slot] = outputFrame;
+        _convertingSamples[slot] = std::move(capturedSample);
+        if (!_parallelPipeline.Submit(capturedFrame, arrivalTime, destBuffer, destLength))
+        {
+            _convertingFrames[slot] = nullptr;
+            _convertingSamples[slot].Unlock();
+        }
+    }
+}
+
+void SampleFrameProvider::OnFrameInputReleased(void* context, uint32_t slot)
+{
+    // The slot's frame was converted, or dropped by StopFrameConversion, so the device's buffer can be reused
+    reinterpret_cast<SampleFrameProvider^>(context)->_convertingSamples[slot].Unlock();
+}
+
+void SampleFrameProvider::OnFrameConverted(void* context, const ParallelFrame& frame)
+{
+    reinterpret_cast<SampleFrameProvider^>(context)->DeliverConvertedFrame(frame);
+}
+
+void SampleFrameProvider::DeliverConvertedFrame(const ParallelFrame& frame)
+{
+    // The publish stage awaits every frame, the slot is only released here if the coroutine isn't there
+    if (!_convertedFrames.Deliver(frame))
+    {
+        _convertingFrames[frame.Slot] = nullptr;
+        _parallelPipeline.Release(frame);
+    }
+}
+
+void SampleFrameProvider::PublishConvertedFrame(const ParallelFrame& frame)
+{
+    // NOTE: Called for one frame at a time in capture order, on the thread that converted it or an older frame
+    // The frame was converted into outputFrame, so its slot can take the next frame right away
+    WDPP::PerceptionFrame^ outputFrame = _convertingFrames[frame.Slot];
+    _convertingFrames[frame.Slot] = nullptr;
+    _parallelPipeline.Release(frame);
+
+    if (!frame.Processed || outputFrame == nullptr) return;
+
+    const ProcessedFrame& processedFrame = frame.Result;
+
+    // Set the output Property according to the frame's "Illumination Enabled" state
+    // NOTE: Each frame must be tagged with this Property otherwise frames won't be delivered to the client app
+    // and so a default value is set to ensure frames are always available
+    //
+    // IMPORTANT: The state is read from a custom attribute assigned to the sample within MFT0
+    // The MFT0 code, which is installed and associated with the device driver, is responsible for
+    // polling the LED illumination state from the device and tagging the sample with this value
+    outputFrame->Properties->Insert(
+        _activeIlluminationEnabledKey,
+        processedFrame.IlluminationEnabled ? _trueValue : _falseValue);
+
+    // Set the IsMirrored property for this frame according to cached value
+    // This property is also set to Provider object's _properties field during initialization
+    // NOTE: The Mirrored state is queried when device is Initialized or Activated and cached in a class field
+    outputFrame->Properties->Insert(
+        _isMirroredKey,
+        _mediaWrapper.IsMirrored() ? _trueValue : _falseValue);
+
+    // Set the output VideoFrame's timestamp
+    // The device's timestamp is mapped to system time rather than stamping the frame on arrival, which would
+    // add the varying delay of reading and converting the frame to the intervals between frames
+    // NOTE: Duration's value is in 100 nanosecond units (ticks) which is also used by MediaFoundation
+    Windows::Foundation::TimeSpan systemRelativeTime;
+    systemRelativeTime.Duration = _framePacer.Pace(processedFrame.SourceTimestamp, frame.ReadTime);
+    outputFrame->RelativeTime = systemRelativeTime;
+
+    ReportFrameTiming(frame.ReadTime);
+
+    // Frames of interleaved sensors are published in illuminated/unilluminated pairs if MFT0 tagged them
+    if (IsIlluminationInterleaved() && processedFrame.IlluminationTagged)
+    {
+        PublishPairedFrame(outputFrame, processedFrame);
+    }
+    else
+    {
+        PublishFrame(outputFrame);
+    }
+
+    if (processedFrame.LuminanceMeasured)
+    {
+        UpdateAutoExposure(processedFrame, MFGetSystemTime());
+    }
+}
+
+void SampleFrameProvider::StopFrameConversion()
+{
+    // Waits for the frame being published, frames that are still converting are dropped along with their output frames
+    _parallelPipeline.Stop();
+    _convertingFrames.fill(nullptr);
+    DropPacedFrames();
+}
+
+void SampleFrameProvider::PublishPairedFrame(WDPP::PerceptionFrame^ frame, const ProcessedFrame& processedFrame)
+{
+    // NOTE: Only called from PublishConvertedFrame, which handles one frame at a time
+    // A single lost frame would otherwise shift the lit/unlit sequence the service relies on for the rest of
+    // the session, so frames whose partner is missing are dropped and only complete pairs are published
+    switch (_illuminationPairer.Submit(processedFrame.SourceTimestamp, processedFrame.IlluminationEnabled))
+    {
+    case PairingDecision::HoldFirst:
+    case PairingDecision::DropHeldAndHoldFirst:
+        _pendingPairFrame = frame;
+        break;
+
+    case PairingDecision::PublishPair:
+        PublishFrame(_pendingPairFrame);
+        PublishFrame(frame);
+        _pendingPairFrame = nullptr;
+        break;
+
+    case PairingDecision::DropHeldAndFrame:
+        _pendingPairFrame = nullptr;
+        break;
+
+    case PairingDecision::DropFrame:
+        break;
+    }
+}
+
+void SampleFrameProvider::PublishFrame(WDPP::PerceptionFrame^ frame)
+{
+    // NOTE: Only called from PublishConvertedFrame, which handles one frame at a time
+    if (!_releaseAtCadence)
+    {
+        ReleaseFrame(frame);
+        return;
+    }
+
+    // Hold the frame until it's due so frames are delivered at the device's cadence; the release timer publishes it,
+    // so the converting thread moves on right away. Frames are queued in capture order and their release times only
+    // increase, so the oldest frame is always the next one due.
+    const MFTIME currentTime = MFGetSystemTime();
+    const MFTIME releaseTime = currentTime + _framePacer.GetReleaseDelay(frame->RelativeTime.Duration, currentTime, _pacedReleaseLatency);
+
+    auto lock = _releaseLock.Lock();
+
+    PacedFrame& pacedFrame = _pacedFrames[(_pacedFrameHead + _pacedFrameCount) % _allocatedFrameCount];
+    pacedFrame.Frame = frame;
+    pacedFrame.ReleaseTime = releaseTime;
+
+    // The timer is only armed for the oldest frame; while it's publishing it rearms itself for the rest
+    if (++_pacedFrameCount == 1 && !_releasing)
+    {
+        ScheduleRelease(releaseTime);
+    }
+}
+
+VOID CALLBACK SampleFrameProvider::OnReleaseTimer(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer)
+{
+    UNREFERENCED_PARAMETER(instance);
+    UNREFERENCED_PARAMETER(timer);
+
+    reinterpret_cast<SampleFrameProvider^>(context)->ReleaseDueFrames();
+}
+
+void SampleFrameProvider::ReleaseDueFrames()
+{
+    // NOTE: Called on a thread pool thread, never concurrently since the timer is only armed while this isn't running
+    {
+        auto lock = _releaseLock.Lock();
+        _releasing = true;
+    }
+
+    // Publishing may take a while, so the lock is only held to take each frame and the converting threads keep
+    // queuing frames meanwhile. Frames due within a millisecond are published right away rather than arming the timer.
+    for (;;)
+    {
+        WDPP::PerceptionFrame^ frame = nullptr;
+        {
+            auto lock = _releaseLock.Lock();
+
+            if (_pacedFrameCount == 0 || _pacedFrames[_pacedFrameHead].ReleaseTime >= MFGetSystemTime() + 10000)
             {
-                hr = sampleBuffer->Lock(&srcBuffer, NULL, &srcLength);
-                if (SUCCEEDED(hr))
+                if (_pacedFrameCount != 0)
                 {
-                    // The Gray8 destination buffer must be exactly half the size of the source YUY2 buffer
-                    if (destLength * 2 == srcLength)
-                    {
-                        // Convert the YUY2 image data into Gray8
-                        // Simply strip the Luminance byte (Y component) from the Source YU/V word
-                        // and copy it into the corresponding byte of the destination buffer
-                        SHORT* src = reinterpret_cast<SHORT*>(srcBuffer);
-                        BYTE* dest = destBuffer;
-                        for (UINT32 i = 0; i < destLength; i++)
-                        {
-                            dest[i] = static_cast<BYTE>(src[i] & 0xFF);
-                        }
-                    }
-
-                    sampleBuffer->Unlock();
+                    ScheduleRelease(_pacedFrames[_pacedFrameHead].ReleaseTime);
                 }
+                _releasing = false;
+                return;
             }
 
-            // Read the "Illumination Enabled" attribute from the media sample and set the output Property accordingly
-            // NOTE: Each frame must be tagged with this Property otherwise frames won't be delivered to the client app
-            // and so a default value is set to ensure frames are always available
-            // 
-            // IMPORTANT: This is a custom GUID assigned to the sample within MFT0
-            // The MFT0 code, which is installed and associated with the device driver, is responsible for
-            // polling the LED illumination state from the device and tagging the sample with this value
-            UINT32 illuminationEnabled = true;
-            mediaSample->GetUINT32(WDPP_ACTIVE_ILLUMINATION_ENABLED, &illuminationEnabled);
-            outputFrame->Properties->Insert(
-                WDP::KnownPerceptionInfraredFrameSourceProperties::ActiveIlluminationEnabled,
-                illuminationEnabled != 0 ? true : false);
-
-            // Set the IsMirrored property for this frame according to cached value
-            // This property is also set to Provider object's _properties field during initialization
-            // NOTE: The Mirrored state is queried when device is Initialized or Activated and cached in a class field
-            outputFrame->Properties->Insert(
-                Windows::Devices::Perception::KnownPerceptionVideoFrameSourceProperties::IsMirrored,
-                _mediaWrapper.IsMirrored());
+            frame = _pacedFrames[_pacedFrameHead].Frame;
+            _pacedFrames[_pacedFrameHead].Frame = nullptr;
+            _pacedFrameHead = (_pacedFrameHead + 1) % _allocatedFrameCount;
+            _pacedFrameCount--;
         }
 
-        // Set the output VideoFrame's timestamp
-        // NOTE: Duration's value is in 100 nanosecond units (ticks) which is also used by MediaFoundation
-        if (SUCCEEDED(hr))
+        ReleaseFrame(frame);
+    }
+}
+
+void SampleFrameProvider::ScheduleRelease(MFTIME releaseTime)
+{
+    // NOTE: Called with _releaseLock held; a negative due time is relative, in 100 nanosecond units
+    ULARGE_INTEGER dueTime;
+    dueTime.QuadPart = static_cast<ULONGLONG>(-(std::max)(releaseTime - MFGetSystemTime(), static_cast<MFTIME>(1)));
+
+    FILETIME fileDueTime;
+    fileDueTime.dwLowDateTime = dueTime.LowPart;
+    fileDueTime.dwHighDateTime = dueTime.HighPart;
+    SetThreadpoolTimer(_releaseTimer, &fileDueTime, 0, 0);
+}
+
+void SampleFrameProvider::DropPacedFrames()
+{
+    // NOTE: Frames aren't being converted, so nothing is queued meanwhile
+    if (_releaseTimer == nullptr) return;
+
+    // A release in progress finishes the frame it's publishing, then finds the ring empty and doesn't rearm the timer
+    {
+        auto lock = _releaseLock.Lock();
+
+        for (PacedFrame& pacedFrame : _pacedFrames)
         {
-            Windows::Foundation::TimeSpan systemRelativeTime;
-            systemRelativeTime.Duration = MFGetSystemTime();
-            outputFrame->RelativeTime = systemRelativeTime;
+            pacedFrame.Frame = nullptr;
         }
+        _pacedFrameHead = 0;
+        _pacedFrameCount = 0;
+        SetThreadpoolTimer(_releaseTimer, nullptr, 0, 0);
     }
-    else
+
+    WaitForThreadpoolTimerCallbacks(_releaseTimer, TRUE);
+}
+
+void SampleFrameProvider::ReleaseFrame(WDPP::PerceptionFrame^ frame)
+{
+    WDPP::PerceptionFrameProviderManagerService::PublishFrameForProvider(this, frame);
+
+    // Report how long the device was gone if this is the first frame since it was removed
+    const LONGLONG removalTime = InterlockedExchange64(&_removalTime, 0);
+    if (removalTime != 0)
     {
-        hr = E_FAIL;
+        TraceDiagnostic(L"SampleFrameProvider: first frame published %lld ms after the device was removed\n",
+            (MFGetSystemTime() - removalTime) / 10000);
     }
 
-    return (SUCCEEDED(hr) ? outputFrame : nullptr);
+    if (_frameSourceAttached)
+    {
+        ReportThroughput();
+    }
 }
 
 bool SampleFrameProvider::IsExposureCompensationSupported()
 {
     bool supported = false;
 
+    // Not supported until MediaCapture is initialized
+    if (_mediaCapture.Get() == nullptr) return false;
+
     try
     {
         WMD::ExposureCompensationControl^ exposureControl = _mediaCapture->VideoDeviceController->ExposureCompensationControl;
@@ -327,59 +910,292 @@ bool SampleFrameProvider::IsExposureCompensationSupported()
     return supported;
 }
 
-bool SampleFrameProvider::SetExposureCompensation(_Inout_ float& newValue)
+Concurrency::task<void> SampleFrameProvider::CompletePropertyRequestAsync(WDPP::PerceptionPropertyChangeRequest^ request, Concurrency::task<void> mediaCaptureReady)
 {
-    WMD::ExposureCompensationControl^ exposureControl = _mediaCapture->VideoDeviceController->ExposureCompensationControl;
-    bool successful = false;
+    // The local reference keeps the provider alive until the request is completed
+    SampleFrameProvider^ provider = this;
+    Windows::Foundation::Deferral^ deferral = request->GetDeferral();
+    WDP::PerceptionFrameSourcePropertyChangeStatus status;
 
-    // Catch any exceptions and return if set operation was succesful or not
     try
     {
-        if (newValue < exposureControl->Min)
+        const float requestedValue = safe_cast<float>(request->Value);
+
+        co_await mediaCaptureReady;
+        status = co_await provider->SetExposureCompensationAsync(requestedValue);
+    }
+    catch (Platform::Exception^)
+    {
+        status = WDP::PerceptionFrameSourcePropertyChangeStatus::ValueOutOfRange;
+    }
+
+    request->Status = status;
+    deferral->Complete();
+}
+
+Concurrency::task<WDP::PerceptionFrameSourcePropertyChangeStatus> SampleFrameProvider::SetExposureCompensationAsync(float requestedValue)
+{
+    SampleFrameProvider^ provider = this;
+    WMD::ExposureCompensationControl^ exposureControl = nullptr;
+    float newValue = requestedValue;
+
+    // Guards _mediaCapture against Suspend while the value is requested, but isn't held while the device applies it
+    {
+        auto lock = _pipelineLock.Lock();
+
+        if (!IsExposureCompensationSupported())
         {
-            newValue = exposureControl->Min;
+            co_return WDP::PerceptionFrameSourcePropertyChangeStatus::PropertyNotSupported;
         }
 
-        if (newValue > exposureControl->Max)
+        // Catch any exceptions and report the value as out of range if it can't be set
+        try
         {
-            newValue = exposureControl->Max;
+            exposureControl = _mediaCapture->VideoDeviceController->ExposureCompensationControl;
+
+            // Values outside the device's range are clamped and the applied value is reported in the Property
+            if (newValue < exposureControl->Min)
+            {
+                newValue = exposureControl->Min;
+            }
+
+            if (newValue > exposureControl->Max)
+            {
+                newValue = exposureControl->Max;
+            }
         }
+        catch (Platform::Exception^)
+        {
+            exposureControl = nullptr;
+        }
+    }
 
-        // Apply the new ExposureCompensation value to the device and wait for the result
-        auto setTask = Concurrency::create_task(exposureControl->SetValueAsync(newValue));
-        setTask.wait();
+    if (exposureControl == nullptr)
+    {
+        co_return WDP::PerceptionFrameSourcePropertyChangeStatus::ValueOutOfRange;
+    }
 
-        successful = true;
+    // Apply the new ExposureCompensation value to the device and update the Property once it's applied
+    bool applied = true;
+    try
+    {
+        co_await exposureControl->SetValueAsync(newValue);
+    }
+    catch (Platform::Exception^)
+    {
+        applied = false;
+    }
+
+    if (!applied)
+    {
+        co_return WDP::PerceptionFrameSourcePropertyChangeStatus::ValueOutOfRange;
     }
-    catch (Platform::Exception^) { ; }
 
-    return successful;
+    auto lock = provider->_pipelineLock.Lock();
+    provider->_properties->Insert(WDP::KnownPerceptionInfraredFrameSourceProperties::ExposureCompensation, newValue);
+    co_return WDP::PerceptionFrameSourcePropertyChangeStatus::Accepted;
 }
 
-void SampleFrameProvider::InitializeSourceVideoProperties()
+void SampleFrameProvider::InitializeAutoExposure()
 {
-    // Collect the key video properties from the MediaFoundaton source object
-    // VideoSourceDescription is a helper class to store the parameters
-    VideoSourceDescription^ videoProfile = CreateVideoDescriptionFromMediaSource();
+    if (!IsExposureCompensationSupported()) return;
 
-    // Initialize FrameAllocator object according to the video frame parameters acquired from MediaFoundation
-    _frameAllocator = ref new WDPP::PerceptionVideoFrameAllocator(
-        2, /*Num requested frames*/
-        videoProfile->BitmapPixelFormat,
-        videoProfile->PixelSize,
-        videoProfile->BitmapAlphaMode);
+    WMD::ExposureCompensationControl^ exposureControl = _mediaCapture->VideoDeviceController->ExposureCompensationControl;
 
-    // IFrameProvider objects are required to expose the current video profile data via their Properties
+    AutoExposureSettings settings = AutoExposureController::GetDefaultSettings();
+    settings.MinValue = exposureControl->Min;
+    settings.MaxValue = exposureControl->Max;
+    settings.Step = exposureControl->Step;
+    _autoExposure.Configure(settings, exposureControl->Value);
+
+    // The luminance of illuminated frames is measured while they're converted
+    _framePipeline.SetLuminanceStatistics(true);
+    _autoExposureEnabled = true;
+}
+
+void SampleFrameProvider::UpdateAutoExposure(const ProcessedFrame& processedFrame, MFTIME currentTime)
+{
+    // NOTE: Only called from PublishConvertedFrame, which handles one frame at a time
+    const LuminanceStatistics& statistics = _framePipeline.GetLuminanceStatistics();
+    _exposureLatency.OnFrame(processedFrame.Sequence, currentTime, statistics);
+
+    // Only one value is applied at a time and the frame path never waits for the device
+    if (_exposureUpdatePending != 0) return;
+
+    // Skip this frame rather than wait while the pipeline is reconfigured, e.g. the device is being removed
+    auto lock = _pipelineLock.TryLock();
+    if (!lock.IsLocked() || _suspended || _mediaCapture.Get() == nullptr) return;
+
+    if (!_autoExposureEnabled)
+    {
+        _framePipeline.SetLuminanceStatistics(false);
+        return;
+    }
+
+    const float previousValue = _autoExposure.GetCurrentValue();
+    float newValue;
+    if (!_autoExposure.Evaluate(statistics, currentTime, newValue)) return;
+
+    // Apply the value asynchronously; the controller's rate limit leaves the device time to apply it before
+    // its effect is measured
+    InterlockedExchange(&_exposureUpdatePending, 1);
+    try
+    {
+        WMD::ExposureCompensationControl^ exposureControl = _mediaCapture->VideoDeviceController->ExposureCompensationControl;
+        _exposureLatency.BeginChange(previousValue, newValue, processedFrame.Sequence, currentTime);
+        ApplyAutoExposureAsync(exposureControl, newValue);
+    }
+    catch (Platform::Exception^)
+    {
+        _autoExposure.Revert();
+        InterlockedExchange(&_exposureUpdatePending, 0);
+    }
+}
+
+Concurrency::task<void> SampleFrameProvider::ApplyAutoExposureAsync(WMD::ExposureCompensationControl^ exposureControl, float newValue)
+{
+    // NOTE: Runs on the publishing thread until the device takes the value, the frame path never waits for it
+    SampleFrameProvider^ provider = this;
+    bool applied = true;
+
+    try
+    {
+        co_await exposureControl->SetValueAsync(newValue);
+    }
+    catch (Platform::Exception^)
+    {
+        applied = false;
+    }
+
+    // The controller only tracks values the device accepted; like a requested value, an applied value is
+    // reported in the Property, unless a request turned automatic exposure off in the meantime
+    {
+        auto lock = provider->_pipelineLock.Lock();
+        if (applied)
+        {
+            provider->_autoExposure.Commit();
+            if (provider->_autoExposureEnabled)
+            {
+                provider->_properties->Insert(WDP::KnownPerceptionInfraredFrameSourceProperties::ExposureCompensation, newValue);
+            }
+        }
+        else
+        {
+            provider->_autoExposure.Revert();
+        }
+    }
+
+    InterlockedExchange(&provider->_exposureUpdatePending, 0);
+}
+
+Concurrency::task<void> SampleFrameProvider::InitializeMediaCaptureAsync(Platform::String^ targetDeviceId)
+{
+    // Initialization takes a while and only the exposure control depends on it, so no thread waits for it; the
+    // local reference keeps the provider alive until it's done
+    // NOTE: Called with _pipelineLock held or from the constructor; the lock isn't held once the coroutine suspends
+    SampleFrameProvider^ provider = this;
+    const UINT32 initialization = ++_mediaCaptureInitializations;
+    WMC::MediaCapture^ mediaCapture = nullptr;
+    HRESULT hr = S_OK;
+
+    try
+    {
+        // NOTE: We are not using MediaCapture to stream frames (using MediaFoundation's IMFSourceReader)
+        // but in order to access extended camera properties, e.g. ExposureCompensation, we must utilize
+        // VideoDeviceController, which is only obtained through a MediaCapture instance
+        WMC::MediaCaptureInitializationSettings^ initSettings = ref new WMC::MediaCaptureInitializationSettings();
+        mediaCapture = ref new WMC::MediaCapture();
+
+        // Connect MediaCapture to the same device in MediaFoundation initialization
+        initSettings->VideoDeviceId = targetDeviceId;
+        initSettings->StreamingCaptureMode = WMC::StreamingCaptureMode::Video;
+
+        co_await mediaCapture->InitializeAsync(initSettings);
+    }
+    catch (Platform::Exception^ ex)
+    {
+        hr = ex->HResult;
+    }
+
+    if (FAILED(hr))
+    {
+        TraceDiagnostic(L"SampleFrameProvider: MediaCapture failed to initialize, hr = 0x%08X\n", hr);
+        co_return;
+    }
+
+    provider->OnMediaCaptureInitialized(mediaCapture, initialization);
+}
+
+void SampleFrameProvider::OnMediaCaptureInitialized(WMC::MediaCapture^ mediaCapture, UINT32 initialization)
+{
+    auto lock = _pipelineLock.Lock();
+
+    // The device was removed or reopened since this initialization was started
+    if (_suspended || initialization != _mediaCaptureInitializations) return;
+
+    _mediaCapture = mediaCapture;
+    UpdateExposureCompensationProperty();
+
+    if (_autoExposureRequested)
+    {
+        _autoExposureRequested = false;
+        InitializeAutoExposure();
+    }
+}
+
+void SampleFrameProvider::UpdateExposureCompensationProperty()
+{
+    if (!IsExposureCompensationSupported()) return;
+
+    // Set the ExposureCompensation property according to the current state of the device
+    try
+    {
+        _properties->Insert(
+            WDP::KnownPerceptionInfraredFrameSourceProperties::ExposureCompensation,
+            _mediaCapture->VideoDeviceController->ExposureCompensationControl->Value);
+    }
+    catch (Platform::Exception^) { ; }
+}
+
+void SampleFrameProvider::InitializeSourceVideoProperties()
+{
+    // Collect the video profiles found by the MediaFoundation wrapper
+    // NOTE: The device's profiles are ranked best first and the selected profile is the one used for streaming
+    MediaDeviceCapabilities capabilities = _mediaWrapper.GetCapabilities();
+    if (capabilities.Profiles.empty())
+    {
+        ThrowIfFailed(E_NOT_VALID_STATE, L"Source media doesn't provide a compatible video profile");
+    }
+
+    // Set up the conversion kernel and frame allocator and publish the VideoProfile property
     // We must set at least 1 video profile for the VideoProfile, SupportedVideoProfiles and AvailableVideoProfiles properties
-    _properties->Insert(
-        WDP::KnownPerceptionVideoFrameSourceProperties::VideoProfile,
-        videoProfile->AsPropertySet());
-    
+    ConfigureFramePipeline(capabilities.Profiles[capabilities.SelectedProfileIndex]);
+
     // Note that the Value for SupportedVideoProfiles and AvailableVideoProfiles is a Vector of IPropertySets since
-    // a single IFrameProvider can support multiple video modes. 
-    // However, in this implementation we only support a single profile
+    // a single IFrameProvider can support multiple video modes.
+    // List the highest ranked profiles in order; different source formats may produce the same Gray8 profile
+    // in which case only the best of them is listed
     auto supportedVideoProfiles = ref new Platform::Collections::Vector<WFC::IPropertySet^>();
-    supportedVideoProfiles->Append(videoProfile->AsPropertySet());
+    std::vector<VideoSourceDescription^> listedProfiles;
+
+    for (const MediaProfileDescriptor& profile : capabilities.Profiles)
+    {
+        if (listedProfiles.size() >= _maxListedVideoProfiles) break;
+
+        VideoSourceDescription^ description = CreateVideoDescriptionFromProfile(profile);
+
+        bool alreadyListed = false;
+        for (VideoSourceDescription^ listedProfile : listedProfiles)
+        {
+            alreadyListed = alreadyListed || listedProfile->IsSameVideoMode(description);
+        }
+
+        if (!alreadyListed)
+        {
+            listedProfiles.push_back(description);
+            supportedVideoProfiles->Append(description->AsPropertySet());
+        }
+    }
 
     // Use this property to list all supported VideoProfiles supported by this Provider
     _properties->Insert(
@@ -387,7 +1203,7 @@ void SampleFrameProvider::InitializeSourceVideoProperties()
         supportedVideoProfiles->GetView());
 
     // Use this property to specify the set of VideoProfiles currently available at this time.
-    // Again, since this implementation only support a single Profile, this value is the same as SupportedVideoProfiles
+    // Every listed profile can be streamed by this device at any time, so this value is the same as SupportedVideoProfiles
     _properties->Insert(
         WDP::KnownPerceptionVideoFrameSourceProperties::AvailableVideoProfiles,
         supportedVideoProfiles->GetView());
@@ -403,14 +1219,9 @@ void SampleFrameProvider::InitializeSourceVideoProperties()
         WDP::KnownPerceptionFrameSourceProperties::PhysicalDeviceIds,
         providerIds->GetView());
 
-    // Set the ExposureCompensation property according to the current state of the device
-    WMD::ExposureCompensationControl^ exposureControl = _mediaCapture->VideoDeviceController->ExposureCompensationControl;
-    if (exposureControl->Supported)
-    {
-        _properties->Insert(
-            WDP::KnownPerceptionInfraredFrameSourceProperties::ExposureCompensation,
-            exposureControl->Value);
-    }
+    // Set the ExposureCompensation property according to the current state of the device, if MediaCapture is
+    // initialized already; otherwise it's set once it is
+    UpdateExposureCompensationProperty();
 
     // Set IsMirrored property according to the current state of the device
     // This property is also set to each individual PerceptionFrames PropertySet 
@@ -489,18 +1300,201 @@ void SampleFrameProvider::InitializeSourceVideoProperties()
     //
 }
 
+void SampleFrameProvider::InitializeFrameReplay(_In_ LPCWSTR replayPath, bool pacedReplay)
+{
+    // The recording is replayed in a loop so the provider keeps streaming for as long as it's started
+    auto replaySource = std::make_shared<FrameReplaySource>();
+    if (!replaySource->Open(replayPath, pacedReplay ? ReplayPacing::Original : ReplayPacing::FlatOut, true))
+    {
+        TraceDiagnostic(L"SampleFrameProvider: can't replay %s, using the device's frames\n", replayPath);
+        return;
+    }
+
+    FrameLayout layout;
+    if (!replaySource->GetFrameLayout(layout))
+    {
+        TraceDiagnostic(L"SampleFrameProvider: %s doesn't hold any frames, using the device's frames\n", replayPath);
+        return;
+    }
+
+    // The frame rate is derived from the recorded timestamps
+    AttachFrameSource(replaySource, layout, replaySource->GetAverageFrameInterval());
+
+    TraceDiagnostic(L"SampleFrameProvider: replaying %Iu frames of %ux%u from %s\n",
+        replaySource->GetFrameCount(), layout.Width, layout.Height, replayPath);
+}
+
+void SampleFrameProvider::InitializeSyntheticFrames()
+{
+    SyntheticFrameSettings settings;
+    settings.Format = static_cast<FramePixelFormat>(ReadProviderSetting(SyntheticFormatValue, static_cast<DWORD>(FramePixelFormat::YUY2)));
+    settings.Width = ReadProviderSetting(SyntheticWidthValue, _targetFrameWidth);
+    settings.Height = ReadProviderSetting(SyntheticHeightValue, _targetFrameHeight);
+    settings.FrameRate = ReadProviderSetting(SyntheticFrameRateValue, _targetFrameRate);
+    settings.Paced = ReadProviderSetting(SyntheticPacedValue, 1) != 0;
+    settings.AlternateIllumination = true;
+
+    auto syntheticSource = std::make_shared<SyntheticFrameSource>();
+    if (!syntheticSource->Open(settings))
+    {
+        TraceDiagnostic(L"SampleFrameProvider: invalid synthetic frame settings, using the device's frames\n");
+        return;
+    }
+
+    AttachFrameSource(syntheticSource, syntheticSource->GetFrameLayout(), 10000000 / settings.FrameRate);
+
+    TraceDiagnostic(L"SampleFrameProvider: generating %ux%u frames of format %u at %u fps%s\n",
+        settings.Width, settings.Height, static_cast<UINT32>(settings.Format), settings.FrameRate,
+        settings.Paced ? L"" : L" (unpaced)");
+}
+
+void SampleFrameProvider::AttachFrameSource(const std::shared_ptr<IFrameSource>& frameSource, const FrameLayout& layout, INT64 frameInterval)
+{
+    // Describe the source's frames as a media profile
+    MediaProfileDescriptor sourceProfile = {};
+    sourceProfile.Subtype = MediaDeviceManager::GetMediaSubtype(layout.Format);
+    sourceProfile.Width = layout.Width;
+    sourceProfile.Height = layout.Height;
+    sourceProfile.FrameRateNumerator = (frameInterval > 0) ? 10000000 : _targetFrameRate;
+    sourceProfile.FrameRateDenominator = (frameInterval > 0) ? static_cast<UINT32>((std::min)(frameInterval, static_cast<INT64>(MAXUINT32))) : 1;
+    sourceProfile.PixelAspectNumerator = 1;
+    sourceProfile.PixelAspectDenominator = 1;
+
+    VideoSourceDescription^ videoProfile = ConfigureFramePipeline(sourceProfile);
+
+    // The source's profile is the only one this provider can stream
+    auto supportedVideoProfiles = ref new Platform::Collections::Vector<WFC::IPropertySet^>();
+    supportedVideoProfiles->Append(videoProfile->AsPropertySet());
+
+    _properties->Insert(
+        WDP::KnownPerceptionVideoFrameSourceProperties::SupportedVideoProfiles,
+        supportedVideoProfiles->GetView());
+    _properties->Insert(
+        WDP::KnownPerceptionVideoFrameSourceProperties::AvailableVideoProfiles,
+        supportedVideoProfiles->GetView());
+
+    ThrowIfFailed(_mediaWrapper.SetFrameSource(frameSource), L"Failed to set the frame source");
+    _frameSourceAttached = true;
+}
+
+void SampleFrameProvider::ReportFrameTiming(MFTIME currentTime)
+{
+    // NOTE: Only called from PublishConvertedFrame, which handles one frame at a time
+    if (_timingReportTime == 0)
+    {
+        _timingReportTime = currentTime;
+    }
+
+    if (currentTime - _timingReportTime >= _timingReportInterval)
+    {
+        const FramePacerStats stats = _framePacer.TakeStats();
+        const PairingStats pairingStats = _illuminationPairer.GetStats();
+
+        TraceDiagnostic(L"SampleFrameProvider: frame interval %.2f ms, jitter on arrival %.3f ms (max %.2f ms), paced %.3f ms (max %.2f ms), %llu resyncs\n",
+            stats.Paced.MeanInterval / 10000.0,
+            stats.Arrival.StandardDeviation / 10000.0,
+            stats.Arrival.MaxDeviation / 10000.0,
+            stats.Paced.StandardDeviation / 10000.0,
+            stats.Paced.MaxDeviation / 10000.0,
+            stats.Resyncs);
+
+        TraceDiagnostic(L"SampleFrameProvider: device clock offset %lld ms, drift %.1f ppm from %u observations, %llu clock resets\n",
+            stats.Clock.Offset / 10000,
+            stats.Clock.DriftPpm,
+            stats.Clock.Samples,
+            stats.Clock.Resets);
+
+        if (_framePipeline.GetLuminanceStatistics().Pixels != 0)
+        {
+            TraceDiagnostic(L"SampleFrameProvider: auto exposure %.2f EV after %llu updates, median luminance %u, %.1f%% saturated\n",
+                _autoExposure.GetCurrentValue(),
+                _autoExposure.GetUpdates(),
+                static_cast<UINT32>(_framePipeline.GetLuminanceStatistics().GetPercentile(0.5)),
+                100.0 * _framePipeline.GetLuminanceStatistics().Saturated / _framePipeline.GetLuminanceStatistics().Pixels);
+
+            const ExposureLatencyStats latencyStats = _exposureLatency.GetStats();
+            const LatencyHistogram& timeLatency = _exposureLatency.GetTimeLatency();
+            TraceDiagnostic(L"SampleFrameProvider: exposure changes seen after %u frames (%.1f ms) median, %u frames (%.1f ms) 95th percentile; %llu of %llu seen, %llu timed out, %llu superseded\n",
+                _exposureLatency.GetFramePercentile(50.0),
+                timeLatency.GetPercentile(50.0) / 10000.0,
+                _exposureLatency.GetFramePercentile(95.0),
+                timeLatency.GetPercentile(95.0) / 10000.0,
+                latencyStats.Observed,
+                latencyStats.Changes,
+                latencyStats.TimedOut,
+                latencyStats.Superseded);
+        }
+
+        if (IsIlluminationInterleaved())
+        {
+            TraceDiagnostic(L"SampleFrameProvider: %llu illumination pairs published, %llu frames dropped without a partner; inferred illumination phase %s, %llu rephases\n",
+                pairingStats.PairsPublished,
+                pairingStats.OrphansDropped,
+                _framePipeline.GetIlluminationDetector().IsLocked() ? L"locked" : L"not locked",
+                _framePipeline.GetIlluminationDetector().GetRephases());
+        }
+
+        _timingReportTime = currentTime;
+    }
+}
+
+void SampleFrameProvider::ReportThroughput()
+{
+    // NOTE: Only called from PublishConvertedFrame, which handles one frame at a time
+    const MFTIME currentTime = MFGetSystemTime();
+    if (_throughputWindowStart == 0)
+    {
+        _throughputWindowStart = currentTime;
+    }
+
+    _publishedFrames++;
+
+    const MFTIME elapsedTime = currentTime - _throughputWindowStart;
+    if (elapsedTime >= _throughputReportInterval)
+    {
+        TraceDiagnostic(L"SampleFrameProvider: published %.1f frames per second\n",
+            static_cast<double>(_publishedFrames) * 1.0e7 / static_cast<double>(elapsedTime));
+
+        _publishedFrames = 0;
+        _throughputWindowStart = currentTime;
+    }
+}
+
+void SampleFrameProvider::InitializeFrameRecording(_In_ LPCWSTR recordingDirectory)
+{
+    // Slots must fit a frame of any profile the service may switch to
+    MediaDeviceCapabilities capabilities = _mediaWrapper.GetCapabilities();
+    UINT32 maxFrameLength = 0;
+
+    for (const MediaProfileDescriptor& profile : capabilities.Profiles)
+    {
+        const FrameLayout layout = GetPackedFrameLayout(MediaDeviceManager::GetFramePixelFormat(profile.Subtype), profile.Width, profile.Height);
+        maxFrameLength = (std::max)(maxFrameLength, GetFrameLength(layout));
+    }
+
+    // Every provider instance writes its own file
+    WCHAR recordingPath[MAX_PATH];
+    _snwprintf_s(recordingPath, _countof(recordingPath), _TRUNCATE, L"%s\\SampleFrameProvider_%lld.frames", recordingDirectory, MFGetSystemTime());
+
+    // The file is written by the recorder's own thread, disk writes may block for long and don't belong on the executor
+    auto frameRecorder = std::make_shared<FrameRecorder>();
+    if (!frameRecorder->Open(recordingPath, maxFrameLength, _recorderSlotCount))
+    {
+        TraceDiagnostic(L"SampleFrameProvider: can't record to %s\n", recordingPath);
+        return;
+    }
+
+    ThrowIfFailed(_mediaWrapper.SetFrameRecorder(frameRecorder), L"Failed to set the frame recorder");
+
+    TraceDiagnostic(L"SampleFrameProvider: recording frames to %s\n", recordingPath);
+}
+
 void SampleFrameProvider::UpdateSourceVideoProperties()
 {
     // Update the PropertySet for device properties that may have changed since Provider was initialized
 
     // Update the ExposureCompensation property with the current device state
-    WMD::ExposureCompensationControl^ exposureControl = _mediaCapture->VideoDeviceController->ExposureCompensationControl;
-    if (exposureControl->Supported)
-    {
-        _properties->Insert(
-            WDP::KnownPerceptionInfraredFrameSourceProperties::ExposureCompensation,
-            exposureControl->Value);
-    }
+    UpdateExposureCompensationProperty();
 
     // Refresh the IsMirrored Property 
     _properties->Insert(
@@ -30,11 +30,63 @@ enum class SensorIRIlluminationTypes
     ContinuousIllumination_CleanIR,
 };
 
+// Hands the frames ParallelFramePipeline delivers to its ParallelFrameReadyProc to the coroutine awaiting them
+// NOTE: The pipeline never delivers frames concurrently and the coroutine awaits the next frame before Deliver returns
+class ConvertedFrameChannel
+{
+public:
+
+    class Awaiter
+    {
+    public:
+
+        explicit Awaiter(ConvertedFrameChannel& channel) : _channel(channel) {}
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::experimental::coroutine_handle<> consumer) { _channel._consumer = consumer; }
+        ParallelFrame await_resume() const { return _channel._frame; }
+
+    private:
+
+        ConvertedFrameChannel& _channel;
+    };
+
+    ConvertedFrameChannel() : _consumer(nullptr), _frame() {}
+    ~ConvertedFrameChannel() { if (_consumer) _consumer.destroy(); }
+
+    // Resumes the consumer with the frame on the calling thread; returns false if no coroutine awaits a frame
+    bool Deliver(const ParallelFrame& frame)
+    {
+        std::experimental::coroutine_handle<> consumer = _consumer;
+        if (!consumer) return false;
+
+        _consumer = nullptr;
+        _frame = frame;
+        consumer.resume();
+        return true;
+    }
+
+    Awaiter NextFrameAsync() { return Awaiter(*this); }
+
+private:
+
+    std::experimental::coroutine_handle<> _consumer;
+    ParallelFrame _frame;
+};
+
 ref class SampleFrameProvider : public WDPP::IPerceptionFrameProvider
 {
 internal:
 
-    SampleFrameProvider(Platform::String^ targetDeviceId);
+    // The executor is shared by every provider of the manager and converts the provider's frames
+    SampleFrameProvider(Platform::String^ targetDeviceId, const std::shared_ptr<WorkStealingExecutor>& executor);
+
+    // Selects the processor the provider's frames are read and converted on, see MediaFoundationWrapper::SetWorkerAffinity
+    void SetWorkerAffinity(UINT32 workerSlot) { _mediaWrapper.SetWorkerAffinity(workerSlot); }
+
+    // Releases the device but keeps the frame pool, conversion kernel and capabilities, see SampleFrameProviderManager::ParkProvider
+    void Suspend();
+    bool Resume(Platform::String^ targetDeviceId);
 
     // Specify the IR illumination type for this provider's sensor; change if type doesn't match your device
     // This type dictates the Properties set by the provider
@@ -58,25 +110,128 @@ internal:
 
     static const bool _requiredKsSensorDevice = false; // If set limits enumeration to devices with KSCATEGORY_SENSOR_CAMERA attribute
 
+    // TODO: Adjust the target video mode to your sensor; the device's media types are ranked by how closely they
+    // match these values and by the cost of converting them, and the best one is selected (see MediaDeviceManager)
+    static const UINT32 _targetFrameWidth = 640;
+    static const UINT32 _targetFrameHeight = 480;
+    static const UINT32 _targetFrameRate = 30;
+    static const UINT32 _maxListedVideoProfiles = 4;  // Limits the number of profiles listed in SupportedVideoProfiles
+    static const UINT32 _recorderSlotCount = 8;       // Frames buffered in memory while the recording is written to disk
+    static const MFTIME _throughputReportInterval = 50000000;  // Throughput of a frame source is traced every 5 seconds
+    static const UINT32 _conversionWorkers = 2;       // Frames converted at once on the executor, see ParallelFramePipeline
+    static const UINT32 _conversionSlots = _conversionWorkers + ParallelFramePipeline::ReorderSlots;
+    static const UINT32 _allocatedFrameCount = _conversionSlots + 2;  // One per slot, one held back waiting for its partner (see IlluminationPairer) and one being delivered
+    static const size_t _frameBufferCacheSize = _allocatedFrameCount;     // Never references more frames than _frameAllocator has
+    static const MFTIME _pacedReleaseLatency = 50000;  // Frames are released 5 ms after their presentation time if PacedDelivery is set
+    static const MFTIME _timingReportInterval = 100000000;  // Frame jitter is traced every 10 seconds
+
 private:
 
     // Internal methods
-    WDPP::PerceptionFrame^ CopyMediaSampleToPerceptionFrame();
-    VideoSourceDescription^ CreateVideoDescriptionFromMediaSource();
+    Concurrency::task<void> CaptureFramesAsync();
+    Concurrency::task<void> PublishFramesAsync();
+    void SubmitCapturedFrame();
+    static void OnFrameConverted(void* context, const ParallelFrame& frame);
+    void DeliverConvertedFrame(const ParallelFrame& frame);
+    static void OnFrameInputReleased(void* context, uint32_t slot);
+    void PublishConvertedFrame(const ParallelFrame& frame);
+    void StopFrameConversion();
+    HRESULT StartReadingFrames();
+    void PublishPairedFrame(WDPP::PerceptionFrame^ frame, const ProcessedFrame& processedFrame);
+    void PublishFrame(WDPP::PerceptionFrame^ frame);
+    void ReleaseFrame(WDPP::PerceptionFrame^ frame);
+    static VOID CALLBACK OnReleaseTimer(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer);
+    void ReleaseDueFrames();
+    void ScheduleRelease(MFTIME releaseTime);
+    void DropPacedFrames();
+    bool IsIlluminationInterleaved() const { return _sensorIRIllumination != SensorIRIlluminationTypes::ContinuousIllumination_CleanIR; }
+    VideoSourceDescription^ CreateVideoDescriptionFromProfile(const MediaProfileDescriptor& profile);
+    VideoSourceDescription^ ConfigureFramePipeline(const MediaProfileDescriptor& profile);
+    WDP::PerceptionFrameSourcePropertyChangeStatus ApplyVideoProfile(VideoSourceDescription^ requestedProfile);
     bool IsExposureCompensationSupported();
-    bool SetExposureCompensation(_Inout_ float& newValue);
+    Concurrency::task<WDP::PerceptionFrameSourcePropertyChangeStatus> SetExposureCompensationAsync(float requestedValue);
+    Concurrency::task<void> CompletePropertyRequestAsync(WDPP::PerceptionPropertyChangeRequest^ request, Concurrency::task<void> mediaCaptureReady);
+    Concurrency::task<void> ApplyAutoExposureAsync(WMD::ExposureCompensationControl^ exposureControl, float newValue);
+    Concurrency::task<void> InitializeMediaCaptureAsync(Platform::String^ targetDeviceId);
+    void OnMediaCaptureInitialized(WMC::MediaCapture^ mediaCapture, UINT32 initialization);
+    void UpdateExposureCompensationProperty();
     void InitializeSourceVideoProperties();
+    void InitializeFrameReplay(_In_ LPCWSTR replayPath, bool pacedReplay);
+    void InitializeSyntheticFrames();
+    void AttachFrameSource(const std::shared_ptr<IFrameSource>& frameSource, const FrameLayout& layout, INT64 frameInterval);
+    void ReportThroughput();
+    void ReportFrameTiming(MFTIME currentTime);
+    void InitializeAutoExposure();
+    void UpdateAutoExposure(const ProcessedFrame& processedFrame, MFTIME currentTime);
+    void InitializeFrameRecording(_In_ LPCWSTR recordingDirectory);
     void UpdateSourceVideoProperties();
     
     // Class fields
     MediaFoundationWrapper _mediaWrapper;
-    EventRegistrationToken _readFrameCallbackToken;
     EventRegistrationToken _availablityChangedCallbackToken;
 
     WFC::IPropertySet^ _properties;
     WDPP::PerceptionFrameProviderInfo^ _providerInfo;
     WDPP::PerceptionVideoFrameAllocator^ _frameAllocator;
     Platform::Agile<WMC::MediaCapture> _mediaCapture;
+
+    FramePipeline _framePipeline;           // Converts captured frames, shared with HeadlessFrameProvider
+    MemoryBufferByteAccessCache<_frameBufferCacheSize> _frameBufferCache;
+    std::shared_ptr<WorkStealingExecutor> _executor;
+    ParallelFramePipeline _parallelPipeline;    // Converts several frames at once and hands them back in capture order
+    std::array<WDPP::PerceptionFrame^, _conversionSlots> _convertingFrames;    // The frame each slot of _parallelPipeline converts into
+    std::array<LockedFrameSample, _conversionSlots> _convertingSamples;       // The device sample each slot converts from
+    ConvertedFrameChannel _convertedFrames;     // Hands the converted frames to PublishFramesAsync
+    volatile LONG _streamStarts;            // Counts StartReadingFrames calls, frames read before the latest one are dropped
+    LONG _conversionStreamStarts;           // _streamStarts when _parallelPipeline was started, only used on the frame reading thread
+
+    // Property keys and values set on every frame, created once so publishing a frame doesn't allocate them
+    Platform::String^ _activeIlluminationEnabledKey;
+    Platform::String^ _isMirroredKey;
+    Platform::Object^ _trueValue;
+    Platform::Object^ _falseValue;
+    MediaProfileDescriptor _activeProfile;
+    WRLW::CriticalSection _pipelineLock;    // Serializes Start, Stop, video profile changes, Suspend and Resume
+
+    // MediaCapture initializes asynchronously; _mediaCapture stays null until it's done, see InitializeMediaCaptureAsync
+    Concurrency::task<void> _mediaCaptureReady;     // Completes once the latest initialization finished or failed
+    UINT32 _mediaCaptureInitializations;            // Identifies the latest initialization, earlier ones are ignored
+
+    bool _frameSourceAttached;              // Frames are replayed or generated instead of read from the device
+    UINT64 _publishedFrames;                // Frames published since _throughputWindowStart, see ReportThroughput
+    MFTIME _throughputWindowStart;
+
+    FramePacer _framePacer;                 // Derives each frame's RelativeTime from the device timestamp
+    bool _releaseAtCadence;                 // Publish frames at the device's cadence rather than as soon as they're converted
+
+    // A frame waiting in _pacedFrames until it's due
+    struct PacedFrame
+    {
+        WDPP::PerceptionFrame^ Frame;
+        MFTIME ReleaseTime;                 // MFGetSystemTime when the frame is published
+    };
+
+    // Frames are held here rather than on the converting thread, which must not block, if _releaseAtCadence is set
+    // NOTE: Every held frame comes from _frameAllocator, so the ring can't overflow
+    PTP_TIMER _releaseTimer;                // Publishes the frames that are due, armed for the oldest one
+    WRLW::CriticalSection _releaseLock;     // Guards the fields below
+    std::array<PacedFrame, _allocatedFrameCount> _pacedFrames;     // Ring of frames in capture order
+    UINT32 _pacedFrameHead;
+    UINT32 _pacedFrameCount;
+    bool _releasing;                        // OnReleaseTimer is publishing frames and rearms the timer once it's done
+    MFTIME _timingReportTime;
+
+    IlluminationPairer _illuminationPairer; // Keeps the lit and unlit frames of interleaved sensors in sequence
+    WDPP::PerceptionFrame^ _pendingPairFrame;   // Illuminated frame waiting for its unilluminated partner
+
+    AutoExposureController _autoExposure;   // Only used while a converted frame is published, see PublishConvertedFrame
+    bool _autoExposureEnabled;              // Guarded by _pipelineLock, cleared by explicit ExposureCompensation requests
+    bool _autoExposureRequested;            // Guarded by _pipelineLock, enables _autoExposure once MediaCapture is initialized
+    volatile LONG _exposureUpdatePending;   // Set while the device applies a value chosen by _autoExposure
+    ExposureLatencyTracker _exposureLatency;    // Frames until a value chosen by _autoExposure shows in the frames
+    bool _suspended;
+    bool _resumeStreaming;                  // Streaming state to restore on Resume, tracks Start/Stop calls made while suspended
+    volatile LONGLONG _removalTime;         // MFGetSystemTime when the device was removed, cleared by the first frame after Resume
 };
 
 } // end namespace
\ No newline at end of file
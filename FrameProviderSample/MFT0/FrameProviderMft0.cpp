@@ -16,8 +16,50 @@
 #include "SampleHelpers.h"
 #include <WinString.h>
 
+// Settings share the key of the frame provider's settings
+static const WCHAR Mft0SettingsKey[] = L"Software\\Microsoft\\Analog\\Providers\\MediaFoundation";
+static const WCHAR AsyncProcessingValue[] = L"Mft0AsyncProcessing";
+static const WCHAR Gray8OutputValue[] = L"Mft0Gray8Output";
+static const WCHAR FrameStatisticsValue[] = L"Mft0FrameStatistics";
+
+static DWORD ReadMft0Setting(_In_ LPCWSTR pszValueName, DWORD dwDefaultValue)
+{
+    DWORD dwValue = 0;
+    DWORD cbValue = sizeof(dwValue);
+
+    if (RegGetValueW(HKEY_LOCAL_MACHINE, Mft0SettingsKey, pszValueName, RRF_RT_REG_DWORD, NULL, &dwValue, &cbValue) != ERROR_SUCCESS)
+    {
+        dwValue = dwDefaultValue;
+    }
+    return dwValue;
+}
+
 // CFrameProviderMft0
 
+HRESULT CFrameProviderMft0::FinalConstruct()
+{
+    HRESULT hr = S_OK;
+
+    do {
+        // In asynchronous mode the MFT holds several samples and asks for input with events, so the capture
+        // pipeline can deliver the next frame while earlier frames are still being tagged
+        m_bAsync = (ReadMft0Setting(AsyncProcessingValue, 0) != 0);
+
+        // L8 output types let the camera pipeline hand only the luma plane to the frame provider's process
+        m_bOfferGray8 = (ReadMft0Setting(Gray8OutputValue, 0) != 0);
+
+        // Statistics let the frame provider judge the exposure of a frame without reading its pixels again
+        m_bMeasureFrames = (ReadMft0Setting(FrameStatisticsValue, 0) != 0);
+        if (m_bAsync)
+        {
+            m_uiQueueCapacity = MFT0_ASYNC_QUEUE_CAPACITY;
+            CHK_LOG_BRK(MFCreateEventQueue(&m_pEventQueue));
+        }
+    } while (FALSE);
+
+    return hr;
+}
+
 STDMETHODIMP CFrameProviderMft0::GetIids(
     /* [out] */ _Out_ ULONG *iidCount,
     /* [size_is][size_is][out] */ _Outptr_result_buffer_maybenull_(*iidCount) IID **iids)
@@ -188,7 +230,7 @@ STDMETHODIMP CFrameProviderMft0::GetAttributes(
         CHK_NULL_PTR_BRK(ppAttributes);
         if(!m_pGlobalAttributes) {
             CHK_LOG_BRK(MFCreateAttributes(&m_pGlobalAttributes, 3));
-            CHK_LOG_BRK(m_pGlobalAttributes->SetUINT32(MF_TRANSFORM_ASYNC, FALSE));
+            CHK_LOG_BRK(m_pGlobalAttributes->SetUINT32(MF_TRANSFORM_ASYNC, m_bAsync));
             CHK_LOG_BRK(m_pGlobalAttributes->SetString(MFT_ENUM_HARDWARE_URL_Attribute, L"Sample_CameraExtensionMft"));
             CHK_LOG_BRK(m_pGlobalAttributes->SetUINT32(MFT_SUPPORT_DYNAMIC_FORMAT_CHANGE, TRUE));
         }
@@ -354,7 +396,7 @@ STDMETHODIMP CFrameProviderMft0::GetOutputAvailableType(
             CHK_LOG_BRK(GenerateMFMediaTypeListFromDevice(dwOutputStreamID));
         }
 
-        CHK_LOG_BRK(GetMediaType(dwOutputStreamID, dwTypeIndex, ppType));
+        CHK_LOG_BRK(GetMediaType(dwOutputStreamID, dwTypeIndex, ppType, TRUE));
     } while (FALSE);
     
     LeaveCriticalSection(&m_critSec);
@@ -377,13 +419,19 @@ STDMETHODIMP CFrameProviderMft0::SetInputType(
     do {
         if(bReallySet) {
             CComPtr<IMFMediaType> pFullType;
-            CHK_LOG_BRK(IsMediaTypeSupported(dwInputStreamID, pType, &pFullType));
+            CHK_LOG_BRK(IsMediaTypeSupported(dwInputStreamID, pType, &pFullType, &m_inputTypeEntry));
             SAFERELEASE(m_pInputType);
-            SAFERELEASE(m_pOutputType);
-            m_pOutputType = pFullType;
-            m_pOutputType->AddRef();
             m_pInputType = pFullType;
             m_pInputType->AddRef();
+
+            // The output type is the input type unless it's the L8 type converted from it
+            if(m_pOutputType == NULL || m_outputTypeEntry.dwSourceIndex != m_inputTypeEntry.dwIndex) {
+                SAFERELEASE(m_pOutputType);
+                m_pOutputType = pFullType;
+                m_pOutputType->AddRef();
+                m_outputTypeEntry = m_inputTypeEntry;
+            }
+            CHK_LOG_BRK(SelectProcessing());
         } else {
             CHK_LOG_BRK(IsMediaTypeSupported(dwInputStreamID, pType));
         }
@@ -400,10 +448,38 @@ STDMETHODIMP CFrameProviderMft0::SetOutputType(
 {
     HRESULT hr = S_OK;
 
+    EnterCriticalSection(&m_critSec);
+
+    BOOL bReallySet = ((dwFlags & MFT_SET_TYPE_TEST_ONLY) == 0);
     do {
-        CHK_LOG_BRK(SetInputType(dwOutputStreamID, pType, dwFlags));
+        CComPtr<IMFMediaType> pFullType;
+        MediaTypeCatalogEntry entry;
+        CHK_LOG_BRK(IsMediaTypeSupported(dwOutputStreamID, pType, &pFullType, &entry, TRUE));
+
+        // Device types are passed through, so the input type is set to the same type
+        if(entry.dwSourceIndex == entry.dwIndex) {
+            if(bReallySet) {
+                SAFERELEASE(m_pOutputType);
+            }
+            CHK_LOG_BRK(SetInputType(dwOutputStreamID, pType, dwFlags));
+            break;
+        }
+        if(!bReallySet) {
+            break;
+        }
+
+        // L8 types are converted from the device type they were created for
+        if(m_pInputType == NULL || m_inputTypeEntry.dwIndex != entry.dwSourceIndex) {
+            CHK_LOG_BRK(SetInputType(dwOutputStreamID, m_listOfMediaTypes[entry.dwSourceIndex], dwFlags));
+        }
+        SAFERELEASE(m_pOutputType);
+        m_pOutputType = pFullType;
+        m_pOutputType->AddRef();
+        m_outputTypeEntry = entry;
+        CHK_LOG_BRK(SelectProcessing());
     } while (FALSE);
 
+    LeaveCriticalSection(&m_critSec);
     return hr;
 }
 
@@ -483,9 +559,9 @@ STDMETHODIMP CFrameProviderMft0::GetInputStatus(
             CHK_LOG_BRK(MF_E_INVALIDSTREAMNUMBER);
         }
 
-        // If we already have an input sample, we don't accept
-        // another one until the client calls ProcessOutput or Flush.
-        if (m_pSample == NULL)
+        // If our queue is full, we don't accept another sample
+        // until the client calls ProcessOutput or Flush.
+        if (CanAcceptInput())
         {
             *pdwFlags = MFT_INPUT_STATUS_ACCEPT_DATA;
         }
@@ -509,8 +585,8 @@ STDMETHODIMP CFrameProviderMft0::GetOutputStatus(
     do {
         CHK_NULL_BRK(pdwFlags);
         // We can produce an output sample if (and only if)
-        // we have an input sample.
-        if (m_pSample != NULL)
+        // the oldest input sample has been processed.
+        if (HasPendingOutput())
         {
             *pdwFlags = MFT_OUTPUT_STATUS_SAMPLE_READY;
         }
@@ -551,33 +627,57 @@ STDMETHODIMP CFrameProviderMft0::ProcessMessage(
 
     EnterCriticalSection(&m_critSec);
 
-    switch (eMessage)
-    {
-    case MFT_MESSAGE_COMMAND_FLUSH:
-        // Flush the MFT.
-        hr = OnFlush();
-        break;
-
-    case MFT_MESSAGE_COMMAND_DRAIN:
-        // Drain: Tells the MFT not to accept any more input until
-        // all of the pending output has been processed. That is our
-        // default behevior already, so there is nothing to do.
-        break;
-
-    case MFT_MESSAGE_SET_D3D_MANAGER:
-        // The pipeline should never send this message unless the MFT
-        // has the MF_SA_D3D_AWARE attribute set to TRUE. However, if we
-        // do get this message, it's invalid and we don't implement it.
-        hr = E_NOTIMPL;
-        break;
-
-        // The remaining messages do not require any action from this MFT.
-    case MFT_MESSAGE_NOTIFY_BEGIN_STREAMING:
-    case MFT_MESSAGE_NOTIFY_END_STREAMING:
-    case MFT_MESSAGE_NOTIFY_END_OF_STREAM:
-    case MFT_MESSAGE_NOTIFY_START_OF_STREAM:
-        break;
-    }
+    do {
+        CHK_LOG_BRK(CheckAsyncState());
+
+        switch (eMessage)
+        {
+        case MFT_MESSAGE_COMMAND_FLUSH:
+            // Flush the MFT.
+            hr = OnFlush();
+            break;
+
+        case MFT_MESSAGE_COMMAND_DRAIN:
+            // Drain: Tells the MFT not to accept any more input until
+            // all of the pending output has been processed. That is our
+            // default behevior already in synchronous mode. In asynchronous
+            // mode we stop requesting input and signal once the queue is empty.
+            if (m_bAsync)
+            {
+                if (m_uiQueueCount == 0)
+                {
+                    hr = CompleteDrain();
+                }
+                else
+                {
+                    m_bDraining = TRUE;
+                }
+            }
+            break;
+
+        case MFT_MESSAGE_NOTIFY_START_OF_STREAM:
+            // Asynchronous MFTs start requesting input when streaming starts or resumes after a flush.
+            if (m_bAsync)
+            {
+                m_bStreaming = TRUE;
+                hr = RequestInput();
+            }
+            break;
+
+        case MFT_MESSAGE_SET_D3D_MANAGER:
+            // The pipeline should never send this message unless the MFT
+            // has the MF_SA_D3D_AWARE attribute set to TRUE. However, if we
+            // do get this message, it's invalid and we don't implement it.
+            hr = E_NOTIMPL;
+            break;
+
+            // The remaining messages do not require any action from this MFT.
+        case MFT_MESSAGE_NOTIFY_BEGIN_STREAMING:
+        case MFT_MESSAGE_NOTIFY_END_STREAMING:
+        case MFT_MESSAGE_NOTIFY_END_OF_STREAM:
+            break;
+        }
+    } while (FALSE);
 
     LeaveCriticalSection(&m_critSec);
     return hr;
@@ -589,10 +689,17 @@ STDMETHODIMP CFrameProviderMft0::ProcessInput(
     DWORD dwFlags)
 {
     HRESULT hr = S_OK;
+    SampleProcessing processing = {};
+    CComPtr<IMFVideoSampleAllocatorEx> pGray8Allocator;
+    UINT32 uiSlot = 0;
+    UINT32 uiFlushCount = 0;
+    BOOL bQueued = FALSE;
 
     EnterCriticalSection(&m_critSec);
 
     do {
+        CHK_LOG_BRK(CheckAsyncState());
+
         CHK_NULL_BRK(pSample);
 
         CHK_BOOL_BRK(dwFlags == 0)
@@ -609,9 +716,9 @@ STDMETHODIMP CFrameProviderMft0::ProcessInput(
             CHK_LOG_BRK(MF_E_NOTACCEPTING);   // Client must set input and output types.
         }
 
-        if (m_pSample != NULL)
+        if (!CanAcceptInput() || (m_bAsync && m_uiInputRequested == 0))
         {
-            CHK_LOG_BRK(MF_E_NOTACCEPTING);   // We already have an input sample.
+            CHK_LOG_BRK(MF_E_NOTACCEPTING);   // Our queue is full or we didn't ask for input.
         }
 
         // Validate the number of buffers. There should only be a single buffer to hold the video frame.
@@ -626,12 +733,80 @@ STDMETHODIMP CFrameProviderMft0::ProcessInput(
             CHK_LOG_BRK(MF_E_SAMPLE_HAS_TOO_MANY_BUFFERS);
         }
 
-        // Cache the sample. We do the actual work in ProcessOutput.
-        m_pSample = pSample;
+        // Queue the sample before it's processed so samples are output in the order they arrived,
+        // even if the client calls ProcessInput from several threads.
+        uiSlot = (m_uiQueueHead + m_uiQueueCount) % MFT0_ASYNC_QUEUE_CAPACITY;
+        m_sampleQueue[uiSlot].pSample = pSample;
+        m_sampleQueue[uiSlot].bProcessed = FALSE;
+        m_sampleQueue[uiSlot].bAnnounced = FALSE;
         pSample->AddRef();  // Hold a reference count on the sample.
+        m_uiQueueCount++;
+
+        if (m_bAsync)
+        {
+            m_uiInputRequested--;
+        }
+
+        processing = m_processing;
+        pGray8Allocator = m_pGray8Allocator;
+        uiFlushCount = m_uiFlushCount;
+        bQueued = TRUE;
     } while (FALSE);
 
     LeaveCriticalSection(&m_critSec);
+
+    if (bQueued)
+    {
+        // Process the sample without holding the lock so reading its metadata and pixels doesn't block the other
+        // calls of the capture pipeline; the caller keeps the sample alive until we return.
+        // Frames converted to L8 are output in a new sample; a frame is dropped if no sample is free
+        CComPtr<IMFSample> pGray8Sample;
+        (void)ProcessSample(processing, pGray8Allocator, pSample, &pGray8Sample);
+
+        EnterCriticalSection(&m_critSec);
+
+        // A flush or shutdown while the sample was processed already released it
+        if (uiFlushCount == m_uiFlushCount)
+        {
+            QueuedSample &processed = m_sampleQueue[uiSlot];
+            processed.bProcessed = TRUE;
+            if (processing.settings.ConvertToGray8)
+            {
+                SAFERELEASE(processed.pSample);
+                processed.pSample = pGray8Sample.Detach();
+            }
+
+            DiscardDroppedSamples();
+
+            // Samples are output in order, so a sample is only announced once every sample ahead of it is processed
+            if (m_bAsync)
+            {
+                for (UINT32 i = 0; i < m_uiQueueCount; i++)
+                {
+                    QueuedSample &queued = m_sampleQueue[(m_uiQueueHead + i) % MFT0_ASYNC_QUEUE_CAPACITY];
+                    if (!queued.bProcessed)
+                    {
+                        break;
+                    }
+                    if (!queued.bAnnounced && queued.pSample != NULL)
+                    {
+                        queued.bAnnounced = TRUE;
+                        (void)QueueTransformEvent(METransformHaveOutput);
+                    }
+                }
+
+                // Dropped samples free their slot right away
+                if (m_bDraining && m_uiQueueCount == 0)
+                {
+                    (void)CompleteDrain();
+                }
+                (void)RequestInput();
+            }
+        }
+
+        LeaveCriticalSection(&m_critSec);
+    }
+
     return hr;
 }
 
@@ -646,6 +821,8 @@ STDMETHODIMP CFrameProviderMft0::ProcessOutput(
     EnterCriticalSection(&m_critSec);
 
     do {
+        CHK_LOG_BRK(CheckAsyncState());
+
         CHK_BOOL_BRK(dwFlags == 0);
         CHK_NULL_BRK(pOutputSamples);
         CHK_NULL_BRK(pdwStatus);
@@ -653,39 +830,36 @@ STDMETHODIMP CFrameProviderMft0::ProcessOutput(
         // Must be exactly one output buffer.
         CHK_BOOL_BRK(cOutputBufferCount == 1);
 
-        // If we don't have an input sample, we need some input before
+        // If we don't have a processed input sample, we need some input before
         // we can generate any output.
-        if (m_pSample == NULL)
+        if (!HasPendingOutput())
         {
             hr = MF_E_TRANSFORM_NEED_MORE_INPUT;
             break;
         }
 
-        // In this case we're not performing any processing on the image buffer itself
-        // Just assign the input sample object to the output parameter
-        pOutputSamples[0].pSample = m_pSample;
-        pOutputSamples[0].pSample->AddRef();
+        // In this case we're not performing any processing on the image buffer itself, the sample was tagged
+        // by ProcessInput. Just hand our reference on the input sample to the output parameter
+        QueuedSample &queued = m_sampleQueue[m_uiQueueHead];
+        pOutputSamples[0].pSample = queued.pSample;
         pOutputSamples[0].dwStatus = 0;
         *pdwStatus = 0;
 
-        //
-        // *** IMPORTANT ***
-        //
-        // TODO: Acquire the IR illumination state of the IR sensor for the current frame
-        // This is a device specific operation that cannot be performed in the Sample
-        //
-        
-        // TEMP CODE - replace with actual illumination polling code
-        static bool dummyIlluminationEnabled = false;
-        dummyIlluminationEnabled = !dummyIlluminationEnabled;
-
-        // Add the custom "illumination enabled" attribute holding current illumination value to the media sample
-        // This value is read from IFrameProvider to set the corresponding Property on the PerceptionFrame
-        m_pSample->SetUINT32(WDPP_ACTIVE_ILLUMINATION_ENABLED, dummyIlluminationEnabled);
+        queued.pSample = NULL;
+        m_uiQueueHead = (m_uiQueueHead + 1) % MFT0_ASYNC_QUEUE_CAPACITY;
+        m_uiQueueCount--;
+        DiscardDroppedSamples();
 
+        if (m_bAsync)
+        {
+            if (m_bDraining && m_uiQueueCount == 0)
+            {
+                CHK_LOG_BRK(CompleteDrain());
+            }
+            CHK_LOG_BRK(RequestInput());
+        }
     } while (FALSE);
 
-    SAFERELEASE(m_pSample);   // Release our input sample.
     LeaveCriticalSection(&m_critSec);
     return hr;
 }
@@ -745,13 +919,423 @@ STDMETHODIMP CFrameProviderMft0::OnFlush()
 {
     HRESULT hr = S_OK;
 
-    // For this MFT, flushing just means releasing the input sample.
-    SAFERELEASE(m_pSample);
+    // For this MFT, flushing just means releasing the input samples. Samples still being tagged
+    // are dropped when their tagging finishes.
+    ReleaseQueuedSamples();
+    m_uiFlushCount++;
+
+    // An asynchronous MFT doesn't request input again until streaming restarts
+    m_uiInputRequested = 0;
+    m_bStreaming = FALSE;
+    m_bDraining = FALSE;
+
+    return hr;
+}
+
+void CFrameProviderMft0::ReleaseQueuedSamples()
+{
+    for (UINT32 i = 0; i < m_uiQueueCount; i++)
+    {
+        SAFERELEASE(m_sampleQueue[(m_uiQueueHead + i) % MFT0_ASYNC_QUEUE_CAPACITY].pSample);
+    }
+    m_uiQueueHead = 0;
+    m_uiQueueCount = 0;
+}
+
+void CFrameProviderMft0::DiscardDroppedSamples()
+{
+    while (m_uiQueueCount > 0 && m_sampleQueue[m_uiQueueHead].bProcessed && m_sampleQueue[m_uiQueueHead].pSample == NULL)
+    {
+        m_uiQueueHead = (m_uiQueueHead + 1) % MFT0_ASYNC_QUEUE_CAPACITY;
+        m_uiQueueCount--;
+    }
+}
+
+STDMETHODIMP CFrameProviderMft0::RequestInput()
+{
+    HRESULT hr = S_OK;
+
+    while (m_bAsync && m_bStreaming && !m_bDraining && (m_uiQueueCount + m_uiInputRequested < m_uiQueueCapacity))
+    {
+        CHK_LOG_BRK(QueueTransformEvent(METransformNeedInput));
+        m_uiInputRequested++;
+    }
+
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::CompleteDrain()
+{
+    // The client sends MFT_MESSAGE_NOTIFY_START_OF_STREAM before it streams again, so outstanding requests are
+    // forgotten like after a flush and RequestInput stays quiet until then
+    m_bDraining = FALSE;
+    m_bStreaming = FALSE;
+    m_uiInputRequested = 0;
+
+    return QueueTransformEvent(METransformDrainComplete);
+}
+
+STDMETHODIMP CFrameProviderMft0::QueueTransformEvent(MediaEventType met)
+{
+    HRESULT hr = S_OK;
+    CComPtr<IMFMediaEvent> pEvent;
+
+    do {
+        CHK_NULL_PTR_BRK(m_pEventQueue);
+        CHK_LOG_BRK(MFCreateMediaEvent(met, GUID_NULL, S_OK, NULL, &pEvent));
+        CHK_LOG_BRK(pEvent->SetUINT32(MF_EVENT_MFT_INPUT_STREAM_ID, 0));
+        CHK_LOG_BRK(m_pEventQueue->QueueEvent(pEvent));
+    } while (FALSE);
+
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::CheckAsyncState()
+{
+    if (m_bShutdown)
+    {
+        return MF_E_SHUTDOWN;
+    }
+
+    // Asynchronous MFTs must not be used until the client unlocks them
+    if (m_bAsync && (m_pGlobalAttributes == NULL || MFGetAttributeUINT32(m_pGlobalAttributes, MF_TRANSFORM_ASYNC_UNLOCK, FALSE) == FALSE))
+    {
+        return MF_E_TRANSFORM_ASYNC_LOCKED;
+    }
+
+    return S_OK;
+}
+
+STDMETHODIMP CFrameProviderMft0::GetEventQueue(IMFMediaEventQueue **ppEventQueue)
+{
+    HRESULT hr = S_OK;
+
+    EnterCriticalSection(&m_critSec);
+
+    do {
+        if (m_bShutdown)
+        {
+            CHK_LOG_BRK(MF_E_SHUTDOWN);
+        }
+        if (m_pEventQueue == NULL)
+        {
+            CHK_LOG_BRK(E_NOTIMPL);     // Synchronous MFTs don't send events.
+        }
+        *ppEventQueue = m_pEventQueue;
+        (*ppEventQueue)->AddRef();
+    } while (FALSE);
+
+    LeaveCriticalSection(&m_critSec);
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::GetEvent(
+    DWORD dwFlags,
+    /* [out] */ _Out_ IMFMediaEvent **ppEvent)
+{
+    HRESULT hr = S_OK;
+    CComPtr<IMFMediaEventQueue> pEventQueue;
+
+    do {
+        // GetEvent may block, so it's called without holding the lock
+        CHK_LOG_BRK(GetEventQueue(&pEventQueue));
+        CHK_LOG_BRK(pEventQueue->GetEvent(dwFlags, ppEvent));
+    } while (FALSE);
+
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::BeginGetEvent(
+    /* [in] */ _In_ IMFAsyncCallback *pCallback,
+    /* [in] */ _In_opt_ IUnknown *punkState)
+{
+    HRESULT hr = S_OK;
+    CComPtr<IMFMediaEventQueue> pEventQueue;
+
+    do {
+        CHK_LOG_BRK(GetEventQueue(&pEventQueue));
+        CHK_LOG_BRK(pEventQueue->BeginGetEvent(pCallback, punkState));
+    } while (FALSE);
+
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::EndGetEvent(
+    /* [in] */ _In_ IMFAsyncResult *pResult,
+    /* [out] */ _Out_ IMFMediaEvent **ppEvent)
+{
+    HRESULT hr = S_OK;
+    CComPtr<IMFMediaEventQueue> pEventQueue;
+
+    do {
+        CHK_LOG_BRK(GetEventQueue(&pEventQueue));
+        CHK_LOG_BRK(pEventQueue->EndGetEvent(pResult, ppEvent));
+    } while (FALSE);
+
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::QueueEvent(
+    MediaEventType met,
+    REFGUID guidExtendedType,
+    HRESULT hrStatus,
+    /* [in] */ _In_opt_ const PROPVARIANT *pvValue)
+{
+    HRESULT hr = S_OK;
+    CComPtr<IMFMediaEventQueue> pEventQueue;
+
+    do {
+        CHK_LOG_BRK(GetEventQueue(&pEventQueue));
+        CHK_LOG_BRK(pEventQueue->QueueEventParamVar(met, guidExtendedType, hrStatus, pvValue));
+    } while (FALSE);
+
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::Shutdown()
+{
+    HRESULT hr = S_OK;
+
+    EnterCriticalSection(&m_critSec);
+
+    do {
+        if (m_bShutdown)
+        {
+            break;
+        }
+        m_bShutdown = TRUE;
+
+        ReleaseQueuedSamples();
+        m_uiFlushCount++;
+
+        if (m_pEventQueue)
+        {
+            CHK_LOG_BRK(m_pEventQueue->Shutdown());
+        }
+    } while (FALSE);
+
+    LeaveCriticalSection(&m_critSec);
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::GetShutdownStatus(
+    /* [out] */ _Out_ MFSHUTDOWN_STATUS *pStatus)
+{
+    HRESULT hr = S_OK;
+
+    EnterCriticalSection(&m_critSec);
+
+    do {
+        CHK_NULL_PTR_BRK(pStatus);
+        if (!m_bShutdown)
+        {
+            hr = MF_E_INVALIDREQUEST;
+            break;
+        }
+        *pStatus = MFSHUTDOWN_COMPLETED;
+    } while (FALSE);
+
+    LeaveCriticalSection(&m_critSec);
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::SelectProcessing()
+{
+    HRESULT hr = S_OK;
+
+    ZeroMemory(&m_processing, sizeof(m_processing));
+
+    do {
+        CHK_NULL_PTR_BRK(m_pInputType);
+
+        // Device types are passed through, L8 types are converted from the input type
+        BOOL bConvert = (m_pOutputType != NULL && m_outputTypeEntry.dwSourceIndex != m_outputTypeEntry.dwIndex);
+
+        // The layout was computed when the type was added to the catalog, and the media subtype's Data1 is its FOURCC
+        bool bSupported = MediaFoundationProvider::GetMft0ProcessingSettings(
+            m_inputTypeEntry.key.subtype.Data1,
+            m_inputTypeEntry.key.uiWidth,
+            m_inputTypeEntry.key.uiHeight,
+            m_inputTypeEntry.lStride,
+            bConvert != FALSE,
+            m_bMeasureFrames != FALSE,
+            m_processing.settings);
+        CHK_BOOL_BRK(bSupported);
+        m_processing.lInputStride = m_inputTypeEntry.lStride;
+
+        if (!bConvert)
+        {
+            if (m_pGray8Allocator)
+            {
+                (void)m_pGray8Allocator->UninitializeSampleAllocator();
+            }
+            break;
+        }
+
+        // The frame size of the output type is what the allocator sizes its buffers for
+        m_processing.cbOutputFrame = (m_outputTypeEntry.cbFrameSize != 0) ?
+            m_outputTypeEntry.cbFrameSize :
+            m_outputTypeEntry.key.uiWidth * m_outputTypeEntry.key.uiHeight;
+
+        // Output samples come from a pool of system memory samples that are recycled once the client releases them
+        if (!m_pGray8Allocator)
+        {
+            CHK_LOG_BRK(MFCreateVideoSampleAllocatorEx(IID_PPV_ARGS(&m_pGray8Allocator)));
+        }
+        (void)m_pGray8Allocator->UninitializeSampleAllocator();
+        CHK_LOG_BRK(m_pGray8Allocator->InitializeSampleAllocatorEx(MFT0_ASYNC_QUEUE_CAPACITY, MFT0_GRAY8_SAMPLE_POOL_SIZE, NULL, m_pOutputType));
+    } while (FALSE);
+
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::ProcessSample(const SampleProcessing &processing, IMFVideoSampleAllocatorEx *pAllocator, IMFSample *pSample, IMFSample **ppOutputSample)
+{
+    HRESULT hr = S_OK;
+    const MediaFoundationProvider::Mft0ProcessingSettings &settings = processing.settings;
+    MediaFoundationProvider::Mft0SampleFrame frame = {};
+    MediaFoundationProvider::Mft0Gray8Frame gray8 = {};
+    MediaFoundationProvider::Mft0SampleResult result;
+    BYTE abCaptureMetadata[4096];
+    bool bNeedsFrame = settings.ConvertToGray8 || settings.MeasureLuma;
+    bool bNeedsCaptureMetadata = false;
+    CComPtr<IMFAttributes> pCaptureMetadata;
+    CComPtr<IMFMediaBuffer> pInputBuffer;
+    CComPtr<IMFMediaBuffer> pOutputBuffer;
+    CComPtr<IMFSample> pOutputSample;
+    LONGLONG llTime = 0;
+    DWORD dwSampleFlags = 0;
+
+    *ppOutputSample = NULL;
+
+    for (UINT32 i = 0; i < settings.ParserCount; i++)
+    {
+        bNeedsFrame |= (settings.Parsers[i]->Location == MediaFoundationProvider::IlluminationMetadataLocation::EmbeddedLine);
+        bNeedsCaptureMetadata |= (settings.Parsers[i]->Location == MediaFoundationProvider::IlluminationMetadataLocation::CaptureMetadata);
+    }
+
+    // The UVC metadata buffer is attached to the sample by the capture pipeline, copy it without allocating
+    UINT32 cbCaptureMetadata = 0;
+    if (bNeedsCaptureMetadata &&
+        SUCCEEDED(pSample->GetUnknown(MFSampleExtension_CaptureMetadata, IID_PPV_ARGS(&pCaptureMetadata))) &&
+        SUCCEEDED(pCaptureMetadata->GetBlob(MF_CAPTURE_METADATA_FRAME_RAWSTREAM, abCaptureMetadata, sizeof(abCaptureMetadata), &cbCaptureMetadata)))
+    {
+        frame.CaptureMetadata = abCaptureMetadata;
+        frame.CaptureMetadataLength = cbCaptureMetadata;
+    }
+
+    do {
+        if (bNeedsFrame)
+        {
+            CHK_LOG_BRK(pSample->GetBufferByIndex(0, &pInputBuffer));
+        }
+        if (settings.ConvertToGray8)
+        {
+            CHK_LOG_BRK(pAllocator->AllocateSample(&pOutputSample));
+            CHK_LOG_BRK(pOutputSample->GetBufferByIndex(0, &pOutputBuffer));
+        }
+
+        // The input buffer is locked once for the embedded line, the conversion and the measurement; without a
+        // frame the illumination state can still be read from the capture metadata
+        VideoBufferLock inputLock(pInputBuffer);
+        VideoBufferLock outputLock(pOutputBuffer);
+        BYTE *pbScanLine0 = NULL;
+        LONG lStride = 0;
+        if (bNeedsFrame &&
+            SUCCEEDED(inputLock.LockBuffer(processing.lInputStride, settings.Layout.Height, &pbScanLine0, &lStride)))
+        {
+            // ProcessMft0Sample skips the pixels of a frame the buffer doesn't hold all of, e.g. a truncated sample
+            DWORD cbInput = 0;
+            frame.ScanLine0 = pbScanLine0;
+            frame.Stride = static_cast<INT32>(lStride);
+            if (inputLock.Is2DBuffer())
+            {
+                frame.Length = static_cast<UINT32>(abs(lStride)) * settings.Layout.Height;
+            }
+            else
+            {
+                frame.Length = SUCCEEDED(pInputBuffer->GetCurrentLength(&cbInput)) ? cbInput : 0;
+            }
+        }
+        if (settings.ConvertToGray8)
+        {
+            BYTE *pbOutput = NULL;
+            LONG lOutputStride = 0;
+            CHK_LOG_BRK(outputLock.LockBuffer(static_cast<LONG>(settings.Layout.Width), settings.Layout.Height, &pbOutput, &lOutputStride));
+            gray8.ScanLine0 = pbOutput;
+            gray8.Stride = static_cast<INT32>(lOutputStride);
+        }
+
+        bool bProcessed = MediaFoundationProvider::ProcessMft0Sample(settings, frame, settings.ConvertToGray8 ? &gray8 : NULL, result);
+        CHK_BOOL_BRK(bProcessed);
+
+        //
+        // *** IMPORTANT ***
+        //
+        // The IR illumination state of the current frame is read from the metadata the sensor delivers with
+        // the frame, see IlluminationMetadata.cpp; add a parser for your sensor's metadata there
+        //
+        if (result.IlluminationTagged)
+        {
+            // Add the custom "illumination enabled" attribute holding current illumination value to the media sample
+            // This value is read from IFrameProvider to set the corresponding Property on the PerceptionFrame
+            // NOTE: Frames without metadata aren't tagged and the provider infers their state from their content
+            (void)pSample->SetUINT32(WDPP_ACTIVE_ILLUMINATION_ENABLED, result.IlluminationEnabled ? TRUE : FALSE);
+        }
+
+        if (!result.Converted)
+        {
+            if (result.LumaMeasured)
+            {
+                AttachFrameStatistics(result.Statistics, pSample);
+            }
+            break;
+        }
+
+        CHK_LOG_BRK(pOutputBuffer->SetCurrentLength(processing.cbOutputFrame));
+
+        // Keep the illumination state, capture metadata and timing of the frame
+        CHK_LOG_BRK(pSample->CopyAllItems(pOutputSample));
+        if (SUCCEEDED(pSample->GetSampleTime(&llTime)))
+        {
+            CHK_LOG_BRK(pOutputSample->SetSampleTime(llTime));
+        }
+        if (SUCCEEDED(pSample->GetSampleDuration(&llTime)))
+        {
+            CHK_LOG_BRK(pOutputSample->SetSampleDuration(llTime));
+        }
+        if (SUCCEEDED(pSample->GetSampleFlags(&dwSampleFlags)))
+        {
+            CHK_LOG_BRK(pOutputSample->SetSampleFlags(dwSampleFlags));
+        }
+        if (result.LumaMeasured)
+        {
+            AttachFrameStatistics(result.Statistics, pOutputSample);
+        }
+
+        *ppOutputSample = pOutputSample.Detach();
+    } while (FALSE);
 
     return hr;
 }
 
-STDMETHODIMP CFrameProviderMft0::GetMediaType( DWORD dwStreamId, DWORD dwTypeIndex, IMFMediaType **ppType)
+void CFrameProviderMft0::AttachFrameStatistics(const MediaFoundationProvider::LumaStatistics &statistics, IMFSample *pSample)
+{
+    if (statistics.Pixels == 0)
+    {
+        return;
+    }
+
+    // The attributes travel with the sample next to the illumination attribute, so the frame provider can read them
+    // while it locks the sample
+    (void)pSample->SetDouble(WDPP_FRAME_LUMA_MEAN, statistics.GetMean());
+    (void)pSample->SetUINT32(WDPP_FRAME_LUMA_MINIMUM, statistics.Minimum);
+    (void)pSample->SetUINT32(WDPP_FRAME_LUMA_MAXIMUM, statistics.Maximum);
+    (void)pSample->SetUINT32(WDPP_FRAME_SATURATED_PIXELS, statistics.Saturated);
+    (void)pSample->SetBlob(WDPP_FRAME_LUMA_HISTOGRAM, reinterpret_cast<const UINT8*>(statistics.Histogram), sizeof(statistics.Histogram));
+}
+
+STDMETHODIMP CFrameProviderMft0::GetMediaType( DWORD dwStreamId, DWORD dwTypeIndex, IMFMediaType **ppType, BOOL bOutput)
 {
     HRESULT hr = S_OK;
 
@@ -759,7 +1343,8 @@ STDMETHODIMP CFrameProviderMft0::GetMediaType( DWORD dwStreamId, DWORD dwTypeInd
         CHK_NULL_PTR_BRK(ppType);
         if(dwStreamId != 0)
             CHK_LOG_BRK(MF_E_INVALIDSTREAMNUMBER);
-        if(dwTypeIndex >= m_listOfMediaTypes.GetCount())
+        // Only device types are offered as input types, the L8 types follow them as output types
+        if(dwTypeIndex >= (bOutput ? m_listOfMediaTypes.GetCount() : m_uiDeviceTypeCount))
             CHK_LOG_BRK(MF_E_NO_MORE_TYPES);
 
         *ppType = m_listOfMediaTypes[dwTypeIndex];
@@ -769,7 +1354,7 @@ STDMETHODIMP CFrameProviderMft0::GetMediaType( DWORD dwStreamId, DWORD dwTypeInd
     return hr;
 }
 
-STDMETHODIMP CFrameProviderMft0::IsMediaTypeSupported(UINT uiStreamId, IMFMediaType *pIMFMediaType, IMFMediaType **ppIMFMediaTypeFull)
+STDMETHODIMP CFrameProviderMft0::IsMediaTypeSupported(UINT uiStreamId, IMFMediaType *pIMFMediaType, IMFMediaType **ppIMFMediaTypeFull, MediaTypeCatalogEntry *pEntry, BOOL bOutput)
 {
     HRESULT hr = S_OK;
 
@@ -780,45 +1365,118 @@ STDMETHODIMP CFrameProviderMft0::IsMediaTypeSupported(UINT uiStreamId, IMFMediaT
         {
             CHK_LOG_BRK(MF_E_INVALIDINDEX);
         }
+
+        // Look the type up by subtype, frame size and frame rate and confirm the match with a single comparison.
+        // Partial types and types that only differ in other attributes fall back to comparing every type.
+        // The L8 types are only offered as output types
+        const UINT uiTypeCount = bOutput ? static_cast<UINT>(m_listOfMediaTypes.GetCount()) : m_uiDeviceTypeCount;
         BOOL bFound = FALSE;
-        for(UINT i = 0; i < m_listOfMediaTypes.GetCount(); i++)
+        DWORD dwIndex = 0;
+        MediaTypeKey key;
+        if(SUCCEEDED(GetMediaTypeKey(pIMFMediaType, &key)) && m_mediaTypeCatalog.Lookup(key, dwIndex) && dwIndex < uiTypeCount)
         {
-            DWORD dwResult = 0;
-            hr = m_listOfMediaTypes[i]->IsEqual(pIMFMediaType, &dwResult);
-            if(hr == S_FALSE)
-            {
-
-                if((dwResult & MF_MEDIATYPE_EQUAL_MAJOR_TYPES) && 
-                    (dwResult& MF_MEDIATYPE_EQUAL_FORMAT_TYPES) && 
-                    (dwResult& MF_MEDIATYPE_EQUAL_FORMAT_DATA))
-                {
-                    hr = S_OK;
-                }
-            }
-            if(hr == S_OK)
-            {
-                bFound = TRUE;
-                if(ppIMFMediaTypeFull) {
-                    *ppIMFMediaTypeFull = m_listOfMediaTypes[i];
-                    (*ppIMFMediaTypeFull)->AddRef();
-                }
-                break;
-            }
-            else if(FAILED(hr))
-            {
-                CHK_LOG_BRK(hr);
-            }
-
+            bFound = IsMatchingMediaType(m_listOfMediaTypes[dwIndex], pIMFMediaType);
+        }
+        for(UINT i = 0; !bFound && i < uiTypeCount; i++)
+        {
+            bFound = IsMatchingMediaType(m_listOfMediaTypes[i], pIMFMediaType);
+            dwIndex = i;
         }
+
         if(bFound == FALSE)
         {
             CHK_LOG_BRK(MF_E_INVALIDMEDIATYPE);
         }
+        if(ppIMFMediaTypeFull) {
+            *ppIMFMediaTypeFull = m_listOfMediaTypes[dwIndex];
+            (*ppIMFMediaTypeFull)->AddRef();
+        }
+        if(pEntry) {
+            *pEntry = m_mediaTypeEntries[dwIndex];
+        }
     } while (FALSE);
 
     return hr;
 }
 
+BOOL CFrameProviderMft0::IsMatchingMediaType(IMFMediaType *pType, IMFMediaType *pProposedType)
+{
+    DWORD dwResult = 0;
+    HRESULT hr = pType->IsEqual(pProposedType, &dwResult);
+    if(hr == S_FALSE)
+    {
+        if((dwResult & MF_MEDIATYPE_EQUAL_MAJOR_TYPES) && 
+            (dwResult& MF_MEDIATYPE_EQUAL_FORMAT_TYPES) && 
+            (dwResult& MF_MEDIATYPE_EQUAL_FORMAT_DATA))
+        {
+            hr = S_OK;
+        }
+    }
+    return hr == S_OK;
+}
+
+STDMETHODIMP CFrameProviderMft0::GetMediaTypeKey(IMFMediaType *pType, MediaTypeKey *pKey)
+{
+    HRESULT hr = S_OK;
+
+    do {
+        ZeroMemory(pKey, sizeof(*pKey));
+        CHK_LOG_BRK(pType->GetGUID(MF_MT_SUBTYPE, &pKey->subtype));
+        CHK_LOG_BRK(MFGetAttributeSize(pType, MF_MT_FRAME_SIZE, &pKey->uiWidth, &pKey->uiHeight));
+        CHK_LOG_BRK(MFGetAttributeRatio(pType, MF_MT_FRAME_RATE, &pKey->uiFrameRateNumerator, &pKey->uiFrameRateDenominator));
+    } while (FALSE);
+
+    return hr;
+}
+
+BOOL CFrameProviderMft0::IsSupportedSubtype(REFGUID subtype)
+{
+    // Video subtypes are FOURCCs or D3DFORMATs in Data1 of a common base GUID, see DEFINE_MEDIATYPE_GUID
+    static const GUID stVideoFormatBase = { 0x00000000, 0x0000, 0x0010, { 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 } };
+
+    if(memcmp(&subtype.Data2, &stVideoFormatBase.Data2, sizeof(GUID) - sizeof(subtype.Data1)) != 0)
+    {
+        return FALSE;
+    }
+
+    switch(subtype.Data1)
+    {
+    case D3DFMT_P8:             // MFVideoFormat_RGB8
+    case D3DFMT_X1R5G5B5:       // MFVideoFormat_RGB555
+    case D3DFMT_R5G6B5:         // MFVideoFormat_RGB565
+    case D3DFMT_R8G8B8:         // MFVideoFormat_RGB24
+    case D3DFMT_X8R8G8B8:       // MFVideoFormat_RGB32
+    case D3DFMT_A8R8G8B8:       // MFVideoFormat_ARGB32
+    case FCC('AI44'):
+    case FCC('AYUV'):
+    case FCC('I420'):
+    case FCC('IYUV'):
+    case FCC('NV11'):
+    case FCC('NV12'):
+    case FCC('UYVY'):
+    case FCC('Y41P'):
+    case FCC('Y41T'):
+    case FCC('Y42T'):
+    case FCC('YUY2'):
+    case FCC('YV12'):
+    case FCC('P010'):
+    case FCC('P016'):
+    case FCC('P210'):
+    case FCC('P216'):
+    case FCC('v210'):
+    case FCC('v216'):
+    case FCC('v410'):
+    case FCC('Y210'):
+    case FCC('Y216'):
+    case FCC('Y410'):
+    case FCC('Y416'):
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+
 STDMETHODIMP CFrameProviderMft0::GenerateMFMediaTypeListFromDevice(UINT uiStreamId)
 {
     HRESULT hr = S_OK;
@@ -828,6 +1486,9 @@ STDMETHODIMP CFrameProviderMft0::GenerateMFMediaTypeListFromDevice(UINT uiStream
         CHK_NULL_PTR_BRK(m_pSourceTransform);
 
         m_listOfMediaTypes.RemoveAll();
+        m_mediaTypeEntries.RemoveAll();
+        m_mediaTypeCatalog.RemoveAll();
+        m_uiDeviceTypeCount = 0;
         for(UINT iMediaType = 0; TRUE; iMediaType++)
         {
             CComPtr<IMFMediaType> pMediaType;
@@ -836,23 +1497,9 @@ STDMETHODIMP CFrameProviderMft0::GenerateMFMediaTypeListFromDevice(UINT uiStream
                 break;
             CHK_LOG_BRK(pMediaType->GetGUID(MF_MT_SUBTYPE, &stSubType));
 
-            if(((stSubType == MFVideoFormat_RGB8)   || (stSubType == MFVideoFormat_RGB555) ||
-                (stSubType == MFVideoFormat_RGB565) || (stSubType == MFVideoFormat_RGB24) ||
-                (stSubType == MFVideoFormat_RGB32)  || (stSubType == MFVideoFormat_ARGB32) ||
-                (stSubType == MFVideoFormat_AI44)   || (stSubType == MFVideoFormat_AYUV) ||
-                (stSubType == MFVideoFormat_I420)   || (stSubType == MFVideoFormat_IYUV) ||
-                (stSubType == MFVideoFormat_NV11)   || (stSubType == MFVideoFormat_NV12) ||
-                (stSubType == MFVideoFormat_UYVY)   || (stSubType == MFVideoFormat_Y41P) ||
-                (stSubType == MFVideoFormat_Y41T)   || (stSubType == MFVideoFormat_Y42T) ||
-                (stSubType == MFVideoFormat_YUY2)   || (stSubType == MFVideoFormat_YV12) ||
-                (stSubType == MFVideoFormat_P010)   || (stSubType == MFVideoFormat_P016) ||
-                (stSubType == MFVideoFormat_P210)   || (stSubType == MFVideoFormat_P216) ||
-                (stSubType == MFVideoFormat_v210)   || (stSubType == MFVideoFormat_v216) ||
-                (stSubType == MFVideoFormat_v410)   || (stSubType == MFVideoFormat_Y210) ||
-                (stSubType == MFVideoFormat_Y216)   || (stSubType == MFVideoFormat_Y410) ||
-                (stSubType == MFVideoFormat_Y416)) )
+            if(IsSupportedSubtype(stSubType))
             {
-                m_listOfMediaTypes[(ULONG)(m_listOfMediaTypes.GetCount())] = pMediaType;
+                CHK_LOG_BRK(AddMediaType(pMediaType, (DWORD)(m_listOfMediaTypes.GetCount())));
             }
         }        
 
@@ -862,5 +1509,89 @@ STDMETHODIMP CFrameProviderMft0::GenerateMFMediaTypeListFromDevice(UINT uiStream
         hr = S_OK;
     }
 
+    // Offer an L8 output type for each YUY2 and NV12 type the device doesn't already offer in L8
+    m_uiDeviceTypeCount = static_cast<UINT32>(m_listOfMediaTypes.GetCount());
+    for(UINT32 i = 0; SUCCEEDED(hr) && m_bOfferGray8 && i < m_uiDeviceTypeCount; i++)
+    {
+        MediaTypeKey key = m_mediaTypeEntries[i].key;
+        if(!IsEqualGUID(key.subtype, MFVideoFormat_YUY2) && !IsEqualGUID(key.subtype, MFVideoFormat_NV12))
+        {
+            continue;
+        }
+
+        key.subtype = MFVideoFormat_L8;
+        if(m_mediaTypeCatalog.Lookup(key) == NULL)
+        {
+            CComPtr<IMFMediaType> pGray8Type;
+            hr = CreateGray8MediaType(m_listOfMediaTypes[i], &pGray8Type);
+            if(SUCCEEDED(hr))
+            {
+                hr = AddMediaType(pGray8Type, i);
+            }
+        }
+    }
+
     return hr;
-}
\ No newline at end of file
+}
+
+STDMETHODIMP CFrameProviderMft0::AddMediaType(IMFMediaType *pType, DWORD dwSourceIndex)
+{
+    HRESULT hr = S_OK;
+
+    do {
+        // Compute the frame layout once here rather than every time the type is negotiated
+        MediaTypeCatalogEntry entry = {};
+        entry.dwIndex = (DWORD)(m_listOfMediaTypes.GetCount());
+        entry.dwSourceIndex = dwSourceIndex;
+        const BOOL bHasKey = SUCCEEDED(GetMediaTypeKey(pType, &entry.key));
+        CHK_LOG_BRK(pType->GetGUID(MF_MT_SUBTYPE, &entry.key.subtype));
+
+        if(FAILED(pType->GetUINT32(MF_MT_DEFAULT_STRIDE, (UINT32*)&entry.lStride)) &&
+            FAILED(MFGetStrideForBitmapInfoHeader(entry.key.subtype.Data1, entry.key.uiWidth, &entry.lStride)))
+        {
+            entry.lStride = 0;
+        }
+        if(FAILED(pType->GetUINT32(MF_MT_SAMPLE_SIZE, &entry.cbFrameSize)) &&
+            FAILED(MFCalculateImageSize(entry.key.subtype, entry.key.uiWidth, entry.key.uiHeight, &entry.cbFrameSize)))
+        {
+            entry.cbFrameSize = 0;
+        }
+
+        m_listOfMediaTypes[entry.dwIndex] = pType;
+        m_mediaTypeEntries.Add(entry);
+
+        // Devices may offer types that only differ in attributes other than the key, the first one is kept
+        if(bHasKey && m_mediaTypeCatalog.Lookup(entry.key) == NULL)
+        {
+            m_mediaTypeCatalog.SetAt(entry.key, entry.dwIndex);
+        }
+    } while (FALSE);
+
+    return hr;
+}
+
+STDMETHODIMP CFrameProviderMft0::CreateGray8MediaType(IMFMediaType *pSourceType, IMFMediaType **ppType)
+{
+    HRESULT hr = S_OK;
+    CComPtr<IMFMediaType> pType;
+    UINT32 uiWidth = 0;
+    UINT32 uiHeight = 0;
+
+    do {
+        CHK_LOG_BRK(MFGetAttributeSize(pSourceType, MF_MT_FRAME_SIZE, &uiWidth, &uiHeight));
+
+        // Same size, frame rate and aspect ratio as the device type, with a tightly packed luma plane
+        CHK_LOG_BRK(MFCreateMediaType(&pType));
+        CHK_LOG_BRK(pSourceType->CopyAllItems(pType));
+        CHK_LOG_BRK(pType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_L8));
+        CHK_LOG_BRK(pType->SetUINT32(MF_MT_DEFAULT_STRIDE, uiWidth));
+        CHK_LOG_BRK(pType->SetUINT32(MF_MT_SAMPLE_SIZE, uiWidth * uiHeight));
+        CHK_LOG_BRK(pType->SetUINT32(MF_MT_FIXED_SIZE_SAMPLES, TRUE));
+        CHK_LOG_BRK(pType->SetUINT32(MF_MT_ALL_SAMPLES_INDEPENDENT, TRUE));
+        (void)pType->DeleteItem(MF_MT_AVG_BITRATE);
+
+        *ppType = pType.Detach();
+    } while (FALSE);
+
+    return hr;
+}
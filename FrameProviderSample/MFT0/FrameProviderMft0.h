@@ -15,6 +15,7 @@
 #include "resource.h"       // main symbols
 #include "FrameProviderSampleMft0.h"
 #include "SampleHelpers.h"
+#include "../Pipeline/Mft0SampleProcessor.h"
 
 #if defined(_WIN32_WCE) && !defined(_CE_DCOM) && !defined(_CE_ALLOW_SINGLE_THREADED_OBJECTS_IN_MTA)
 #error "Single-threaded COM objects are not properly supported on Windows CE platform, such as the Windows Mobile platforms that do not include full DCOM support. Define _CE_ALLOW_SINGLE_THREADED_OBJECTS_IN_MTA to force ATL to support creating single-thread COM object's and allow use of it's single-threaded COM object implementations. The threading model in your rgs file was set to 'Free' as that is the only threading model supported in non DCOM Windows CE platforms."
@@ -26,6 +27,85 @@ using namespace ATL;
 // {24AE8CD8-117D-41B4-88F6-2AE46EF9AF58}
 static const GUID WDPP_ACTIVE_ILLUMINATION_ENABLED = { 0x24ae8cd8, 0x117d, 0x41b4,{ 0x88, 0xf6, 0x2a, 0xe4, 0x6e, 0xf9, 0xaf, 0x58 } };
 
+// Define GUIDs for the luma statistics of the current media sample, see CFrameProviderMft0::AttachFrameStatistics
+// Mean luma (double) {41D62076-0D4C-4D12-B546-B54111326C48}
+static const GUID WDPP_FRAME_LUMA_MEAN = { 0x41d62076, 0x0d4c, 0x4d12,{ 0xb5, 0x46, 0xb5, 0x41, 0x11, 0x32, 0x6c, 0x48 } };
+// Minimum luma (UINT32) {8E208917-B9BA-44B4-9795-AA47C268D8B8}
+static const GUID WDPP_FRAME_LUMA_MINIMUM = { 0x8e208917, 0xb9ba, 0x44b4,{ 0x97, 0x95, 0xaa, 0x47, 0xc2, 0x68, 0xd8, 0xb8 } };
+// Maximum luma (UINT32) {7FBB2058-995A-460E-9158-4E2F065851D0}
+static const GUID WDPP_FRAME_LUMA_MAXIMUM = { 0x7fbb2058, 0x995a, 0x460e,{ 0x91, 0x58, 0x4e, 0x2f, 0x06, 0x58, 0x51, 0xd0 } };
+// Pixel count of each of the 16 luma bins, bin i holding the levels 16 * i to 16 * i + 15 (blob of 16 UINT32)
+// {9C60384C-D510-4AC3-BC4F-C34204D93AB2}
+static const GUID WDPP_FRAME_LUMA_HISTOGRAM = { 0x9c60384c, 0xd510, 0x4ac3,{ 0xbc, 0x4f, 0xc3, 0x42, 0x04, 0xd9, 0x3a, 0xb2 } };
+// Pixels at or above LumaStatistics::SaturationLevel (UINT32) {C1A63672-CF71-47A2-B303-D9DEE8F0B62F}
+static const GUID WDPP_FRAME_SATURATED_PIXELS = { 0xc1a63672, 0xcf71, 0x47a2,{ 0xb3, 0x03, 0xd9, 0xde, 0xe8, 0xf0, 0xb6, 0x2f } };
+
+// Number of samples the MFT holds in asynchronous mode; in synchronous mode it holds a single sample
+static const UINT32 MFT0_ASYNC_QUEUE_CAPACITY = 4;
+
+// Number of L8 output samples the MFT can have in flight, i.e. queued or held by the client
+static const DWORD MFT0_GRAY8_SAMPLE_POOL_SIZE = 16;
+
+// Per-sample work for the current media types, see SelectProcessing; the work itself is portable, see
+// Pipeline/Mft0SampleProcessor.h
+struct SampleProcessing
+{
+    MediaFoundationProvider::Mft0ProcessingSettings settings;
+    LONG lInputStride;              // Default stride of the input type, negative for bottom-up frames
+    DWORD cbOutputFrame;            // Current length of the L8 output samples, 0 if samples are passed through
+};
+
+// A sample held by the MFT; samples are tagged outside the lock, so a sample is only output once it's processed
+struct QueuedSample
+{
+    IMFSample *pSample;             // NULL once processed if the sample was dropped, e.g. when no L8 sample was free
+    BOOL bProcessed;
+    BOOL bAnnounced;                // METransformHaveOutput was sent for the sample (asynchronous mode)
+};
+
+// Identifies a media type offered by the device
+struct MediaTypeKey
+{
+    GUID subtype;
+    UINT32 uiWidth;
+    UINT32 uiHeight;
+    UINT32 uiFrameRateNumerator;
+    UINT32 uiFrameRateDenominator;
+};
+
+class MediaTypeKeyTraits : public CElementTraitsBase<MediaTypeKey>
+{
+public:
+    static ULONG Hash(const MediaTypeKey &key)
+    {
+        ULONG ulHash = key.subtype.Data1;
+        ulHash = (ulHash * 31) + key.uiWidth;
+        ulHash = (ulHash * 31) + key.uiHeight;
+        ulHash = (ulHash * 31) + key.uiFrameRateNumerator;
+        ulHash = (ulHash * 31) + key.uiFrameRateDenominator;
+        return ulHash;
+    }
+
+    static bool CompareElements(const MediaTypeKey &key1, const MediaTypeKey &key2)
+    {
+        return IsEqualGUID(key1.subtype, key2.subtype) &&
+            key1.uiWidth == key2.uiWidth &&
+            key1.uiHeight == key2.uiHeight &&
+            key1.uiFrameRateNumerator == key2.uiFrameRateNumerator &&
+            key1.uiFrameRateDenominator == key2.uiFrameRateDenominator;
+    }
+};
+
+// A media type offered by the MFT with the frame layout computed once when the types are enumerated
+struct MediaTypeCatalogEntry
+{
+    MediaTypeKey key;
+    DWORD dwIndex;                  // Index of the type in m_listOfMediaTypes
+    DWORD dwSourceIndex;            // Index of the device type an L8 output type is converted from, dwIndex for device types
+    LONG lStride;                   // Default stride, 0 if it can't be computed for the subtype
+    UINT32 cbFrameSize;             // Size of a frame in bytes, 0 if it can't be computed for the subtype
+};
+
 
 // CFrameProviderMft0
 
@@ -34,18 +114,36 @@ class ATL_NO_VTABLE CFrameProviderMft0 :
     public CComCoClass<CFrameProviderMft0, &CLSID_FrameProviderMft0>,
     public IFrameProviderMft0,
     public IMFTransform,
+    public IMFMediaEventGenerator,
+    public IMFShutdown,
     public IInspectable
 {
 public:
-    CFrameProviderMft0() :   m_pSample(NULL),
+    CFrameProviderMft0() :   m_uiQueueHead(0),
+        m_uiQueueCount(0),
+        m_uiQueueCapacity(1),
+        m_uiFlushCount(0),
+        m_bAsync(FALSE),
+        m_pEventQueue(NULL),
+        m_uiInputRequested(0),
+        m_bStreaming(FALSE),
+        m_bDraining(FALSE),
+        m_bShutdown(FALSE),
         m_pInputType(NULL),
         m_pOutputType(NULL),
         m_pInputAttributes(0),
         m_pGlobalAttributes(0),
         m_pSourceTransform(0),
         m_uiStreamId(0),
-        m_nRefCount(1)
+        m_nRefCount(1),
+        m_uiDeviceTypeCount(0),
+        m_inputTypeEntry(),
+        m_outputTypeEntry(),
+        m_bOfferGray8(FALSE),
+        m_bMeasureFrames(FALSE),
+        m_processing()
     {
+        ZeroMemory(m_sampleQueue, sizeof(m_sampleQueue));
         InitializeCriticalSection(&m_critSec);
     }
 
@@ -56,15 +154,14 @@ public:
     BEGIN_COM_MAP(CFrameProviderMft0)
         COM_INTERFACE_ENTRY(IFrameProviderMft0)
         COM_INTERFACE_ENTRY(IMFTransform)
+        COM_INTERFACE_ENTRY(IMFMediaEventGenerator)
+        COM_INTERFACE_ENTRY(IMFShutdown)
         COM_INTERFACE_ENTRY(IInspectable)
     END_COM_MAP()
 
     DECLARE_PROTECT_FINAL_CONSTRUCT()
 
-    HRESULT FinalConstruct()
-    {
-        return S_OK;
-    }
+    HRESULT FinalConstruct();
 
     void FinalRelease()
     {
@@ -182,6 +279,31 @@ public:
         /* [size_is][out][in] */ MFT_OUTPUT_DATA_BUFFER *pOutputSamples,
         /* [out] */ DWORD *pdwStatus);
 
+    // IMFMediaEventGenerator, only used in asynchronous mode
+    STDMETHODIMP GetEvent(
+        DWORD dwFlags,
+        /* [out] */ _Out_ IMFMediaEvent **ppEvent);
+
+    STDMETHODIMP BeginGetEvent(
+        /* [in] */ _In_ IMFAsyncCallback *pCallback,
+        /* [in] */ _In_opt_ IUnknown *punkState);
+
+    STDMETHODIMP EndGetEvent(
+        /* [in] */ _In_ IMFAsyncResult *pResult,
+        /* [out] */ _Out_ IMFMediaEvent **ppEvent);
+
+    STDMETHODIMP QueueEvent(
+        MediaEventType met,
+        REFGUID guidExtendedType,
+        HRESULT hrStatus,
+        /* [in] */ _In_opt_ const PROPVARIANT *pvValue);
+
+    // IMFShutdown
+    STDMETHODIMP Shutdown();
+
+    STDMETHODIMP GetShutdownStatus(
+        /* [out] */ _Out_ MFSHUTDOWN_STATUS *pStatus);
+
 protected:
     virtual ~CFrameProviderMft0()
     {
@@ -190,16 +312,57 @@ protected:
         SAFERELEASE(m_pSourceTransform);
         SAFERELEASE(m_pInputType);
         SAFERELEASE(m_pOutputType);
-        SAFERELEASE(m_pSample);
+        ReleaseQueuedSamples();
+        if (m_pEventQueue)
+        {
+            m_pEventQueue->Shutdown();
+            SAFERELEASE(m_pEventQueue);
+        }
         DeleteCriticalSection(&m_critSec);
     }
 
-    STDMETHODIMP GetMediaType(DWORD  dwStreamID, DWORD dwTypeIndex, IMFMediaType **ppType);
-    STDMETHODIMP IsMediaTypeSupported(UINT uiStreamId, IMFMediaType *pIMFMediaType, IMFMediaType **ppIMFMediaTypeFull = NULL);
+    STDMETHODIMP GetMediaType(DWORD  dwStreamID, DWORD dwTypeIndex, IMFMediaType **ppType, BOOL bOutput = FALSE);
+    STDMETHODIMP IsMediaTypeSupported(UINT uiStreamId, IMFMediaType *pIMFMediaType, IMFMediaType **ppIMFMediaTypeFull = NULL, MediaTypeCatalogEntry *pEntry = NULL, BOOL bOutput = FALSE);
     STDMETHODIMP GenerateMFMediaTypeListFromDevice(UINT uiStreamId);
 
-    // HasPendingOutput: Returns TRUE if the MFT is holding an input sample.
-    BOOL HasPendingOutput() const { return m_pSample != NULL; }
+    // GetMediaTypeKey: Reads the subtype, frame size and frame rate identifying pType in the media type catalog.
+    static STDMETHODIMP GetMediaTypeKey(IMFMediaType *pType, MediaTypeKey *pKey);
+
+    // IsMatchingMediaType: Returns TRUE if pProposedType matches pType, the way the pipeline compares types.
+    static BOOL IsMatchingMediaType(IMFMediaType *pType, IMFMediaType *pProposedType);
+
+    // AddMediaType: Adds a type to m_listOfMediaTypes and the catalog.
+    STDMETHODIMP AddMediaType(IMFMediaType *pType, DWORD dwSourceIndex);
+
+    // CreateGray8MediaType: Creates the L8 type offered for a YUY2 or NV12 device type.
+    static STDMETHODIMP CreateGray8MediaType(IMFMediaType *pSourceType, IMFMediaType **ppType);
+
+    // IsSupportedSubtype: Returns TRUE if frames of the subtype are passed through by this MFT.
+    static BOOL IsSupportedSubtype(REFGUID subtype);
+
+    // HasPendingOutput: Returns TRUE if the MFT is holding a processed sample.
+    BOOL HasPendingOutput() const { return m_uiQueueCount > 0 && m_sampleQueue[m_uiQueueHead].bProcessed; }
+
+    // CanAcceptInput: Returns TRUE if the MFT has room for another input sample.
+    BOOL CanAcceptInput() const { return m_uiQueueCount < m_uiQueueCapacity; }
+
+    // ReleaseQueuedSamples: Releases every sample the MFT holds.
+    void ReleaseQueuedSamples();
+
+    // RequestInput: Sends METransformNeedInput for each free slot not requested yet (asynchronous mode).
+    STDMETHODIMP RequestInput();
+
+    // CompleteDrain: Sends METransformDrainComplete; input isn't requested again until streaming restarts (asynchronous mode).
+    STDMETHODIMP CompleteDrain();
+
+    // QueueTransformEvent: Sends an event for stream 0 to the client (asynchronous mode).
+    STDMETHODIMP QueueTransformEvent(MediaEventType met);
+
+    // GetEventQueue: Returns the event queue of an asynchronous MFT that hasn't been shut down.
+    STDMETHODIMP GetEventQueue(IMFMediaEventQueue **ppEventQueue);
+
+    // CheckAsyncState: Fails calls the client isn't allowed to make, i.e. after shutdown or before an async MFT is unlocked.
+    STDMETHODIMP CheckAsyncState();
 
     // IsValidInputStream: Returns TRUE if dwInputStreamID is a valid input stream identifier.
     BOOL IsValidInputStream(DWORD dwInputStreamID);
@@ -211,9 +374,38 @@ protected:
 
     STDMETHODIMP OnFlush();
 
+    // SelectProcessing: Selects the per-sample work for the current input and output types.
+    STDMETHODIMP SelectProcessing();
+
+    // ProcessSample: Tags, converts and measures the sample. *ppOutputSample receives the L8 sample from pAllocator,
+    // with the input's attributes and timestamps, if the sample is converted and NULL otherwise.
+    // NOTE: Called without holding m_critSec, so it only uses the processing passed in.
+    static STDMETHODIMP ProcessSample(const SampleProcessing &processing, IMFVideoSampleAllocatorEx *pAllocator, IMFSample *pSample, IMFSample **ppOutputSample);
+
+    // AttachFrameStatistics: Adds the luma statistics attributes to the sample.
+    static void AttachFrameStatistics(const MediaFoundationProvider::LumaStatistics &statistics, IMFSample *pSample);
+
+    // DiscardDroppedSamples: Removes dropped samples from the head of the queue.
+    void DiscardDroppedSamples();
+
+    // Only guards the MFT's state, samples are tagged without holding it
     CRITICAL_SECTION            m_critSec;
 
-    IMFSample                   *m_pSample;                 // Input sample.
+    // Input samples in arrival order; m_uiQueueCapacity is 1 in synchronous mode
+    QueuedSample                m_sampleQueue[MFT0_ASYNC_QUEUE_CAPACITY];
+    UINT32                      m_uiQueueHead;
+    UINT32                      m_uiQueueCount;
+    UINT32                      m_uiQueueCapacity;
+    UINT32                      m_uiFlushCount;             // Tells samples being tagged that they were flushed.
+
+    // Asynchronous mode, see FinalConstruct
+    BOOL                        m_bAsync;
+    IMFMediaEventQueue          *m_pEventQueue;
+    UINT32                      m_uiInputRequested;         // METransformNeedInput events not answered by ProcessInput yet.
+    BOOL                        m_bStreaming;               // Set by MFT_MESSAGE_NOTIFY_START_OF_STREAM, cleared by a flush or a completed drain.
+    BOOL                        m_bDraining;
+    BOOL                        m_bShutdown;
+
     IMFMediaType                *m_pInputType;              // Input media type.
     IMFMediaType                *m_pOutputType;             // Output media type.
 
@@ -224,7 +416,25 @@ protected:
     IMFTransform                *m_pSourceTransform;
     UINT                        m_uiStreamId;
     UINT                        m_nRefCount;
-    CAtlMap<DWORD, CComPtr<IMFMediaType>> m_listOfMediaTypes;
+    CAtlMap<DWORD, CComPtr<IMFMediaType>> m_listOfMediaTypes;     // Device types followed by the L8 output types.
+    UINT32                      m_uiDeviceTypeCount;        // Types in m_listOfMediaTypes offered as input types.
+
+    // Layout of each type in m_listOfMediaTypes, and the index of each type by subtype, frame size and frame rate,
+    // so negotiating a type is a lookup
+    CAtlArray<MediaTypeCatalogEntry> m_mediaTypeEntries;
+    CAtlMap<MediaTypeKey, DWORD, MediaTypeKeyTraits> m_mediaTypeCatalog;
+    MediaTypeCatalogEntry       m_inputTypeEntry;           // Catalog entry of the current input type.
+    MediaTypeCatalogEntry       m_outputTypeEntry;          // Catalog entry of the current output type.
+
+    // L8 output types converting YUY2 and NV12 frames inside MFT0, see FinalConstruct
+    BOOL                        m_bOfferGray8;
+    CComPtr<IMFVideoSampleAllocatorEx> m_pGray8Allocator;
+
+    // Luma statistics attached to each output sample, see FinalConstruct
+    BOOL                        m_bMeasureFrames;
+
+    // Illumination metadata parsers, conversion and measurement selected by the media types
+    SampleProcessing            m_processing;
 };
 
 OBJECT_ENTRY_AUTO(__uuidof(FrameProviderMft0), CFrameProviderMft0)
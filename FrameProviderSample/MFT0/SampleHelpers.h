@@ -64,13 +64,17 @@
 class VideoBufferLock
 {
 public:
+    // pBuffer may be NULL, in which case LockBuffer fails; this lets callers lock a buffer only when they have one.
     VideoBufferLock(IMFMediaBuffer *pBuffer) : m_p2DBuffer(NULL)
     {
         m_pBuffer = pBuffer;
-        m_pBuffer->AddRef();
+        if (m_pBuffer)
+        {
+            m_pBuffer->AddRef();
 
-        // Query for the 2-D buffer interface. OK if this fails.
-        m_pBuffer->QueryInterface(IID_IMF2DBuffer, (void**)&m_p2DBuffer);
+            // Query for the 2-D buffer interface. OK if this fails.
+            m_pBuffer->QueryInterface(IID_IMF2DBuffer, (void**)&m_p2DBuffer);
+        }
     }
 
     ~VideoBufferLock()
@@ -96,6 +100,11 @@ public:
     {
         HRESULT hr = S_OK;
 
+        if (m_pBuffer == NULL)
+        {
+            return E_POINTER;
+        }
+
         // Use the 2-D version if available.
         if (m_p2DBuffer)
         {
@@ -127,16 +136,23 @@ public:
         return hr;
     }
 
+    // Lock2D always maps a whole frame, while a buffer without IMF2DBuffer may hold less than one
+    BOOL Is2DBuffer() const
+    {
+        return m_p2DBuffer != NULL;
+    }
+
     HRESULT UnlockBuffer()
     {
         if (m_p2DBuffer)
         {
             return m_p2DBuffer->Unlock2D();
         }
-        else
+        else if (m_pBuffer)
         {
             return m_pBuffer->Unlock();
         }
+        return S_OK;
     }
 
 private:
@@ -12,6 +12,9 @@
 #include "pch.h"
 #include "MediaFoundationWrapper.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace ABI::Windows::System::Threading;
 using namespace ABI::Windows::System::Threading::Core;
 
@@ -21,9 +24,19 @@ using namespace Microsoft::WRL::Wrappers;
 namespace MediaFoundationProvider
 {
 
+// Relative weights of the terms used by ScoreMediaProfile; each term is measured in octaves (log2) from the
+// provider's target, so a weight of 1.0 means halving or doubling the quantity costs one point
+static const double ResolutionShortfallWeight = 2.0;    // Fewer pixels than the target lose detail the service needs
+static const double ResolutionExcessWeight = 1.0;       // More pixels than the target are converted and then mostly ignored
+static const double FrameRateShortfallWeight = 1.5;     // Frames slower than the target delay the service's decisions
+static const double FrameRateExcessWeight = 0.5;        // Faster frames are welcome, e.g. to pair illuminated and ambient frames
+static const double ConversionCostWeight = 0.5;         // CPU time spent converting each pixel to Gray8
+static const double BandwidthWeight = 0.25;             // Bytes per second moved from the device beyond a Gray8 stream at the target
+
 MediaDeviceManager::MediaDeviceManager() :
     _uniqueSourceID(nullptr),
     _friendlySourceName(nullptr),
+    _frameLayout(),
     _streamIndex(static_cast<DWORD>(-1)),
     _cachedIsMirrored(false)
 {
@@ -62,6 +75,9 @@ HRESULT MediaDeviceManager::Shutdown()
     _friendlySourceName = nullptr;
     _streamIndex = static_cast<DWORD>(-1);
 
+    // NOTE: _capabilities is kept on purpose, if the same device is initialized again, e.g. after it was briefly
+    // disconnected, it's opened with the profile that was active before
+
     return S_OK;
 }
 
@@ -82,11 +98,15 @@ HRESULT MediaDeviceManager::ActivateStream(bool newActiveState)
     return _sourceReader->SetStreamSelection(_streamIndex, newActiveState);
 }
 
-HRESULT MediaDeviceManager::ReadSample(ComPtr<IMFSample>& sampleData, _Out_ bool* readerStillValid)
+HRESULT MediaDeviceManager::ReadSample(ComPtr<IMFSample>& sampleData, _Out_ bool* readerStillValid, _Out_opt_ LONGLONG* timestamp)
 {
     auto lock = _threadLocker.Lock();
 
     sampleData.Reset();
+    if (timestamp != nullptr)
+    {
+        *timestamp = 0;
+    }
 
     bool readerValidLocal = false;
     HRESULT hr = E_NOT_VALID_STATE;
@@ -121,6 +141,11 @@ HRESULT MediaDeviceManager::ReadSample(ComPtr<IMFSample>& sampleData, _Out_ bool
                 else
                 {
                     readerValidLocal = true;     // Received a valid sample; everything is good
+
+                    if (timestamp != nullptr)
+                    {
+                        *timestamp = timeStamp;
+                    }
                 }
             }
             else
@@ -154,12 +179,167 @@ HRESULT MediaDeviceManager::RefreshStreamPropertyCache()
     return S_OK;
 }
 
+HRESULT MediaDeviceManager::SetMediaProfile(UINT32 profileIndex)
+{
+    auto lock = _threadLocker.Lock();
+
+    if (_sourceReader == nullptr) return E_NOT_VALID_STATE;
+    if (profileIndex >= _capabilities.Profiles.size()) return E_INVALIDARG;
+
+    const MediaProfileDescriptor& profile = _capabilities.Profiles[profileIndex];
+    ComPtr<IMFMediaType> appliedType;
+
+    // Deselect the current stream, the new profile may belong to a different stream, and discard any
+    // samples of the previous media type still queued in the reader
+    HRESULT hr = _sourceReader->SetStreamSelection(_streamIndex, FALSE);
+    if (SUCCEEDED(hr))
+    {
+        hr = _sourceReader->Flush(_streamIndex);
+    }
+
+    // Set the new media type on the existing reader; the stream is selected again when Start is called
+    if (SUCCEEDED(hr))
+    {
+        hr = ApplyMediaProfile(_sourceReader, profile, appliedType.GetAddressOf());
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        _sourceAttributes = appliedType;
+        _streamIndex = profile.StreamIndex;
+        _capabilities.SelectedProfileIndex = profileIndex;
+        _frameLayout = GetPackedFrameLayout(GetFramePixelFormat(profile.Subtype), profile.Width, profile.Height);
+    }
+
+    return hr;
+}
+
 HRESULT MediaDeviceManager::InitializeSourceDevice(_In_ LPCWSTR targetDeviceId)
+{
+    MediaProfileCache profileCache;
+    MediaDeviceCapabilities cachedCapabilities;
+    HRESULT hr;
+
+    // Enumerating devices and media types is identical every time a known device is connected
+    // If this device was seen before, open it directly using the cached capabilities
+    if (!_capabilities.Profiles.empty() && _wcsicmp(_capabilities.SymbolicLink.c_str(), targetDeviceId) == 0)
+    {
+        // Reconnecting to the device of the previous initialization, keep its selected profile
+        cachedCapabilities = _capabilities;
+        hr = S_OK;
+    }
+    else
+    {
+        hr = profileCache.Lookup(targetDeviceId, &cachedCapabilities);
+
+        // Rank the cached profiles again in case the provider's targets changed since the entry was written
+        if (SUCCEEDED(hr))
+        {
+            RankMediaProfiles(cachedCapabilities);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = InitializeSourceDeviceFromCache(targetDeviceId, cachedCapabilities);
+        if (FAILED(hr))
+        {
+            // The cached entry no longer matches what the device reports, discard it and fall back to a full enumeration
+            profileCache.Invalidate(targetDeviceId);
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        hr = InitializeSourceDeviceFromEnumeration(targetDeviceId);
+
+        // Failing to write the cache only means the next initialization takes the slow path again
+        if (SUCCEEDED(hr))
+        {
+            profileCache.Store(targetDeviceId, _capabilities);
+        }
+    }
+
+    // Read device properties and save them to cached values
+    if (SUCCEEDED(hr))
+    {
+        RefreshStreamPropertyCache();
+    }
+
+    return hr;
+}
+
+HRESULT MediaDeviceManager::InitializeSourceDeviceFromCache(_In_ LPCWSTR targetDeviceId, _In_ const MediaDeviceCapabilities& cachedCapabilities)
+{
+    ComPtr<IMFAttributes> sourceAttributes;
+    ComPtr<IMFMediaSource> mediaSource;
+    ComPtr<IMFSourceReader> sourceReader;
+    ComPtr<IMFMediaType> appliedType;
+
+    // Opening the symbolic link bypasses the category restriction of the enumeration, so an entry that wasn't written
+    // for a KSCATEGORY_SENSOR_CAMERA device is a miss while the restriction is set
+    if (SampleFrameProvider::_requiredKsSensorDevice && !cachedCapabilities.SensorCameraCategory)
+    {
+        return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+    }
+
+    // Create the MediaSource straight from the device's symbolic link, no enumeration is needed
+    HRESULT hr = MFCreateAttributes(sourceAttributes.GetAddressOf(), 2);
+    if (SUCCEEDED(hr))
+    {
+        hr = sourceAttributes->SetGUID(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE, MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_GUID);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = sourceAttributes->SetString(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_SYMBOLIC_LINK, targetDeviceId);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = MFCreateDeviceSource(sourceAttributes.Get(), mediaSource.GetAddressOf());
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = CreateMediaSourceReader(mediaSource, sourceReader);
+    }
+
+    // Apply the cached profile; this fails if the native media type at the cached index doesn't match the cached description
+    if (SUCCEEDED(hr))
+    {
+        hr = ApplyMediaProfile(sourceReader, cachedCapabilities.Profiles[cachedCapabilities.SelectedProfileIndex], appliedType.GetAddressOf());
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = AcquireIdentificationStrings(cachedCapabilities);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        const MediaProfileDescriptor& selectedProfile = cachedCapabilities.Profiles[cachedCapabilities.SelectedProfileIndex];
+
+        _sourceReader = sourceReader;
+        _sourceAttributes = appliedType;
+        _streamIndex = selectedProfile.StreamIndex;
+        _capabilities = cachedCapabilities;
+        _frameLayout = GetPackedFrameLayout(GetFramePixelFormat(selectedProfile.Subtype), selectedProfile.Width, selectedProfile.Height);
+    }
+    else if (mediaSource != nullptr)
+    {
+        mediaSource->Shutdown();
+    }
+
+    return hr;
+}
+
+HRESULT MediaDeviceManager::InitializeSourceDeviceFromEnumeration(_In_ LPCWSTR targetDeviceId)
 {
     ComPtr<IMFAttributes> enumAttributes;
     ComPtr<IMFActivate> sourceActivation;
+    ComPtr<IMFMediaSource> mediaSource;
     ComPtr<IMFSourceReader> sourceReader;
-    DWORD streamIndex = static_cast<DWORD>(-1);
+    ComPtr<IMFMediaType> appliedType;
+    MediaDeviceCapabilities capabilities;
 
     // Create an attribute store to specify the enumeration parameters
     // Specify "VIDCAP" devices as the major type to enumerate
@@ -184,29 +364,47 @@ HRESULT MediaDeviceManager::InitializeSourceDevice(_In_ LPCWSTR targetDeviceId)
         hr = EnumMediaCaptureDevices(targetDeviceId, enumAttributes, sourceActivation);
     }
 
-    // Use the returned activator to create a MediaSourceReader object and identify the stream index we'll read frames
+    // Use the returned activator to create a MediaSource and a MediaSourceReader object to read frames from it
     if (SUCCEEDED(hr))
     {
-        hr = InitializeMediaSourceReader(sourceActivation, sourceReader, &streamIndex);
+        hr = sourceActivation->ActivateObject(IID_PPV_ARGS(mediaSource.GetAddressOf()));
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = CreateMediaSourceReader(mediaSource, sourceReader);
     }
 
-    // Acquire an ID and Friendly Name strings from the Activation attributes
+    // Examine the media types available from the reader and select one that best matches our needs (if any)
+    // Set the choosen MediaType and Stream index to the reader object
     if (SUCCEEDED(hr))
     {
-        hr = AcquireIdentificationStrings(sourceActivation);
+        hr = FindCompatibleMediaProfile(sourceReader, capabilities);
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = ApplyMediaProfile(sourceReader, capabilities.Profiles[capabilities.SelectedProfileIndex], appliedType.GetAddressOf());
     }
 
-    // If all went well, save the key object references and tag the class as Initialized
+    // Acquire an ID and Friendly Name strings from the Activation attributes
     if (SUCCEEDED(hr))
     {
-        _sourceReader = sourceReader;
-        _streamIndex = streamIndex;
+        hr = AcquireIdentificationStrings(sourceActivation);
     }
 
-    // Read device properties and save them to cached values
+    // If all went well, save the key object references and tag the class as Initialized
     if (SUCCEEDED(hr))
     {
-        RefreshStreamPropertyCache();
+        capabilities.SymbolicLink = _uniqueSourceID;
+        capabilities.FriendlyName = _friendlySourceName;
+        capabilities.SensorCameraCategory = SampleFrameProvider::_requiredKsSensorDevice;
+
+        const MediaProfileDescriptor& selectedProfile = capabilities.Profiles[capabilities.SelectedProfileIndex];
+
+        _sourceReader = sourceReader;
+        _sourceAttributes = appliedType;
+        _streamIndex = selectedProfile.StreamIndex;
+        _capabilities = capabilities;
+        _frameLayout = GetPackedFrameLayout(GetFramePixelFormat(selectedProfile.Subtype), selectedProfile.Width, selectedProfile.Height);
     }
 
     return hr;
@@ -239,6 +437,32 @@ HRESULT MediaDeviceManager::AcquireIdentificationStrings(_In_ const ComPtr<IMFAc
     return hr;
 }
 
+HRESULT MediaDeviceManager::AcquireIdentificationStrings(_In_ const MediaDeviceCapabilities& capabilities)
+{
+    // Copy the cached strings into CoTaskMem allocations so they're released the same way as strings read from IMFActivate
+    const size_t sourceIDSize = (capabilities.SymbolicLink.size() + 1) * sizeof(WCHAR);
+    const size_t friendlyNameSize = (capabilities.FriendlyName.size() + 1) * sizeof(WCHAR);
+
+    LPWSTR sourceID = static_cast<LPWSTR>(CoTaskMemAlloc(sourceIDSize));
+    LPWSTR friendlyName = static_cast<LPWSTR>(CoTaskMemAlloc(friendlyNameSize));
+
+    if (sourceID == nullptr || friendlyName == nullptr)
+    {
+        // Safe to pass in NULL pointers
+        CoTaskMemFree(sourceID);
+        CoTaskMemFree(friendlyName);
+        return E_OUTOFMEMORY;
+    }
+
+    memcpy(sourceID, capabilities.SymbolicLink.c_str(), sourceIDSize);
+    memcpy(friendlyName, capabilities.FriendlyName.c_str(), friendlyNameSize);
+
+    _uniqueSourceID = sourceID;
+    _friendlySourceName = friendlyName;
+
+    return S_OK;
+}
+
 HRESULT MediaDeviceManager::EnumMediaCaptureDevices(_In_ LPCWSTR targetDeviceId, _In_ const ComPtr<IMFAttributes>& enumAtributes, _Out_ ComPtr<IMFActivate>& mediaSourceActivate)
 {
     IMFActivate **ppDevices = NULL;
@@ -297,65 +521,74 @@ HRESULT MediaDeviceManager::EnumMediaCaptureDevices(_In_ LPCWSTR targetDeviceId,
     return hr;
 }
 
-HRESULT MediaDeviceManager::InitializeMediaSourceReader(_In_ const ComPtr<IMFActivate>& mediaSourceActivate, _Out_ ComPtr<IMFSourceReader>& sourceReader, _Out_ DWORD* streamIndex)
+HRESULT MediaDeviceManager::CreateMediaSourceReader(_In_ const ComPtr<IMFMediaSource>& mediaSource, _Out_ ComPtr<IMFSourceReader>& sourceReader)
 {
-    // Create a MediaSource object from the passed in Activator
-    ComPtr<IMFMediaSource> mediaSource;
-    HRESULT hr = mediaSourceActivate->ActivateObject(IID_PPV_ARGS(mediaSource.GetAddressOf()));
-
     // Create a MediaSourceReader object from the activated MediaSource
+    ComPtr<IMFAttributes> readerAttributes;
+
+    HRESULT hr = MFCreateAttributes(readerAttributes.GetAddressOf(), 1);
     if (SUCCEEDED(hr))
     {
-        ComPtr<IMFAttributes> readerAttributes;
-
-        hr = MFCreateAttributes(readerAttributes.GetAddressOf(), 1);
-        if (SUCCEEDED(hr))
-        {
-            hr = readerAttributes->SetUINT32(MF_READWRITE_ENABLE_HARDWARE_TRANSFORMS, TRUE);
-        }
-        if (SUCCEEDED(hr))
-        {
-            hr = MFCreateSourceReaderFromMediaSource(mediaSource.Get(), readerAttributes.Get(), sourceReader.GetAddressOf());
-        }
+        hr = readerAttributes->SetUINT32(MF_READWRITE_ENABLE_HARDWARE_TRANSFORMS, TRUE);
     }
-
-    // Examine the media types available from the reader and select one that best matches our needs (if any)
-    // Set the choosen MediaType and Stream index to the reader object
     if (SUCCEEDED(hr))
     {
-        ComPtr<IMFMediaType> chosenProfile;
-        hr = FindCompatibleMediaProfile(sourceReader, chosenProfile.GetAddressOf(), streamIndex);
-
-        if (SUCCEEDED(hr))
-        {
-            hr = sourceReader->SetCurrentMediaType(*streamIndex, NULL, chosenProfile.Get());
-        }
-        if (SUCCEEDED(hr))
-        {
-            // Make sure stream is not selected at this point, it'll be enabled when Start is called by the service
-            hr = sourceReader->SetStreamSelection(*streamIndex, FALSE);
-        }
-        if (SUCCEEDED(hr))
-        {
-            _sourceAttributes = chosenProfile;
-        }
+        hr = MFCreateSourceReaderFromMediaSource(mediaSource.Get(), readerAttributes.Get(), sourceReader.ReleaseAndGetAddressOf());
     }
 
     if (FAILED(hr))
     {
         sourceReader.Reset();
-        *streamIndex = static_cast<DWORD>(-1);
     }
 
     return hr;
 }
 
-HRESULT MediaDeviceManager::FindCompatibleMediaProfile(_In_ const ComPtr<IMFSourceReader>& sourceReader, _Outptr_ IMFMediaType** chosenType, _Out_ DWORD* chosenStreamIndex)
+HRESULT MediaDeviceManager::ApplyMediaProfile(_In_ const ComPtr<IMFSourceReader>& sourceReader, _In_ const MediaProfileDescriptor& profile, _Outptr_ IMFMediaType** appliedType)
+{
+    ComPtr<IMFMediaType> mediaType;
+    MediaProfileDescriptor currentProfile;
+
+    *appliedType = nullptr;
+
+    // Fetch the native media type directly by its index and make sure it's still the type described by the profile
+    HRESULT hr = sourceReader->GetNativeMediaType(profile.StreamIndex, profile.TypeIndex, mediaType.GetAddressOf());
+    if (SUCCEEDED(hr) && !IsMediaProfileValid(mediaType))
+    {
+        hr = MF_E_INVALIDMEDIATYPE;
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = DescribeMediaProfile(mediaType, profile.StreamIndex, profile.TypeIndex, &currentProfile);
+    }
+    if (SUCCEEDED(hr) && memcmp(&currentProfile, &profile, sizeof(profile)) != 0)
+    {
+        hr = MF_E_INVALIDMEDIATYPE;
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = sourceReader->SetCurrentMediaType(profile.StreamIndex, NULL, mediaType.Get());
+    }
+    if (SUCCEEDED(hr))
+    {
+        // Make sure stream is not selected at this point, it'll be enabled when Start is called by the service
+        hr = sourceReader->SetStreamSelection(profile.StreamIndex, FALSE);
+    }
+    if (SUCCEEDED(hr))
+    {
+        *appliedType = mediaType.Detach();
+    }
+
+    return hr;
+}
+
+HRESULT MediaDeviceManager::FindCompatibleMediaProfile(_In_ const ComPtr<IMFSourceReader>& sourceReader, _Inout_ MediaDeviceCapabilities& capabilities)
 {
-    std::vector<ComPtr<IMFMediaType>> mediaCandidates;
     HRESULT hr;
 
-    *chosenStreamIndex = static_cast<DWORD>(-1);
+    capabilities.Profiles.clear();
+    capabilities.SelectedProfileIndex = 0;
 
     for (UINT32 streamIndex = 0;; streamIndex++)
     {
@@ -368,9 +601,10 @@ HRESULT MediaDeviceManager::FindCompatibleMediaProfile(_In_ const ComPtr<IMFSour
             {
                 // Check the sample meets our minimum requirements and if
                 // it passes, add it to the list of types we'll consider
-                if (IsMediaProfileValid(mediaType))
+                MediaProfileDescriptor profile;
+                if (IsMediaProfileValid(mediaType) && SUCCEEDED(DescribeMediaProfile(mediaType, streamIndex, typeIndex, &profile)))
                 {
-                    mediaCandidates.push_back(mediaType);
+                    capabilities.Profiles.push_back(profile);
                 }
             }
             else if (hr == MF_E_NO_MORE_TYPES || hr == MF_E_INVALIDSTREAMNUMBER) break;
@@ -378,27 +612,64 @@ HRESULT MediaDeviceManager::FindCompatibleMediaProfile(_In_ const ComPtr<IMFSour
 
         // If we've found at least 1 valid media type from this stream we don't need to continue enumerating media types
         // Otherwise if no valid media types were found, continue to the next stream (if any more)
-        if (!mediaCandidates.empty())
+        if (!capabilities.Profiles.empty())
         {
-            *chosenStreamIndex = streamIndex;
             break;
         }
         else if (hr == MF_E_INVALIDSTREAMNUMBER) break;
     }
 
-    // Simply select the first valid device
-    if (!mediaCandidates.empty())
+    hr = capabilities.Profiles.empty() ? E_NOT_SET : S_OK;
+
+    // Order the profiles from best to worst; the best one is used for streaming
+    if (SUCCEEDED(hr))
     {
-        *chosenType = mediaCandidates[0].Get();
-        (*chosenType)->AddRef();
-        hr = S_OK;
+        RankMediaProfiles(capabilities);
     }
-    else
+
+    return hr;
+}
+
+void MediaDeviceManager::RankMediaProfiles(_Inout_ MediaDeviceCapabilities& capabilities)
+{
+    // A stable sort keeps the driver's own ordering for profiles with identical scores
+    std::stable_sort(capabilities.Profiles.begin(), capabilities.Profiles.end(),
+        [](const MediaProfileDescriptor& left, const MediaProfileDescriptor& right)
     {
-        hr = E_NOT_SET;
+        return ScoreMediaProfile(left) > ScoreMediaProfile(right);
+    });
+
+    capabilities.SelectedProfileIndex = 0;
+}
+
+double MediaDeviceManager::ScoreMediaProfile(_In_ const MediaProfileDescriptor& profile)
+{
+    const FrameConversionKernel* conversionKernel = FindFrameConversionKernel(GetFramePixelFormat(profile.Subtype));
+    if (conversionKernel == nullptr || profile.Width == 0 || profile.Height == 0 ||
+        profile.FrameRateNumerator == 0 || profile.FrameRateDenominator == 0)
+    {
+        return -HUGE_VAL;
     }
 
-    return hr;
+    const double targetPixels = static_cast<double>(SampleFrameProvider::_targetFrameWidth) * SampleFrameProvider::_targetFrameHeight;
+    const double targetFrameRate = static_cast<double>(SampleFrameProvider::_targetFrameRate);
+    const double pixels = static_cast<double>(profile.Width) * profile.Height;
+    const double frameRate = static_cast<double>(profile.FrameRateNumerator) / profile.FrameRateDenominator;
+
+    // A Gray8 profile exactly matching the target size and frame rate scores 0, every other profile is scored relative to it
+    const double resolutionOctaves = log2(pixels / targetPixels);
+    double score = (resolutionOctaves < 0.0) ? ResolutionShortfallWeight * resolutionOctaves : -ResolutionExcessWeight * resolutionOctaves;
+
+    const double frameRateOctaves = log2(frameRate / targetFrameRate);
+    score += (frameRateOctaves < 0.0) ? FrameRateShortfallWeight * frameRateOctaves : FrameRateExcessWeight * frameRateOctaves;
+
+    score -= ConversionCostWeight * log2(static_cast<double>(conversionKernel->RelativeCost));
+
+    const double bytesPerSecond = pixels * conversionKernel->BitsPerPixel / 8.0 * frameRate;
+    const double targetBytesPerSecond = targetPixels * targetFrameRate;
+    score -= BandwidthWeight * (std::max)(0.0, log2(bytesPerSecond / targetBytesPerSecond));
+
+    return score;
 }
 
 HRESULT MediaDeviceManager::QueryIsMirroredState(_Out_ bool* isMirrored)
@@ -475,13 +746,13 @@ bool MediaDeviceManager::IsMediaProfileValid(_In_ const ComPtr<IMFMediaType>& wo
         if (!IsEqualGUID(guidType, MFMediaType_Video)) { hr = E_FAIL; }
     }
 
-    // Must natively supporty YUY2 video format
+    // Must natively support a video format the provider can convert to Gray8
     if (SUCCEEDED(hr))
     {
         hr = workingProfile->GetGUID(MF_MT_SUBTYPE, &guidType);
         if (SUCCEEDED(hr))
         {
-            if (!IsEqualGUID(MFVideoFormat_YUY2, guidType)) { hr = E_FAIL; }
+            if (FindFrameConversionKernel(GetFramePixelFormat(guidType)) == nullptr) { hr = E_FAIL; }
         }
     }
 
@@ -509,4 +780,53 @@ bool MediaDeviceManager::IsMediaProfileValid(_In_ const ComPtr<IMFMediaType>& wo
     return !!SUCCEEDED(hr);
 }
 
+FramePixelFormat MediaDeviceManager::GetFramePixelFormat(REFGUID subtype)
+{
+    if (IsEqualGUID(subtype, MFVideoFormat_YUY2)) return FramePixelFormat::YUY2;
+    if (IsEqualGUID(subtype, MFVideoFormat_NV12)) return FramePixelFormat::NV12;
+    if (IsEqualGUID(subtype, MFVideoFormat_L8)) return FramePixelFormat::Gray8;
+
+    return FramePixelFormat::Unknown;
+}
+
+GUID MediaDeviceManager::GetMediaSubtype(FramePixelFormat format)
+{
+    switch (format)
+    {
+        case FramePixelFormat::YUY2: return MFVideoFormat_YUY2;
+        case FramePixelFormat::NV12: return MFVideoFormat_NV12;
+        case FramePixelFormat::Gray8: return MFVideoFormat_L8;
+        default: return GUID_NULL;
+    }
+}
+
+HRESULT MediaDeviceManager::DescribeMediaProfile(_In_ const ComPtr<IMFMediaType>& mediaType, DWORD streamIndex, DWORD typeIndex, _Out_ MediaProfileDescriptor* profile)
+{
+    // Zero the whole structure, including padding, since descriptors are compared and stored as raw memory
+    ZeroMemory(profile, sizeof(*profile));
+    profile->StreamIndex = streamIndex;
+    profile->TypeIndex = typeIndex;
+
+    HRESULT hr = mediaType->GetGUID(MF_MT_SUBTYPE, &profile->Subtype);
+    if (SUCCEEDED(hr))
+    {
+        hr = MFGetAttributeSize(mediaType.Get(), MF_MT_FRAME_SIZE, &profile->Width, &profile->Height);
+    }
+    if (SUCCEEDED(hr))
+    {
+        // Not every driver reports a frame rate range, in which case the nominal frame rate is also the maximum
+        hr = MFGetAttributeRatio(mediaType.Get(), MF_MT_FRAME_RATE_RANGE_MAX, &profile->FrameRateNumerator, &profile->FrameRateDenominator);
+        if (FAILED(hr))
+        {
+            hr = MFGetAttributeRatio(mediaType.Get(), MF_MT_FRAME_RATE, &profile->FrameRateNumerator, &profile->FrameRateDenominator);
+        }
+    }
+    if (SUCCEEDED(hr))
+    {
+        hr = MFGetAttributeRatio(mediaType.Get(), MF_MT_PIXEL_ASPECT_RATIO, &profile->PixelAspectNumerator, &profile->PixelAspectDenominator);
+    }
+
+    return hr;
+}
+
 } // end namespace
@@ -26,25 +26,40 @@ public:
     LPWSTR GetFriendSourceName() { _threadLocker.Lock(); return _friendlySourceName; }
     bool IsInitialized() { _threadLocker.Lock(); return _sourceReader != nullptr; }
     bool IsMirrored() { _threadLocker.Lock(); return _cachedIsMirrored; }
+    MediaDeviceCapabilities GetCapabilities() { auto lock = _threadLocker.Lock(); return _capabilities; }
+    FrameLayout GetFrameLayout() { auto lock = _threadLocker.Lock(); return _frameLayout; }
 
     HRESULT Initialize(_In_ LPCWSTR targetDeviceId);
     HRESULT Shutdown();
     HRESULT ActivateStream(bool newActiveState);
-    HRESULT ReadSample(WRL::ComPtr<IMFSample>& sampleData, _Out_ bool* readerStillValid);
+    HRESULT ReadSample(WRL::ComPtr<IMFSample>& sampleData, _Out_ bool* readerStillValid, _Out_opt_ LONGLONG* timestamp);
     HRESULT RefreshStreamPropertyCache();
+    HRESULT SetMediaProfile(UINT32 profileIndex);
+
+    static FramePixelFormat GetFramePixelFormat(REFGUID subtype);
+    static GUID GetMediaSubtype(FramePixelFormat format);
 
 private:
 
     HRESULT InitializeSourceDevice(_In_ LPCWSTR targetDeviceId);
+    HRESULT InitializeSourceDeviceFromCache(_In_ LPCWSTR targetDeviceId, _In_ const MediaDeviceCapabilities& cachedCapabilities);
+    HRESULT InitializeSourceDeviceFromEnumeration(_In_ LPCWSTR targetDeviceId);
     HRESULT EnumMediaCaptureDevices(_In_ LPCWSTR targetDeviceId, _In_ const WRL::ComPtr<IMFAttributes>& enumAtributes, _Out_ WRL::ComPtr<IMFActivate>& mediaSourceActivate);
-    HRESULT InitializeMediaSourceReader(_In_ const WRL::ComPtr<IMFActivate>& mediaSourceActivate, _Out_ WRL::ComPtr<IMFSourceReader>& sourceReader, _Out_ DWORD* streamIndex);
-    HRESULT FindCompatibleMediaProfile(_In_ const WRL::ComPtr<IMFSourceReader>& sourceReader, _Outptr_ IMFMediaType** chosenType, _Out_ DWORD* chosesStreamIndex);
+    HRESULT CreateMediaSourceReader(_In_ const WRL::ComPtr<IMFMediaSource>& mediaSource, _Out_ WRL::ComPtr<IMFSourceReader>& sourceReader);
+    void RankMediaProfiles(_Inout_ MediaDeviceCapabilities& capabilities);
+    static double ScoreMediaProfile(_In_ const MediaProfileDescriptor& profile);
+    HRESULT FindCompatibleMediaProfile(_In_ const WRL::ComPtr<IMFSourceReader>& sourceReader, _Inout_ MediaDeviceCapabilities& capabilities);
+    HRESULT ApplyMediaProfile(_In_ const WRL::ComPtr<IMFSourceReader>& sourceReader, _In_ const MediaProfileDescriptor& profile, _Outptr_ IMFMediaType** appliedType);
     HRESULT AcquireIdentificationStrings(_In_ const WRL::ComPtr<IMFActivate>& sourceActivation);
+    HRESULT AcquireIdentificationStrings(_In_ const MediaDeviceCapabilities& capabilities);
     HRESULT QueryIsMirroredState(_Out_ bool* isMirrored);
     bool IsMediaProfileValid(_In_ const WRL::ComPtr<IMFMediaType>& workingProfile);
+    HRESULT DescribeMediaProfile(_In_ const WRL::ComPtr<IMFMediaType>& mediaType, DWORD streamIndex, DWORD typeIndex, _Out_ MediaProfileDescriptor* profile);
 
     WRL::ComPtr<IMFSourceReader> _sourceReader;
     WRL::ComPtr<IMFMediaType> _sourceAttributes;
+    MediaDeviceCapabilities _capabilities;
+    FrameLayout _frameLayout;               // Layout of the frames returned by ReadSample
 
     WRLW::CriticalSection _threadLocker;
     LPWSTR _uniqueSourceID;
@@ -21,17 +21,33 @@ using namespace Microsoft::WRL::Wrappers;
 
 namespace MediaFoundationProvider {
 
+// Maximum time SetMediaProfile waits for the last ReadFrameProc task to exit
+static const DWORD DrainTimeoutMilliseconds = 500;
+
+// Time ReadFrameProc waits before polling a frame source again that ran out of frames
+static const DWORD EndOfSourceWaitMilliseconds = 100;
+
+// Value of _idealProcessor if SetWorkerAffinity wasn't called; ReadFrameProc runs wherever the thread pool schedules it
+static const DWORD NoIdealProcessor = static_cast<DWORD>(-1);
+
 MediaFoundationWrapper::MediaFoundationWrapper() :
+    _readFrameWork(nullptr),
+    _reader(nullptr),
+    _readResult(E_ABORT),
     _readFrameFinished(NULL),
     _stopReadingFrames(NULL),
+    _currentFrame(),
     _currentFrameResult(0),
+    _idealProcessor(NoIdealProcessor),
     _running(false)
 {
     RoInitializeWrapper initialize(RO_INIT_MULTITHREADED);
     MFStartup(MF_VERSION, MFSTARTUP_NOSOCKET);
 
-    _stopReadingFrames = CreateEvent(NULL, TRUE, FALSE, L"MediaWrapper_StopReadingFrames");
-    _readFrameFinished = CreateEvent(NULL, FALSE, FALSE, L"MediaWrapper_ReadFrameFinished");
+    // NOTE: The events must not be named, otherwise every wrapper in the process would share them and stopping
+    // one device would stop reading frames from all of them
+    _stopReadingFrames = CreateEvent(NULL, TRUE, FALSE, NULL);
+    _readFrameFinished = CreateEvent(NULL, TRUE, FALSE, NULL);
 }
 
 MediaFoundationWrapper::~MediaFoundationWrapper()
@@ -55,7 +71,10 @@ HRESULT MediaFoundationWrapper::Initialize(_In_ LPCWSTR targetDeviceId)
     hr = _deviceManager.Initialize(targetDeviceId);
     if (SUCCEEDED(hr))
     {
-        hr = GetActivationFactory(HStringReference(RuntimeClass_Windows_System_Threading_ThreadPool).Get(), &_threadPool);
+        // The work object is reused for every frame, unlike ThreadPool::RunAsync which allocates a new
+        // work item and IAsyncAction each time
+        _readFrameWork = CreateThreadpoolWork(ReadFrameWorkCallback, this, nullptr);
+        hr = (_readFrameWork != nullptr) ? S_OK : HRESULT_FROM_WIN32(GetLastError());
     }
 
     return hr;
@@ -67,8 +86,19 @@ HRESULT MediaFoundationWrapper::Shutdown()
     // ReadFrameProc should exit within 1 frame (typically 33 ms) or less
     Stop(true);
 
+    // Releasing the recorder writes its index and closes the recording
+    _frameRecorder.reset();
+    _frameSource.reset();
+
     _deviceManager.Shutdown();
-    _threadPool.Reset();
+
+    // ReadFrameProc may still be restoring the ideal processor of its thread after signaling _readFrameFinished
+    if (_readFrameWork != nullptr)
+    {
+        WaitForThreadpoolWorkCallbacks(_readFrameWork, FALSE);
+        CloseThreadpoolWork(_readFrameWork);
+        _readFrameWork = nullptr;
+    }
     return S_OK;
 }
 
@@ -86,20 +116,17 @@ HRESULT MediaFoundationWrapper::Start()
         return E_ACCESSDENIED;
     }
 
-    hr = CreateReadFrameAsyncTask();
+    // Frames are read once the reader awaits ReadFrameAsync
+    hr = _deviceManager.ActivateStream(true);
     if (SUCCEEDED(hr))
     {
-        hr = _deviceManager.ActivateStream(true);
-        if (SUCCEEDED(hr))
-        {
-            _running = true;
-        }
+        _running = true;
+    }
 
-        // Update cached values of device properties
-        if (SUCCEEDED(hr))
-        {
-            _deviceManager.RefreshStreamPropertyCache();
-        }
+    // Update cached values of device properties
+    if (SUCCEEDED(hr))
+    {
+        _deviceManager.RefreshStreamPropertyCache();
     }
     return hr;
 }
@@ -134,40 +161,91 @@ HRESULT MediaFoundationWrapper::Stop(bool waitForStop)
         auto lock = _readFrameLock.Lock();
 
         _currentFrameResult = 0;
-        _currentFrame.Reset();
+        _currentFrame = CapturedFrame();
     }
 
     return S_OK;
 }
 
-HRESULT MediaFoundationWrapper::SubscribeReadFrame(const ComPtr<IWorkItemHandler>& readFrameCallback, EventRegistrationToken* pEventToken)
+HRESULT MediaFoundationWrapper::Detach()
+{
+    if (!IsInitialized()) return E_ABORT;
+
+    // Unlike Shutdown, only the device objects are released; MediaFoundation and the thread pool stay initialized
+    // NOTE: The device manager keeps the capabilities of the device so Reattach can open it directly
+    if (_running)
+    {
+        Stop(true);
+    }
+
+    return _deviceManager.Shutdown();
+}
+
+HRESULT MediaFoundationWrapper::Reattach(_In_ LPCWSTR targetDeviceId)
 {
     if (!IsInitialized()) return E_ABORT;
     if (_running) return E_ACCESSDENIED;
 
-    if (readFrameCallback == nullptr) return E_INVALIDARG;
-    if (pEventToken == nullptr) return E_POINTER;
+    return _deviceManager.Initialize(targetDeviceId);
+}
+
+HRESULT MediaFoundationWrapper::SetMediaProfile(UINT32 profileIndex)
+{
+    if (!IsInitialized()) return E_ABORT;
+    if (_running) return E_ACCESSDENIED;
+
+    // The media type may only change once the last ReadFrameProc task has exited, otherwise subscribers could
+    // still receive a frame of the previous media type. ReadFrameProc resets _stopReadingFrames and then signals
+    // _readFrameFinished when it exits after Stop was called.
+    if (WaitForSingleObject(_stopReadingFrames, 0) == WAIT_OBJECT_0)
+    {
+        if (WaitForSingleObject(_readFrameFinished, DrainTimeoutMilliseconds) != WAIT_OBJECT_0)
+        {
+            return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+        }
+    }
 
-    return _readFrameEvents.Add(readFrameCallback.Get(), pEventToken);
+    return _deviceManager.SetMediaProfile(profileIndex);
 }
 
-HRESULT MediaFoundationWrapper::SubscribeAvailableChanged(const ComPtr<IWorkItemHandler>& availableChangedCallback, EventRegistrationToken* pEventToken)
+HRESULT MediaFoundationWrapper::SetFrameSource(const std::shared_ptr<IFrameSource>& frameSource)
 {
     if (!IsInitialized()) return E_ABORT;
     if (_running) return E_ACCESSDENIED;
 
-    if (availableChangedCallback == nullptr) return E_INVALIDARG;
-    if (pEventToken == nullptr) return E_POINTER;
+    _frameSource = frameSource;
+    return S_OK;
+}
 
-    return _availableChangedEvents.Add(availableChangedCallback.Get(), pEventToken);
+HRESULT MediaFoundationWrapper::SetFrameRecorder(const std::shared_ptr<FrameRecorder>& frameRecorder)
+{
+    if (!IsInitialized()) return E_ABORT;
+    if (_running) return E_ACCESSDENIED;
+
+    _frameRecorder = frameRecorder;
+    return S_OK;
+}
+
+void MediaFoundationWrapper::SetWorkerAffinity(UINT32 workerSlot)
+{
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+
+    // Spread the wrappers of different devices over the processors, skipping processor 0 when possible since
+    // it services most of the system's interrupts, including those of the capture devices
+    const DWORD processorCount = systemInfo.dwNumberOfProcessors;
+    _idealProcessor = (processorCount > 1) ? 1 + (workerSlot % (processorCount - 1)) : 0;
 }
 
-HRESULT MediaFoundationWrapper::UnsubscribeReadFrame(EventRegistrationToken eventToken)
+HRESULT MediaFoundationWrapper::SubscribeAvailableChanged(const ComPtr<IWorkItemHandler>& availableChangedCallback, EventRegistrationToken* pEventToken)
 {
     if (!IsInitialized()) return E_ABORT;
     if (_running) return E_ACCESSDENIED;
 
-    return _readFrameEvents.Remove(eventToken);
+    if (availableChangedCallback == nullptr) return E_INVALIDARG;
+    if (pEventToken == nullptr) return E_POINTER;
+
+    return _availableChangedEvents.Add(availableChangedCallback.Get(), pEventToken);
 }
 
 HRESULT MediaFoundationWrapper::UnsubscribeAvailableChanged(EventRegistrationToken eventToken)
@@ -178,31 +256,57 @@ HRESULT MediaFoundationWrapper::UnsubscribeAvailableChanged(EventRegistrationTok
     return _availableChangedEvents.Remove(eventToken);
 }
 
-HRESULT MediaFoundationWrapper::CreateReadFrameAsyncTask()
+void MediaFoundationWrapper::ReadNextFrame(std::experimental::coroutine_handle<> reader)
 {
-    HRESULT hr;
+    // The reader is done with the previous frame; its data is no longer valid once the buffer is unlocked, unless the
+    // reader took the sample
+    LockedFrameSample previousSample;
+    {
+        auto lock = _readFrameLock.Lock();
+        _currentFrame.Data = nullptr;
+        _currentFrame.Length = 0;
+        previousSample = std::move(_currentSample);
+    }
+    previousSample.Unlock();
 
+    _reader = reader;
+    CreateReadFrameAsyncTask();
+}
+
+HRESULT MediaFoundationWrapper::CreateReadFrameAsyncTask()
+{
     // Since we're about to start a new ReadFrame task, ensure _readFrameFinished event is not signaled
-    // NOTE: We don't keep the reference to IAsyncAction since only one task runs at a time and running
-    // status and errors are communicated through member variables.
+    // NOTE: Only one task runs at a time and running status and errors are communicated through member variables.
     ResetEvent(_readFrameFinished);
 
-    ComPtr<IAsyncAction> asyncAction;
-    hr = _threadPool->RunAsync(Callback<IWorkItemHandler>([this](IAsyncAction* asyncAction) -> HRESULT
-    {
-        UNREFERENCED_PARAMETER(asyncAction);
+    SubmitThreadpoolWork(_readFrameWork);
+    return S_OK;
+}
 
-        this->ReadFrameProc();
-        return S_OK;
-    }).Get(), &asyncAction);
+VOID CALLBACK MediaFoundationWrapper::ReadFrameWorkCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work)
+{
+    UNREFERENCED_PARAMETER(instance);
+    UNREFERENCED_PARAMETER(work);
 
-    return hr;
+    static_cast<MediaFoundationWrapper*>(context)->ReadFrameProc();
 }
 
 void MediaFoundationWrapper::ReadFrameProc()
 {
     bool availablityChanged = false;
-    HRESULT hr = S_OK;
+    HRESULT hr = E_ABORT;
+
+    // The buffer of the current sample stays locked until the reader awaits the next frame or, if the reader took the
+    // sample, until it's done with the frame
+    LockedFrameSample lockedSample;
+    CapturedFrame capturedFrame = {};
+
+    // Run this device's frame work on its ideal processor; the thread belongs to the pool and is shared with
+    // other work items, so the previous ideal processor is restored before returning
+    const DWORD idealProcessor = _idealProcessor;
+    const DWORD previousIdealProcessor = (idealProcessor != NoIdealProcessor) ?
+        SetThreadIdealProcessor(GetCurrentThread(), idealProcessor) :
+        NoIdealProcessor;
 
     // At each stage of the task, check that _stopReadingFrames is not signalled
     // Otherwise, exit the proc as quickly as possible
@@ -213,38 +317,43 @@ void MediaFoundationWrapper::ReadFrameProc()
         // If the device is connected, attempt to read the next frame from the device
         // If this fails, we'll assume device is no longer available and signal this to ISourceProvider.
         ComPtr<IMFSample> sampleData;
+        LONGLONG timestamp;
         bool readerStillValid;
 
-        if (_deviceManager.IsInitialized())
+        if (_frameSource != nullptr)
+        {
+            // Frames come from the frame source instead of the device, e.g. a recording being replayed
+            hr = _frameSource->ReadFrame(capturedFrame) ? S_OK : MF_E_END_OF_STREAM;
+        }
+        else if (_deviceManager.IsInitialized())
         {
-            hr = _deviceManager.ReadSample(sampleData, &readerStillValid);
+            hr = _deviceManager.ReadSample(sampleData, &readerStillValid, &timestamp);
             if (!readerStillValid)
             {
                 _deviceManager.Shutdown(); // Device objects are no longer valid so get rid of them
                 availablityChanged = true;
             }
-        }
-        else hr = E_NOT_SET;
 
-        // Don't update current results if we've been signaled to exit; Stop() will reset the values
-        if (CheckIfKeepRunning())
-        {
-            // If ReadFrame succeeded and produce a valid sample save it to current results
-            // Else if we failed because availabity changed clear frame data (it's invalid) but save HR
-            // Otherwise do nothing
             if (SUCCEEDED(hr))
             {
-                _currentFrame = sampleData;
-                _currentFrameResult = hr;
+                hr = LockSample(sampleData, timestamp, &capturedFrame, lockedSample);
             }
-            else if (availablityChanged)
+
+            // Record exactly what the device produced; Append only copies the frame, the file is written on another thread
+            if (SUCCEEDED(hr) && _frameRecorder != nullptr)
             {
-                _currentFrame.Reset();
-                _currentFrameResult = hr;
+                _frameRecorder->Append(capturedFrame);
             }
         }
+        else hr = E_NOT_SET;
     } // Leave CriticalSection
 
+    // Don't spin on a frame source that ran out of frames, wait a little unless we're stopped in the meantime
+    if (hr == MF_E_END_OF_STREAM)
+    {
+        WaitForSingleObject(_stopReadingFrames, EndOfSourceWaitMilliseconds);
+    }
+
     // If availablity of the sensor has changed, call event handlers
     if (CheckIfKeepRunning())
     {
@@ -257,27 +366,44 @@ void MediaFoundationWrapper::ReadFrameProc()
         }
     }
 
-    // If succesfully acquired new frame data, call event handlers
-    if (CheckIfKeepRunning())
+    // If we're still running, the reader gets the frame and awaits the next one; otherwise it's told to stop
+    // NOTE: Once we've committed to keep running don't check the event again, the next ReadFrameProc task does
+    const bool commitedToKeepRunning = CheckIfKeepRunning();
     {
-        if (SUCCEEDED(hr))
+        auto lock = _readFrameLock.Lock();
+
+        // Don't update current results if we've been signaled to exit; Stop() will reset the values
+        // If ReadFrame succeeded and produce a valid sample save it to current results
+        // Else if we failed because availabity changed clear frame data (it's invalid) but save HR
+        // Otherwise do nothing
+        if (commitedToKeepRunning && SUCCEEDED(hr))
         {
-            if (FAILED(_readFrameEvents.InvokeAll(nullptr)))
-            {
-                // This doesn't impact ReadFrame functionality so we can ignore failures
-            }
+            _currentFrame = capturedFrame;
+            _currentSample = std::move(lockedSample);
+            _currentFrameResult = hr;
         }
+        else if (commitedToKeepRunning && availablityChanged)
+        {
+            _currentFrame = CapturedFrame();
+            _currentFrameResult = hr;
+        }
+
+        _readResult = commitedToKeepRunning ? hr : E_ABORT;
     }
 
-    // If we're still running, queue up another ReadFrameProc task
-    // NOTE: Once we've committed to spawning a new task don't check the event again
-    bool commitedToKeepRunning = CheckIfKeepRunning();
-    if (commitedToKeepRunning)
+    // A frame that isn't handed to the reader is no longer needed
+    lockedSample.Unlock();
+
+    // The reader handles the frame on this thread and, unless it was told to stop, awaits the next frame before
+    // resume returns, which already submits the next ReadFrameProc task
+    std::experimental::coroutine_handle<> reader = _reader;
+    _reader = nullptr;
+    if (reader)
     {
-        CreateReadFrameAsyncTask();
+        reader.resume();
     }
 
-    // If we've been signaled to Stop, set _stopReadingFrames indicating we're exiting the
+    // If we've been signaled to Stop, the reader has exited; set _readFrameFinished indicating we're exiting the
     // ReadFrame proc and Manually reset _stopReadingFrames
     //
     // NOTE: Reset _stopReadingFrames event BEFORE signaling _readFrameFinished, this should
@@ -288,6 +414,91 @@ void MediaFoundationWrapper::ReadFrameProc()
         ResetEvent(_stopReadingFrames);
         SetEvent(_readFrameFinished);
     }
+
+    // NOTE: Don't access any members from here on, the wrapper may be destroyed once _readFrameFinished is signaled
+    if (previousIdealProcessor != NoIdealProcessor)
+    {
+        SetThreadIdealProcessor(GetCurrentThread(), previousIdealProcessor);
+    }
+}
+
+HRESULT MediaFoundationWrapper::TakeCurrentFrame(_Out_ CapturedFrame* frame, _Out_ LockedFrameSample* sample)
+{
+    auto lock = _readFrameLock.Lock();
+
+    *frame = _currentFrame;
+    *sample = std::move(_currentSample);
+    return _currentFrameResult;
+}
+
+HRESULT MediaFoundationWrapper::LockSample(_In_ const ComPtr<IMFSample>& sample, LONGLONG timestamp, _Out_ CapturedFrame* frame, _Out_ LockedFrameSample& lockedSample)
+{
+    BYTE* data;
+    DWORD length;
+
+    *frame = CapturedFrame();
+
+    // Lock the sample's buffer, it stays locked until lockedSample is unlocked
+    HRESULT hr = lockedSample.Lock(sample, &data, &length);
+    if (SUCCEEDED(hr))
+    {
+        frame->Data = data;
+        frame->Length = length;
+        frame->Layout = _deviceManager.GetFrameLayout();
+        frame->Timestamp = timestamp;
+
+        // IMPORTANT: This is a custom GUID assigned to the sample within MFT0
+        // The MFT0 code, which is installed and associated with the device driver, is responsible for
+        // polling the LED illumination state from the device and tagging the sample with this value
+        UINT32 illuminationEnabled;
+        frame->IlluminationTagged = SUCCEEDED(sample->GetUINT32(WDPP_ACTIVE_ILLUMINATION_ENABLED, &illuminationEnabled));
+        frame->IlluminationEnabled = frame->IlluminationTagged && (illuminationEnabled != 0);
+    }
+
+    return hr;
+}
+
+LockedFrameSample& LockedFrameSample::operator=(LockedFrameSample&& other)
+{
+    if (this != &other)
+    {
+        Unlock();
+        _sample = std::move(other._sample);
+        _buffer = std::move(other._buffer);
+    }
+    return *this;
+}
+
+HRESULT LockedFrameSample::Lock(_In_ const ComPtr<IMFSample>& sample, _Out_ BYTE** data, _Out_ DWORD* length)
+{
+    ComPtr<IMFMediaBuffer> sampleBuffer;
+
+    Unlock();
+
+    // The sample is kept along with its buffer, otherwise the source could recycle the buffer for another frame
+    HRESULT hr = sample->GetBufferByIndex(0, sampleBuffer.GetAddressOf());
+    if (SUCCEEDED(hr))
+    {
+        hr = sampleBuffer->Lock(data, NULL, length);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        _sample = sample;
+        _buffer = sampleBuffer;
+    }
+
+    return hr;
+}
+
+void LockedFrameSample::Unlock()
+{
+    if (_buffer != nullptr)
+    {
+        _buffer->Unlock();
+    }
+    _buffer.Reset();
+    _sample.Reset();
 }
 
 inline bool MediaFoundationWrapper::CheckIfKeepRunning()
@@ -310,7 +521,7 @@ bool MediaFoundationWrapper::CheckIfAvailable()
             ComPtr<IMFSample> dummyData;
             bool availablityChanged = false;
 
-            _deviceManager.ReadSample(dummyData, &currentlyAvailable);
+            _deviceManager.ReadSample(dummyData, &currentlyAvailable, nullptr);
             if (!currentlyAvailable)
             {
                 _deviceManager.Shutdown(); // Device objects are no longer valid so get rid of them
@@ -13,10 +13,51 @@
 
 namespace MediaFoundationProvider {
 
+// The media sample a frame was read from, kept alive with its buffer locked so the frame's data stays valid after the
+// next frame was read, e.g. until the frame was converted on another thread
+// NOTE: The buffer is unlocked by Unlock or when the LockedFrameSample is destroyed
+class LockedFrameSample
+{
+public:
+
+    LockedFrameSample() {}
+    LockedFrameSample(LockedFrameSample&& other) : _sample(std::move(other._sample)), _buffer(std::move(other._buffer)) {}
+    ~LockedFrameSample() { Unlock(); }
+
+    LockedFrameSample& operator=(LockedFrameSample&& other);
+    LockedFrameSample(const LockedFrameSample&) = delete;
+    LockedFrameSample& operator=(const LockedFrameSample&) = delete;
+
+    HRESULT Lock(_In_ const WRL::ComPtr<IMFSample>& sample, _Out_ BYTE** data, _Out_ DWORD* length);
+    void Unlock();
+    bool IsLocked() const { return _buffer != nullptr; }
+
+private:
+
+    WRL::ComPtr<IMFSample> _sample;
+    WRL::ComPtr<IMFMediaBuffer> _buffer;
+};
+
 class MediaFoundationWrapper
 {
 public:
 
+    // Awaited by the coroutine reading the frames, see ReadFrameAsync
+    class ReadFrameAwaiter
+    {
+    public:
+
+        explicit ReadFrameAwaiter(MediaFoundationWrapper& wrapper) : _wrapper(wrapper) {}
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::experimental::coroutine_handle<> reader) { _wrapper.ReadNextFrame(reader); }
+        HRESULT await_resume() const { return _wrapper._readResult; }
+
+    private:
+
+        MediaFoundationWrapper& _wrapper;
+    };
+
     MediaFoundationWrapper();
     virtual ~MediaFoundationWrapper();
 
@@ -24,35 +65,56 @@ public:
     HRESULT Shutdown();
     HRESULT Start();
     HRESULT Stop(bool waitForStop);
+    HRESULT SetMediaProfile(UINT32 profileIndex);
+    HRESULT Detach();
+    HRESULT Reattach(_In_ LPCWSTR targetDeviceId);
+    void SetWorkerAffinity(UINT32 workerSlot);
+    HRESULT SetFrameSource(const std::shared_ptr<IFrameSource>& frameSource);
+    HRESULT SetFrameRecorder(const std::shared_ptr<FrameRecorder>& frameRecorder);
+
+    // Reads the next frame on the wrapper's work item and resumes the awaiting coroutine on it: with S_OK once a frame
+    // was read, with E_ABORT once the wrapper was stopped, which ends the stream, or with the error reading failed with,
+    // e.g. because the device was removed. The reader handles the frame before it awaits the next one, which frees it.
+    // NOTE: Only one coroutine reads frames and it must not await again after E_ABORT
+    ReadFrameAwaiter ReadFrameAsync() { return ReadFrameAwaiter(*this); }
 
-    HRESULT SubscribeReadFrame(const WRL::ComPtr<AWST::IWorkItemHandler>& readFrameCallback, EventRegistrationToken* pEventToken);
     HRESULT SubscribeAvailableChanged(const WRL::ComPtr<AWST::IWorkItemHandler>& availableChangedCallback, EventRegistrationToken* pEventToken);
-    HRESULT UnsubscribeReadFrame(EventRegistrationToken eventToken);
     HRESULT UnsubscribeAvailableChanged(EventRegistrationToken eventToken);
 
     WRL::ComPtr<IMFMediaType> GetSourceAttributes() { return _deviceManager.GetSourceAttributes(); }
-    WRL::ComPtr<IMFSample> GetCurrentFrame() { _readFrameLock.Lock(); { return _currentFrame; } }
-    HRESULT GetCurrentFrameResult() { _readFrameLock.Lock(); { return _currentFrameResult; } }
+    MediaDeviceCapabilities GetCapabilities() { return _deviceManager.GetCapabilities(); }
+    // NOTE: The frame's data is only valid until the reader awaits the next frame
+    HRESULT GetCurrentFrame(_Out_ CapturedFrame* frame) { auto lock = _readFrameLock.Lock(); *frame = _currentFrame; return _currentFrameResult; }
+    // Hands the locked sample of the current frame to the reader, so the frame's data stays valid until the reader
+    // unlocks it; frames of a frame source stay valid until the source is replaced and come without one
+    HRESULT TakeCurrentFrame(_Out_ CapturedFrame* frame, _Out_ LockedFrameSample* sample);
     LPWSTR GetUniqueSourceID() { return _deviceManager.GetUniqueSourceID(); }
     LPWSTR GetFriendSourceName() { return _deviceManager.GetFriendSourceName(); }
-    bool IsInitialized() { return _threadPool != nullptr; }
+    bool IsInitialized() { return _readFrameWork != nullptr; }
     bool IsRunning() { return _running; }
     bool IsAvailable() { return CheckIfAvailable(); }
     bool IsMirrored() { return _deviceManager.IsMirrored(); }
 
 private:
 
+    void ReadNextFrame(std::experimental::coroutine_handle<> reader);
     HRESULT CreateReadFrameAsyncTask();
+    static VOID CALLBACK ReadFrameWorkCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
     void ReadFrameProc();
     inline bool CheckIfKeepRunning();
     bool CheckIfAvailable();
+    HRESULT LockSample(_In_ const WRL::ComPtr<IMFSample>& sample, LONGLONG timestamp, _Out_ CapturedFrame* frame, _Out_ LockedFrameSample& lockedSample);
 
     MediaDeviceManager _deviceManager;
+    std::shared_ptr<IFrameSource> _frameSource;         // Replaces the device as the source of frames if set
+    std::shared_ptr<FrameRecorder> _frameRecorder;      // Records every frame read from the device if set
 
-    WRL::ComPtr<AWST::IThreadPoolStatics> _threadPool;
-    WRL::ComPtr<IMFSample> _currentFrame;
+    PTP_WORK _readFrameWork;                            // Created once and submitted for every frame
+    std::experimental::coroutine_handle<> _reader;      // Resumed by ReadFrameProc once the frame was read
+    HRESULT _readResult;                                // Returned to _reader by ReadFrameAsync
+    CapturedFrame _currentFrame;
+    LockedFrameSample _currentSample;                   // Unlocked once the reader awaits the next frame unless it took it
 
-    WRL::EventSource<AWST::IWorkItemHandler> _readFrameEvents;
     WRL::EventSource<AWST::IWorkItemHandler> _availableChangedEvents;
 
     HANDLE _readFrameFinished;
@@ -60,6 +122,7 @@ private:
     WRLW::CriticalSection _readFrameLock;
 
     HRESULT _currentFrameResult;
+    DWORD _idealProcessor;
     bool _running;
 };
 
@@ -0,0 +1,422 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+// DEVPKEY values are only declared by devpkey.h; initguid.h makes this file provide their definitions
+#include <initguid.h>
+#include <devpkey.h>
+#include <cfgmgr32.h>
+#include <sddl.h>
+#include <aclapi.h>
+
+namespace MediaFoundationProvider
+{
+
+// Layout of a cache file:
+//   CacheFileHeader
+//   WCHAR[SymbolicLinkLength]          (strings are not null terminated)
+//   WCHAR[DriverVersionLength]
+//   WCHAR[FriendlyNameLength]
+//   MediaProfileDescriptor[ProfileCount]
+struct CacheFileHeader
+{
+    UINT32 Magic;
+    UINT32 Version;
+    UINT32 SymbolicLinkLength;
+    UINT32 DriverVersionLength;
+    UINT32 FriendlyNameLength;
+    UINT32 ProfileCount;
+    UINT32 SelectedProfileIndex;
+    UINT32 Flags;                       // CacheFlag values
+    UINT32 Checksum;                    // FNV-1a hash of everything following the header
+};
+
+static const UINT32 CacheFileMagic = 0x4D504643;    // "CFPM"
+static const UINT32 CacheFileVersion = 3;     // 2: Profiles include every format with a Gray8 conversion kernel, 3: Flags
+static const UINT32 CacheFlagSensorCameraCategory = 0x1;
+static const UINT32 MaxCachedStringLength = 1024;
+static const UINT32 MaxCachedProfileCount = 1024;
+static const LONGLONG MaxCacheFileSize = 1024 * 1024;
+
+// Only SYSTEM and Administrators may create or change cache files, the provider trusts their contents to pick media types
+// P: don't inherit the permissive ACL of ProgramData; OICI: files created in the directory get the same ACL
+static const LPCWSTR CacheDirectorySecurity = L"D:P(A;OICI;FA;;;SY)(A;OICI;FA;;;BA)";
+
+static UINT32 ComputeChecksum(_In_reads_bytes_(length) const BYTE* data, size_t length)
+{
+    UINT32 hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// True if the object is owned by SYSTEM or Administrators, i.e. wasn't created by an ordinary user
+static bool IsOwnedByAdministrators(_In_ HANDLE object)
+{
+    PSID owner = nullptr;
+    PSECURITY_DESCRIPTOR securityDescriptor = nullptr;
+
+    DWORD error = GetSecurityInfo(object, SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION, &owner, NULL, NULL, NULL, &securityDescriptor);
+    if (error != ERROR_SUCCESS) return false;
+
+    const bool trusted = IsWellKnownSid(owner, WinLocalSystemSid) || IsWellKnownSid(owner, WinBuiltinAdministratorsSid);
+    LocalFree(securityDescriptor);
+    return trusted;
+}
+
+static void AppendBytes(std::vector<BYTE>& buffer, _In_reads_bytes_(length) const void* data, size_t length)
+{
+    const BYTE* bytes = static_cast<const BYTE*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + length);
+}
+
+MediaProfileCache::MediaProfileCache()
+{
+    // Cached capabilities are shared by every process loading the provider so they're kept in ProgramData
+    WCHAR expandedPath[MAX_PATH];
+    DWORD length = ExpandEnvironmentStringsW(L"%ProgramData%\\SampleFrameProvider\\ProfileCache", expandedPath, ARRAYSIZE(expandedPath));
+    if (length > 0 && length <= ARRAYSIZE(expandedPath) && expandedPath[0] != L'%')
+    {
+        _cacheDirectory = expandedPath;
+    }
+}
+
+HRESULT MediaProfileCache::Lookup(_In_ LPCWSTR symbolicLink, _Out_ MediaDeviceCapabilities* capabilities)
+{
+    if (symbolicLink == nullptr || capabilities == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::wstring filePath;
+    std::wstring driverVersion;
+    std::vector<BYTE> fileData;
+
+    HRESULT hr = GetCacheFilePath(symbolicLink, false, filePath);
+    if (SUCCEEDED(hr))
+    {
+        hr = QueryDriverVersion(symbolicLink, driverVersion);
+    }
+
+    // Read the entire file in one go, it's typically only a few hundred bytes
+    if (SUCCEEDED(hr))
+    {
+        HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+        }
+        else
+        {
+            // Entries written by anyone but the service, e.g. into a directory created before it was locked down, are ignored
+            LARGE_INTEGER fileSize;
+            if (!IsOwnedByAdministrators(file))
+            {
+                hr = HRESULT_FROM_WIN32(ERROR_INVALID_OWNER);
+            }
+            else if (!GetFileSizeEx(file, &fileSize))
+            {
+                hr = HRESULT_FROM_WIN32(GetLastError());
+            }
+            else if (fileSize.QuadPart < static_cast<LONGLONG>(sizeof(CacheFileHeader)) || fileSize.QuadPart > MaxCacheFileSize)
+            {
+                hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+            }
+            else
+            {
+                DWORD bytesRead = 0;
+                fileData.resize(static_cast<size_t>(fileSize.QuadPart));
+                if (!ReadFile(file, fileData.data(), static_cast<DWORD>(fileData.size()), &bytesRead, NULL))
+                {
+                    hr = HRESULT_FROM_WIN32(GetLastError());
+                }
+                else if (bytesRead != fileData.size())
+                {
+                    hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+                }
+            }
+            CloseHandle(file);
+        }
+    }
+
+    // Validate the header and that the payload size exactly matches the counts it specifies
+    CacheFileHeader header = { 0 };
+    if (SUCCEEDED(hr))
+    {
+        memcpy(&header, fileData.data(), sizeof(header));
+
+        const size_t expectedSize = sizeof(CacheFileHeader) +
+            (static_cast<size_t>(header.SymbolicLinkLength) + header.DriverVersionLength + header.FriendlyNameLength) * sizeof(WCHAR) +
+            static_cast<size_t>(header.ProfileCount) * sizeof(MediaProfileDescriptor);
+
+        if ((header.Magic != CacheFileMagic) ||
+            (header.Version != CacheFileVersion) ||
+            (header.SymbolicLinkLength > MaxCachedStringLength) ||
+            (header.DriverVersionLength > MaxCachedStringLength) ||
+            (header.FriendlyNameLength > MaxCachedStringLength) ||
+            (header.ProfileCount == 0) ||
+            (header.ProfileCount > MaxCachedProfileCount) ||
+            (header.SelectedProfileIndex >= header.ProfileCount) ||
+            (expectedSize != fileData.size()) ||
+            (header.Checksum != ComputeChecksum(fileData.data() + sizeof(header), fileData.size() - sizeof(header))))
+        {
+            hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+    }
+
+    // The entry is only a hit if it was written for this device and the same driver version
+    if (SUCCEEDED(hr))
+    {
+        const WCHAR* strings = reinterpret_cast<const WCHAR*>(fileData.data() + sizeof(header));
+        std::wstring cachedSymbolicLink(strings, header.SymbolicLinkLength);
+        std::wstring cachedDriverVersion(strings + header.SymbolicLinkLength, header.DriverVersionLength);
+
+        if ((_wcsicmp(cachedSymbolicLink.c_str(), symbolicLink) != 0) || (cachedDriverVersion != driverVersion))
+        {
+            hr = HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        }
+        else
+        {
+            const BYTE* profileData = reinterpret_cast<const BYTE*>(strings + header.SymbolicLinkLength + header.DriverVersionLength + header.FriendlyNameLength);
+
+            capabilities->SymbolicLink = cachedSymbolicLink;
+            capabilities->FriendlyName.assign(strings + header.SymbolicLinkLength + header.DriverVersionLength, header.FriendlyNameLength);
+            capabilities->Profiles.resize(header.ProfileCount);
+            memcpy(capabilities->Profiles.data(), profileData, header.ProfileCount * sizeof(MediaProfileDescriptor));
+            capabilities->SelectedProfileIndex = header.SelectedProfileIndex;
+            capabilities->SensorCameraCategory = (header.Flags & CacheFlagSensorCameraCategory) != 0;
+        }
+    }
+
+    return hr;
+}
+
+HRESULT MediaProfileCache::Store(_In_ LPCWSTR symbolicLink, const MediaDeviceCapabilities& capabilities)
+{
+    if (symbolicLink == nullptr ||
+        capabilities.Profiles.empty() ||
+        capabilities.Profiles.size() > MaxCachedProfileCount ||
+        capabilities.SelectedProfileIndex >= capabilities.Profiles.size() ||
+        capabilities.SymbolicLink.size() > MaxCachedStringLength ||
+        capabilities.FriendlyName.size() > MaxCachedStringLength)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::wstring filePath;
+    std::wstring driverVersion;
+
+    HRESULT hr = GetCacheFilePath(symbolicLink, true, filePath);
+    if (SUCCEEDED(hr))
+    {
+        hr = QueryDriverVersion(symbolicLink, driverVersion);
+    }
+    if (SUCCEEDED(hr) && driverVersion.size() > MaxCachedStringLength)
+    {
+        hr = E_INVALIDARG;
+    }
+
+    // Serialize the capabilities into a single buffer
+    std::vector<BYTE> fileData;
+    if (SUCCEEDED(hr))
+    {
+        CacheFileHeader header = { 0 };
+        header.Magic = CacheFileMagic;
+        header.Version = CacheFileVersion;
+        header.SymbolicLinkLength = static_cast<UINT32>(capabilities.SymbolicLink.size());
+        header.DriverVersionLength = static_cast<UINT32>(driverVersion.size());
+        header.FriendlyNameLength = static_cast<UINT32>(capabilities.FriendlyName.size());
+        header.ProfileCount = static_cast<UINT32>(capabilities.Profiles.size());
+        header.SelectedProfileIndex = capabilities.SelectedProfileIndex;
+        header.Flags = capabilities.SensorCameraCategory ? CacheFlagSensorCameraCategory : 0;
+
+        AppendBytes(fileData, &header, sizeof(header));
+        AppendBytes(fileData, capabilities.SymbolicLink.data(), capabilities.SymbolicLink.size() * sizeof(WCHAR));
+        AppendBytes(fileData, driverVersion.data(), driverVersion.size() * sizeof(WCHAR));
+        AppendBytes(fileData, capabilities.FriendlyName.data(), capabilities.FriendlyName.size() * sizeof(WCHAR));
+        AppendBytes(fileData, capabilities.Profiles.data(), capabilities.Profiles.size() * sizeof(MediaProfileDescriptor));
+
+        header.Checksum = ComputeChecksum(fileData.data() + sizeof(header), fileData.size() - sizeof(header));
+        memcpy(fileData.data(), &header, sizeof(header));
+    }
+
+    // Write to a temporary file and move it into place so a reader never observes a partially written entry
+    if (SUCCEEDED(hr))
+    {
+        std::wstring tempFilePath = filePath + L".tmp";
+
+        HANDLE file = CreateFileW(tempFilePath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+        }
+        else
+        {
+            DWORD bytesWritten = 0;
+            if (!WriteFile(file, fileData.data(), static_cast<DWORD>(fileData.size()), &bytesWritten, NULL))
+            {
+                hr = HRESULT_FROM_WIN32(GetLastError());
+            }
+            CloseHandle(file);
+        }
+
+        if (SUCCEEDED(hr) && !MoveFileExW(tempFilePath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        if (FAILED(hr))
+        {
+            DeleteFileW(tempFilePath.c_str());
+        }
+    }
+
+    return hr;
+}
+
+HRESULT MediaProfileCache::Invalidate(_In_ LPCWSTR symbolicLink)
+{
+    std::wstring filePath;
+
+    HRESULT hr = GetCacheFilePath(symbolicLink, false, filePath);
+    if (SUCCEEDED(hr) && !DeleteFileW(filePath.c_str()))
+    {
+        DWORD error = GetLastError();
+        hr = (error == ERROR_FILE_NOT_FOUND) ? S_OK : HRESULT_FROM_WIN32(error);
+    }
+
+    return hr;
+}
+
+HRESULT MediaProfileCache::GetCacheFilePath(_In_ LPCWSTR symbolicLink, bool createDirectory, _Out_ std::wstring& filePath)
+{
+    if (symbolicLink == nullptr) return E_INVALIDARG;
+    if (_cacheDirectory.empty()) return E_NOT_VALID_STATE;
+
+    // Symbolic links are long and full of reserved path characters so name the file after a hash of the link instead
+    // NOTE: Symbolic links are compared case insensitive, i.e. DeviceWatcher and MediaFoundation don't agree on casing
+    UINT64 hash = 14695981039346656037ull;
+    for (LPCWSTR current = symbolicLink; *current != L'\0'; current++)
+    {
+        hash = (hash ^ static_cast<UINT64>(towlower(*current))) * 1099511628211ull;
+    }
+
+    WCHAR fileName[32];
+    swprintf_s(fileName, L"\\%016llx.bin", hash);
+
+    // Create the cache directory, and its parent, if they don't exist yet
+    if (createDirectory)
+    {
+        HRESULT hr = CreateCacheDirectory();
+        if (FAILED(hr)) return hr;
+    }
+
+    filePath = _cacheDirectory + fileName;
+    return S_OK;
+}
+
+HRESULT MediaProfileCache::CreateCacheDirectory()
+{
+    PSECURITY_DESCRIPTOR securityDescriptor = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(CacheDirectorySecurity, SDDL_REVISION_1, &securityDescriptor, NULL))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    SECURITY_ATTRIBUTES securityAttributes = { sizeof(securityAttributes), securityDescriptor, FALSE };
+    HRESULT hr = S_OK;
+
+    std::wstring parentDirectory = _cacheDirectory.substr(0, _cacheDirectory.find_last_of(L'\\'));
+    if (!CreateDirectoryW(parentDirectory.c_str(), &securityAttributes) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        hr = HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    if (SUCCEEDED(hr) && !CreateDirectoryW(_cacheDirectory.c_str(), &securityAttributes))
+    {
+        hr = HRESULT_FROM_WIN32(GetLastError());
+
+        // The directory exists already, e.g. it was created before it was locked down or by someone else. Lock it down
+        // if it belongs to the service, otherwise don't store anything in it.
+        if (hr == HRESULT_FROM_WIN32(ERROR_ALREADY_EXISTS))
+        {
+            HANDLE directory = CreateFileW(_cacheDirectory.c_str(), READ_CONTROL | WRITE_DAC, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+            if (directory == INVALID_HANDLE_VALUE)
+            {
+                hr = HRESULT_FROM_WIN32(GetLastError());
+            }
+            else
+            {
+                BOOL daclPresent = FALSE;
+                BOOL daclDefaulted = FALSE;
+                PACL dacl = nullptr;
+
+                if (!IsOwnedByAdministrators(directory))
+                {
+                    hr = HRESULT_FROM_WIN32(ERROR_INVALID_OWNER);
+                }
+                else if (!GetSecurityDescriptorDacl(securityDescriptor, &daclPresent, &dacl, &daclDefaulted))
+                {
+                    hr = HRESULT_FROM_WIN32(GetLastError());
+                }
+                else
+                {
+                    DWORD error = SetSecurityInfo(directory, SE_FILE_OBJECT, DACL_SECURITY_INFORMATION | PROTECTED_DACL_SECURITY_INFORMATION,
+                        NULL, NULL, dacl, NULL);
+                    hr = (error == ERROR_SUCCESS) ? S_OK : HRESULT_FROM_WIN32(error);
+                }
+                CloseHandle(directory);
+            }
+        }
+    }
+
+    LocalFree(securityDescriptor);
+    return hr;
+}
+
+HRESULT MediaProfileCache::QueryDriverVersion(_In_ LPCWSTR symbolicLink, _Out_ std::wstring& driverVersion)
+{
+    DEVPROPTYPE propertyType;
+    WCHAR instanceId[MAX_DEVICE_ID_LEN];
+    WCHAR versionString[MAX_PATH];
+    ULONG bufferSize = sizeof(instanceId);
+    DEVINST deviceInstance = 0;
+
+    driverVersion.clear();
+
+    // The symbolic link identifies the device interface, the driver version is a property of the device node owning it
+    CONFIGRET cr = CM_Get_Device_Interface_PropertyW(symbolicLink, &DEVPKEY_Device_InstanceId, &propertyType, reinterpret_cast<PBYTE>(instanceId), &bufferSize, 0);
+    if (cr == CR_SUCCESS)
+    {
+        cr = CM_Locate_DevNodeW(&deviceInstance, instanceId, CM_LOCATE_DEVNODE_NORMAL);
+    }
+    if (cr == CR_SUCCESS)
+    {
+        bufferSize = sizeof(versionString);
+        cr = CM_Get_DevNode_PropertyW(deviceInstance, &DEVPKEY_Device_DriverVersion, &propertyType, reinterpret_cast<PBYTE>(versionString), &bufferSize, 0);
+    }
+    if (cr == CR_SUCCESS)
+    {
+        if (propertyType != DEVPROP_TYPE_STRING)
+        {
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+        driverVersion = versionString;
+    }
+
+    return (cr == CR_SUCCESS) ? S_OK : HRESULT_FROM_WIN32(CM_MapCrToWin32Err(cr, ERROR_NOT_FOUND));
+}
+
+} // end namespace
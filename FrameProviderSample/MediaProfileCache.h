@@ -0,0 +1,68 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace MediaFoundationProvider
+{
+
+// Describes a single native media type of the capture device, i.e. the media type returned by
+// IMFSourceReader::GetNativeMediaType(StreamIndex, TypeIndex)
+// NOTE: This structure is written to disk as-is and must remain a POD type
+struct MediaProfileDescriptor
+{
+    DWORD StreamIndex;
+    DWORD TypeIndex;
+    GUID Subtype;
+    UINT32 Width;
+    UINT32 Height;
+    UINT32 FrameRateNumerator;
+    UINT32 FrameRateDenominator;
+    UINT32 PixelAspectNumerator;
+    UINT32 PixelAspectDenominator;
+};
+
+// The result of enumerating a capture device: its identification strings, all valid media profiles
+// and the profile selected for streaming
+struct MediaDeviceCapabilities
+{
+    std::wstring SymbolicLink;
+    std::wstring FriendlyName;
+    std::vector<MediaProfileDescriptor> Profiles;
+    UINT32 SelectedProfileIndex;
+    bool SensorCameraCategory;      // The device was enumerated as a KSCATEGORY_SENSOR_CAMERA device
+};
+
+// Persists MediaDeviceCapabilities across provider instances so that a known device can be opened directly
+// without enumerating all capture devices and walking every native media type
+//
+// Each device is stored in its own small file keyed by the device's symbolic link. The driver version is
+// saved along with the capabilities and a lookup misses if it no longer matches, i.e. after a driver update.
+class MediaProfileCache
+{
+public:
+
+    MediaProfileCache();
+
+    HRESULT Lookup(_In_ LPCWSTR symbolicLink, _Out_ MediaDeviceCapabilities* capabilities);
+    HRESULT Store(_In_ LPCWSTR symbolicLink, const MediaDeviceCapabilities& capabilities);
+    HRESULT Invalidate(_In_ LPCWSTR symbolicLink);
+
+private:
+
+    HRESULT GetCacheFilePath(_In_ LPCWSTR symbolicLink, bool createDirectory, _Out_ std::wstring& filePath);
+    HRESULT CreateCacheDirectory();
+    HRESULT QueryDriverVersion(_In_ LPCWSTR symbolicLink, _Out_ std::wstring& driverVersion);
+
+    std::wstring _cacheDirectory;
+};
+
+} // end namespace
@@ -65,3 +65,168 @@ private:
 
     Microsoft::WRL::ComPtr<Windows::Foundation::IMemoryBufferByteAccess> m_spByteAccess;
 };
+
+//
+//
+// Caches the byte* and capacity of the most recently used IMemoryBuffers
+// Frame allocators hand out the same few frames over and over, so the IMemoryBufferReference of a frame is
+// created the first time the frame is seen and reused afterwards. The byte* of a cached buffer remains valid until
+// it's evicted, the cache is cleared or the buffer is closed; a closed buffer is evicted the next time it's looked up.
+// NOTE: Not thread safe, except that buffers may be closed on any thread
+//
+// ex:
+//      MemoryBufferByteAccessCache<4> byteAccessCache;
+//      unsigned char *pData = nullptr;
+//      unsigned int capacity;
+//      HRESULT hr = byteAccessCache.GetBuffer(spBuffer.Get(), &pData, &capacity);
+//
+template <size_t CacheSize>
+class MemoryBufferByteAccessCache
+{
+public:
+
+    MemoryBufferByteAccessCache() : m_nextEntry(0)
+    {
+        for (size_t i = 0; i < CacheSize; i++)
+        {
+            m_entries[i].closed = 0;
+            m_entries[i].closedToken.value = 0;
+        }
+        Clear();
+    }
+
+    ~MemoryBufferByteAccessCache()
+    {
+        Clear();
+    }
+
+    HRESULT GetBuffer(_In_ IInspectable *pBuffer, _Outptr_result_bytebuffer_(*pCapacity) BYTE **ppData, _Out_ UINT32 *pCapacity)
+    {
+        MemoryBufferPtr spMemoryBuffer;
+
+        *ppData = nullptr;
+        *pCapacity = 0;
+
+        HRESULT hr = pBuffer->QueryInterface(IID_PPV_ARGS(&spMemoryBuffer));
+
+        // The cached buffers are referenced, so a match can't be a different buffer at a reused address
+        CacheEntry* replacedEntry = nullptr;
+        for (size_t i = 0; SUCCEEDED(hr) && (i < CacheSize); i++)
+        {
+            if (m_entries[i].spMemoryBuffer == spMemoryBuffer)
+            {
+                // The byte* of a closed buffer is no longer valid; creating a new reference fails if it's still closed
+                if (InterlockedCompareExchange(&m_entries[i].closed, 0, 0) != 0)
+                {
+                    replacedEntry = &m_entries[i];
+                    break;
+                }
+
+                *ppData = m_entries[i].pData;
+                *pCapacity = m_entries[i].capacity;
+                return S_OK;
+            }
+        }
+
+        // Replace the closed entry of the buffer or the oldest entry
+        if (replacedEntry == nullptr)
+        {
+            replacedEntry = &m_entries[m_nextEntry];
+            m_nextEntry = (m_nextEntry + 1) % CacheSize;
+        }
+        CacheEntry& entry = *replacedEntry;
+        ClearEntry(entry);
+
+        if (SUCCEEDED(hr))
+        {
+            hr = spMemoryBuffer->CreateReference(&entry.spBufferReference);
+        }
+
+        Microsoft::WRL::ComPtr<Windows::Foundation::IMemoryBufferByteAccess> spByteAccess;
+        if (SUCCEEDED(hr))
+        {
+            hr = entry.spBufferReference.As(&spByteAccess);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            hr = spByteAccess->GetBuffer(&entry.pData, &entry.capacity);
+        }
+
+        // The reference is closed along with the buffer, e.g. if the service closes a frame it was handed
+        if (SUCCEEDED(hr))
+        {
+            volatile LONG* closed = &entry.closed;
+            hr = entry.spBufferReference->add_Closed(
+                Microsoft::WRL::Callback<__FITypedEventHandler_2_Windows__CFoundation__CIMemoryBufferReference_IInspectable>(
+                    [closed](MemoryBufferReference*, IInspectable*) -> HRESULT
+            {
+                InterlockedExchange(closed, 1);
+                return S_OK;
+            }).Get(), &entry.closedToken);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            entry.spMemoryBuffer = spMemoryBuffer;
+            *ppData = entry.pData;
+            *pCapacity = entry.capacity;
+        }
+        else
+        {
+            ClearEntry(entry);
+        }
+
+        return hr;
+    }
+
+    // Releases all cached references, e.g. when the frames of an allocator are no longer used
+    void Clear()
+    {
+        for (size_t i = 0; i < CacheSize; i++)
+        {
+            ClearEntry(m_entries[i]);
+        }
+    }
+
+private:
+
+#ifdef ____x_Windows_CFoundation_CIMemoryBuffer_FWD_DEFINED__
+    typedef Windows::Foundation::IMemoryBufferReference MemoryBufferReference;
+    typedef Microsoft::WRL::ComPtr<Windows::Foundation::IMemoryBuffer> MemoryBufferPtr;
+#else
+    typedef ABI::Windows::Foundation::IMemoryBufferReference MemoryBufferReference;
+    typedef Microsoft::WRL::ComPtr<ABI::Windows::Foundation::IMemoryBuffer> MemoryBufferPtr;
+#endif
+    typedef Microsoft::WRL::ComPtr<MemoryBufferReference> MemoryBufferReferencePtr;
+
+    struct CacheEntry
+    {
+        MemoryBufferPtr spMemoryBuffer;
+        MemoryBufferReferencePtr spBufferReference;
+        BYTE *pData;
+        UINT32 capacity;
+        EventRegistrationToken closedToken;
+        volatile LONG closed;               // Set by the Closed handler, which may run on any thread
+    };
+
+    static void ClearEntry(CacheEntry& entry)
+    {
+        // A handler that's already running may still set closed afterwards, which only evicts the next buffer early
+        if (entry.closedToken.value != 0)
+        {
+            entry.spBufferReference->remove_Closed(entry.closedToken);
+            entry.closedToken.value = 0;
+        }
+        InterlockedExchange(&entry.closed, 0);
+
+        // Releasing the last reference closes the IMemoryBufferReference
+        entry.spBufferReference.Reset();
+        entry.spMemoryBuffer.Reset();
+        entry.pData = nullptr;
+        entry.capacity = 0;
+    }
+
+    CacheEntry m_entries[CacheSize];
+    size_t m_nextEntry;
+};
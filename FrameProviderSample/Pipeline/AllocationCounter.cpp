@@ -0,0 +1,94 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "AllocationCounter.h"
+
+#ifdef FRAME_PIPELINE_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace MediaFoundationProvider {
+
+#ifdef FRAME_PIPELINE_COUNT_ALLOCATIONS
+
+static thread_local uint64_t ThreadAllocationCount = 0;
+
+bool IsAllocationCountingEnabled()
+{
+    return true;
+}
+
+uint64_t GetThreadAllocationCount()
+{
+    return ThreadAllocationCount;
+}
+
+static void* CountedAllocate(std::size_t size)
+{
+    ThreadAllocationCount++;
+
+    void* memory = std::malloc(size != 0 ? size : 1);
+    if (memory == nullptr) throw std::bad_alloc();
+
+    return memory;
+}
+
+#else
+
+bool IsAllocationCountingEnabled()
+{
+    return false;
+}
+
+uint64_t GetThreadAllocationCount()
+{
+    return 0;
+}
+
+#endif
+
+} // end namespace
+
+#ifdef FRAME_PIPELINE_COUNT_ALLOCATIONS
+
+// NOTE: The nothrow variants forward to these; over-aligned allocations aren't counted
+void* operator new(std::size_t size)
+{
+    return MediaFoundationProvider::CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return MediaFoundationProvider::CountedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+#endif
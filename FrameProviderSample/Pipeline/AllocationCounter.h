@@ -0,0 +1,27 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Counts the heap allocations made by each thread so tests can verify the steady-state frame path doesn't allocate
+//
+// Counting replaces the global operator new and is only compiled in if FRAME_PIPELINE_COUNT_ALLOCATIONS is defined,
+// which must only be done for test and benchmark executables, never for the provider DLL.
+bool IsAllocationCountingEnabled();
+
+// Returns the number of allocations made by the calling thread so far, or 0 if counting isn't enabled
+uint64_t GetThreadAllocationCount();
+
+} // end namespace
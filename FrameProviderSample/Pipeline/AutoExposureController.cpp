@@ -0,0 +1,116 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "AutoExposureController.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MediaFoundationProvider {
+
+static const double SaturationCorrection = -0.5;       // EV applied at least while too many pixels are saturated
+
+AutoExposureSettings AutoExposureController::GetDefaultSettings()
+{
+    AutoExposureSettings settings;
+    settings.TargetLevel = 100;
+    settings.MaxSaturatedFraction = 0.02;
+    settings.Deadband = 0.15;
+    settings.Gain = 0.6;
+    settings.MinUpdateInterval = 2500000;   // 250 ms
+    settings.MinValue = -2.0f;
+    settings.MaxValue = 2.0f;
+    settings.Step = 0.0f;
+
+    return settings;
+}
+
+AutoExposureController::AutoExposureController() :
+    _settings(GetDefaultSettings()),
+    _currentValue(0.0f),
+    _pendingValue(0.0f),
+    _pending(false),
+    _lastUpdateTime(0),
+    _updated(false),
+    _updates(0)
+{
+}
+
+void AutoExposureController::Configure(const AutoExposureSettings& settings, float currentValue)
+{
+    _settings = settings;
+    _currentValue = currentValue;
+    _pending = false;
+    _updated = false;
+}
+
+bool AutoExposureController::Evaluate(const LuminanceStatistics& statistics, int64_t time, float& newValue)
+{
+    if (statistics.Pixels == 0 || _pending) return false;
+    if (_updated && time - _lastUpdateTime < _settings.MinUpdateInterval) return false;
+
+    // The median isn't thrown off by small highlights, e.g. reflections of the illuminator
+    const double level = (std::max)(static_cast<double>(statistics.GetPercentile(0.5)), 1.0);
+    double error = std::log2(static_cast<double>(_settings.TargetLevel) / level);
+
+    const double saturatedFraction = static_cast<double>(statistics.Saturated) / statistics.Pixels;
+    if (saturatedFraction > _settings.MaxSaturatedFraction)
+    {
+        error = (std::min)(error, SaturationCorrection);
+    }
+
+    if (std::fabs(error) < _settings.Deadband) return false;
+
+    const float value = Quantize(_currentValue + _settings.Gain * error);
+    if (value == _currentValue) return false;
+
+    // A refused value is retried no sooner than an accepted one would be followed up
+    _pendingValue = value;
+    _pending = true;
+    _lastUpdateTime = time;
+    _updated = true;
+
+    newValue = value;
+    return true;
+}
+
+void AutoExposureController::Commit()
+{
+    if (!_pending) return;
+
+    _currentValue = _pendingValue;
+    _pending = false;
+    _updates++;
+}
+
+void AutoExposureController::Revert()
+{
+    _pending = false;
+}
+
+float AutoExposureController::Quantize(double value) const
+{
+    if (_settings.Step > 0.0f)
+    {
+        // Move at least one step so small errors above the deadband still make progress
+        double steps = std::round((value - _currentValue) / _settings.Step);
+        if (steps == 0.0)
+        {
+            steps = (value > _currentValue) ? 1.0 : -1.0;
+        }
+        value = _currentValue + steps * _settings.Step;
+    }
+
+    value = (std::min)((std::max)(value, static_cast<double>(_settings.MinValue)), static_cast<double>(_settings.MaxValue));
+    return static_cast<float>(value);
+}
+
+} // end namespace
@@ -0,0 +1,77 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameConversion.h"
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+struct AutoExposureSettings
+{
+    uint8_t TargetLevel;            // Median luminance of a well exposed illuminated frame
+    double MaxSaturatedFraction;    // Larger fractions of saturated pixels always lower the exposure
+    double Deadband;                // Errors below this many EV are left alone
+    double Gain;                    // Fraction of the error corrected by a single update
+    int64_t MinUpdateInterval;      // Minimum time between device updates, in 100 nanosecond units
+
+    // Range and granularity of the device's ExposureCompensation, in EV
+    float MinValue;
+    float MaxValue;
+    float Step;
+};
+
+// Drives the device's exposure compensation toward a target brightness
+//
+// Each illuminated frame's LuminanceStatistics is compared to the target and the correction is expressed in EV,
+// i.e. stops of brightness, so the controller converges at the same rate for dark and bright scenes. Only a part
+// of the error is corrected at a time and updates are at least MinUpdateInterval apart, which leaves the device
+// time to apply a value before its effect is measured. A value returned by Evaluate is only taken as the device's
+// value once the device accepted it, see Commit and Revert.
+// NOTE: Not thread safe.
+class AutoExposureController
+{
+public:
+
+    static AutoExposureSettings GetDefaultSettings();
+
+    AutoExposureController();
+
+    void Configure(const AutoExposureSettings& settings, float currentValue);
+
+    // Returns true and the value to apply if the device's exposure compensation should change
+    // Nothing is evaluated until the value is committed or reverted
+    bool Evaluate(const LuminanceStatistics& statistics, int64_t time, float& newValue);
+
+    // The device applied or refused the value returned by Evaluate
+    void Commit();
+    void Revert();
+    bool IsPending() const { return _pending; }
+
+    float GetCurrentValue() const { return _currentValue; }
+    uint64_t GetUpdates() const { return _updates; }
+
+private:
+
+    float Quantize(double value) const;
+
+    AutoExposureSettings _settings;
+    float _currentValue;            // Last value the device accepted
+    float _pendingValue;
+    bool _pending;
+    int64_t _lastUpdateTime;
+    bool _updated;
+    uint64_t _updates;
+};
+
+} // end namespace
@@ -0,0 +1,94 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "CacheMissCounter.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace MediaFoundationProvider {
+
+#ifdef __linux__
+
+CacheMissCounter::CacheMissCounter() :
+    _descriptor(-1)
+{
+    perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    // The calling thread on any CPU; glibc has no wrapper for the system call
+    _descriptor = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+CacheMissCounter::~CacheMissCounter()
+{
+    if (_descriptor >= 0)
+    {
+        close(_descriptor);
+    }
+}
+
+void CacheMissCounter::Start()
+{
+    if (_descriptor < 0) return;
+
+    ioctl(_descriptor, PERF_EVENT_IOC_RESET, 0);
+    ioctl(_descriptor, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+uint64_t CacheMissCounter::Stop()
+{
+    if (_descriptor < 0) return 0;
+
+    ioctl(_descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+    uint64_t misses = 0;
+    if (read(_descriptor, &misses, sizeof(misses)) != static_cast<ssize_t>(sizeof(misses)))
+    {
+        return 0;
+    }
+    return misses;
+}
+
+#else
+
+CacheMissCounter::CacheMissCounter() :
+    _descriptor(-1)
+{
+}
+
+CacheMissCounter::~CacheMissCounter()
+{
+}
+
+void CacheMissCounter::Start()
+{
+}
+
+uint64_t CacheMissCounter::Stop()
+{
+    return 0;
+}
+
+#endif
+
+} // end namespace
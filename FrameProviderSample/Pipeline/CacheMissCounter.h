@@ -0,0 +1,45 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Counts the last level cache misses of the calling thread between Start and Stop, e.g. to see how much of a frame's
+// processing time goes to fetching the frame from memory
+//
+// Uses the hardware performance counters through perf_event_open on Linux and isn't available elsewhere; it's also
+// unavailable if the kernel doesn't expose the counter to the process, e.g. in most virtual machines and containers.
+class CacheMissCounter
+{
+public:
+
+    CacheMissCounter();
+    ~CacheMissCounter();
+
+    bool IsAvailable() const { return _descriptor >= 0; }
+
+    void Start();
+
+    // Returns the misses since Start, or 0 if the counter isn't available
+    uint64_t Stop();
+
+private:
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    int _descriptor;
+};
+
+} // end namespace
@@ -0,0 +1,161 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "ClockCorrelator.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace MediaFoundationProvider {
+
+ClockCorrelator::ClockCorrelator() :
+    _resets(0)
+{
+    Reset();
+}
+
+void ClockCorrelator::Reset()
+{
+    _count = 0;
+    _next = 0;
+    _blockCount = 0;
+    _originDeviceTime = 0;
+    _originSystemTime = 0;
+    _delay = 0.0;
+    _drift = 0.0;
+    _lastDeviceTime = 0;
+    _jumpStartDeviceTime = 0;
+    _jumping = false;
+}
+
+int64_t ClockCorrelator::Correlate(int64_t deviceTime, int64_t systemTime)
+{
+    // Start over if the device clock went backwards or jumped, e.g. after the stream was restarted or the device
+    // was replugged. A jump must persist, frames held up by a stall disagree with the estimate too but only briefly.
+    if (IsLocked())
+    {
+        const bool disagrees = std::llabs(systemTime - ToSystemTime(deviceTime)) > ResetThreshold;
+        if (disagrees && !_jumping)
+        {
+            _jumpStartDeviceTime = deviceTime;
+        }
+        _jumping = disagrees;
+
+        if (deviceTime <= _lastDeviceTime || (disagrees && deviceTime - _jumpStartDeviceTime >= JumpDuration))
+        {
+            _resets++;
+            Reset();
+        }
+        else if (disagrees)
+        {
+            // Leave the estimate as it is until it's clear whether the clock jumped; a frame isn't mapped to a time
+            // after its arrival, in case the clock did jump forward
+            _lastDeviceTime = deviceTime;
+            return (std::min)(ToSystemTime(deviceTime), systemTime);
+        }
+    }
+
+    if (!IsLocked())
+    {
+        _originDeviceTime = deviceTime;
+        _originSystemTime = systemTime;
+    }
+
+    const Observation observation = { deviceTime, systemTime };
+    if (_blockCount == 0 || GetDelay(observation) < GetDelay(_block))
+    {
+        _block = observation;
+    }
+    _lastDeviceTime = deviceTime;
+
+    // Refit once a block is complete; until then only a less delayed observation lowers the offset
+    if (++_blockCount == ObservationsPerBlock)
+    {
+        _window[_next] = _block;
+        _next = (_next + 1) % WindowSize;
+        if (_count < WindowSize) _count++;
+        _blockCount = 0;
+
+        Fit();
+    }
+    else
+    {
+        const double x = static_cast<double>(_block.DeviceTime - _originDeviceTime);
+        const double residual = GetDelay(_block) - _drift * x;
+        _delay = (_count == 0 && _blockCount == 1) ? residual : (std::min)(_delay, residual);
+    }
+
+    return ToSystemTime(deviceTime);
+}
+
+int64_t ClockCorrelator::ToSystemTime(int64_t deviceTime) const
+{
+    const double x = static_cast<double>(deviceTime - _originDeviceTime);
+    return _originSystemTime + static_cast<int64_t>(x + _delay + _drift * x + 0.5);
+}
+
+ClockCorrelation ClockCorrelator::GetCorrelation() const
+{
+    ClockCorrelation correlation;
+    correlation.Offset = IsLocked() ? ToSystemTime(_lastDeviceTime) - _lastDeviceTime : 0;
+    correlation.DriftPpm = -_drift * 1.0e6;
+    correlation.Samples = _count;
+    correlation.Resets = _resets;
+
+    return correlation;
+}
+
+double ClockCorrelator::GetDelay(const Observation& observation) const
+{
+    // Both times are taken relative to the origin before converting to double, so they're exact for decades of
+    // streaming and the delay itself is small
+    return static_cast<double>((observation.SystemTime - _originSystemTime) - (observation.DeviceTime - _originDeviceTime));
+}
+
+void ClockCorrelator::Fit()
+{
+    if (_count >= MinDriftBlocks)
+    {
+        double sumX = 0.0;
+        double sumY = 0.0;
+        for (uint32_t i = 0; i < _count; i++)
+        {
+            sumX += static_cast<double>(_window[i].DeviceTime - _originDeviceTime);
+            sumY += GetDelay(_window[i]);
+        }
+
+        const double meanX = sumX / _count;
+        const double meanY = sumY / _count;
+        double covariance = 0.0;
+        double variance = 0.0;
+        for (uint32_t i = 0; i < _count; i++)
+        {
+            const double x = static_cast<double>(_window[i].DeviceTime - _originDeviceTime) - meanX;
+            const double y = GetDelay(_window[i]) - meanY;
+            covariance += x * y;
+            variance += x * x;
+        }
+
+        if (variance > 0.0)
+        {
+            _drift = covariance / variance;
+        }
+    }
+
+    // Shift the line down onto the least delayed observation
+    for (uint32_t i = 0; i < _count; i++)
+    {
+        const double residual = GetDelay(_window[i]) - _drift * static_cast<double>(_window[i].DeviceTime - _originDeviceTime);
+        _delay = (i == 0) ? residual : (std::min)(_delay, residual);
+    }
+}
+
+} // end namespace
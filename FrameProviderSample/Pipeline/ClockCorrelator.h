@@ -0,0 +1,89 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Current relation between the device clock and the system clock, for diagnostics
+struct ClockCorrelation
+{
+    int64_t Offset;                 // System time minus device time at the latest device timestamp
+    double DriftPpm;                // How much faster the device clock runs than the system clock, in parts per million
+    uint32_t Samples;               // Observations the estimate is based on, one per ObservationsPerBlock frames
+    uint64_t Resets;                // Times the device clock was found to have jumped, e.g. after a replug
+};
+
+// Maps device timestamps into the system clock domain
+//
+// Every frame contributes an observation of its device timestamp and the system time it arrived at. The earliest
+// arrivals were delayed the least, so only the least delayed observation of every ObservationsPerBlock frames is
+// kept. The drift between the clocks is the least squares slope of the delays of those observations over the
+// window, and the offset follows their lower envelope along that slope. The estimate starts over if the device
+// clock goes backwards, or if it disagrees with the system clock by more than ResetThreshold for JumpDuration of
+// device time; frames arriving late after a scheduler stall are just delayed observations.
+// NOTE: All times are in 100 nanosecond units. Not thread safe.
+class ClockCorrelator
+{
+public:
+
+    static const uint32_t ObservationsPerBlock = 16;
+    static const uint32_t WindowSize = 128;             // Blocks, about 68 seconds at 30 fps
+    static const uint32_t MinDriftBlocks = 8;           // The drift isn't estimated from fewer blocks
+    static const int64_t ResetThreshold = 2000000;      // 200 ms
+    static const int64_t JumpDuration = 10000000;       // 1 s, longer than frames are plausibly held up
+
+    ClockCorrelator();
+
+    void Reset();
+
+    // Adds an observation and returns the device time mapped to system time; the result may be later than
+    // systemTime while the estimate settles
+    int64_t Correlate(int64_t deviceTime, int64_t systemTime);
+
+    int64_t ToSystemTime(int64_t deviceTime) const;
+    bool IsLocked() const { return _count != 0 || _blockCount != 0; }
+
+    ClockCorrelation GetCorrelation() const;
+
+private:
+
+    struct Observation
+    {
+        int64_t DeviceTime;
+        int64_t SystemTime;
+    };
+
+    void Fit();
+    double GetDelay(const Observation& observation) const;
+
+    Observation _window[WindowSize];
+    uint32_t _count;
+    uint32_t _next;
+    Observation _block;             // Least delayed observation of the block being collected
+    uint32_t _blockCount;
+
+    // Line fitted through the observations, relative to the first observation after a reset:
+    // system = _originSystemTime + x + _delay + _drift * x, where x = device - _originDeviceTime
+    int64_t _originDeviceTime;
+    int64_t _originSystemTime;
+    double _delay;
+    double _drift;
+
+    int64_t _lastDeviceTime;
+    int64_t _jumpStartDeviceTime;   // First of the consecutive observations beyond ResetThreshold, if _jumping
+    bool _jumping;
+    uint64_t _resets;
+};
+
+} // end namespace
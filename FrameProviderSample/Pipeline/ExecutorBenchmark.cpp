@@ -0,0 +1,440 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "ExecutorBenchmark.h"
+#include "LatencyHistogram.h"
+#include "PerceptionService.h"
+#include "WorkStealingExecutor.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+struct BenchmarkProvider;
+
+// One task of a frame; the tasks of every frame in flight are preallocated and reused
+struct BenchmarkTask
+{
+    ExecutorTaskProc Proc;
+    BenchmarkProvider* Provider;
+    uint32_t FrameSlot;
+    uint32_t Index;                     // Stripe of a Capture task
+    int64_t SubmitTime;
+    int64_t StartTime;
+};
+
+struct BenchmarkFrameSlot
+{
+    bool Busy;
+    std::atomic<uint32_t> TasksRemaining;
+    std::vector<BenchmarkTask> Tasks;   // The Capture tasks followed by the Background task
+    std::vector<uint8_t> Recording;
+};
+
+struct BenchmarkProvider
+{
+    uint32_t Index;
+    const ExecutorBenchmarkSettings* Settings;
+    std::vector<uint8_t> Frame;
+    std::unique_ptr<BenchmarkFrameSlot[]> Slots;
+    std::atomic<uint64_t> Checksum;
+
+    std::mutex Lock;
+    std::condition_variable FrameCompleted;
+    uint64_t FramesCompleted;
+
+    // Shared by all providers; only updated once per frame
+    std::mutex* HistogramLock;
+    LatencyHistogram* CaptureLatencies;
+    LatencyHistogram* BackgroundLatencies;
+};
+
+// Runs a task for a provider; implemented once per ExecutorBenchmarkScheduler
+class BenchmarkScheduler
+{
+public:
+
+    virtual ~BenchmarkScheduler() {}
+    virtual bool Submit(BenchmarkTask& task, TaskPriority priority) = 0;
+    virtual uint32_t GetThreadCount() const = 0;
+};
+
+class WorkStealingScheduler : public BenchmarkScheduler
+{
+public:
+
+    explicit WorkStealingScheduler(uint32_t workers) { _executor.Start(workers); }
+
+    // Like a provider's worker slot, each provider prefers its own worker
+    virtual bool Submit(BenchmarkTask& task, TaskPriority priority) override
+    {
+        return _executor.Submit(priority, task.Proc, &task, task.Provider->Index);
+    }
+
+    virtual uint32_t GetThreadCount() const override { return _executor.GetWorkerCount(); }
+
+private:
+
+    WorkStealingExecutor _executor;
+};
+
+// Every provider converts on its own threads and writes its recording on another one, i.e. what providers do
+// without a shared executor
+class ThreadsPerProviderScheduler : public BenchmarkScheduler
+{
+public:
+
+    ThreadsPerProviderScheduler(uint32_t providers, uint32_t workers)
+    {
+        for (uint32_t i = 0; i < providers; i++)
+        {
+            _queues.emplace_back(new TaskQueue());
+            _queues.emplace_back(new TaskQueue());
+        }
+
+        for (uint32_t i = 0; i < providers; i++)
+        {
+            for (uint32_t j = 0; j < workers; j++)
+            {
+                _threads.emplace_back(&ThreadsPerProviderScheduler::ThreadProc, this, _queues[2 * i].get());
+            }
+            _threads.emplace_back(&ThreadsPerProviderScheduler::ThreadProc, this, _queues[2 * i + 1].get());
+        }
+    }
+
+    virtual ~ThreadsPerProviderScheduler()
+    {
+        for (std::unique_ptr<TaskQueue>& queue : _queues)
+        {
+            std::lock_guard<std::mutex> lock(queue->Lock);
+            queue->Stopping = true;
+            queue->TaskQueued.notify_all();
+        }
+        for (std::thread& thread : _threads)
+        {
+            thread.join();
+        }
+    }
+
+    virtual bool Submit(BenchmarkTask& task, TaskPriority priority) override
+    {
+        TaskQueue& queue = *_queues[2 * task.Provider->Index + ((priority == TaskPriority::Background) ? 1 : 0)];
+
+        {
+            std::lock_guard<std::mutex> lock(queue.Lock);
+            if (queue.Count == TaskQueueCapacity) return false;
+
+            QueuedTask& queuedTask = queue.Tasks[(queue.Front + queue.Count) % TaskQueueCapacity];
+            queuedTask.Proc = task.Proc;
+            queuedTask.Context = &task;
+            queue.Count++;
+        }
+        queue.TaskQueued.notify_one();
+
+        return true;
+    }
+
+    virtual uint32_t GetThreadCount() const override { return static_cast<uint32_t>(_threads.size()); }
+
+private:
+
+    static const uint32_t TaskQueueCapacity = 1024;
+
+    struct QueuedTask
+    {
+        ExecutorTaskProc Proc;
+        void* Context;
+    };
+
+    struct TaskQueue
+    {
+        TaskQueue() : Front(0), Count(0), Stopping(false) {}
+
+        std::mutex Lock;
+        std::condition_variable TaskQueued;
+        QueuedTask Tasks[TaskQueueCapacity];
+        uint32_t Front;
+        uint32_t Count;
+        bool Stopping;
+    };
+
+    void ThreadProc(TaskQueue* queue)
+    {
+        std::unique_lock<std::mutex> lock(queue->Lock);
+
+        for (;;)
+        {
+            queue->TaskQueued.wait(lock, [queue]() { return queue->Count != 0 || queue->Stopping; });
+            if (queue->Count == 0) break;
+
+            const QueuedTask task = queue->Tasks[queue->Front];
+            queue->Front = (queue->Front + 1) % TaskQueueCapacity;
+            queue->Count--;
+
+            lock.unlock();
+            task.Proc(task.Context);
+            lock.lock();
+        }
+    }
+
+    std::vector<std::unique_ptr<TaskQueue>> _queues;        // Capture and Background queue of each provider
+    std::vector<std::thread> _threads;
+};
+
+#ifdef _WIN32
+
+// Submits each task as its own callback like Windows::System::Threading::ThreadPool::RunAsync does; the default pool
+// has no notion of the tasks' priorities
+class SystemThreadPoolScheduler : public BenchmarkScheduler
+{
+public:
+
+    virtual bool Submit(BenchmarkTask& task, TaskPriority priority) override
+    {
+        UNREFERENCED_PARAMETER(priority);
+        return TrySubmitThreadpoolCallback(&SystemThreadPoolScheduler::Callback, &task, nullptr) != FALSE;
+    }
+
+    virtual uint32_t GetThreadCount() const override { return 0; }
+
+private:
+
+    static VOID CALLBACK Callback(PTP_CALLBACK_INSTANCE instance, PVOID context)
+    {
+        UNREFERENCED_PARAMETER(instance);
+        BenchmarkTask* task = static_cast<BenchmarkTask*>(context);
+        task->Proc(task);
+    }
+};
+
+#endif
+
+static void CompleteTask(BenchmarkTask& task)
+{
+    BenchmarkProvider& provider = *task.Provider;
+    BenchmarkFrameSlot& slot = provider.Slots[task.FrameSlot];
+
+    if (--slot.TasksRemaining != 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(*provider.HistogramLock);
+
+        const size_t captureTasks = slot.Tasks.size() - 1;
+        for (size_t i = 0; i < captureTasks; i++)
+        {
+            provider.CaptureLatencies->Record(slot.Tasks[i].StartTime - slot.Tasks[i].SubmitTime);
+        }
+        provider.BackgroundLatencies->Record(slot.Tasks[captureTasks].StartTime - slot.Tasks[captureTasks].SubmitTime);
+    }
+
+    // Notified under the lock, since the provider is destroyed once its last frame completed
+    std::lock_guard<std::mutex> lock(provider.Lock);
+    slot.Busy = false;
+    provider.FramesCompleted++;
+    provider.FrameCompleted.notify_one();
+}
+
+// Sums a stripe of the frame like a conversion kernel reads it
+static void CaptureTaskProc(void* context)
+{
+    BenchmarkTask& task = *static_cast<BenchmarkTask*>(context);
+    task.StartTime = GetPipelineTime();
+
+    const BenchmarkProvider& provider = *task.Provider;
+    const uint32_t length = provider.Settings->CaptureTaskBytes;
+    const uint8_t* data = provider.Frame.data() + static_cast<size_t>(task.Index) * length;
+
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        sum += data[i];
+    }
+    task.Provider->Checksum += sum;
+
+    CompleteTask(task);
+}
+
+// Copies the frame like FrameRecorder::Append does
+static void BackgroundTaskProc(void* context)
+{
+    BenchmarkTask& task = *static_cast<BenchmarkTask*>(context);
+    task.StartTime = GetPipelineTime();
+
+    BenchmarkFrameSlot& slot = task.Provider->Slots[task.FrameSlot];
+    memcpy(slot.Recording.data(), task.Provider->Frame.data(), slot.Recording.size());
+
+    CompleteTask(task);
+}
+
+static void SubmitFrames(BenchmarkScheduler& scheduler, BenchmarkProvider& provider)
+{
+    const ExecutorBenchmarkSettings& settings = *provider.Settings;
+
+    for (uint64_t frame = 0; frame < settings.FramesPerProvider; frame++)
+    {
+        const uint32_t slotIndex = static_cast<uint32_t>(frame % settings.FramesInFlight);
+        BenchmarkFrameSlot& slot = provider.Slots[slotIndex];
+
+        {
+            std::unique_lock<std::mutex> lock(provider.Lock);
+            provider.FrameCompleted.wait(lock, [&slot]() { return !slot.Busy; });
+            slot.Busy = true;
+        }
+
+        slot.TasksRemaining = static_cast<uint32_t>(slot.Tasks.size());
+        for (BenchmarkTask& task : slot.Tasks)
+        {
+            const TaskPriority priority = (task.Proc == &BackgroundTaskProc) ? TaskPriority::Background : TaskPriority::Capture;
+
+            // A full queue only happens if a scheduler falls far behind; run the task here rather than lose it
+            task.SubmitTime = GetPipelineTime();
+            if (!scheduler.Submit(task, priority))
+            {
+                task.Proc(&task);
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(provider.Lock);
+    provider.FrameCompleted.wait(lock, [&provider, &settings]() { return provider.FramesCompleted == settings.FramesPerProvider; });
+}
+
+ExecutorBenchmarkSettings GetDefaultExecutorBenchmarkSettings()
+{
+    ExecutorBenchmarkSettings settings;
+    settings.Providers = 4;
+    settings.FramesPerProvider = 2000;
+    settings.FramesInFlight = 4;
+    settings.CaptureTasksPerFrame = 8;
+    settings.CaptureTaskBytes = 64 * 1024;
+    settings.BackgroundTaskBytes = 256 * 1024;
+    settings.Workers = 0;
+
+    return settings;
+}
+
+const char* GetExecutorBenchmarkSchedulerName(ExecutorBenchmarkScheduler scheduler)
+{
+    switch (scheduler)
+    {
+    case ExecutorBenchmarkScheduler::WorkStealing: return "WorkStealing";
+    case ExecutorBenchmarkScheduler::ThreadsPerProvider: return "ThreadsPerProvider";
+    case ExecutorBenchmarkScheduler::SystemThreadPool: return "SystemThreadPool";
+    default: return "?";
+    }
+}
+
+bool RunExecutorBenchmark(ExecutorBenchmarkScheduler scheduler, const ExecutorBenchmarkSettings& settings, ExecutorBenchmarkResult& result)
+{
+    if (settings.Providers == 0 || settings.Providers > WorkStealingExecutor::MaxWorkers ||
+        settings.FramesPerProvider == 0 || settings.FramesInFlight == 0 ||
+        settings.CaptureTasksPerFrame == 0 || settings.CaptureTaskBytes == 0)
+    {
+        return false;
+    }
+
+    const uint32_t workers = (settings.Workers != 0) ? settings.Workers : (std::max)(std::thread::hardware_concurrency(), 1u);
+
+    std::unique_ptr<BenchmarkScheduler> benchmarkScheduler;
+    switch (scheduler)
+    {
+    case ExecutorBenchmarkScheduler::WorkStealing:
+        benchmarkScheduler.reset(new WorkStealingScheduler(workers));
+        break;
+    case ExecutorBenchmarkScheduler::ThreadsPerProvider:
+        benchmarkScheduler.reset(new ThreadsPerProviderScheduler(settings.Providers, workers));
+        break;
+#ifdef _WIN32
+    case ExecutorBenchmarkScheduler::SystemThreadPool:
+        benchmarkScheduler.reset(new SystemThreadPoolScheduler());
+        break;
+#endif
+    default:
+        return false;
+    }
+
+    std::mutex histogramLock;
+    std::unique_ptr<LatencyHistogram> captureLatencies(new LatencyHistogram());
+    std::unique_ptr<LatencyHistogram> backgroundLatencies(new LatencyHistogram());
+
+    // Every buffer is allocated and touched before the clock starts
+    std::vector<std::unique_ptr<BenchmarkProvider>> providers;
+    for (uint32_t i = 0; i < settings.Providers; i++)
+    {
+        std::unique_ptr<BenchmarkProvider> provider(new BenchmarkProvider());
+        provider->Index = i;
+        provider->Settings = &settings;
+        provider->Frame.assign(static_cast<size_t>(settings.CaptureTasksPerFrame) * settings.CaptureTaskBytes, static_cast<uint8_t>(i + 1));
+        provider->Slots.reset(new BenchmarkFrameSlot[settings.FramesInFlight]);
+        provider->Checksum = 0;
+        provider->FramesCompleted = 0;
+        provider->HistogramLock = &histogramLock;
+        provider->CaptureLatencies = captureLatencies.get();
+        provider->BackgroundLatencies = backgroundLatencies.get();
+
+        for (uint32_t j = 0; j < settings.FramesInFlight; j++)
+        {
+            BenchmarkFrameSlot& slot = provider->Slots[j];
+            slot.Busy = false;
+            slot.Recording.assign((std::min)(static_cast<size_t>(settings.BackgroundTaskBytes), provider->Frame.size()), 0);
+            slot.Tasks.resize(settings.CaptureTasksPerFrame + 1);
+
+            for (uint32_t k = 0; k < slot.Tasks.size(); k++)
+            {
+                BenchmarkTask& task = slot.Tasks[k];
+                task.Proc = (k < settings.CaptureTasksPerFrame) ? &CaptureTaskProc : &BackgroundTaskProc;
+                task.Provider = provider.get();
+                task.FrameSlot = j;
+                task.Index = k;
+            }
+        }
+        providers.push_back(std::move(provider));
+    }
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> drivers;
+    for (std::unique_ptr<BenchmarkProvider>& provider : providers)
+    {
+        drivers.emplace_back(&SubmitFrames, std::ref(*benchmarkScheduler), std::ref(*provider));
+    }
+    for (std::thread& driver : drivers)
+    {
+        driver.join();
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    result.Tasks = static_cast<uint64_t>(settings.Providers) * settings.FramesPerProvider * (settings.CaptureTasksPerFrame + 1);
+    result.Seconds = elapsed.count();
+    result.TasksPerSecond = (result.Seconds > 0) ? result.Tasks / result.Seconds : 0;
+    result.CaptureLatencyP50 = captureLatencies->GetPercentile(50);
+    result.CaptureLatencyP99 = captureLatencies->GetPercentile(99);
+    result.BackgroundLatencyP99 = backgroundLatencies->GetPercentile(99);
+    result.Threads = benchmarkScheduler->GetThreadCount();
+
+    return true;
+}
+
+} // end namespace
@@ -0,0 +1,60 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// How the benchmark's tasks are run
+enum class ExecutorBenchmarkScheduler
+{
+    WorkStealing,           // One WorkStealingExecutor shared by every provider
+    ThreadsPerProvider,     // Conversion threads and a recording writer thread per provider, see ParallelFramePipeline and FrameRecorder
+    SystemThreadPool,       // The process's default thread pool, which also runs Windows::System::Threading::ThreadPool work items; Windows only
+};
+
+struct ExecutorBenchmarkSettings
+{
+    uint32_t Providers;                 // Providers submitting frames at the same time
+    uint32_t FramesPerProvider;
+    uint32_t FramesInFlight;            // Frames a provider submits before it waits for the oldest one
+    uint32_t CaptureTasksPerFrame;      // e.g. the stripes of the frame's conversion
+    uint32_t CaptureTaskBytes;          // Bytes read by each Capture task
+    uint32_t BackgroundTaskBytes;       // Bytes copied by the frame's Background task, like a recorder slot
+    uint32_t Workers;                   // Executor workers and conversion threads per provider, 0 for one per hardware thread
+};
+
+// NOTE: Latencies are the time from submitting a task until it started, in 100 nanosecond units
+struct ExecutorBenchmarkResult
+{
+    uint64_t Tasks;
+    double Seconds;
+    double TasksPerSecond;
+    int64_t CaptureLatencyP50;
+    int64_t CaptureLatencyP99;
+    int64_t BackgroundLatencyP99;
+    uint32_t Threads;                   // Threads created to run the tasks, 0 for the system thread pool
+};
+
+// 4 providers with 8 Capture tasks of 64 KB and one Background task of 256 KB per frame
+ExecutorBenchmarkSettings GetDefaultExecutorBenchmarkSettings();
+
+const char* GetExecutorBenchmarkSchedulerName(ExecutorBenchmarkScheduler scheduler);
+
+// Runs the frames of every provider to completion with the given scheduler, like several providers converting and
+// recording frames at full rate, so the throughput and the latency of Capture tasks under contention can be compared.
+// Returns false if the scheduler isn't available on this platform or the settings are invalid.
+bool RunExecutorBenchmark(ExecutorBenchmarkScheduler scheduler, const ExecutorBenchmarkSettings& settings, ExecutorBenchmarkResult& result);
+
+} // end namespace
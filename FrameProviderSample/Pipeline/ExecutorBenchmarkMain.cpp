@@ -0,0 +1,84 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+// Command line host for the executor benchmark, built separately from the provider DLL, e.g.
+//     g++ -std=c++14 -O2 -pthread -DFRAME_PIPELINE_EXECUTOR_BENCHMARK Pipeline/*.cpp -o ExecutorBenchmark
+// FRAME_PIPELINE_EXECUTOR_BENCHMARK selects this main, like FRAME_PIPELINE_SOAK does for the soak test's, see SoakMain.cpp
+//
+// Usage: ExecutorBenchmark [providers [frames [workers]]]
+// Prints one CSV line per scheduler; the system thread pool is only measured on Windows
+
+#ifdef FRAME_PIPELINE_EXECUTOR_BENCHMARK
+
+#include "ExecutorBenchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace MediaFoundationProvider;
+
+int main(int argc, char* argv[])
+{
+    ExecutorBenchmarkSettings settings = GetDefaultExecutorBenchmarkSettings();
+
+    if (argc > 1)
+    {
+        settings.Providers = static_cast<uint32_t>(atoi(argv[1]));
+    }
+    if (argc > 2)
+    {
+        settings.FramesPerProvider = static_cast<uint32_t>(atoi(argv[2]));
+    }
+    if (argc > 3)
+    {
+        settings.Workers = static_cast<uint32_t>(atoi(argv[3]));
+    }
+
+    const ExecutorBenchmarkScheduler schedulers[] =
+    {
+        ExecutorBenchmarkScheduler::WorkStealing,
+        ExecutorBenchmarkScheduler::ThreadsPerProvider,
+        ExecutorBenchmarkScheduler::SystemThreadPool,
+    };
+
+    printf("scheduler,providers,threads,tasks,seconds,tasks_per_s,capture_p50_us,capture_p99_us,background_p99_us\n");
+
+    bool measured = false;
+    for (ExecutorBenchmarkScheduler scheduler : schedulers)
+    {
+        ExecutorBenchmarkResult result;
+        if (!RunExecutorBenchmark(scheduler, settings, result)) continue;
+
+        measured = true;
+        printf("%s,%u,%u,%llu,%.3f,%.0f,%.1f,%.1f,%.1f\n",
+            GetExecutorBenchmarkSchedulerName(scheduler),
+            settings.Providers,
+            result.Threads,
+            static_cast<unsigned long long>(result.Tasks),
+            result.Seconds,
+            result.TasksPerSecond,
+            result.CaptureLatencyP50 / 10.0,
+            result.CaptureLatencyP99 / 10.0,
+            result.BackgroundLatencyP99 / 10.0);
+        fflush(stdout);
+    }
+
+    if (!measured)
+    {
+        fprintf(stderr, "Usage: %s [providers [frames [workers]]]\n", argv[0]);
+        return 2;
+    }
+
+    return 0;
+}
+
+#endif
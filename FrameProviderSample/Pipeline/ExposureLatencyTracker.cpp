@@ -0,0 +1,99 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "ExposureLatencyTracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace MediaFoundationProvider {
+
+static const double MinDetectableChange = 0.1;     // EV, smaller changes are lost in the noise of the scene
+
+ExposureLatencyTracker::ExposureLatencyTracker()
+{
+    Reset();
+}
+
+void ExposureLatencyTracker::Reset()
+{
+    _pending = false;
+    _change = PendingChange();
+    _nextId = 1;
+    _lastLevel = 0.0;
+
+    _stats = ExposureLatencyStats();
+    memset(_frameLatency, 0, sizeof(_frameLatency));
+    _timeLatency.Reset();
+}
+
+uint32_t ExposureLatencyTracker::BeginChange(float previousValue, float newValue, uint64_t frameSequence, int64_t time)
+{
+    _stats.Changes++;
+    _stats.Superseded += _pending ? 1 : 0;
+
+    _change.Id = _nextId++;
+    _change.ExpectedChange = static_cast<double>(newValue) - static_cast<double>(previousValue);
+    _change.BaselineLevel = _lastLevel;
+    _change.FrameSequence = frameSequence;
+    _change.Time = time;
+
+    // Without a measured frame there is nothing to compare to
+    _pending = (_lastLevel > 0.0 && std::fabs(_change.ExpectedChange) >= MinDetectableChange);
+
+    return _change.Id;
+}
+
+bool ExposureLatencyTracker::OnFrame(uint64_t frameSequence, int64_t time, const LuminanceStatistics& statistics)
+{
+    _lastLevel = (std::max)(statistics.GetMean(), 1.0);
+
+    if (!_pending || frameSequence <= _change.FrameSequence) return false;
+
+    const uint64_t frames = frameSequence - _change.FrameSequence;
+    const double observedChange = std::log2(_lastLevel / _change.BaselineLevel);
+    const double threshold = (std::max)(std::fabs(_change.ExpectedChange) / 2.0, MinDetectableChange);
+
+    if (observedChange * (_change.ExpectedChange > 0.0 ? 1.0 : -1.0) >= threshold)
+    {
+        _pending = false;
+        _stats.Observed++;
+        _frameLatency[(std::min)(frames, static_cast<uint64_t>(MaxLatencyFrames))]++;
+        _timeLatency.Record(time - _change.Time);
+        return true;
+    }
+
+    if (frames >= MaxLatencyFrames)
+    {
+        _pending = false;
+        _stats.TimedOut++;
+    }
+
+    return false;
+}
+
+uint32_t ExposureLatencyTracker::GetFramePercentile(double percentile) const
+{
+    if (_stats.Observed == 0) return 0;
+
+    const double threshold = percentile / 100.0 * static_cast<double>(_stats.Observed);
+    uint64_t count = 0;
+
+    for (uint32_t frames = 0; frames <= MaxLatencyFrames; frames++)
+    {
+        count += _frameLatency[frames];
+        if (static_cast<double>(count) >= threshold) return frames;
+    }
+    return MaxLatencyFrames;
+}
+
+} // end namespace
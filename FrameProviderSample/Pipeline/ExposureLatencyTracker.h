@@ -0,0 +1,81 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameConversion.h"
+#include "LatencyHistogram.h"
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+struct ExposureLatencyStats
+{
+    uint64_t Changes;               // Changes passed to BeginChange
+    uint64_t Observed;              // Changes whose effect was found in a frame
+    uint64_t TimedOut;              // Changes without a visible effect within MaxLatencyFrames frames
+    uint64_t Superseded;            // Changes replaced by the next one before their effect was seen
+};
+
+// Measures how many frames it takes until an exposure change shows in the frames
+//
+// Each change gets a sequence number and remembers the frame sequence, time and mean luminance at which it was
+// requested. The first following frame whose luminance moved in the expected direction by at least half the
+// change, in EV, is taken as the first frame captured with the new value. Delays are counted per frame and, in
+// milliseconds, in a LatencyHistogram.
+// NOTE: Times are in 100 nanosecond units. Not thread safe.
+class ExposureLatencyTracker
+{
+public:
+
+    static const uint32_t MaxLatencyFrames = 30;
+
+    ExposureLatencyTracker();
+
+    void Reset();
+
+    // Returns the change's sequence number
+    uint32_t BeginChange(float previousValue, float newValue, uint64_t frameSequence, int64_t time);
+
+    // Returns true if this frame is the first to reflect the pending change
+    // NOTE: Only pass frames whose luminance was measured, i.e. illuminated frames
+    bool OnFrame(uint64_t frameSequence, int64_t time, const LuminanceStatistics& statistics);
+
+    ExposureLatencyStats GetStats() const { return _stats; }
+
+    // Returns the smallest delay in frames within which the given percentile (0 - 100) of the observed changes
+    // showed, or 0 if none was observed
+    uint32_t GetFramePercentile(double percentile) const;
+    const LatencyHistogram& GetTimeLatency() const { return _timeLatency; }
+
+private:
+
+    struct PendingChange
+    {
+        uint32_t Id;
+        double ExpectedChange;      // EV
+        double BaselineLevel;       // Mean luminance when the change was requested
+        uint64_t FrameSequence;
+        int64_t Time;
+    };
+
+    bool _pending;
+    PendingChange _change;
+    uint32_t _nextId;
+    double _lastLevel;
+
+    ExposureLatencyStats _stats;
+    uint64_t _frameLatency[MaxLatencyFrames + 1];
+    LatencyHistogram _timeLatency;
+};
+
+} // end namespace
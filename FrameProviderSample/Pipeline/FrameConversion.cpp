@@ -0,0 +1,175 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "FrameConversion.h"
+#include "LumaKernels.h"
+
+#include <cstring>
+
+namespace MediaFoundationProvider {
+
+void LuminanceStatistics::Reset()
+{
+    memset(Histogram, 0, sizeof(Histogram));
+    Pixels = 0;
+    Saturated = 0;
+    Sum = 0;
+}
+
+uint8_t LuminanceStatistics::GetPercentile(double fraction) const
+{
+    // Smallest level at or below which the given fraction of the pixels lie
+    const uint64_t threshold = static_cast<uint64_t>(fraction * Pixels);
+    uint64_t count = 0;
+
+    for (uint32_t level = 0; level < 256; level++)
+    {
+        count += Histogram[level];
+        if (count > threshold) return static_cast<uint8_t>(level);
+    }
+    return 255;
+}
+
+static void MeasureLuminance(const uint8_t* row, uint32_t width, LuminanceStatistics* statistics)
+{
+    uint64_t sum = 0;
+    uint32_t saturated = 0;
+    for (uint32_t x = 0; x < width; x++)
+    {
+        statistics->Histogram[row[x]]++;
+        sum += row[x];
+        saturated += (row[x] >= LuminanceStatistics::SaturationLevel) ? 1 : 0;
+    }
+
+    statistics->Pixels += width;
+    statistics->Saturated += saturated;
+    statistics->Sum += sum;
+}
+
+static void MeasureLuminance(const FrameLayout& layout, const uint8_t* destination, uint32_t y, LuminanceStatistics* statistics, SampledLuminance* sampledLuminance)
+{
+    const uint8_t* row = destination + static_cast<size_t>(y) * layout.Width;
+
+    if (statistics != nullptr && (y % LuminanceStatisticsRowStep) == 0)
+    {
+        MeasureLuminance(row, layout.Width, statistics);
+    }
+
+    if (sampledLuminance != nullptr && (y % SampledLuminance::RowStep) == 0)
+    {
+        uint32_t sum = 0;
+        uint32_t pixels = 0;
+        for (uint32_t x = 0; x < layout.Width; x += SampledLuminance::ColumnStep, pixels++)
+        {
+            sum += row[x];
+        }
+
+        sampledLuminance->Sum += sum;
+        sampledLuminance->Pixels += pixels;
+    }
+}
+
+// All kernels verify the source holds a complete frame and the destination is exactly one Gray8 frame
+static bool IsConversionValid(const FrameLayout& layout, uint32_t sourceLength, uint32_t destinationLength)
+{
+    const uint32_t frameLength = GetFrameLength(layout);
+    return (frameLength != 0) &&
+        (sourceLength >= frameLength) &&
+        (destinationLength == layout.Width * layout.Height);
+}
+
+static bool ConvertYUY2ToGray8(const FrameLayout& layout, const uint8_t* source, uint32_t sourceLength, uint8_t* destination, uint32_t destinationLength, LuminanceStatistics* statistics, SampledLuminance* sampledLuminance)
+{
+    if (!IsConversionValid(layout, sourceLength, destinationLength)) return false;
+    if (statistics != nullptr) statistics->Reset();
+    if (sampledLuminance != nullptr) *sampledLuminance = SampledLuminance();
+
+    // Simply strip the Luminance byte (Y component) from each source YU/YV word
+    for (uint32_t y = 0; y < layout.Height; y++)
+    {
+        ExtractLumaYUY2(source + static_cast<size_t>(y) * layout.Stride, destination + static_cast<size_t>(y) * layout.Width, layout.Width);
+        MeasureLuminance(layout, destination, y, statistics, sampledLuminance);
+    }
+    return true;
+}
+
+static bool ConvertPlanarLumaToGray8(const FrameLayout& layout, const uint8_t* source, uint32_t sourceLength, uint8_t* destination, uint32_t destinationLength, LuminanceStatistics* statistics, SampledLuminance* sampledLuminance)
+{
+    if (!IsConversionValid(layout, sourceLength, destinationLength)) return false;
+    if (statistics != nullptr) statistics->Reset();
+    if (sampledLuminance != nullptr) *sampledLuminance = SampledLuminance();
+
+    // NV12 and Gray8 both start with a full resolution 8 bit luma plane, copy it and ignore any chroma plane
+    if (layout.Stride == layout.Width && statistics == nullptr && sampledLuminance == nullptr)
+    {
+        memcpy(destination, source, destinationLength);
+    }
+    else
+    {
+        for (uint32_t y = 0; y < layout.Height; y++)
+        {
+            memcpy(destination + static_cast<size_t>(y) * layout.Width, source + static_cast<size_t>(y) * layout.Stride, layout.Width);
+            MeasureLuminance(layout, destination, y, statistics, sampledLuminance);
+        }
+    }
+    return true;
+}
+
+static const FrameConversionKernel s_conversionKernels[] =
+{
+    { FramePixelFormat::YUY2,  16, 3, ConvertYUY2ToGray8 },
+    { FramePixelFormat::NV12,  12, 1, ConvertPlanarLumaToGray8 },
+    { FramePixelFormat::Gray8,  8, 1, ConvertPlanarLumaToGray8 },
+};
+
+const FrameConversionKernel* FindFrameConversionKernel(FramePixelFormat sourceFormat)
+{
+    for (const FrameConversionKernel& kernel : s_conversionKernels)
+    {
+        if (kernel.SourceFormat == sourceFormat)
+        {
+            return &kernel;
+        }
+    }
+    return nullptr;
+}
+
+FrameLayout GetPackedFrameLayout(FramePixelFormat format, uint32_t width, uint32_t height)
+{
+    FrameLayout layout = { format, width, height, (format == FramePixelFormat::YUY2) ? width * 2 : width };
+    return layout;
+}
+
+uint32_t GetFrameLength(const FrameLayout& layout)
+{
+    const uint64_t planeLength = static_cast<uint64_t>(layout.Stride) * layout.Height;
+    uint64_t frameLength = 0;
+
+    switch (layout.Format)
+    {
+        case FramePixelFormat::YUY2:
+        case FramePixelFormat::Gray8:
+            frameLength = planeLength;
+            break;
+
+        // The chroma plane has half the rows of the luma plane and the same stride
+        case FramePixelFormat::NV12:
+            frameLength = planeLength + planeLength / 2;
+            break;
+
+        default:
+            break;
+    }
+
+    return (frameLength <= UINT32_MAX) ? static_cast<uint32_t>(frameLength) : 0;
+}
+
+} // end namespace
@@ -0,0 +1,99 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// NOTE: Files in the Pipeline folder only depend on the C++ standard library so the frame processing logic
+// can be built and exercised outside of the Windows Runtime, e.g. for offline benchmarks
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Source pixel formats the provider can convert into the Gray8 frames delivered to the service
+enum class FramePixelFormat : uint32_t
+{
+    Unknown = 0,
+    YUY2 = 1,       // Packed 4:2:2, the luma sample is every other byte
+    NV12 = 2,       // Planar 4:2:0, a full resolution luma plane followed by the interleaved chroma plane
+    Gray8 = 3,      // Luma only, i.e. MFVideoFormat_L8
+};
+
+// Memory layout of a single source frame
+// NOTE: Stride is the number of bytes between the start of two rows of the first (luma) plane
+struct FrameLayout
+{
+    FramePixelFormat Format;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Stride;
+};
+
+// Luminance of a converted frame, gathered by the conversion kernels while the rows are converted
+// NOTE: Only every LuminanceStatisticsRowStep-th row is measured
+struct LuminanceStatistics
+{
+    static const uint8_t SaturationLevel = 250;
+
+    uint32_t Histogram[256];
+    uint32_t Pixels;
+    uint32_t Saturated;             // Pixels at or above SaturationLevel
+    uint64_t Sum;
+
+    void Reset();
+    uint8_t GetPercentile(double fraction) const;
+    double GetMean() const { return (Pixels != 0) ? static_cast<double>(Sum) / Pixels : 0.0; }
+};
+
+static const uint32_t LuminanceStatisticsRowStep = 2;
+
+// Mean luminance of a sparse grid of pixels, cheap enough to gather for every frame
+struct SampledLuminance
+{
+    static const uint32_t RowStep = 8;
+    static const uint32_t ColumnStep = 4;
+
+    uint64_t Sum;
+    uint32_t Pixels;
+
+    double GetMean() const { return (Pixels != 0) ? static_cast<double>(Sum) / Pixels : 0.0; }
+};
+
+// Converts one frame; statistics and sampledLuminance are optional and measure the converted rows while they're
+// still in the cache
+typedef bool (*FrameConversionProc)(
+    const FrameLayout& layout,
+    const uint8_t* source,
+    uint32_t sourceLength,
+    uint8_t* destination,
+    uint32_t destinationLength,
+    LuminanceStatistics* statistics,
+    SampledLuminance* sampledLuminance);
+
+// Converts frames of a single source format into tightly packed Gray8 frames
+struct FrameConversionKernel
+{
+    FramePixelFormat SourceFormat;
+    uint32_t BitsPerPixel;          // Average source bits per pixel, used to estimate the bandwidth of a profile
+    uint32_t RelativeCost;          // Approximate cost of converting a pixel relative to a plain copy (1)
+    FrameConversionProc Convert;
+};
+
+// Returns the conversion kernel for the given source format, or nullptr if the format isn't supported
+const FrameConversionKernel* FindFrameConversionKernel(FramePixelFormat sourceFormat);
+
+// Returns the minimum layout of the given format, i.e. without any padding at the end of each row
+FrameLayout GetPackedFrameLayout(FramePixelFormat format, uint32_t width, uint32_t height);
+
+// Returns the number of bytes a source frame with the given layout occupies, or 0 if the format isn't supported
+uint32_t GetFrameLength(const FrameLayout& layout);
+
+} // end namespace
@@ -0,0 +1,111 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MediaFoundationProvider {
+
+FramePacer::FramePacer() :
+    _reportedResyncs(0)
+{
+    Reset();
+
+    _arrivalJitter.Reset();
+    _pacedJitter.Reset();
+}
+
+void FramePacer::Reset()
+{
+    _clock.Reset();
+    _lastPresentationTime = 0;
+}
+
+int64_t FramePacer::Pace(int64_t sourceTimestamp, int64_t arrivalTime)
+{
+    const int64_t presentationTime = _clock.Correlate(sourceTimestamp, arrivalTime);
+
+    // Never hand out a presentation time in the future or one that doesn't advance
+    int64_t pacedTime = (std::min)(presentationTime, arrivalTime);
+    pacedTime = (std::max)(pacedTime, _lastPresentationTime + 1);
+
+    _lastPresentationTime = pacedTime;
+
+    _arrivalJitter.Add(arrivalTime);
+    _pacedJitter.Add(pacedTime);
+
+    return pacedTime;
+}
+
+int64_t FramePacer::GetReleaseDelay(int64_t presentationTime, int64_t currentTime, int64_t releaseLatency) const
+{
+    return (std::max)(presentationTime + releaseLatency - currentTime, static_cast<int64_t>(0));
+}
+
+FramePacerStats FramePacer::TakeStats()
+{
+    FramePacerStats stats;
+    stats.Arrival = _arrivalJitter.GetJitter();
+    stats.Paced = _pacedJitter.GetJitter();
+    stats.Clock = _clock.GetCorrelation();
+    stats.Resyncs = stats.Clock.Resets - _reportedResyncs;
+
+    _arrivalJitter.Reset();
+    _pacedJitter.Reset();
+    _reportedResyncs = stats.Clock.Resets;
+
+    return stats;
+}
+
+void FramePacer::JitterAccumulator::Reset()
+{
+    PreviousTime = 0;
+    Count = 0;
+    Mean = 0.0;
+    SumOfSquares = 0.0;
+    MinInterval = 0.0;
+    MaxInterval = 0.0;
+}
+
+void FramePacer::JitterAccumulator::Add(int64_t time)
+{
+    // The first time of a measurement only starts the first interval
+    if (PreviousTime != 0)
+    {
+        const double interval = static_cast<double>(time - PreviousTime);
+
+        // Welford's running mean and variance
+        Count++;
+        const double delta = interval - Mean;
+        Mean += delta / static_cast<double>(Count);
+        SumOfSquares += delta * (interval - Mean);
+
+        MinInterval = (Count == 1) ? interval : (std::min)(MinInterval, interval);
+        MaxInterval = (Count == 1) ? interval : (std::max)(MaxInterval, interval);
+    }
+
+    PreviousTime = time;
+}
+
+FrameJitter FramePacer::JitterAccumulator::GetJitter() const
+{
+    FrameJitter jitter;
+    jitter.Intervals = Count;
+    jitter.MeanInterval = Mean;
+    jitter.StandardDeviation = (Count > 1) ? std::sqrt(SumOfSquares / static_cast<double>(Count - 1)) : 0.0;
+    jitter.MaxDeviation = static_cast<int64_t>((std::max)(MaxInterval - Mean, Mean - MinInterval) + 0.5);
+
+    return jitter;
+}
+
+} // end namespace
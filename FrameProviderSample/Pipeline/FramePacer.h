@@ -0,0 +1,86 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "ClockCorrelator.h"
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Spread of the intervals between consecutive frames, in 100 nanosecond units
+struct FrameJitter
+{
+    uint64_t Intervals;
+    double MeanInterval;
+    double StandardDeviation;       // Jitter, i.e. how much the intervals vary around their mean
+    int64_t MaxDeviation;           // Largest difference of an interval to the mean
+};
+
+struct FramePacerStats
+{
+    FrameJitter Arrival;            // Intervals at which frames arrived, i.e. without pacing
+    FrameJitter Paced;              // Intervals of the assigned presentation times
+    uint64_t Resyncs;               // Times the device clock jumped and the correlation started over
+    ClockCorrelation Clock;         // Offset and drift between the device clock and the system clock
+};
+
+// Assigns presentation times to frames from the device's timestamps instead of their arrival times
+//
+// Frames arrive after a varying delay, e.g. depending on thread pool scheduling, so stamping them on arrival makes
+// the intervals between them jitter. The device's timestamps are evenly spaced but use the device's clock, so the
+// pacer maps each timestamp into system time through a ClockCorrelator.
+// NOTE: All times are in 100 nanosecond units. Not thread safe.
+class FramePacer
+{
+public:
+
+    FramePacer();
+
+    void Reset();
+
+    // Returns the presentation time in the system clock domain for a frame with the given device timestamp that
+    // arrived at arrivalTime (system clock); presentation times are strictly increasing
+    int64_t Pace(int64_t sourceTimestamp, int64_t arrivalTime);
+
+    // Releasing frames at their presentation time plus this delay delivers them at the device's cadence
+    // Returns the time to wait until the frame is due, 0 if it's already late
+    int64_t GetReleaseDelay(int64_t presentationTime, int64_t currentTime, int64_t releaseLatency) const;
+
+    // Returns the jitter measured since the last call and starts a new measurement
+    FramePacerStats TakeStats();
+
+private:
+
+    struct JitterAccumulator
+    {
+        int64_t PreviousTime;
+        uint64_t Count;
+        double Mean;
+        double SumOfSquares;
+        double MinInterval;
+        double MaxInterval;
+
+        void Reset();
+        void Add(int64_t time);
+        FrameJitter GetJitter() const;
+    };
+
+    ClockCorrelator _clock;
+    int64_t _lastPresentationTime;
+
+    JitterAccumulator _arrivalJitter;
+    JitterAccumulator _pacedJitter;
+    uint64_t _reportedResyncs;      // ClockCorrelation::Resets at the last TakeStats
+};
+
+} // end namespace
@@ -0,0 +1,104 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "FramePipeline.h"
+
+namespace MediaFoundationProvider {
+
+FramePipeline::FramePipeline() :
+    _conversionKernel(nullptr),
+    _sourceLayout(),
+    _measureLuminance(false),
+    _detectIllumination(false),
+    _framesProcessed(0),
+    _framesFailed(0)
+{
+    _luminanceStatistics.Reset();
+}
+
+bool FramePipeline::Configure(const FrameLayout& sourceLayout)
+{
+    const FrameConversionKernel* conversionKernel = FindFrameConversionKernel(sourceLayout.Format);
+    if (conversionKernel == nullptr) return false;
+
+    _conversionKernel = conversionKernel;
+    _sourceLayout = sourceLayout;
+
+    return true;
+}
+
+bool FramePipeline::Process(const CapturedFrame& frame, uint8_t* destination, uint32_t destinationLength, ProcessedFrame& result)
+{
+    ConvertedFrame converted;
+    Convert(frame, destination, destinationLength, converted);
+    return Complete(converted, result);
+}
+
+void FramePipeline::Convert(const CapturedFrame& frame, uint8_t* destination, uint32_t destinationLength, ConvertedFrame& converted) const
+{
+    // Frames must be tagged with the illumination state otherwise the service won't deliver them to the client app,
+    // so frames that weren't tagged by MFT0 are reported as illuminated unless the state is inferred from their content
+    // Unilluminated frames of interleaved sensors only show ambient light and aren't measured
+    converted.SourceTimestamp = frame.Timestamp;
+    converted.IlluminationTagged = frame.IlluminationTagged;
+    converted.IlluminationEnabled = frame.IlluminationTagged ? frame.IlluminationEnabled : true;
+    converted.LuminanceSampled = _detectIllumination && !frame.IlluminationTagged;
+    converted.LuminanceMeasured = _measureLuminance.load(std::memory_order_relaxed) && converted.IlluminationEnabled;
+    converted.Converted = false;
+
+    if (_conversionKernel == nullptr || frame.Data == nullptr) return;
+
+    const FrameConversionKernel* conversionKernel = (frame.Layout.Format == _sourceLayout.Format) ?
+        _conversionKernel :
+        FindFrameConversionKernel(frame.Layout.Format);
+
+    // The kernel fails if the buffers don't hold exactly one frame of the negotiated size
+    converted.Converted = (conversionKernel != nullptr) &&
+        conversionKernel->Convert(frame.Layout, frame.Data, frame.Length, destination, destinationLength,
+            converted.LuminanceMeasured ? &converted.Luminance : nullptr,
+            converted.LuminanceSampled ? &converted.Sampled : nullptr);
+}
+
+bool FramePipeline::Complete(const ConvertedFrame& converted, ProcessedFrame& result)
+{
+    const uint64_t sequence = _framesProcessed + _framesFailed;
+
+    if (!converted.Converted)
+    {
+        _framesFailed++;
+        return false;
+    }
+
+    bool illuminationTagged = converted.IlluminationTagged;
+    bool illuminationEnabled = converted.IlluminationEnabled;
+    bool illuminated;
+    if (converted.LuminanceSampled && _phaseDetector.Submit(converted.Sampled.GetMean(), illuminated))
+    {
+        illuminationTagged = true;
+        illuminationEnabled = illuminated;
+    }
+
+    if (converted.LuminanceMeasured)
+    {
+        _luminanceStatistics = converted.Luminance;
+    }
+
+    _framesProcessed++;
+    result.Sequence = sequence;
+    result.SourceTimestamp = converted.SourceTimestamp;
+    result.IlluminationEnabled = illuminationEnabled;
+    result.IlluminationTagged = illuminationTagged;
+    result.LuminanceMeasured = converted.LuminanceMeasured && illuminationEnabled;
+
+    return true;
+}
+
+} // end namespace
@@ -0,0 +1,97 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameSource.h"
+#include "IlluminationPhaseDetector.h"
+
+#include <atomic>
+
+namespace MediaFoundationProvider {
+
+// Describes a frame converted by FramePipeline
+struct ProcessedFrame
+{
+    uint64_t Sequence;              // Number of frames submitted before this one, gaps indicate frames that failed to convert
+    int64_t SourceTimestamp;        // CapturedFrame::Timestamp of the source frame
+    bool IlluminationEnabled;       // Value of the ActiveIlluminationEnabled property to publish with the frame
+    bool IlluminationTagged;        // The illumination state is known, i.e. tagged by MFT0 or inferred, see IlluminationPairer
+    bool LuminanceMeasured;         // GetLuminanceStatistics describes this frame
+};
+
+// A frame converted by FramePipeline::Convert that still has to be completed, see FramePipeline::Complete
+struct ConvertedFrame
+{
+    bool Converted;
+    int64_t SourceTimestamp;
+    bool IlluminationTagged;        // Illumination state of the source frame
+    bool IlluminationEnabled;
+    bool LuminanceMeasured;         // Luminance holds the statistics of the frame
+    bool LuminanceSampled;          // Sampled is needed to infer the illumination state
+    LuminanceStatistics Luminance;
+    SampledLuminance Sampled;
+};
+
+// Turns captured frames into the Gray8 frames published to the service
+//
+// This is the per-frame logic shared by SampleFrameProvider and HeadlessFrameProvider, so it behaves the same
+// inside SensorDataService and in headless tests. Process is split into Convert, which only reads the configuration
+// so several frames can be converted concurrently (see ParallelFramePipeline), and Complete, which tracks the frame
+// sequence and must see every frame in capture order.
+// NOTE: Only Convert is thread safe; Configure must not be called while frames are processed
+class FramePipeline
+{
+public:
+
+    FramePipeline();
+
+    // Selects the conversion kernel for the negotiated source layout, returns false if the format isn't supported
+    bool Configure(const FrameLayout& sourceLayout);
+    bool IsConfigured() const { return _conversionKernel != nullptr; }
+
+    const FrameLayout& GetSourceLayout() const { return _sourceLayout; }
+    uint32_t GetOutputLength() const { return _sourceLayout.Width * _sourceLayout.Height; }
+
+    // Converts the frame into destination, which must hold exactly one Gray8 frame of the source's size
+    // Frames that don't match the negotiated format, e.g. from a frame source, are converted with their own kernel
+    bool Process(const CapturedFrame& frame, uint8_t* destination, uint32_t destinationLength, ProcessedFrame& result);
+
+    // The two halves of Process; result is only valid if Complete returns true
+    void Convert(const CapturedFrame& frame, uint8_t* destination, uint32_t destinationLength, ConvertedFrame& converted) const;
+    bool Complete(const ConvertedFrame& converted, ProcessedFrame& result);
+
+    // Measures the luminance of illuminated frames while they're converted, e.g. for AutoExposureController
+    // NOTE: May be called on any thread, frames converted afterwards are measured
+    void SetLuminanceStatistics(bool enable) { _measureLuminance.store(enable, std::memory_order_relaxed); }
+    const LuminanceStatistics& GetLuminanceStatistics() const { return _luminanceStatistics; }
+
+    // Infers the illumination state of frames that weren't tagged by MFT0 from their brightness
+    void SetIlluminationDetection(bool enable) { _detectIllumination = enable; }
+    const IlluminationPhaseDetector& GetIlluminationDetector() const { return _phaseDetector; }
+
+    uint64_t GetFramesProcessed() const { return _framesProcessed; }
+    uint64_t GetFramesFailed() const { return _framesFailed; }
+
+private:
+
+    const FrameConversionKernel* _conversionKernel;
+    FrameLayout _sourceLayout;
+    std::atomic<bool> _measureLuminance;        // Set by the thread enabling auto exposure, read by the converting threads
+    LuminanceStatistics _luminanceStatistics;
+    bool _detectIllumination;
+    IlluminationPhaseDetector _phaseDetector;
+
+    uint64_t _framesProcessed;
+    uint64_t _framesFailed;
+};
+
+} // end namespace
@@ -0,0 +1,234 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "FrameRecorder.h"
+
+#include <cstring>
+
+namespace MediaFoundationProvider {
+
+static const uint8_t s_padding[RecordAlignment] = {};
+
+FrameRecorder::FrameRecorder() :
+    _file(nullptr),
+    _fileOffset(0),
+    _maxFrameLength(0),
+    _pendingHead(0),
+    _pendingCount(0),
+    _stopWriting(false),
+    _writeFailed(false),
+    _framesWritten(0),
+    _framesDropped(0)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    Close();
+}
+
+bool FrameRecorder::Open(const PathChar* path, uint32_t maxFrameLength, uint32_t slotCount)
+{
+    if (_file != nullptr || path == nullptr || maxFrameLength == 0 || slotCount == 0) return false;
+
+#ifdef _WIN32
+    if (_wfopen_s(&_file, path, L"wb") != 0)
+    {
+        _file = nullptr;
+    }
+#else
+    _file = fopen(path, "wb");
+#endif
+    if (_file == nullptr) return false;
+
+    // Allocate every slot up front; Append never allocates
+    _maxFrameLength = static_cast<uint32_t>(AlignRecordOffset(maxFrameLength));
+    _slotMemory.assign(static_cast<size_t>(_maxFrameLength) * slotCount, 0);
+    _slots.resize(slotCount);
+    _freeSlots.clear();
+    _pendingSlots.assign(slotCount, 0);
+    _pendingHead = 0;
+    _pendingCount = 0;
+
+    for (uint32_t i = 0; i < slotCount; i++)
+    {
+        _slots[i].Data = _slotMemory.data() + static_cast<size_t>(i) * _maxFrameLength;
+        _freeSlots.push_back(slotCount - 1 - i);
+    }
+
+    // Reserve room for roughly 10 minutes of 30 fps video before the index has to grow
+    _index.clear();
+    _index.reserve(18000);
+
+    RecordingFileHeader fileHeader = { RecordingFileMagic, RecordingFileVersion, RecordAlignment, 0 };
+    _fileOffset = 0;
+    _writeFailed = (fwrite(&fileHeader, sizeof(fileHeader), 1, _file) != 1);
+    _fileOffset += sizeof(fileHeader);
+    _writeFailed = _writeFailed || !WritePadding(AlignRecordOffset(_fileOffset) - _fileOffset);
+
+    _framesWritten = 0;
+    _framesDropped = 0;
+    _stopWriting = false;
+    _writerThread = std::thread(&FrameRecorder::WriterProc, this);
+
+    return true;
+}
+
+void FrameRecorder::Close()
+{
+    if (_file == nullptr) return;
+
+    // The writer thread drains all pending slots before it exits
+    {
+        std::lock_guard<std::mutex> lock(_slotLock);
+        _stopWriting = true;
+    }
+    _slotsPending.notify_one();
+
+    if (_writerThread.joinable())
+    {
+        _writerThread.join();
+    }
+
+    // Append the index and the trailer pointing to it
+    if (!_writeFailed)
+    {
+        RecordingFileTrailer trailer = { RecordingTrailerMagic, static_cast<uint32_t>(_index.size()), _fileOffset };
+
+        if (!_index.empty())
+        {
+            fwrite(_index.data(), sizeof(RecordIndexEntry), _index.size(), _file);
+        }
+        fwrite(&trailer, sizeof(trailer), 1, _file);
+    }
+
+    fclose(_file);
+    _file = nullptr;
+}
+
+bool FrameRecorder::Append(const CapturedFrame& frame)
+{
+    uint32_t slotIndex;
+
+    {
+        std::lock_guard<std::mutex> lock(_slotLock);
+
+        if (_file == nullptr || _stopWriting || _writeFailed || frame.Length > _maxFrameLength || _freeSlots.empty())
+        {
+            _framesDropped++;
+            return false;
+        }
+
+        slotIndex = _freeSlots.back();
+        _freeSlots.pop_back();
+    }
+
+    // The slot belongs to this thread until it's queued, so the copy is made without holding the lock
+    RecorderSlot& slot = _slots[slotIndex];
+    slot.Header.Magic = RecordMagic;
+    slot.Header.Length = frame.Length;
+    slot.Header.Timestamp = frame.Timestamp;
+    slot.Header.Format = static_cast<uint32_t>(frame.Layout.Format);
+    slot.Header.Width = frame.Layout.Width;
+    slot.Header.Height = frame.Layout.Height;
+    slot.Header.Stride = frame.Layout.Stride;
+    slot.Header.Flags = (frame.IlluminationTagged ? RecordFlagIlluminationTagged : 0) |
+        (frame.IlluminationEnabled ? RecordFlagIlluminationEnabled : 0);
+    slot.Header.Reserved = 0;
+    memcpy(slot.Data, frame.Data, frame.Length);
+
+    {
+        std::lock_guard<std::mutex> lock(_slotLock);
+
+        _pendingSlots[(_pendingHead + _pendingCount) % _pendingSlots.size()] = slotIndex;
+        _pendingCount++;
+    }
+    _slotsPending.notify_one();
+
+    return true;
+}
+
+uint64_t FrameRecorder::GetFramesWritten()
+{
+    std::lock_guard<std::mutex> lock(_slotLock);
+    return _framesWritten;
+}
+
+uint64_t FrameRecorder::GetFramesDropped()
+{
+    std::lock_guard<std::mutex> lock(_slotLock);
+    return _framesDropped;
+}
+
+void FrameRecorder::WriterProc()
+{
+    std::unique_lock<std::mutex> lock(_slotLock);
+
+    for (;;)
+    {
+        _slotsPending.wait(lock, [this] { return _pendingCount > 0 || _stopWriting; });
+
+        if (_pendingCount == 0)
+        {
+            break;      // Stopped and fully drained
+        }
+
+        const uint32_t slotIndex = _pendingSlots[_pendingHead];
+        _pendingHead = (_pendingHead + 1) % _pendingSlots.size();
+        _pendingCount--;
+
+        // Write without holding the lock so Append is never blocked by disk I/O
+        lock.unlock();
+        const bool written = !_writeFailed && WriteRecord(_slots[slotIndex]);
+        lock.lock();
+
+        _freeSlots.push_back(slotIndex);
+        if (written)
+        {
+            _framesWritten++;
+        }
+        else
+        {
+            // The file is incomplete from here on; drop everything else rather than writing a corrupted record
+            _writeFailed = true;
+            _framesDropped++;
+        }
+    }
+}
+
+bool FrameRecorder::WriteRecord(const RecorderSlot& slot)
+{
+    const uint64_t recordOffset = _fileOffset;
+
+    bool succeeded = (fwrite(&slot.Header, sizeof(slot.Header), 1, _file) == 1);
+    _fileOffset += sizeof(slot.Header);
+    succeeded = succeeded && WritePadding(AlignRecordOffset(_fileOffset) - _fileOffset);
+
+    succeeded = succeeded && (slot.Header.Length == 0 || fwrite(slot.Data, slot.Header.Length, 1, _file) == 1);
+    _fileOffset += slot.Header.Length;
+    succeeded = succeeded && WritePadding(AlignRecordOffset(_fileOffset) - _fileOffset);
+
+    if (succeeded)
+    {
+        RecordIndexEntry indexEntry = { recordOffset, slot.Header.Timestamp };
+        _index.push_back(indexEntry);
+    }
+
+    return succeeded;
+}
+
+bool FrameRecorder::WritePadding(uint64_t length)
+{
+    _fileOffset += length;
+    return (length == 0) || (fwrite(s_padding, static_cast<size_t>(length), 1, _file) == 1);
+}
+
+} // end namespace
@@ -0,0 +1,84 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameSource.h"
+#include "FrameRecording.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+// Appends captured frames to a recording file (see FrameRecording.h) without blocking the capture thread
+//
+// Frames are copied into one of a fixed number of preallocated slots and written to disk by a dedicated writer
+// thread. If the writer falls behind and every slot is waiting to be written, new frames are dropped and counted
+// rather than stalling the capture thread.
+class FrameRecorder
+{
+public:
+
+    FrameRecorder();
+    ~FrameRecorder();
+
+    // Creates the recording file; frames longer than maxFrameLength are dropped
+    bool Open(const PathChar* path, uint32_t maxFrameLength, uint32_t slotCount);
+
+    // Waits for all pending frames to be written, then writes the index and closes the file
+    void Close();
+
+    // Called on the capture thread; copies the frame and returns immediately
+    bool Append(const CapturedFrame& frame);
+
+    uint64_t GetFramesWritten();
+    uint64_t GetFramesDropped();
+
+private:
+
+    struct RecorderSlot
+    {
+        RecordHeader Header;
+        uint8_t* Data;
+    };
+
+    void WriterProc();
+    bool WriteRecord(const RecorderSlot& slot);
+    bool WritePadding(uint64_t length);
+
+    FILE* _file;
+    uint64_t _fileOffset;
+    uint32_t _maxFrameLength;
+
+    std::vector<uint8_t> _slotMemory;
+    std::vector<RecorderSlot> _slots;
+    std::vector<uint32_t> _freeSlots;           // Stack of slots available to Append
+    std::vector<uint32_t> _pendingSlots;        // Ring of slots waiting to be written, in capture order
+    size_t _pendingHead;
+    size_t _pendingCount;
+
+    std::vector<RecordIndexEntry> _index;       // Only accessed by the writer thread until it exits
+
+    std::mutex _slotLock;
+    std::condition_variable _slotsPending;
+    std::thread _writerThread;
+    bool _stopWriting;
+    bool _writeFailed;
+
+    uint64_t _framesWritten;
+    uint64_t _framesDropped;
+};
+
+} // end namespace
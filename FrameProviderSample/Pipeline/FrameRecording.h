@@ -0,0 +1,83 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Container format shared by FrameRecorder and FrameReplaySource
+//
+//   RecordingFileHeader, padded to RecordAlignment
+//   For every frame: RecordHeader, padded to RecordAlignment, followed by the frame data, padded to RecordAlignment
+//   RecordIndexEntry[FrameCount]       - written when the recording is closed
+//   RecordingFileTrailer               - written when the recording is closed
+//
+// Records are only ever appended; a recording that was never closed, e.g. because the process crashed, has no
+// index and it's rebuilt by walking the records. Frame data starts on a RecordAlignment boundary so replayed frames
+// can be used straight from the mapped file. All values are little endian.
+
+static const uint32_t RecordingFileMagic = 0x52465246;     // "FRFR"
+static const uint32_t RecordingFileVersion = 1;
+static const uint32_t RecordMagic = 0x44524346;            // "FCRD"
+static const uint32_t RecordingTrailerMagic = 0x58444946;  // "FIDX"
+static const uint32_t RecordAlignment = 64;
+
+// RecordHeader::Flags
+static const uint32_t RecordFlagIlluminationTagged = 0x1;
+static const uint32_t RecordFlagIlluminationEnabled = 0x2;
+
+struct RecordingFileHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t RecordAlignment;
+    uint32_t Reserved;
+};
+
+struct RecordHeader
+{
+    uint32_t Magic;
+    uint32_t Length;                // Number of data bytes following the padded header
+    int64_t Timestamp;
+    uint32_t Format;                // FramePixelFormat
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Stride;
+    uint32_t Flags;
+    uint32_t Reserved;
+};
+
+struct RecordIndexEntry
+{
+    uint64_t Offset;                // File offset of the RecordHeader
+    int64_t Timestamp;
+};
+
+struct RecordingFileTrailer
+{
+    uint32_t Magic;
+    uint32_t FrameCount;
+    uint64_t IndexOffset;
+};
+
+static_assert(sizeof(RecordingFileHeader) == 16, "RecordingFileHeader is part of the file format");
+static_assert(sizeof(RecordHeader) == 40, "RecordHeader is part of the file format");
+static_assert(sizeof(RecordIndexEntry) == 16, "RecordIndexEntry is part of the file format");
+static_assert(sizeof(RecordingFileTrailer) == 16, "RecordingFileTrailer is part of the file format");
+
+inline uint64_t AlignRecordOffset(uint64_t offset)
+{
+    return (offset + RecordAlignment - 1) & ~static_cast<uint64_t>(RecordAlignment - 1);
+}
+
+} // end namespace
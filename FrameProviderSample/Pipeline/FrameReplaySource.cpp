@@ -0,0 +1,293 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "FrameReplaySource.h"
+
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MediaFoundationProvider {
+
+FrameReplaySource::FrameReplaySource() :
+    _view(nullptr),
+    _viewSize(0),
+#ifdef _WIN32
+    _file(INVALID_HANDLE_VALUE),
+    _mapping(nullptr),
+#else
+    _file(-1),
+#endif
+    _nextFrame(0),
+    _pacing(ReplayPacing::Original),
+    _loop(false),
+    _replayStartTimestamp(0)
+{
+}
+
+FrameReplaySource::~FrameReplaySource()
+{
+    Close();
+}
+
+bool FrameReplaySource::Open(const PathChar* path, ReplayPacing pacing, bool loop)
+{
+    Close();
+
+    if (path == nullptr || !MapFile(path)) return false;
+
+    // Verify the file header
+    const RecordingFileHeader* fileHeader = reinterpret_cast<const RecordingFileHeader*>(_view);
+    if (_viewSize < AlignRecordOffset(sizeof(RecordingFileHeader)) ||
+        fileHeader->Magic != RecordingFileMagic ||
+        fileHeader->Version != RecordingFileVersion ||
+        fileHeader->RecordAlignment != RecordAlignment)
+    {
+        Close();
+        return false;
+    }
+
+    // Use the index written when the recording was closed; if there is none, walk the records
+    if (!LoadIndex())
+    {
+        RebuildIndex();
+    }
+
+    _pacing = pacing;
+    _loop = loop;
+    Rewind();
+
+    return true;
+}
+
+void FrameReplaySource::Close()
+{
+    UnmapFile();
+
+    _index.clear();
+    _nextFrame = 0;
+}
+
+void FrameReplaySource::Rewind()
+{
+    _nextFrame = 0;
+    _replayStartTime = std::chrono::steady_clock::now();
+    _replayStartTimestamp = _index.empty() ? 0 : _index.front().Timestamp;
+}
+
+bool FrameReplaySource::ReadFrame(CapturedFrame& frame)
+{
+    if (_index.empty()) return false;
+
+    if (_nextFrame == _index.size())
+    {
+        if (!_loop) return false;
+        Rewind();
+    }
+
+    const RecordIndexEntry& indexEntry = _index[_nextFrame++];
+    const RecordHeader* record = GetRecord(indexEntry.Offset);
+
+    // Records are validated when the index is loaded
+    frame.Data = reinterpret_cast<const uint8_t*>(record) + AlignRecordOffset(sizeof(RecordHeader));
+    frame.Length = record->Length;
+    frame.Layout.Format = static_cast<FramePixelFormat>(record->Format);
+    frame.Layout.Width = record->Width;
+    frame.Layout.Height = record->Height;
+    frame.Layout.Stride = record->Stride;
+    frame.Timestamp = record->Timestamp;
+    frame.IlluminationTagged = (record->Flags & RecordFlagIlluminationTagged) != 0;
+    frame.IlluminationEnabled = (record->Flags & RecordFlagIlluminationEnabled) != 0;
+
+    // Wait until the frame is due relative to the first frame of the recording
+    // NOTE: Timestamps are in 100 nanosecond units
+    if (_pacing == ReplayPacing::Original)
+    {
+        const int64_t elapsedTicks = record->Timestamp - _replayStartTimestamp;
+        if (elapsedTicks > 0)
+        {
+            std::this_thread::sleep_until(_replayStartTime + std::chrono::microseconds(elapsedTicks / 10));
+        }
+    }
+
+    return true;
+}
+
+bool FrameReplaySource::GetFrameLayout(FrameLayout& layout) const
+{
+    if (_index.empty()) return false;
+
+    const RecordHeader* record = GetRecord(_index.front().Offset);
+    layout.Format = static_cast<FramePixelFormat>(record->Format);
+    layout.Width = record->Width;
+    layout.Height = record->Height;
+    layout.Stride = record->Stride;
+
+    return true;
+}
+
+int64_t FrameReplaySource::GetAverageFrameInterval() const
+{
+    if (_index.size() < 2) return 0;
+
+    const int64_t duration = _index.back().Timestamp - _index.front().Timestamp;
+    return (duration > 0) ? duration / static_cast<int64_t>(_index.size() - 1) : 0;
+}
+
+bool FrameReplaySource::MapFile(const PathChar* path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    _file = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        UnmapFile();
+        return false;
+    }
+
+    _mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping != nullptr)
+    {
+        _view = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    _viewSize = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    _file = open(path, O_RDONLY);
+    if (_file < 0) return false;
+
+    struct stat fileStatus;
+    if (fstat(_file, &fileStatus) != 0 || fileStatus.st_size == 0)
+    {
+        UnmapFile();
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+    if (view != MAP_FAILED)
+    {
+        _view = static_cast<const uint8_t*>(view);
+        madvise(view, static_cast<size_t>(fileStatus.st_size), MADV_SEQUENTIAL);
+    }
+    _viewSize = static_cast<uint64_t>(fileStatus.st_size);
+#endif
+
+    if (_view == nullptr)
+    {
+        UnmapFile();
+        return false;
+    }
+
+    return true;
+}
+
+void FrameReplaySource::UnmapFile()
+{
+#ifdef _WIN32
+    if (_view != nullptr) UnmapViewOfFile(_view);
+    if (_mapping != nullptr) CloseHandle(_mapping);
+    if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+
+    _mapping = nullptr;
+    _file = INVALID_HANDLE_VALUE;
+#else
+    if (_view != nullptr) munmap(const_cast<uint8_t*>(_view), static_cast<size_t>(_viewSize));
+    if (_file >= 0) close(_file);
+
+    _file = -1;
+#endif
+
+    _view = nullptr;
+    _viewSize = 0;
+}
+
+bool FrameReplaySource::LoadIndex()
+{
+    if (_viewSize < sizeof(RecordingFileTrailer)) return false;
+
+    const RecordingFileTrailer* trailer = reinterpret_cast<const RecordingFileTrailer*>(_view + _viewSize - sizeof(RecordingFileTrailer));
+    const uint64_t indexLength = static_cast<uint64_t>(trailer->FrameCount) * sizeof(RecordIndexEntry);
+    const uint64_t indexEnd = _viewSize - sizeof(RecordingFileTrailer);
+
+    // The index must end exactly at the trailer; compared separately so a corrupt offset can't wrap around
+    if (trailer->Magic != RecordingTrailerMagic ||
+        trailer->IndexOffset > indexEnd ||
+        indexLength != indexEnd - trailer->IndexOffset)
+    {
+        return false;
+    }
+
+    // The index isn't necessarily aligned for RecordIndexEntry, so copy it instead of pointing into the mapping
+    const RecordIndexEntry* entries = reinterpret_cast<const RecordIndexEntry*>(_view + trailer->IndexOffset);
+    _index.assign(entries, entries + trailer->FrameCount);
+
+    // Every indexed record must be complete, otherwise fall back to walking the records
+    for (const RecordIndexEntry& indexEntry : _index)
+    {
+        if (GetRecord(indexEntry.Offset) == nullptr)
+        {
+            _index.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FrameReplaySource::RebuildIndex()
+{
+    _index.clear();
+
+    // Walk the records until one is incomplete, e.g. the last record of a recording that was cut short
+    uint64_t offset = AlignRecordOffset(sizeof(RecordingFileHeader));
+    for (const RecordHeader* record = GetRecord(offset); record != nullptr; record = GetRecord(offset))
+    {
+        RecordIndexEntry indexEntry = { offset, record->Timestamp };
+        _index.push_back(indexEntry);
+
+        offset += AlignRecordOffset(sizeof(RecordHeader)) + AlignRecordOffset(record->Length);
+    }
+}
+
+const RecordHeader* FrameReplaySource::GetRecord(uint64_t offset) const
+{
+    const uint64_t dataOffset = offset + AlignRecordOffset(sizeof(RecordHeader));
+
+    if ((offset % RecordAlignment) != 0 || dataOffset > _viewSize || offset > dataOffset)
+    {
+        return nullptr;
+    }
+
+    // The record must be complete and hold at least one frame of the layout it describes
+    const RecordHeader* record = reinterpret_cast<const RecordHeader*>(_view + offset);
+    const FrameLayout layout = { static_cast<FramePixelFormat>(record->Format), record->Width, record->Height, record->Stride };
+
+    if (record->Magic != RecordMagic ||
+        record->Length > _viewSize - dataOffset ||
+        GetFrameLength(layout) == 0 ||
+        GetFrameLength(layout) > record->Length)
+    {
+        return nullptr;
+    }
+
+    return record;
+}
+
+} // end namespace
@@ -0,0 +1,76 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameSource.h"
+#include "FrameRecording.h"
+
+#include <chrono>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+enum class ReplayPacing
+{
+    Original,       // Frames are returned at the pace they were recorded
+    FlatOut,        // Frames are returned as fast as they're read, e.g. for benchmarks
+};
+
+// Replays a recording made by FrameRecorder
+// The file is mapped into memory and the returned frames point straight into the mapping, no frame data is copied
+class FrameReplaySource : public IFrameSource
+{
+public:
+
+    FrameReplaySource();
+    virtual ~FrameReplaySource();
+
+    bool Open(const PathChar* path, ReplayPacing pacing, bool loop);
+    void Close();
+    void Rewind();
+
+    size_t GetFrameCount() const { return _index.size(); }
+
+    // Describe the recording so a video profile matching its frames can be published
+    bool GetFrameLayout(FrameLayout& layout) const;
+    int64_t GetAverageFrameInterval() const;
+
+    // IFrameSource
+    virtual bool ReadFrame(CapturedFrame& frame) override;
+
+private:
+
+    bool MapFile(const PathChar* path);
+    void UnmapFile();
+    bool LoadIndex();
+    void RebuildIndex();
+    const RecordHeader* GetRecord(uint64_t offset) const;
+
+    const uint8_t* _view;
+    uint64_t _viewSize;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#else
+    int _file;
+#endif
+
+    std::vector<RecordIndexEntry> _index;
+    size_t _nextFrame;
+
+    ReplayPacing _pacing;
+    bool _loop;
+    std::chrono::steady_clock::time_point _replayStartTime;
+    int64_t _replayStartTimestamp;
+};
+
+} // end namespace
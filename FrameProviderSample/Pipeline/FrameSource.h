@@ -0,0 +1,51 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameConversion.h"
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// File paths are UTF-16 on Windows and narrow (UTF-8) strings everywhere else
+#ifdef _WIN32
+typedef wchar_t PathChar;
+#else
+typedef char PathChar;
+#endif
+
+// A single frame exactly as the capture device produced it, i.e. before it's converted to Gray8
+struct CapturedFrame
+{
+    const uint8_t* Data;
+    uint32_t Length;
+    FrameLayout Layout;
+    int64_t Timestamp;              // Presentation time reported by the device in 100 nanosecond units
+    bool IlluminationTagged;        // Set if the frame carried the active illumination state (see WDPP_ACTIVE_ILLUMINATION_ENABLED)
+    bool IlluminationEnabled;
+};
+
+// Produces frames in place of a capture device, e.g. to replay a recording
+class IFrameSource
+{
+public:
+
+    virtual ~IFrameSource() {}
+
+    // Returns the next frame or false if the source has no more frames
+    // NOTE: The frame's Data remains valid until the source is closed or destroyed, so frames can still be converted
+    // while the next ones are read
+    virtual bool ReadFrame(CapturedFrame& frame) = 0;
+};
+
+} // end namespace
@@ -0,0 +1,295 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "HeadlessFrameProvider.h"
+
+namespace MediaFoundationProvider {
+
+HeadlessFrameProvider::HeadlessFrameProvider(const std::string& providerId, IPerceptionService* service, const std::shared_ptr<IFrameSource>& frameSource, const FrameLayout& sourceLayout) :
+    _providerId(providerId),
+    _service(service),
+    _frameSource(frameSource),
+    _pairIllumination(false),
+    _parallelPipeline(_framePipeline),
+    _conversionWorkers(1),
+    _executor(nullptr),
+    _stopReadingFrames(false),
+    _available(false),
+    _steadyStateAllocations(0)
+{
+    // A provider that can't convert its frames is never available, like a device without a compatible media type
+    if (_framePipeline.Configure(sourceLayout))
+    {
+        _outputFrames[0].resize(_framePipeline.GetOutputLength());
+        _outputFrames[1].resize(_framePipeline.GetOutputLength());
+        _available = (_frameSource != nullptr);
+    }
+
+    _service->RegisterFrameProvider(_providerId);
+    _service->UpdateAvailabilityForProvider(_providerId, _available);
+}
+
+HeadlessFrameProvider::~HeadlessFrameProvider()
+{
+    Stop();
+
+    _service->UnregisterFrameProvider(_providerId);
+}
+
+bool HeadlessFrameProvider::Start()
+{
+    if (IsRunning()) return true;
+    if (!_available) return false;
+
+    _stopReadingFrames = false;
+    _worker = std::thread(&HeadlessFrameProvider::ReadFrameProc, this);
+
+    return true;
+}
+
+void HeadlessFrameProvider::Stop()
+{
+    if (!IsRunning()) return;
+
+    _stopReadingFrames = true;
+    _worker.join();
+}
+
+PropertyChangeStatus HeadlessFrameProvider::SetProperty(const std::string& name, double value)
+{
+    // The source's video profile is fixed and there is no device to apply the exposure to
+    if (name == HeadlessVideoProfileProperty ||
+        name == HeadlessSupportedVideoProfilesProperty ||
+        name == HeadlessAvailableVideoProfilesProperty)
+    {
+        return PropertyChangeStatus::PropertyReadOnly;
+    }
+    else if (name == HeadlessExposureCompensationProperty)
+    {
+        return PropertyChangeStatus::PropertyNotSupported;
+    }
+
+    std::lock_guard<std::mutex> lock(_propertiesLock);
+    _properties[name] = value;
+
+    return PropertyChangeStatus::Accepted;
+}
+
+void HeadlessFrameProvider::SetIlluminationPairing(bool enable, int64_t frameInterval)
+{
+    _pairIllumination = enable;
+    _illuminationPairer.SetFrameInterval(frameInterval);
+}
+
+bool HeadlessFrameProvider::SetConversionWorkers(uint32_t workerCount, WorkStealingExecutor* executor)
+{
+    if (IsRunning() || workerCount == 0 || workerCount > ParallelFramePipeline::MaxWorkers) return false;
+
+    _conversionWorkers = workerCount;
+    _executor = executor;
+    return true;
+}
+
+bool HeadlessFrameProvider::GetProperty(const std::string& name, double& value)
+{
+    std::lock_guard<std::mutex> lock(_propertiesLock);
+
+    auto property = _properties.find(name);
+    if (property == _properties.end()) return false;
+
+    value = property->second;
+    return true;
+}
+
+void HeadlessFrameProvider::ReadFrameProc()
+{
+    // A frame held when the provider was stopped won't get its partner
+    _illuminationPairer.Reset();
+
+    if (_conversionWorkers > 1 || _executor != nullptr)
+    {
+        ReadFramesInParallel();
+        return;
+    }
+
+    const FrameLayout& layout = _framePipeline.GetSourceLayout();
+    uint64_t framesRead = 0;
+    size_t outputIndex = 0;
+    PublishedFrame heldFrame = {};
+
+    while (!_stopReadingFrames)
+    {
+        const uint64_t allocationCount = GetThreadAllocationCount();
+
+        CapturedFrame capturedFrame;
+        if (!_frameSource->ReadFrame(capturedFrame))
+        {
+            // The source ran out of frames; report it like a removed device
+            _available = false;
+            _service->UpdateAvailabilityForProvider(_providerId, false);
+            break;
+        }
+
+        const int64_t readTime = GetPipelineTime();
+
+        ProcessedFrame processedFrame;
+        std::vector<uint8_t>& outputFrame = _outputFrames[outputIndex];
+        if (_framePipeline.Process(capturedFrame, outputFrame.data(), static_cast<uint32_t>(outputFrame.size()), processedFrame))
+        {
+            PublishedFrame publishedFrame;
+            publishedFrame.Sequence = processedFrame.Sequence;
+            publishedFrame.SourceTimestamp = processedFrame.SourceTimestamp;
+            publishedFrame.ReadTime = readTime;
+            publishedFrame.PresentationTime = _framePacer.Pace(processedFrame.SourceTimestamp, readTime);
+            publishedFrame.Data = outputFrame.data();
+            publishedFrame.Length = static_cast<uint32_t>(outputFrame.size());
+            publishedFrame.Width = layout.Width;
+            publishedFrame.Height = layout.Height;
+            publishedFrame.IlluminationEnabled = processedFrame.IlluminationEnabled;
+
+            // Keep the held frame's buffer and convert the next frame into the other one
+            if (PublishOrHoldFrame(publishedFrame, processedFrame.IlluminationTagged, heldFrame))
+            {
+                outputIndex ^= 1;
+            }
+        }
+
+        // Once warmed up, reading, converting and publishing a frame must not allocate
+        if (++framesRead > SteadyStateWarmupFrames)
+        {
+            _steadyStateAllocations += GetThreadAllocationCount() - allocationCount;
+        }
+    }
+}
+
+void HeadlessFrameProvider::ReadFramesInParallel()
+{
+    uint64_t framesRead = 0;
+    HeldParallelFrame heldFrame = {};
+
+    if (!_parallelPipeline.Start(_conversionWorkers, _executor)) return;
+
+    while (!_stopReadingFrames)
+    {
+        const uint64_t allocationCount = GetThreadAllocationCount();
+
+        CapturedFrame capturedFrame;
+        if (!_frameSource->ReadFrame(capturedFrame))
+        {
+            // The source ran out of frames; report it like a removed device
+            _available = false;
+            _service->UpdateAvailabilityForProvider(_providerId, false);
+            break;
+        }
+
+        const int64_t readTime = GetPipelineTime();
+
+        // Publish the oldest frames until a slot is free for this one, then whatever else is already converted
+        while (!_parallelPipeline.CanSubmit() && PublishNextParallelFrame(true, heldFrame))
+        {
+        }
+        _parallelPipeline.Submit(capturedFrame, readTime);
+        while (PublishNextParallelFrame(false, heldFrame))
+        {
+        }
+
+        // Only counts the reading thread; the workers convert into preallocated slots
+        if (++framesRead > SteadyStateWarmupFrames)
+        {
+            _steadyStateAllocations += GetThreadAllocationCount() - allocationCount;
+        }
+    }
+
+    // Frames read before stopping are still published, like the sequential path does; a frame still held won't get
+    // its partner and is dropped with the slots
+    while (PublishNextParallelFrame(true, heldFrame))
+    {
+    }
+
+    _parallelPipeline.Stop();
+}
+
+bool HeadlessFrameProvider::PublishNextParallelFrame(bool wait, HeldParallelFrame& heldFrame)
+{
+    ParallelFrame frame;
+    if (!_parallelPipeline.Next(frame, wait)) return false;
+
+    if (!frame.Processed)
+    {
+        _parallelPipeline.Release(frame);
+        return true;
+    }
+
+    const FrameLayout& layout = _framePipeline.GetSourceLayout();
+
+    PublishedFrame publishedFrame;
+    publishedFrame.Sequence = frame.Result.Sequence;
+    publishedFrame.SourceTimestamp = frame.Result.SourceTimestamp;
+    publishedFrame.ReadTime = frame.ReadTime;
+    publishedFrame.PresentationTime = _framePacer.Pace(frame.Result.SourceTimestamp, frame.ReadTime);
+    publishedFrame.Data = frame.Data;
+    publishedFrame.Length = frame.Length;
+    publishedFrame.Width = layout.Width;
+    publishedFrame.Height = layout.Height;
+    publishedFrame.IlluminationEnabled = frame.Result.IlluminationEnabled;
+
+    const bool paired = _pairIllumination && frame.Result.IlluminationTagged;
+    const bool held = PublishOrHoldFrame(publishedFrame, frame.Result.IlluminationTagged, heldFrame.Published);
+
+    // Every decision of the pairer resolves the frame it held before, so that frame's slot can be reused
+    if (paired && heldFrame.Holding)
+    {
+        _parallelPipeline.Release(heldFrame.Frame);
+        heldFrame.Holding = false;
+    }
+
+    if (held)
+    {
+        heldFrame.Frame = frame;
+        heldFrame.Holding = true;
+    }
+    else
+    {
+        _parallelPipeline.Release(frame);
+    }
+
+    return true;
+}
+
+bool HeadlessFrameProvider::PublishOrHoldFrame(const PublishedFrame& frame, bool illuminationTagged, PublishedFrame& heldFrame)
+{
+    if (!_pairIllumination || !illuminationTagged)
+    {
+        _service->PublishFrameForProvider(_providerId, frame);
+        return false;
+    }
+
+    switch (_illuminationPairer.Submit(frame.SourceTimestamp, frame.IlluminationEnabled))
+    {
+    case PairingDecision::HoldFirst:
+    case PairingDecision::DropHeldAndHoldFirst:
+        heldFrame = frame;
+        return true;
+
+    case PairingDecision::PublishPair:
+        _service->PublishFrameForProvider(_providerId, heldFrame);
+        _service->PublishFrameForProvider(_providerId, frame);
+        break;
+
+    case PairingDecision::DropHeldAndFrame:
+    case PairingDecision::DropFrame:
+        break;
+    }
+
+    return false;
+}
+
+} // end namespace
@@ -0,0 +1,120 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "AllocationCounter.h"
+#include "FramePacer.h"
+#include "FramePipeline.h"
+#include "IlluminationPairer.h"
+#include "ParallelFramePipeline.h"
+#include "PerceptionService.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+// Property names understood by HeadlessFrameProvider::SetProperty, see KnownPerceptionVideoFrameSourceProperties
+// and KnownPerceptionInfraredFrameSourceProperties
+static const char HeadlessVideoProfileProperty[] = "VideoProfile";
+static const char HeadlessSupportedVideoProfilesProperty[] = "SupportedVideoProfiles";
+static const char HeadlessAvailableVideoProfilesProperty[] = "AvailableVideoProfiles";
+static const char HeadlessExposureCompensationProperty[] = "ExposureCompensation";
+
+// Stands in for SampleFrameProvider outside of SensorDataService
+//
+// Frames are read from an IFrameSource on a dedicated thread, converted by the same FramePipeline as
+// SampleFrameProvider and published to an IPerceptionService, usually a PerceptionServiceStandIn. The provider
+// registers itself when it's created and becomes unavailable once its frame source runs out of frames, like
+// SampleFrameProvider does when its device is removed.
+class HeadlessFrameProvider
+{
+public:
+
+    // Frames read after Start before the frame path is considered to be in steady state
+    static const uint64_t SteadyStateWarmupFrames = 16;
+
+    HeadlessFrameProvider(const std::string& providerId, IPerceptionService* service, const std::shared_ptr<IFrameSource>& frameSource, const FrameLayout& sourceLayout);
+    ~HeadlessFrameProvider();
+
+    const std::string& GetProviderId() const { return _providerId; }
+    bool IsAvailable() const { return _available; }
+    bool IsRunning() const { return _worker.joinable(); }
+
+    // IPerceptionFrameProvider
+    bool Start();
+    void Stop();
+    PropertyChangeStatus SetProperty(const std::string& name, double value);
+
+    // Publishes tagged frames in illuminated/unilluminated pairs like SampleFrameProvider does for interleaved sensors
+    // NOTE: Only call these while the provider is stopped
+    void SetIlluminationPairing(bool enable, int64_t frameInterval);
+    PairingStats GetPairingStats() const { return _illuminationPairer.GetStats(); }
+
+    // Converts up to workerCount frames concurrently and publishes them in capture order, see ParallelFramePipeline;
+    // 1 converts each frame on the reading thread. Frames are converted on the executor if one is given, e.g. one
+    // shared by every provider of the process.
+    // NOTE: Only call this while the provider is stopped
+    bool SetConversionWorkers(uint32_t workerCount, WorkStealingExecutor* executor = nullptr);
+
+    bool GetProperty(const std::string& name, double& value);
+
+    // Heap allocations made while reading, converting and publishing frames in steady state, see AllocationCounter
+    // NOTE: Includes the allocations made by the service while the frame is published
+    uint64_t GetSteadyStateAllocations() const { return _steadyStateAllocations; }
+
+private:
+
+    void ReadFrameProc();
+    // A frame whose slot is kept until its illumination partner arrives
+    struct HeldParallelFrame
+    {
+        bool Holding;
+        ParallelFrame Frame;
+        PublishedFrame Published;
+    };
+
+    void ReadFramesInParallel();
+    bool PublishNextParallelFrame(bool wait, HeldParallelFrame& heldFrame);
+
+    // Publishes the frame or hands it to the IlluminationPairer; returns true if the frame is held until its partner
+    // arrives, in which case its data must remain valid
+    bool PublishOrHoldFrame(const PublishedFrame& frame, bool illuminationTagged, PublishedFrame& heldFrame);
+
+    const std::string _providerId;
+    IPerceptionService* const _service;
+    std::shared_ptr<IFrameSource> _frameSource;
+
+    FramePipeline _framePipeline;
+    FramePacer _framePacer;
+    std::vector<uint8_t> _outputFrames[2];      // The second frame is held while it waits for its partner
+    IlluminationPairer _illuminationPairer;
+    bool _pairIllumination;
+    ParallelFramePipeline _parallelPipeline;
+    uint32_t _conversionWorkers;
+    WorkStealingExecutor* _executor;
+
+    std::thread _worker;
+    std::atomic<bool> _stopReadingFrames;
+    std::atomic<bool> _available;
+    std::atomic<uint64_t> _steadyStateAllocations;
+
+    std::mutex _propertiesLock;
+    std::map<std::string, double> _properties;
+};
+
+} // end namespace
@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "IlluminationMetadata.h"
+
+#include <cstring>
+
+namespace MediaFoundationProvider {
+
+static uint32_t ReadUInt32(const uint8_t* data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Sample embedded line: the last line of the luma plane starts with SampleEmbeddedLineMagic followed by a frame
+// counter and the illumination flags, each a little endian UINT32. In YUY2 frames the values occupy the raw bytes
+// of the line rather than only its luma samples.
+static bool ParseSampleEmbeddedLine(const IlluminationMetadataInput& input, bool& illuminated)
+{
+    const uint32_t metadataLength = 3 * sizeof(uint32_t);
+    const uint64_t lineOffset = static_cast<uint64_t>(input.Layout.Stride) * (input.Layout.Height - 1);
+
+    if (input.Frame == nullptr || input.Layout.Height == 0 || input.Layout.Stride < metadataLength ||
+        lineOffset + metadataLength > input.FrameLength)
+    {
+        return false;
+    }
+
+    const uint8_t* line = input.Frame + lineOffset;
+    if (ReadUInt32(line) != SampleEmbeddedLineMagic) return false;
+
+    illuminated = (ReadUInt32(line + 2 * sizeof(uint32_t)) & SampleIlluminationFlagEnabled) != 0;
+    return true;
+}
+
+// Sample capture metadata: the UVC metadata buffer is a sequence of KSCAMERA_METADATA_ITEMHEADER items, i.e. a UINT32
+// MetadataId and a UINT32 Size that includes the header. The sample item has SampleCaptureMetadataId and its payload
+// starts with the illumination flags.
+static bool ParseSampleCaptureMetadata(const IlluminationMetadataInput& input, bool& illuminated)
+{
+    const uint32_t headerLength = 2 * sizeof(uint32_t);
+
+    if (input.CaptureMetadata == nullptr) return false;
+
+    uint32_t offset = 0;
+    while (input.CaptureMetadataLength - offset >= headerLength)
+    {
+        const uint32_t metadataId = ReadUInt32(input.CaptureMetadata + offset);
+        const uint32_t size = ReadUInt32(input.CaptureMetadata + offset + sizeof(uint32_t));
+
+        // Stop at malformed items rather than read past the buffer
+        if (size < headerLength || size > input.CaptureMetadataLength - offset) return false;
+
+        if (metadataId == SampleCaptureMetadataId && size >= headerLength + sizeof(uint32_t))
+        {
+            illuminated = (ReadUInt32(input.CaptureMetadata + offset + headerLength) & SampleIlluminationFlagEnabled) != 0;
+            return true;
+        }
+
+        // Items are padded to 8 bytes
+        offset += (size + 7) & ~7u;
+        if (offset > input.CaptureMetadataLength) return false;
+    }
+
+    return false;
+}
+
+// TODO: Add an entry for your sensor's metadata; parsers are tried in this order
+static const IlluminationMetadataParser s_illuminationMetadataParsers[] =
+{
+    { "SampleCaptureMetadata", 0, IlluminationMetadataLocation::CaptureMetadata, ParseSampleCaptureMetadata },
+    { "SampleEmbeddedLineYUY2", FourCCYUY2, IlluminationMetadataLocation::EmbeddedLine, ParseSampleEmbeddedLine },
+    { "SampleEmbeddedLineNV12", FourCCNV12, IlluminationMetadataLocation::EmbeddedLine, ParseSampleEmbeddedLine },
+    { "SampleEmbeddedLineL8", FourCCL8, IlluminationMetadataLocation::EmbeddedLine, ParseSampleEmbeddedLine },
+};
+
+uint32_t FindIlluminationMetadataParsers(uint32_t subtypeFourCC, const IlluminationMetadataParser** parsers, uint32_t maxParsers)
+{
+    uint32_t parserCount = 0;
+
+    for (const IlluminationMetadataParser& parser : s_illuminationMetadataParsers)
+    {
+        if (parserCount < maxParsers && (parser.SubtypeFourCC == 0 || parser.SubtypeFourCC == subtypeFourCC))
+        {
+            parsers[parserCount++] = &parser;
+        }
+    }
+    return parserCount;
+}
+
+const IlluminationMetadataParser* ParseIlluminationMetadata(
+    const IlluminationMetadataParser* const* parsers,
+    uint32_t parserCount,
+    const IlluminationMetadataInput& input,
+    bool& illuminated)
+{
+    for (uint32_t i = 0; i < parserCount; i++)
+    {
+        if (parsers[i]->Parse(input, illuminated))
+        {
+            return parsers[i];
+        }
+    }
+    return nullptr;
+}
+
+} // end namespace
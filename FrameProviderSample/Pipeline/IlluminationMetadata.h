@@ -0,0 +1,75 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameConversion.h"
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Where a parser finds the illumination state of a frame
+enum class IlluminationMetadataLocation : uint32_t
+{
+    EmbeddedLine = 1,       // A line of the frame carries metadata instead of pixels
+    CaptureMetadata = 2,    // The UVC metadata buffer attached to the sample, i.e. MF_CAPTURE_METADATA_FRAME_RAWSTREAM
+};
+
+// Everything a parser may look at for a single frame; either part may be missing
+struct IlluminationMetadataInput
+{
+    const uint8_t* Frame;
+    uint32_t FrameLength;
+    FrameLayout Layout;
+    const uint8_t* CaptureMetadata;
+    uint32_t CaptureMetadataLength;
+};
+
+// Returns true if the frame's metadata was found, in which case illuminated holds the illuminator state
+typedef bool (*IlluminationMetadataProc)(const IlluminationMetadataInput& input, bool& illuminated);
+
+// Reads the illumination state a sensor reports with each frame
+//
+// Parsers only read a few bytes at a known location, so parsing a frame takes well under a microsecond and needs
+// no query to the device. Vendors add an entry for their sensor's metadata to the parser table; parsers are selected
+// by the subtype of the negotiated media type and tried in table order until one finds its metadata.
+struct IlluminationMetadataParser
+{
+    const char* Name;
+    uint32_t SubtypeFourCC;             // Data1 of the media subtype GUID, 0 for any subtype
+    IlluminationMetadataLocation Location;
+    IlluminationMetadataProc Parse;
+};
+
+// Data1 of the media subtype GUIDs of the formats MFT0 reads frames of
+static const uint32_t FourCCYUY2 = 0x32595559;     // MFVideoFormat_YUY2
+static const uint32_t FourCCNV12 = 0x3231564E;     // MFVideoFormat_NV12
+static const uint32_t FourCCL8 = 0x00000050;       // MFVideoFormat_L8, i.e. D3DFMT_L8
+
+static const uint32_t MaxIlluminationMetadataParsers = 4;
+
+// Fills parsers with the parsers for the given media subtype, in the order they should be tried, and returns their count
+uint32_t FindIlluminationMetadataParsers(uint32_t subtypeFourCC, const IlluminationMetadataParser** parsers, uint32_t maxParsers);
+
+// Tries the given parsers in order; returns the parser that found the frame's metadata, or nullptr
+const IlluminationMetadataParser* ParseIlluminationMetadata(
+    const IlluminationMetadataParser* const* parsers,
+    uint32_t parserCount,
+    const IlluminationMetadataInput& input,
+    bool& illuminated);
+
+// Layout of the metadata understood by the sample parsers, see IlluminationMetadata.cpp
+static const uint32_t SampleEmbeddedLineMagic = 0x4D4C4C49;        // "ILLM", little endian
+static const uint32_t SampleCaptureMetadataId = 0x80001000;         // MetadataId_Custom + 0x1000
+static const uint32_t SampleIlluminationFlagEnabled = 0x1;
+
+} // end namespace
@@ -0,0 +1,76 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "IlluminationPairer.h"
+
+namespace MediaFoundationProvider {
+
+static const int64_t DefaultFrameInterval = 333333;     // 30 fps
+
+IlluminationPairer::IlluminationPairer() :
+    _holding(false),
+    _heldTimestamp(0),
+    _stats()
+{
+    SetFrameInterval(DefaultFrameInterval);
+}
+
+void IlluminationPairer::SetFrameInterval(int64_t frameInterval)
+{
+    _maxPartnerGap = (frameInterval > 0 ? frameInterval : DefaultFrameInterval) * 3 / 2;
+}
+
+void IlluminationPairer::Reset()
+{
+    _stats.OrphansDropped += _holding ? 1 : 0;
+    _holding = false;
+}
+
+PairingDecision IlluminationPairer::Submit(int64_t timestamp, bool illuminated)
+{
+    if (!_holding)
+    {
+        // Pairs always start with the illuminated frame
+        if (!illuminated)
+        {
+            _stats.OrphansDropped++;
+            return PairingDecision::DropFrame;
+        }
+
+        _holding = true;
+        _heldTimestamp = timestamp;
+        return PairingDecision::HoldFirst;
+    }
+
+    const int64_t gap = timestamp - _heldTimestamp;
+    const bool partnerInTime = (gap > 0 && gap <= _maxPartnerGap);
+
+    if (!illuminated && partnerInTime)
+    {
+        _holding = false;
+        _stats.PairsPublished++;
+        return PairingDecision::PublishPair;
+    }
+    else if (illuminated)
+    {
+        // The held frame's partner is missing, this frame may still get one
+        _stats.OrphansDropped++;
+        _heldTimestamp = timestamp;
+        return PairingDecision::DropHeldAndHoldFirst;
+    }
+
+    // An unilluminated frame that's too late, or from before the held frame, belongs to neither pair
+    _holding = false;
+    _stats.OrphansDropped += 2;
+    return PairingDecision::DropHeldAndFrame;
+}
+
+} // end namespace
@@ -0,0 +1,66 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// What to do with a frame submitted to IlluminationPairer
+enum class PairingDecision
+{
+    HoldFirst,              // Keep the frame until its partner arrives
+    PublishPair,            // Publish the held frame followed by this one
+    DropHeldAndHoldFirst,   // The held frame is an orphan; drop it and keep this frame instead
+    DropHeldAndFrame,       // Neither frame has a partner; drop both
+    DropFrame,              // The frame is an orphan; drop it
+};
+
+struct PairingStats
+{
+    uint64_t PairsPublished;
+    uint64_t OrphansDropped;        // Frames dropped because their partner was missing
+};
+
+// Groups the frames of an interleaved sensor into illuminated/unilluminated pairs
+//
+// The service relies on lit and unlit frames alternating, so a single lost frame would shift the sequence for the
+// rest of the session. Each pair starts with an illuminated frame that's held back until the unilluminated frame
+// captured right after it arrives; frames without a partner within 1.5 frame intervals are dropped rather than
+// published out of sequence.
+// NOTE: Timestamps are in 100 nanosecond units. Not thread safe.
+class IlluminationPairer
+{
+public:
+
+    IlluminationPairer();
+
+    // The expected time between two frames, i.e. between the two frames of a pair
+    void SetFrameInterval(int64_t frameInterval);
+
+    // Forgets the held frame, e.g. after the stream was restarted; the caller drops the frame it held
+    void Reset();
+
+    PairingDecision Submit(int64_t timestamp, bool illuminated);
+    bool IsHoldingFrame() const { return _holding; }
+
+    PairingStats GetStats() const { return _stats; }
+
+private:
+
+    int64_t _maxPartnerGap;
+    bool _holding;
+    int64_t _heldTimestamp;
+    PairingStats _stats;
+};
+
+} // end namespace
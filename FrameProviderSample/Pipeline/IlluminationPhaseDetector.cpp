@@ -0,0 +1,87 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "IlluminationPhaseDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MediaFoundationProvider {
+
+static const double MinContrast = 0.08;     // Relative brightness change that tells a lit frame from an unlit one
+
+IlluminationPhaseDetector::IlluminationPhaseDetector() :
+    _rephases(0)
+{
+    Reset();
+}
+
+void IlluminationPhaseDetector::Reset()
+{
+    _frameIndex = 0;
+    _previousLuminance = 0.0;
+    _litParity = 0;
+    _agreements = 0;
+    _disagreements = 0;
+    _weakChanges = 0;
+    _locked = false;
+}
+
+bool IlluminationPhaseDetector::Submit(double meanLuminance, bool& illuminated)
+{
+    const uint32_t parity = static_cast<uint32_t>(_frameIndex & 1);
+
+    // The first frame only provides the reference for the second
+    if (_frameIndex++ != 0)
+    {
+        const double contrast = (meanLuminance - _previousLuminance) / (std::max)((std::max)(meanLuminance, _previousLuminance), 1.0);
+
+        if (std::fabs(contrast) < MinContrast)
+        {
+            _agreements = 0;
+            if (++_weakChanges >= UnlockFrames)
+            {
+                _locked = false;
+            }
+        }
+        else
+        {
+            // A frame brighter than the one before it is lit
+            const uint32_t impliedParity = (contrast > 0.0) ? parity : (parity ^ 1);
+            _weakChanges = 0;
+
+            if (impliedParity == _litParity)
+            {
+                _agreements++;
+                _disagreements = 0;
+            }
+            else if (!_locked || ++_disagreements >= RephaseFrames)
+            {
+                _rephases += _locked ? 1 : 0;
+                _litParity = impliedParity;
+                _agreements = (std::max)(_disagreements, 1u);
+                _disagreements = 0;
+            }
+
+            if (_agreements >= LockFrames)
+            {
+                _locked = true;
+            }
+        }
+    }
+
+    _previousLuminance = meanLuminance;
+    illuminated = (parity == _litParity);
+
+    return _locked;
+}
+
+} // end namespace
@@ -0,0 +1,56 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Infers which frames of an interleaved sensor were illuminated from their brightness
+//
+// Used when frames aren't tagged by MFT0. The illuminator makes every other frame noticeably brighter, so the
+// relative brightness change between consecutive frames alternates in sign; the detector tracks which frame
+// parity is lit and locks once LockFrames consecutive changes agreed. A dropped frame shifts the parity, which
+// is picked up after RephaseFrames changes disagree, and changes too small to tell the frames apart, e.g. while
+// the illuminator is off, release the lock.
+// NOTE: Not thread safe
+class IlluminationPhaseDetector
+{
+public:
+
+    static const uint32_t LockFrames = 3;
+    static const uint32_t RephaseFrames = 2;
+    static const uint32_t UnlockFrames = 8;
+
+    IlluminationPhaseDetector();
+
+    void Reset();
+
+    // Returns true if the phase is locked, in which case illuminated tells whether the frame was lit
+    bool Submit(double meanLuminance, bool& illuminated);
+
+    bool IsLocked() const { return _locked; }
+    uint64_t GetRephases() const { return _rephases; }
+
+private:
+
+    uint64_t _frameIndex;
+    double _previousLuminance;
+    uint32_t _litParity;            // Parity of the frame indices that are illuminated
+    uint32_t _agreements;
+    uint32_t _disagreements;
+    uint32_t _weakChanges;
+    bool _locked;
+    uint64_t _rephases;
+};
+
+} // end namespace
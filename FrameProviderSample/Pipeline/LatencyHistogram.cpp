@@ -0,0 +1,86 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+
+namespace MediaFoundationProvider {
+
+LatencyHistogram::LatencyHistogram()
+{
+    Reset();
+}
+
+void LatencyHistogram::Reset()
+{
+    std::fill(_buckets, _buckets + BucketCount, 0);
+    _count = 0;
+    _maximum = 0;
+}
+
+void LatencyHistogram::Record(int64_t latency)
+{
+    const uint64_t value = (latency > 0) ? static_cast<uint64_t>(latency) : 0;
+
+    _buckets[GetBucket(value)]++;
+    _count++;
+    _maximum = (std::max)(_maximum, static_cast<int64_t>(value));
+}
+
+int64_t LatencyHistogram::GetPercentile(double percentile) const
+{
+    if (_count == 0) return 0;
+
+    // Rank of the requested value, counting from 1
+    const double clampedPercentile = (std::min)((std::max)(percentile, 0.0), 100.0);
+    const uint64_t rank = (std::max)(static_cast<uint64_t>(clampedPercentile / 100.0 * static_cast<double>(_count) + 0.5), static_cast<uint64_t>(1));
+
+    uint64_t counted = 0;
+    for (uint32_t bucket = 0; bucket < BucketCount; bucket++)
+    {
+        counted += _buckets[bucket];
+        if (counted >= rank)
+        {
+            return (std::min)(static_cast<int64_t>(GetBucketUpperBound(bucket)), _maximum);
+        }
+    }
+
+    return _maximum;
+}
+
+uint32_t LatencyHistogram::GetBucket(uint64_t latency)
+{
+    // Values below SubBucketCount get a bucket each
+    if (latency < SubBucketCount) return static_cast<uint32_t>(latency);
+
+    uint32_t highestBit = 0;
+    for (uint64_t remainder = latency >> 1; remainder != 0; remainder >>= 1)
+    {
+        highestBit++;
+    }
+
+    // The bits following the highest set bit select the bucket within the power of two
+    const uint32_t subBucket = static_cast<uint32_t>(latency >> (highestBit - SubBucketBits)) & (SubBucketCount - 1);
+    return (highestBit - SubBucketBits + 1) * SubBucketCount + subBucket;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(uint32_t bucket)
+{
+    if (bucket < SubBucketCount) return bucket;
+
+    const uint32_t shift = bucket / SubBucketCount - 1;
+    const uint64_t lowerBound = static_cast<uint64_t>(SubBucketCount + bucket % SubBucketCount) << shift;
+
+    return lowerBound + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+} // end namespace
@@ -0,0 +1,50 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Counts latencies in logarithmic buckets so percentiles can be taken over millions of frames in constant memory
+// Every power of two is split into SubBucketCount buckets, i.e. a percentile is accurate to within 12.5%
+// NOTE: Not thread safe
+class LatencyHistogram
+{
+public:
+
+    static const uint32_t SubBucketBits = 3;
+    static const uint32_t SubBucketCount = 1 << SubBucketBits;
+    static const uint32_t BucketCount = 64 * SubBucketCount;
+
+    LatencyHistogram();
+
+    void Reset();
+    void Record(int64_t latency);       // Negative latencies are counted as 0
+
+    uint64_t GetCount() const { return _count; }
+    int64_t GetMaximum() const { return _maximum; }
+
+    // Returns the upper bound of the bucket holding the given percentile (0 - 100), or 0 if nothing was recorded
+    int64_t GetPercentile(double percentile) const;
+
+private:
+
+    static uint32_t GetBucket(uint64_t latency);
+    static uint64_t GetBucketUpperBound(uint32_t bucket);
+
+    uint64_t _buckets[BucketCount];
+    uint64_t _count;
+    int64_t _maximum;
+};
+
+} // end namespace
@@ -0,0 +1,212 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "LumaKernels.h"
+
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define LUMA_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace MediaFoundationProvider {
+
+void ExtractLumaYUY2(const uint8_t* source, uint8_t* destination, uint32_t width)
+{
+    uint32_t x = 0;
+
+#ifdef LUMA_KERNELS_SSE2
+    // 32 pixels per iteration: mask the chroma bytes out of each 16 bit Y/UV pair and pack the luma bytes
+    const __m128i lumaMask = _mm_set1_epi16(0x00FF);
+    for (; x + 32 <= width; x += 32)
+    {
+        const __m128i* src = reinterpret_cast<const __m128i*>(source + x * 2);
+        const __m128i luma0 = _mm_and_si128(_mm_loadu_si128(src + 0), lumaMask);
+        const __m128i luma1 = _mm_and_si128(_mm_loadu_si128(src + 1), lumaMask);
+        const __m128i luma2 = _mm_and_si128(_mm_loadu_si128(src + 2), lumaMask);
+        const __m128i luma3 = _mm_and_si128(_mm_loadu_si128(src + 3), lumaMask);
+
+        __m128i* dest = reinterpret_cast<__m128i*>(destination + x);
+        _mm_storeu_si128(dest + 0, _mm_packus_epi16(luma0, luma1));
+        _mm_storeu_si128(dest + 1, _mm_packus_epi16(luma2, luma3));
+    }
+#endif
+
+    for (; x < width; x++)
+    {
+        destination[x] = source[x * 2];
+    }
+}
+
+void LumaStatistics::Reset()
+{
+    memset(this, 0, sizeof(*this));
+    Minimum = 255;
+}
+
+#ifdef LUMA_KERNELS_SSE2
+
+// Measures 16 luma samples per step: SAD against zero sums the samples and the saturation mask, and each histogram bin
+// counts its matches in 16 byte lanes that are summed into statistics before they can wrap
+class LumaAccumulator
+{
+public:
+
+    LumaAccumulator(LumaStatistics& statistics) :
+        _statistics(statistics),
+        _sum(_mm_setzero_si128()),
+        _saturated(_mm_setzero_si128()),
+        _minimum(_mm_set1_epi8(static_cast<char>(0xFF))),
+        _maximum(_mm_setzero_si128()),
+        _steps(0),
+        _pixels(0)
+    {
+        for (uint32_t bin = 0; bin < LumaStatistics::HistogramBins; bin++)
+        {
+            _bins[bin] = _mm_setzero_si128();
+        }
+    }
+
+    void Add(__m128i luma)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i saturationLevel = _mm_set1_epi8(static_cast<char>(LumaStatistics::SaturationLevel));
+        const __m128i saturated = _mm_cmpeq_epi8(_mm_max_epu8(luma, saturationLevel), luma);
+        const __m128i bins = _mm_and_si128(_mm_srli_epi16(luma, 4), _mm_set1_epi8(0x0F));
+
+        _sum = _mm_add_epi64(_sum, _mm_sad_epu8(luma, zero));
+        _saturated = _mm_add_epi64(_saturated, _mm_sad_epu8(saturated, zero));
+        _minimum = _mm_min_epu8(_minimum, luma);
+        _maximum = _mm_max_epu8(_maximum, luma);
+
+        // Matching lanes are -1, so subtracting the comparison counts them
+        for (uint32_t bin = 0; bin < LumaStatistics::HistogramBins; bin++)
+        {
+            _bins[bin] = _mm_sub_epi8(_bins[bin], _mm_cmpeq_epi8(bins, _mm_set1_epi8(static_cast<char>(bin))));
+        }
+
+        _pixels += 16;
+        if (++_steps == 255)
+        {
+            FlushBins();
+        }
+    }
+
+    void Store()
+    {
+        uint8_t minimum[16];
+        uint8_t maximum[16];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(minimum), _minimum);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(maximum), _maximum);
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (minimum[i] < _statistics.Minimum) _statistics.Minimum = minimum[i];
+            if (maximum[i] > _statistics.Maximum) _statistics.Maximum = maximum[i];
+        }
+
+        FlushBins();
+
+        // The saturation mask sums to 255 per saturated lane
+        _statistics.Sum += GetTotal(_sum);
+        _statistics.Saturated += static_cast<uint32_t>(GetTotal(_saturated) / 255);
+        _statistics.Pixels += _pixels;
+    }
+
+private:
+
+    static uint64_t GetTotal(__m128i halves)
+    {
+        uint64_t totals[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(totals), halves);
+        return totals[0] + totals[1];
+    }
+
+    void FlushBins()
+    {
+        const __m128i zero = _mm_setzero_si128();
+        for (uint32_t bin = 0; bin < LumaStatistics::HistogramBins; bin++)
+        {
+            _statistics.Histogram[bin] += static_cast<uint32_t>(GetTotal(_mm_sad_epu8(_bins[bin], zero)));
+            _bins[bin] = zero;
+        }
+        _steps = 0;
+    }
+
+    LumaStatistics& _statistics;
+    __m128i _sum;
+    __m128i _saturated;
+    __m128i _minimum;
+    __m128i _maximum;
+    __m128i _bins[LumaStatistics::HistogramBins];
+    uint32_t _steps;
+    uint32_t _pixels;
+};
+
+#endif
+
+static void MeasureLumaScalar(const uint8_t* luma, uint32_t count, LumaStatistics& statistics)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint8_t value = luma[i];
+        statistics.Sum += value;
+        statistics.Saturated += (value >= LumaStatistics::SaturationLevel) ? 1 : 0;
+        if (value < statistics.Minimum) statistics.Minimum = value;
+        if (value > statistics.Maximum) statistics.Maximum = value;
+        statistics.Histogram[value >> 4]++;
+    }
+    statistics.Pixels += count;
+}
+
+void MeasureLuma(const uint8_t* row, uint32_t width, LumaStatistics& statistics)
+{
+    uint32_t x = 0;
+
+#ifdef LUMA_KERNELS_SSE2
+    LumaAccumulator accumulator(statistics);
+    for (; x + 16 <= width; x += 16)
+    {
+        accumulator.Add(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)));
+    }
+    accumulator.Store();
+#endif
+
+    MeasureLumaScalar(row + x, width - x, statistics);
+}
+
+void MeasureLumaYUY2(const uint8_t* source, uint32_t width, LumaStatistics& statistics)
+{
+    uint32_t x = 0;
+
+#ifdef LUMA_KERNELS_SSE2
+    // Pack the luma bytes of 16 pixels the same way as ExtractLumaYUY2 and measure them while they're in a register
+    const __m128i lumaMask = _mm_set1_epi16(0x00FF);
+    LumaAccumulator accumulator(statistics);
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m128i* src = reinterpret_cast<const __m128i*>(source + x * 2);
+        accumulator.Add(_mm_packus_epi16(
+            _mm_and_si128(_mm_loadu_si128(src + 0), lumaMask),
+            _mm_and_si128(_mm_loadu_si128(src + 1), lumaMask)));
+    }
+    accumulator.Store();
+#endif
+
+    for (; x < width; x++)
+    {
+        MeasureLumaScalar(source + x * 2, 1, statistics);
+    }
+}
+
+} // end namespace
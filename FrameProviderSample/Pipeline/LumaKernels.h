@@ -0,0 +1,48 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Row kernels shared by the provider's frame conversion and MFT0
+//
+// The kernels use SSE2 on x86 and x64, which every processor running Windows 10 supports, and fall back to
+// plain loops elsewhere, e.g. for ARM builds. Rows don't need to be aligned.
+
+// Copies the luma samples of a row of packed YUY2 pixels, i.e. every other byte, into width bytes of destination
+void ExtractLumaYUY2(const uint8_t* source, uint8_t* destination, uint32_t width);
+
+// Luma statistics of a frame, gathered one row at a time by the MeasureLuma kernels
+struct LumaStatistics
+{
+    static const uint32_t HistogramBins = 16;       // Bin i counts the levels 16 * i to 16 * i + 15
+    static const uint8_t SaturationLevel = 250;     // Same as LuminanceStatistics::SaturationLevel
+
+    uint64_t Sum;
+    uint32_t Pixels;
+    uint32_t Saturated;             // Pixels at or above SaturationLevel
+    uint8_t Minimum;
+    uint8_t Maximum;
+    uint32_t Histogram[HistogramBins];
+
+    void Reset();
+    double GetMean() const { return (Pixels != 0) ? static_cast<double>(Sum) / Pixels : 0.0; }
+};
+
+// Adds width luma samples to statistics, from a row of Gray8 or planar luma pixels or a row of packed YUY2 pixels
+void MeasureLuma(const uint8_t* row, uint32_t width, LumaStatistics& statistics);
+void MeasureLumaYUY2(const uint8_t* source, uint32_t width, LumaStatistics& statistics);
+
+} // end namespace
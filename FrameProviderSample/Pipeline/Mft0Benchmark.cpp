@@ -0,0 +1,180 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Mft0Benchmark.h"
+
+#include "CacheMissCounter.h"
+#include "Mft0StandIn.h"
+#include "SyntheticFrameSource.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+namespace MediaFoundationProvider {
+
+static const uint32_t InputSampleCount = 8;             // 8 frames of 720p YUY2 already exceed most last level caches
+static const uint32_t Gray8SampleCount = 4;
+
+Mft0BenchmarkSettings GetDefaultMft0BenchmarkSettings()
+{
+    Mft0BenchmarkSettings settings;
+    settings.Format = FramePixelFormat::YUY2;
+    settings.Resolutions = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+    settings.Frames = 1000;
+    settings.WarmupFrames = 50;
+    settings.ConvertToGray8 = true;
+    settings.MeasureLuma = true;
+    settings.CaptureMetadata = false;
+
+    return settings;
+}
+
+// Writes the sample embedded line, see IlluminationMetadata.cpp
+static void AddEmbeddedLine(const FrameLayout& layout, uint8_t* frame, uint32_t counter, bool illuminated)
+{
+    const uint32_t line[3] = { SampleEmbeddedLineMagic, counter, illuminated ? SampleIlluminationFlagEnabled : 0 };
+    memcpy(frame + static_cast<size_t>(layout.Stride) * (layout.Height - 1), line, sizeof(line));
+}
+
+// Attaches the sample capture metadata item, i.e. a KSCAMERA_METADATA_ITEMHEADER followed by the illumination flags
+// and padded to 8 bytes
+static void AddCaptureMetadata(StandInSample& sample, bool illuminated)
+{
+    const uint32_t item[4] = { SampleCaptureMetadataId, 3 * sizeof(uint32_t), illuminated ? SampleIlluminationFlagEnabled : 0, 0 };
+    sample.SetCaptureMetadata(reinterpret_cast<const uint8_t*>(item), sizeof(item));
+}
+
+static uint32_t GetSubtypeFourCC(FramePixelFormat format)
+{
+    switch (format)
+    {
+    case FramePixelFormat::YUY2: return FourCCYUY2;
+    case FramePixelFormat::NV12: return FourCCNV12;
+    case FramePixelFormat::Gray8: return FourCCL8;
+    default: return 0;
+    }
+}
+
+static bool RunResolution(const Mft0BenchmarkSettings& settings, const Mft0BenchmarkResolution& resolution, Mft0BenchmarkResult& result)
+{
+    SyntheticFrameSettings sourceSettings;
+    sourceSettings.Format = settings.Format;
+    sourceSettings.Width = resolution.Width;
+    sourceSettings.Height = resolution.Height;
+    sourceSettings.FrameRate = 30;
+    sourceSettings.Paced = false;
+    sourceSettings.AlternateIllumination = true;
+
+    SyntheticFrameSource source;
+    if (!source.Open(sourceSettings)) return false;
+    const FrameLayout layout = source.GetFrameLayout();
+
+    Mft0ProcessingSettings processing;
+    if (!GetMft0ProcessingSettings(GetSubtypeFourCC(layout.Format), layout.Width, layout.Height, static_cast<int32_t>(layout.Stride),
+        settings.ConvertToGray8, settings.MeasureLuma, processing))
+    {
+        return false;
+    }
+
+    // The input samples carry the synthetic frames and their illumination state in the sample metadata
+    std::vector<std::unique_ptr<StandInSample>> inputSamples;
+    for (uint32_t i = 0; i < InputSampleCount; i++)
+    {
+        CapturedFrame frame;
+        if (!source.ReadFrame(frame)) return false;
+
+        std::unique_ptr<StandInMediaBuffer> buffer(new StandInMediaBuffer(frame.Length, static_cast<int32_t>(layout.Stride), layout.Height));
+        memcpy(buffer->GetData(), frame.Data, frame.Length);
+        buffer->SetCurrentLength(frame.Length);
+        if (!settings.CaptureMetadata)
+        {
+            AddEmbeddedLine(layout, buffer->GetData(), i, frame.IlluminationEnabled);
+        }
+
+        inputSamples.emplace_back(new StandInSample(std::move(buffer)));
+        inputSamples.back()->SampleTime = frame.Timestamp;
+        if (settings.CaptureMetadata)
+        {
+            AddCaptureMetadata(*inputSamples.back(), frame.IlluminationEnabled);
+        }
+    }
+
+    StandInSamplePool gray8Pool(Gray8SampleCount, layout.Width * layout.Height, static_cast<int32_t>(layout.Width), layout.Height);
+    CacheMissCounter cacheMisses;
+    uint64_t framesTagged = 0;
+    uint64_t framesDropped = 0;
+
+    // The L8 sample is released right away, as if the frame provider was done with it
+    auto processFrame = [&](uint32_t frameIndex)
+    {
+        StandInSample& inputSample = *inputSamples[frameIndex % InputSampleCount];
+        StandInSample* gray8Sample = nullptr;
+        uint32_t illuminated = 0;
+
+        inputSample.ClearAttributes();
+        if (!ProcessStandInSample(processing, &gray8Pool, inputSample, gray8Sample))
+        {
+            framesDropped++;
+            return;
+        }
+        if (((gray8Sample != nullptr) ? gray8Sample : &inputSample)->GetUInt32(Mft0Attribute::IlluminationEnabled, illuminated))
+        {
+            framesTagged++;
+        }
+        gray8Pool.ReleaseSample(gray8Sample);
+    };
+
+    for (uint32_t i = 0; i < settings.WarmupFrames; i++)
+    {
+        processFrame(i);
+    }
+    framesTagged = 0;
+    framesDropped = 0;
+
+    typedef std::chrono::steady_clock Clock;
+    cacheMisses.Start();
+    const Clock::time_point startTime = Clock::now();
+    for (uint32_t i = 0; i < settings.Frames; i++)
+    {
+        processFrame(settings.WarmupFrames + i);
+    }
+    const Clock::time_point endTime = Clock::now();
+    const uint64_t misses = cacheMisses.Stop();
+
+    const double frames = (settings.Frames != 0) ? static_cast<double>(settings.Frames) : 1.0;
+    result.Resolution = resolution;
+    result.Frames = settings.Frames;
+    result.FramesTagged = framesTagged;
+    result.FramesDropped = framesDropped;
+    result.NanosecondsPerFrame = std::chrono::duration<double, std::nano>(endTime - startTime).count() / frames;
+    result.CacheMissesCounted = cacheMisses.IsAvailable();
+    result.CacheMissesPerFrame = static_cast<double>(misses) / frames;
+
+    return true;
+}
+
+bool RunMft0Benchmark(const Mft0BenchmarkSettings& settings, std::vector<Mft0BenchmarkResult>& results)
+{
+    results.clear();
+
+    for (const Mft0BenchmarkResolution& resolution : settings.Resolutions)
+    {
+        Mft0BenchmarkResult result;
+        if (!RunResolution(settings, resolution, result)) return false;
+
+        results.push_back(result);
+    }
+
+    return true;
+}
+
+} // end namespace
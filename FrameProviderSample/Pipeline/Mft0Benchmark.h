@@ -0,0 +1,60 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameConversion.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+struct Mft0BenchmarkResolution
+{
+    uint32_t Width;
+    uint32_t Height;
+};
+
+struct Mft0BenchmarkSettings
+{
+    FramePixelFormat Format;                            // Input format of MFT0, i.e. the device's format
+    std::vector<Mft0BenchmarkResolution> Resolutions;
+    uint32_t Frames;                                    // Frames timed per resolution
+    uint32_t WarmupFrames;
+    bool ConvertToGray8;                                // Like "Mft0Gray8Output" with an L8 output type selected
+    bool MeasureLuma;                                   // Like "Mft0FrameStatistics"
+    bool CaptureMetadata;                               // Tag frames with UVC metadata rather than an embedded line
+};
+
+// Cost of MFT0's per-sample work at one resolution
+struct Mft0BenchmarkResult
+{
+    Mft0BenchmarkResolution Resolution;
+    uint64_t Frames;
+    uint64_t FramesTagged;                              // Frames whose illumination state was found in their metadata
+    uint64_t FramesDropped;
+    double NanosecondsPerFrame;
+    bool CacheMissesCounted;                            // See CacheMissCounter
+    double CacheMissesPerFrame;
+};
+
+// YUY2 at the common IR sensor resolutions with conversion and statistics enabled
+Mft0BenchmarkSettings GetDefaultMft0BenchmarkSettings();
+
+// Drives ProcessMft0Sample through the stand-in MFT0 shell (see Mft0StandIn.h) with synthetic frames, so the
+// driver-side overhead per frame can be tracked on any platform, like HeadlessFrameProvider does for the provider
+//
+// Frames cycle through more input samples than fit in the cache, like frames captured by the device. Returns false if
+// a resolution isn't valid for the format.
+bool RunMft0Benchmark(const Mft0BenchmarkSettings& settings, std::vector<Mft0BenchmarkResult>& results);
+
+} // end namespace
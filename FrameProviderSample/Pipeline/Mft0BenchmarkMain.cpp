@@ -0,0 +1,106 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Command line host for the MFT0 benchmark, built separately from MFT0 and the provider DLL, e.g.
+//     g++ -std=c++14 -O2 -pthread -DFRAME_PIPELINE_MFT0_BENCHMARK Pipeline/*.cpp -o Mft0Benchmark
+// FRAME_PIPELINE_MFT0_BENCHMARK selects this main, like FRAME_PIPELINE_SOAK does for the soak test's, see SoakMain.cpp
+//
+// Usage: Mft0Benchmark [YUY2|NV12|L8 [frames [metadata]]]
+// Tags frames from an embedded line unless "metadata" is given, in which case they carry UVC capture metadata.
+// Prints one CSV line per resolution; cache misses are "-" where the counter isn't available (see CacheMissCounter)
+
+#ifdef FRAME_PIPELINE_MFT0_BENCHMARK
+
+#include "Mft0Benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace MediaFoundationProvider;
+
+static const char* GetFormatName(FramePixelFormat format)
+{
+    switch (format)
+    {
+    case FramePixelFormat::YUY2: return "YUY2";
+    case FramePixelFormat::NV12: return "NV12";
+    case FramePixelFormat::Gray8: return "L8";
+    default: return "?";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Mft0BenchmarkSettings settings = GetDefaultMft0BenchmarkSettings();
+
+    if (argc > 1)
+    {
+        settings.Format =
+            (strcmp(argv[1], "YUY2") == 0) ? FramePixelFormat::YUY2 :
+            (strcmp(argv[1], "NV12") == 0) ? FramePixelFormat::NV12 :
+            (strcmp(argv[1], "L8") == 0) ? FramePixelFormat::Gray8 :
+            FramePixelFormat::Unknown;
+    }
+    if (argc > 2)
+    {
+        settings.Frames = static_cast<uint32_t>(atoi(argv[2]));
+    }
+    if (argc > 3)
+    {
+        settings.CaptureMetadata = (strcmp(argv[3], "metadata") == 0);
+    }
+
+    // L8 frames are already what the conversion produces, so they're only tagged and measured
+    settings.ConvertToGray8 = (settings.Format != FramePixelFormat::Gray8);
+
+    std::vector<Mft0BenchmarkResult> results;
+    if (settings.Format == FramePixelFormat::Unknown || settings.Frames == 0 || !RunMft0Benchmark(settings, results))
+    {
+        fprintf(stderr, "Usage: %s [YUY2|NV12|L8 [frames [metadata]]]\n", argv[0]);
+        return 2;
+    }
+
+    printf("format,width,height,frames,ns_per_frame,cache_misses_per_frame,frames_tagged,frames_dropped\n");
+    for (const Mft0BenchmarkResult& result : results)
+    {
+        char cacheMisses[32] = "-";
+        if (result.CacheMissesCounted)
+        {
+            snprintf(cacheMisses, sizeof(cacheMisses), "%.0f", result.CacheMissesPerFrame);
+        }
+
+        printf("%s,%u,%u,%llu,%.0f,%s,%llu,%llu\n",
+            GetFormatName(settings.Format),
+            result.Resolution.Width,
+            result.Resolution.Height,
+            static_cast<unsigned long long>(result.Frames),
+            result.NanosecondsPerFrame,
+            cacheMisses,
+            static_cast<unsigned long long>(result.FramesTagged),
+            static_cast<unsigned long long>(result.FramesDropped));
+    }
+
+    // Every frame carries its illumination state, so a frame that wasn't tagged means the metadata wasn't found
+    for (const Mft0BenchmarkResult& result : results)
+    {
+        if (result.FramesTagged != result.Frames || result.FramesDropped != 0)
+        {
+            fprintf(stderr, "FAILED: %ux%u tagged %llu of %llu frames\n", result.Resolution.Width, result.Resolution.Height,
+                static_cast<unsigned long long>(result.FramesTagged), static_cast<unsigned long long>(result.Frames));
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+#endif
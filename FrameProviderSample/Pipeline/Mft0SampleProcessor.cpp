@@ -0,0 +1,130 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Mft0SampleProcessor.h"
+
+#include <cstring>
+
+namespace MediaFoundationProvider {
+
+bool GetMft0ProcessingSettings(uint32_t subtypeFourCC, uint32_t width, uint32_t height, int32_t stride,
+    bool convertToGray8, bool measureLuma, Mft0ProcessingSettings& settings)
+{
+    settings = Mft0ProcessingSettings();
+
+    switch (subtypeFourCC)
+    {
+    case FourCCYUY2: settings.Layout.Format = FramePixelFormat::YUY2; break;
+    case FourCCNV12: settings.Layout.Format = FramePixelFormat::NV12; break;
+    case FourCCL8: settings.Layout.Format = FramePixelFormat::Gray8; break;
+    default: settings.Layout.Format = FramePixelFormat::Unknown; break;
+    }
+
+    // Formats without a luma plane can still carry capture metadata
+    settings.Layout.Width = width;
+    settings.Layout.Height = height;
+    settings.Layout.Stride = static_cast<uint32_t>((stride < 0) ? -stride : stride);
+    settings.ParserCount = FindIlluminationMetadataParsers(subtypeFourCC, settings.Parsers, MaxIlluminationMetadataParsers);
+
+    const bool hasLumaPlane = (settings.Layout.Format != FramePixelFormat::Unknown) && (settings.Layout.Stride != 0);
+    settings.ConvertToGray8 = convertToGray8 && hasLumaPlane && (settings.Layout.Format != FramePixelFormat::Gray8);
+    settings.MeasureLuma = measureLuma && hasLumaPlane;
+
+    return !convertToGray8 || settings.ConvertToGray8;
+}
+
+bool ProcessMft0Sample(const Mft0ProcessingSettings& settings, const Mft0SampleFrame& frame, const Mft0Gray8Frame* gray8,
+    Mft0SampleResult& result)
+{
+    result.IlluminationTagged = false;
+    result.IlluminationEnabled = false;
+    result.Converted = false;
+    result.LumaMeasured = false;
+
+    // Embedded lines are only found in top-down frames, the line is the last line of the (luma) plane
+    // The parsers check the line against the real length of the buffer, which may be short of a whole frame
+    IlluminationMetadataInput input = {};
+    input.CaptureMetadata = frame.CaptureMetadata;
+    input.CaptureMetadataLength = frame.CaptureMetadataLength;
+    if (frame.ScanLine0 != nullptr && frame.Stride > 0)
+    {
+        input.Frame = frame.ScanLine0;
+        input.Layout = settings.Layout;
+        input.Layout.Stride = static_cast<uint32_t>(frame.Stride);
+        input.FrameLength = frame.Length;
+    }
+
+    bool illuminated = false;
+    if (ParseIlluminationMetadata(settings.Parsers, settings.ParserCount, input, illuminated) != nullptr)
+    {
+        result.IlluminationTagged = true;
+        result.IlluminationEnabled = illuminated;
+    }
+
+    // The luma plane is only walked if the buffer holds all of it, e.g. a truncated sample without IMF2DBuffer
+    // isn't; a frame that can't be converted is dropped and one that can't be measured is passed on unmeasured
+    const uint32_t width = settings.Layout.Width;
+    const uint32_t rowLength = (settings.Layout.Format == FramePixelFormat::YUY2) ? 2 * width : width;
+    const uint64_t rowPitch = static_cast<uint64_t>((frame.Stride < 0) ? -static_cast<int64_t>(frame.Stride) : frame.Stride);
+    const uint64_t planeLength = (settings.Layout.Height == 0) ? 0 : rowPitch * (settings.Layout.Height - 1) + rowLength;
+    const bool hasPlane = (frame.ScanLine0 != nullptr) && (planeLength != 0) && (planeLength <= frame.Length);
+
+    const bool convert = settings.ConvertToGray8 && gray8 != nullptr && gray8->ScanLine0 != nullptr;
+    const bool measure = settings.MeasureLuma;
+    if (settings.ConvertToGray8 && !convert) return false;
+    if (!hasPlane) return !convert;
+    if (!convert && !measure) return true;
+
+    if (measure)
+    {
+        result.Statistics.Reset();
+    }
+
+    // Both frames are walked from scan line 0 with their own stride, so padded and bottom-up frames work too
+    for (uint32_t y = 0; y < settings.Layout.Height; y++)
+    {
+        const uint8_t* sourceRow = frame.ScanLine0 + static_cast<intptr_t>(y) * frame.Stride;
+
+        if (convert)
+        {
+            uint8_t* destinationRow = gray8->ScanLine0 + static_cast<intptr_t>(y) * gray8->Stride;
+            if (settings.Layout.Format == FramePixelFormat::YUY2)
+            {
+                ExtractLumaYUY2(sourceRow, destinationRow, width);
+            }
+            else
+            {
+                // NV12 starts with a full resolution luma plane, the chroma plane is left behind
+                memcpy(destinationRow, sourceRow, width);
+            }
+
+            // The row was just written, so it's measured from the cache
+            if (measure)
+            {
+                MeasureLuma(destinationRow, width, result.Statistics);
+            }
+        }
+        else if (settings.Layout.Format == FramePixelFormat::YUY2)
+        {
+            MeasureLumaYUY2(sourceRow, width, result.Statistics);
+        }
+        else
+        {
+            MeasureLuma(sourceRow, width, result.Statistics);
+        }
+    }
+
+    result.Converted = convert;
+    result.LumaMeasured = measure;
+    return true;
+}
+
+} // end namespace
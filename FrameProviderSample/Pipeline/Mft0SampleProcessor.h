@@ -0,0 +1,73 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "IlluminationMetadata.h"
+#include "LumaKernels.h"
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// What MFT0 does with each sample, selected from the negotiated media types
+struct Mft0ProcessingSettings
+{
+    const IlluminationMetadataParser* Parsers[MaxIlluminationMetadataParsers];
+    uint32_t ParserCount;
+    FrameLayout Layout;             // Input frames; Stride is 0 if the input format has no known stride
+    bool ConvertToGray8;            // Copy the luma plane of YUY2 or NV12 frames into an L8 frame
+    bool MeasureLuma;               // Gather LumaStatistics of the luma plane
+};
+
+// A locked input sample as the MFT finds it; the frame and the capture metadata may each be missing
+// NOTE: Stride is negative for bottom-up frames, ScanLine0 always points at the top row
+struct Mft0SampleFrame
+{
+    const uint8_t* ScanLine0;
+    int32_t Stride;
+    uint32_t Length;                // Bytes in the buffer from its lowest row, i.e. the bottom row of bottom-up frames
+    const uint8_t* CaptureMetadata;
+    uint32_t CaptureMetadataLength;
+};
+
+// An output frame to convert into, with the same conventions as Mft0SampleFrame
+struct Mft0Gray8Frame
+{
+    uint8_t* ScanLine0;
+    int32_t Stride;
+};
+
+struct Mft0SampleResult
+{
+    bool IlluminationTagged;        // The frame's metadata held its illumination state
+    bool IlluminationEnabled;
+    bool Converted;
+    bool LumaMeasured;
+    LumaStatistics Statistics;
+};
+
+// Fills settings for the given input type; returns false if convertToGray8 is set but the input can't be converted
+// NOTE: stride is the signed default stride of the input type and 0 if it's unknown
+bool GetMft0ProcessingSettings(uint32_t subtypeFourCC, uint32_t width, uint32_t height, int32_t stride,
+    bool convertToGray8, bool measureLuma, Mft0ProcessingSettings& settings);
+
+// Does the per-sample work of MFT0 in a single walk of the frame: reads the illumination state from the frame's
+// metadata, copies the luma plane into gray8 when converting, and measures the luma plane, i.e. the L8 rows right
+// after they're written. Returns false if the frame had to be converted but couldn't be, e.g. because the buffer is
+// shorter than the luma plane.
+//
+// Only uses its arguments, so samples can be processed concurrently; the COM shell in FrameProviderMft0.cpp locks
+// the buffers and applies the result to the sample, see Mft0Benchmark for a stand-in shell.
+bool ProcessMft0Sample(const Mft0ProcessingSettings& settings, const Mft0SampleFrame& frame, const Mft0Gray8Frame* gray8,
+    Mft0SampleResult& result);
+
+} // end namespace
@@ -0,0 +1,277 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Mft0StandIn.h"
+
+#include <cstring>
+
+namespace MediaFoundationProvider {
+
+// Same as the stack buffer FrameProviderMft0 copies the capture metadata into
+static const uint32_t CaptureMetadataBufferLength = 4096;
+
+StandInMediaBuffer::StandInMediaBuffer(uint32_t maxLength, int32_t stride, uint32_t height) :
+    _data(maxLength),
+    _stride(stride),
+    _height(height),
+    _currentLength(0),
+    _locked(false)
+{
+}
+
+bool StandInMediaBuffer::Lock(uint8_t*& scanLine0, int32_t& stride)
+{
+    const uint64_t rowsLength = static_cast<uint64_t>((_stride < 0) ? -_stride : _stride) * _height;
+    if (_locked || _height == 0 || rowsLength > _data.size()) return false;
+
+    _locked = true;
+    stride = _stride;
+    scanLine0 = (_stride < 0) ?
+        _data.data() + static_cast<size_t>(-_stride) * (_height - 1) :
+        _data.data();
+    return true;
+}
+
+void StandInMediaBuffer::Unlock()
+{
+    _locked = false;
+}
+
+StandInSample::StandInSample(std::unique_ptr<StandInMediaBuffer> buffer) :
+    SampleTime(0),
+    SampleDuration(0),
+    SampleFlags(0),
+    _buffer(std::move(buffer)),
+    _attributeMask(0),
+    _attributes(),
+    _histogram(),
+    _captureMetadata(CaptureMetadataBufferLength),
+    _hasCaptureMetadata(false)
+{
+}
+
+void StandInSample::SetUInt32(Mft0Attribute attribute, uint32_t value)
+{
+    _attributes[static_cast<uint32_t>(attribute)] = value;
+    _attributeMask |= 1u << static_cast<uint32_t>(attribute);
+}
+
+void StandInSample::SetDouble(Mft0Attribute attribute, double value)
+{
+    memcpy(&_attributes[static_cast<uint32_t>(attribute)], &value, sizeof(value));
+    _attributeMask |= 1u << static_cast<uint32_t>(attribute);
+}
+
+void StandInSample::SetHistogram(const uint32_t (&histogram)[LumaStatistics::HistogramBins])
+{
+    memcpy(_histogram, histogram, sizeof(_histogram));
+    _attributeMask |= 1u << static_cast<uint32_t>(Mft0Attribute::LumaHistogram);
+}
+
+bool StandInSample::GetUInt32(Mft0Attribute attribute, uint32_t& value) const
+{
+    if ((_attributeMask & (1u << static_cast<uint32_t>(attribute))) == 0) return false;
+
+    value = static_cast<uint32_t>(_attributes[static_cast<uint32_t>(attribute)]);
+    return true;
+}
+
+bool StandInSample::GetDouble(Mft0Attribute attribute, double& value) const
+{
+    if ((_attributeMask & (1u << static_cast<uint32_t>(attribute))) == 0) return false;
+
+    memcpy(&value, &_attributes[static_cast<uint32_t>(attribute)], sizeof(value));
+    return true;
+}
+
+bool StandInSample::GetHistogram(uint32_t (&histogram)[LumaStatistics::HistogramBins]) const
+{
+    if ((_attributeMask & (1u << static_cast<uint32_t>(Mft0Attribute::LumaHistogram))) == 0) return false;
+
+    memcpy(histogram, _histogram, sizeof(histogram));
+    return true;
+}
+
+void StandInSample::SetCaptureMetadata(const uint8_t* metadata, uint32_t length)
+{
+    // Longer metadata is kept whole so GetCaptureMetadata fails like GetBlob does for a small buffer
+    if (length > _captureMetadata.size())
+    {
+        _captureMetadata.resize(length);
+    }
+    memcpy(_captureMetadata.data(), metadata, length);
+    _captureMetadata.resize(length);
+    _hasCaptureMetadata = true;
+}
+
+bool StandInSample::GetCaptureMetadata(uint8_t* metadata, uint32_t size, uint32_t& length) const
+{
+    if (!_hasCaptureMetadata || _captureMetadata.size() > size) return false;
+
+    length = static_cast<uint32_t>(_captureMetadata.size());
+    memcpy(metadata, _captureMetadata.data(), length);
+    return true;
+}
+
+void StandInSample::CopyAllItems(StandInSample& destination) const
+{
+    destination._attributeMask = _attributeMask;
+    memcpy(destination._attributes, _attributes, sizeof(_attributes));
+    memcpy(destination._histogram, _histogram, sizeof(_histogram));
+    destination._hasCaptureMetadata = false;
+    if (_hasCaptureMetadata)
+    {
+        destination.SetCaptureMetadata(_captureMetadata.data(), static_cast<uint32_t>(_captureMetadata.size()));
+    }
+
+    destination.SampleTime = SampleTime;
+    destination.SampleDuration = SampleDuration;
+    destination.SampleFlags = SampleFlags;
+}
+
+void StandInSample::ClearAttributes()
+{
+    _attributeMask = 0;
+}
+
+StandInSamplePool::StandInSamplePool(uint32_t sampleCount, uint32_t maxLength, int32_t stride, uint32_t height) :
+    _free(sampleCount),
+    _freeHead(0),
+    _freeCount(sampleCount)
+{
+    for (uint32_t i = 0; i < sampleCount; i++)
+    {
+        _samples.emplace_back(new StandInSample(std::unique_ptr<StandInMediaBuffer>(new StandInMediaBuffer(maxLength, stride, height))));
+        _free[i] = _samples.back().get();
+    }
+}
+
+StandInSample* StandInSamplePool::AllocateSample()
+{
+    if (_freeCount == 0) return nullptr;
+
+    StandInSample* sample = _free[_freeHead];
+    _freeHead = (_freeHead + 1) % _free.size();
+    _freeCount--;
+
+    sample->ClearAttributes();
+    return sample;
+}
+
+void StandInSamplePool::ReleaseSample(StandInSample* sample)
+{
+    if (sample == nullptr || _freeCount == _free.size()) return;
+
+    _free[(_freeHead + _freeCount) % _free.size()] = sample;
+    _freeCount++;
+}
+
+static void AttachFrameStatistics(const LumaStatistics& statistics, StandInSample& sample)
+{
+    if (statistics.Pixels == 0) return;
+
+    sample.SetDouble(Mft0Attribute::LumaMean, statistics.GetMean());
+    sample.SetUInt32(Mft0Attribute::LumaMinimum, statistics.Minimum);
+    sample.SetUInt32(Mft0Attribute::LumaMaximum, statistics.Maximum);
+    sample.SetUInt32(Mft0Attribute::SaturatedPixels, statistics.Saturated);
+    sample.SetHistogram(statistics.Histogram);
+}
+
+bool ProcessStandInSample(const Mft0ProcessingSettings& settings, StandInSamplePool* pool, StandInSample& sample,
+    StandInSample*& outputSample)
+{
+    Mft0SampleFrame frame = {};
+    Mft0Gray8Frame gray8 = {};
+    Mft0SampleResult result;
+    uint8_t captureMetadata[CaptureMetadataBufferLength];
+
+    outputSample = nullptr;
+
+    bool needsFrame = settings.ConvertToGray8 || settings.MeasureLuma;
+    bool needsCaptureMetadata = false;
+    for (uint32_t i = 0; i < settings.ParserCount; i++)
+    {
+        needsFrame |= (settings.Parsers[i]->Location == IlluminationMetadataLocation::EmbeddedLine);
+        needsCaptureMetadata |= (settings.Parsers[i]->Location == IlluminationMetadataLocation::CaptureMetadata);
+    }
+
+    uint32_t captureMetadataLength = 0;
+    if (needsCaptureMetadata && sample.GetCaptureMetadata(captureMetadata, sizeof(captureMetadata), captureMetadataLength))
+    {
+        frame.CaptureMetadata = captureMetadata;
+        frame.CaptureMetadataLength = captureMetadataLength;
+    }
+
+    StandInSample* gray8Sample = nullptr;
+    if (settings.ConvertToGray8)
+    {
+        gray8Sample = (pool != nullptr) ? pool->AllocateSample() : nullptr;
+        if (gray8Sample == nullptr) return false;
+
+        if (!gray8Sample->GetBuffer().Lock(gray8.ScanLine0, gray8.Stride))
+        {
+            pool->ReleaseSample(gray8Sample);
+            return false;
+        }
+    }
+
+    uint8_t* scanLine0 = nullptr;
+    int32_t stride = 0;
+    const bool inputLocked = needsFrame && sample.GetBuffer().Lock(scanLine0, stride);
+    if (inputLocked)
+    {
+        frame.ScanLine0 = scanLine0;
+        frame.Stride = stride;
+        frame.Length = sample.GetBuffer().GetCurrentLength();
+    }
+
+    const bool processed = ProcessMft0Sample(settings, frame, settings.ConvertToGray8 ? &gray8 : nullptr, result);
+
+    if (inputLocked)
+    {
+        sample.GetBuffer().Unlock();
+    }
+    if (gray8Sample != nullptr)
+    {
+        gray8Sample->GetBuffer().Unlock();
+        if (!processed)
+        {
+            pool->ReleaseSample(gray8Sample);
+            return false;
+        }
+    }
+
+    if (result.IlluminationTagged)
+    {
+        sample.SetUInt32(Mft0Attribute::IlluminationEnabled, result.IlluminationEnabled ? 1 : 0);
+    }
+
+    if (!result.Converted)
+    {
+        if (result.LumaMeasured)
+        {
+            AttachFrameStatistics(result.Statistics, sample);
+        }
+        return processed;
+    }
+
+    gray8Sample->GetBuffer().SetCurrentLength(static_cast<uint32_t>((gray8.Stride < 0) ? -gray8.Stride : gray8.Stride) * settings.Layout.Height);
+    sample.CopyAllItems(*gray8Sample);
+    if (result.LumaMeasured)
+    {
+        AttachFrameStatistics(result.Statistics, *gray8Sample);
+    }
+
+    outputSample = gray8Sample;
+    return true;
+}
+
+} // end namespace
@@ -0,0 +1,127 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "Mft0SampleProcessor.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+// The sample attributes MFT0 writes, see the GUIDs in FrameProviderMft0.h
+enum class Mft0Attribute : uint32_t
+{
+    IlluminationEnabled = 0,        // WDPP_ACTIVE_ILLUMINATION_ENABLED
+    LumaMean,                       // WDPP_FRAME_LUMA_MEAN, stored as the bits of a double
+    LumaMinimum,                    // WDPP_FRAME_LUMA_MINIMUM
+    LumaMaximum,                    // WDPP_FRAME_LUMA_MAXIMUM
+    SaturatedPixels,                // WDPP_FRAME_SATURATED_PIXELS
+    LumaHistogram,                  // WDPP_FRAME_LUMA_HISTOGRAM, see StandInSample::GetHistogram
+    Count
+};
+
+// Stands in for a system memory IMFMediaBuffer holding one frame, locked like VideoBufferLock locks it
+// NOTE: stride is negative for bottom-up frames, in which case scan line 0 is the last row in memory
+class StandInMediaBuffer
+{
+public:
+
+    StandInMediaBuffer(uint32_t maxLength, int32_t stride, uint32_t height);
+
+    // Fails if the buffer is already locked
+    bool Lock(uint8_t*& scanLine0, int32_t& stride);
+    void Unlock();
+
+    uint8_t* GetData() { return _data.data(); }
+    uint32_t GetMaxLength() const { return static_cast<uint32_t>(_data.size()); }
+    uint32_t GetCurrentLength() const { return _currentLength; }
+    void SetCurrentLength(uint32_t length) { _currentLength = length; }
+
+private:
+
+    std::vector<uint8_t> _data;
+    int32_t _stride;
+    uint32_t _height;
+    uint32_t _currentLength;
+    bool _locked;
+};
+
+// Stands in for an IMFSample with a single buffer; attributes are stored in place, so setting and copying them doesn't
+// allocate, like the attribute store of a sample recycled by the capture pipeline
+class StandInSample
+{
+public:
+
+    explicit StandInSample(std::unique_ptr<StandInMediaBuffer> buffer);
+
+    StandInMediaBuffer& GetBuffer() { return *_buffer; }
+
+    void SetUInt32(Mft0Attribute attribute, uint32_t value);
+    void SetDouble(Mft0Attribute attribute, double value);
+    void SetHistogram(const uint32_t (&histogram)[LumaStatistics::HistogramBins]);
+    bool GetUInt32(Mft0Attribute attribute, uint32_t& value) const;
+    bool GetDouble(Mft0Attribute attribute, double& value) const;
+    bool GetHistogram(uint32_t (&histogram)[LumaStatistics::HistogramBins]) const;
+
+    // Like MFSampleExtension_CaptureMetadata's MF_CAPTURE_METADATA_FRAME_RAWSTREAM blob; GetCaptureMetadata copies it
+    // like IMFAttributes::GetBlob and fails if there is none or it doesn't fit
+    void SetCaptureMetadata(const uint8_t* metadata, uint32_t length);
+    bool GetCaptureMetadata(uint8_t* metadata, uint32_t size, uint32_t& length) const;
+
+    // Like IMFAttributes::CopyAllItems, with the sample time, duration and flags that FrameProviderMft0 copies too
+    void CopyAllItems(StandInSample& destination) const;
+
+    // Removes the attributes MFT0 writes, e.g. to process the same sample again; the capture metadata stays
+    void ClearAttributes();
+
+    int64_t SampleTime;
+    int64_t SampleDuration;
+    uint32_t SampleFlags;
+
+private:
+
+    std::unique_ptr<StandInMediaBuffer> _buffer;
+    uint32_t _attributeMask;
+    uint64_t _attributes[static_cast<uint32_t>(Mft0Attribute::Count)];
+    uint32_t _histogram[LumaStatistics::HistogramBins];
+    std::vector<uint8_t> _captureMetadata;
+    bool _hasCaptureMetadata;
+};
+
+// Stands in for the IMFVideoSampleAllocatorEx pool of L8 samples; samples are handed out in the order they were returned
+class StandInSamplePool
+{
+public:
+
+    StandInSamplePool(uint32_t sampleCount, uint32_t maxLength, int32_t stride, uint32_t height);
+
+    // Returns nullptr if every sample is in use
+    StandInSample* AllocateSample();
+    void ReleaseSample(StandInSample* sample);
+
+private:
+
+    std::vector<std::unique_ptr<StandInSample>> _samples;
+    std::vector<StandInSample*> _free;          // Ring of free samples
+    uint32_t _freeHead;
+    uint32_t _freeCount;
+};
+
+// Does what CFrameProviderMft0::ProcessSample does with the stand-ins: copies the capture metadata, locks the buffers,
+// runs ProcessMft0Sample and applies its result to the samples. outputSample receives the L8 sample from pool if the
+// sample is converted and nullptr otherwise; returns false if the sample couldn't be processed, i.e. is dropped.
+bool ProcessStandInSample(const Mft0ProcessingSettings& settings, StandInSamplePool* pool, StandInSample& sample,
+    StandInSample*& outputSample);
+
+} // end namespace
@@ -0,0 +1,307 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "ParallelFramePipeline.h"
+
+namespace MediaFoundationProvider {
+
+ParallelFramePipeline::ParallelFramePipeline(FramePipeline& framePipeline) :
+    _framePipeline(framePipeline),
+    _executor(nullptr),
+    _slotOutput(true),
+    _running(false),
+    _frameReadyProc(nullptr),
+    _frameReadyContext(nullptr),
+    _inputReleasedProc(nullptr),
+    _inputReleasedContext(nullptr),
+    _stopping(false),
+    _submitSequence(0),
+    _convertSequence(0),
+    _returnSequence(0),
+    _tasksPending(0),
+    _delivering(false)
+{
+}
+
+ParallelFramePipeline::~ParallelFramePipeline()
+{
+    Stop();
+}
+
+bool ParallelFramePipeline::Start(uint32_t workerCount, WorkStealingExecutor* executor, bool slotOutput)
+{
+    if (IsRunning()) return true;
+    if (workerCount == 0 || workerCount > MaxWorkers || _framePipeline.GetOutputLength() == 0) return false;
+
+    // The buffers are kept across Start/Stop so a restarted pipeline doesn't allocate again
+    _slots.resize(workerCount + ReorderSlots);
+    for (Slot& slot : _slots)
+    {
+        slot.State = SlotState::Free;
+        if (slotOutput)
+        {
+            slot.Output.resize(_framePipeline.GetOutputLength());
+        }
+        else
+        {
+            std::vector<uint8_t>().swap(slot.Output);
+        }
+    }
+
+    _stopping = false;
+    _submitSequence = 0;
+    _convertSequence = 0;
+    _returnSequence = 0;
+    _tasksPending = 0;
+    _executor = executor;
+    _slotOutput = slotOutput;
+    _running = true;
+
+    // With an executor the slots limit how many frames are converted at once
+    for (uint32_t i = 0; (_executor == nullptr) && (i < workerCount); i++)
+    {
+        _workers.emplace_back(&ParallelFramePipeline::ConvertFrameProc, this);
+    }
+
+    return true;
+}
+
+void ParallelFramePipeline::Stop()
+{
+    if (!IsRunning()) return;
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _stopping = true;
+
+        // The tasks reference the slots, so they must finish before the pipeline can be restarted or destroyed
+        _frameConverted.wait(lock, [this]() { return _tasksPending == 0; });
+    }
+    _frameQueued.notify_all();
+
+    for (std::thread& worker : _workers)
+    {
+        worker.join();
+    }
+    _workers.clear();
+
+    // The pipeline's own workers leave the frames they didn't take, their data is no longer needed either
+    for (uint64_t sequence = _convertSequence; sequence != _submitSequence; sequence++)
+    {
+        ReleaseInput(sequence);
+    }
+    _executor = nullptr;
+    _running = false;
+}
+
+bool ParallelFramePipeline::CanSubmit() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    return IsRunning() && _slots[_submitSequence % _slots.size()].State == SlotState::Free;
+}
+
+uint32_t ParallelFramePipeline::GetNextSlot() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    return _slots.empty() ? 0 : static_cast<uint32_t>(_submitSequence % _slots.size());
+}
+
+bool ParallelFramePipeline::Submit(const CapturedFrame& frame, int64_t readTime)
+{
+    return Submit(frame, readTime, nullptr, 0);
+}
+
+bool ParallelFramePipeline::Submit(const CapturedFrame& frame, int64_t readTime, uint8_t* destination, uint32_t destinationLength)
+{
+    Slot* slot;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (!IsRunning() || GetSlot(_submitSequence).State != SlotState::Free) return false;
+        if (destination == nullptr && !_slotOutput) return false;
+        slot = &GetSlot(_submitSequence);
+    }
+
+    // Free slots are only touched by the caller's thread, so the slot is filled without holding the lock
+    slot->Frame = frame;
+    slot->ReadTime = readTime;
+    if (destination == nullptr)
+    {
+        destination = slot->Output.data();
+        destinationLength = static_cast<uint32_t>(slot->Output.size());
+    }
+    slot->Destination = destination;
+    slot->DestinationLength = destinationLength;
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        slot->State = SlotState::Queued;
+        _submitSequence++;
+        _tasksPending += (_executor != nullptr) ? 1 : 0;
+    }
+
+    // Each task converts the oldest queued frame, which isn't necessarily the one it was queued for. If the executor
+    // rejects the task the frame is converted right here rather than lost.
+    if (_executor == nullptr)
+    {
+        _frameQueued.notify_one();
+    }
+    else if (!_executor->Submit(TaskPriority::Capture, &ParallelFramePipeline::ConvertFrameTask, this))
+    {
+        ConvertFrameTask(this);
+    }
+
+    return true;
+}
+
+bool ParallelFramePipeline::Next(ParallelFrame& frame, bool wait)
+{
+    Slot* slot;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+
+        if (!IsRunning() || _frameReadyProc != nullptr || _returnSequence == _submitSequence) return false;
+
+        slot = &GetSlot(_returnSequence);
+        if (wait)
+        {
+            _frameConverted.wait(lock, [slot]() { return slot->State == SlotState::Converted; });
+        }
+        else if (slot->State != SlotState::Converted)
+        {
+            return false;
+        }
+
+        ReturnFrame(*slot, frame);
+    }
+
+    frame.Processed = _framePipeline.Complete(slot->Converted, frame.Result);
+    return true;
+}
+
+void ParallelFramePipeline::Release(const ParallelFrame& frame)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    if (frame.Slot < _slots.size() && _slots[frame.Slot].State == SlotState::Returned)
+    {
+        _slots[frame.Slot].State = SlotState::Free;
+    }
+}
+
+void ParallelFramePipeline::SetFrameReadyProc(ParallelFrameReadyProc proc, void* context)
+{
+    if (IsRunning()) return;
+
+    _frameReadyProc = proc;
+    _frameReadyContext = context;
+}
+
+void ParallelFramePipeline::SetInputReleasedProc(ParallelInputReleasedProc proc, void* context)
+{
+    if (IsRunning()) return;
+
+    _inputReleasedProc = proc;
+    _inputReleasedContext = context;
+}
+
+void ParallelFramePipeline::ConvertFrameProc()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    for (;;)
+    {
+        _frameQueued.wait(lock, [this]() { return _stopping || _convertSequence != _submitSequence; });
+        if (_stopping) break;
+
+        ConvertNextFrame(lock);
+    }
+}
+
+void ParallelFramePipeline::ConvertFrameTask(void* context)
+{
+    ParallelFramePipeline* pipeline = static_cast<ParallelFramePipeline*>(context);
+    std::unique_lock<std::mutex> lock(pipeline->_lock);
+
+    pipeline->ConvertNextFrame(lock);
+
+    // NOTE: Stop may return and the pipeline be destroyed as soon as the lock is released
+    pipeline->_tasksPending--;
+    pipeline->_frameConverted.notify_all();
+}
+
+void ParallelFramePipeline::ConvertNextFrame(std::unique_lock<std::mutex>& lock)
+{
+    // Frames are taken in capture order, so the oldest frames are converted first
+    const uint64_t sequence = _convertSequence++;
+    Slot& slot = GetSlot(sequence);
+    slot.State = SlotState::Converting;
+
+    // The input is released before the slot is marked converted, so it's done before the slot can be reused
+    lock.unlock();
+    _framePipeline.Convert(slot.Frame, slot.Destination, slot.DestinationLength, slot.Converted);
+    ReleaseInput(sequence);
+    lock.lock();
+
+    slot.State = SlotState::Converted;
+    _frameConverted.notify_all();
+
+    DeliverConvertedFrames(lock);
+}
+
+void ParallelFramePipeline::DeliverConvertedFrames(std::unique_lock<std::mutex>& lock)
+{
+    // The thread already delivering frames also delivers this one once the older ones are done; it checks for more
+    // before giving up the role, so no frame is left behind
+    if (_frameReadyProc == nullptr || _delivering) return;
+    _delivering = true;
+
+    while (!_stopping && _returnSequence != _submitSequence && GetSlot(_returnSequence).State == SlotState::Converted)
+    {
+        Slot& slot = GetSlot(_returnSequence);
+        ParallelFrame frame;
+        ReturnFrame(slot, frame);
+
+        // Only the delivering thread completes frames, so they're still completed one at a time in capture order
+        lock.unlock();
+        frame.Processed = _framePipeline.Complete(slot.Converted, frame.Result);
+        _frameReadyProc(_frameReadyContext, frame);
+        lock.lock();
+    }
+
+    _delivering = false;
+}
+
+void ParallelFramePipeline::ReleaseInput(uint64_t sequence)
+{
+    Slot& slot = GetSlot(sequence);
+    slot.Frame.Data = nullptr;
+
+    if (_inputReleasedProc != nullptr)
+    {
+        _inputReleasedProc(_inputReleasedContext, static_cast<uint32_t>(sequence % _slots.size()));
+    }
+}
+
+void ParallelFramePipeline::ReturnFrame(Slot& slot, ParallelFrame& frame)
+{
+    slot.State = SlotState::Returned;
+    frame.Slot = static_cast<uint32_t>(_returnSequence % _slots.size());
+    frame.ReadTime = slot.ReadTime;
+    frame.Data = slot.Destination;
+    frame.Length = slot.DestinationLength;
+    _returnSequence++;
+}
+
+} // end namespace
@@ -0,0 +1,157 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include "FramePipeline.h"
+#include "WorkStealingExecutor.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+// A frame returned by ParallelFramePipeline::Next or handed to its ParallelFrameReadyProc, valid until it's released
+struct ParallelFrame
+{
+    bool Processed;                 // Set if FramePipeline::Complete succeeded, i.e. Result and Data describe the frame
+    ProcessedFrame Result;
+    int64_t ReadTime;               // Passed to Submit with the frame
+    const uint8_t* Data;            // The Gray8 frame, in the slot or the destination passed to Submit
+    uint32_t Length;
+    uint32_t Slot;
+};
+
+// Receives the frames of a ParallelFramePipeline in capture order as soon as they're converted, see SetFrameReadyProc
+typedef void (*ParallelFrameReadyProc)(void* context, const ParallelFrame& frame);
+
+// Called once the captured frame submitted into slot was read, see SetInputReleasedProc
+typedef void (*ParallelInputReleasedProc)(void* context, uint32_t slot);
+
+// Converts consecutive frames concurrently and returns them in capture order
+//
+// Converting a large frame takes longer than the interval between frames on a single core, so each frame is handed to
+// one of a small ring of slots and converted by the next idle worker thread. Slots don't copy the captured frame, its
+// data is read in place and must stay valid until the frame is converted. The ring doubles as the reorder
+// buffer: Next returns the slots in the order their frames were submitted and completes each frame on the caller's
+// thread, or on the thread handing it to the ParallelFrameReadyProc, so FramePipeline's sequence numbers, illumination
+// phase and luminance statistics advance exactly as if the frames had been processed one by one. A frame's slot is
+// only reused once the caller released it, e.g. after the frame was published or its illumination partner arrived.
+// Frames are converted by the pipeline's own threads or, to share the processors with other providers, as Capture
+// tasks of a WorkStealingExecutor.
+// NOTE: Submit, Next and Release must be called from a single thread, except that a frame delivered to the
+// ParallelFrameReadyProc may be released on any thread. The FramePipeline must not be configured while the workers are
+// running.
+class ParallelFramePipeline
+{
+public:
+
+    // Slots beyond one per worker, so the caller can hold a frame and submit the next one while all workers are busy
+    static const uint32_t ReorderSlots = 2;
+    static const uint32_t MaxWorkers = 16;
+
+    explicit ParallelFramePipeline(FramePipeline& framePipeline);
+    ~ParallelFramePipeline();
+
+    // Converts up to workerCount frames at once, on the executor if one is given; each slot gets a Gray8 buffer to
+    // convert into unless slotOutput is false, in which case every frame must be submitted with a destination
+    // NOTE: The executor must keep running until Stop returns
+    bool Start(uint32_t workerCount, WorkStealingExecutor* executor = nullptr, bool slotOutput = true);
+    // Frames that weren't returned yet are dropped
+    void Stop();
+    bool IsRunning() const { return _running; }
+
+    // Returns true if Submit would accept a frame, i.e. the next slot in the ring was released
+    bool CanSubmit() const;
+    // Queues the frame for conversion in the next slot; returns false if the slot is still in use
+    // NOTE: The frame's data must stay valid until the frame is converted, i.e. until the ParallelInputReleasedProc is
+    // called for the slot or, without one, the frame is returned
+    bool Submit(const CapturedFrame& frame, int64_t readTime);
+    // Converts into destination instead of the slot's own buffer, e.g. the frame a provider publishes, which must stay
+    // valid until the frame is returned
+    bool Submit(const CapturedFrame& frame, int64_t readTime, uint8_t* destination, uint32_t destinationLength);
+    // The ParallelFrame::Slot the next frame submitted will be returned with
+    uint32_t GetNextSlot() const;
+
+    // Returns the oldest submitted frame that wasn't returned yet once it's converted; returns false if every frame
+    // was returned or, unless wait is set, the oldest frame is still being converted
+    bool Next(ParallelFrame& frame, bool wait);
+    void Release(const ParallelFrame& frame);
+
+    // Hands the frames to proc instead of returning them from Next, so a caller that only runs when a frame arrives,
+    // e.g. a device's read callback, doesn't publish each frame an interval late. proc is called on the thread that
+    // converted the oldest frame, and keeps being called on it for younger frames converted in the meantime; calls
+    // are never concurrent. Frames still converting when the pipeline is stopped are dropped.
+    // NOTE: Only call this while the pipeline is stopped, proc must release every frame
+    void SetFrameReadyProc(ParallelFrameReadyProc proc, void* context);
+
+    // Lets the caller release a captured frame's data as soon as it was converted, e.g. unlock the device's buffer,
+    // rather than once the frame is returned. proc is called on the converting thread, or by Stop for frames that
+    // weren't converted, exactly once for every frame Submit accepted.
+    // NOTE: Only call this while the pipeline is stopped
+    void SetInputReleasedProc(ParallelInputReleasedProc proc, void* context);
+
+private:
+
+    enum class SlotState
+    {
+        Free,
+        Queued,         // Waiting for a worker
+        Converting,
+        Converted,      // Waiting for Next
+        Returned,       // Held by the caller until it's released
+    };
+
+    struct Slot
+    {
+        SlotState State;
+        CapturedFrame Frame;            // Data is the caller's until the frame is converted
+        int64_t ReadTime;
+        std::vector<uint8_t> Output;    // Empty unless the pipeline was started with slotOutput
+        uint8_t* Destination;
+        uint32_t DestinationLength;
+        ConvertedFrame Converted;
+    };
+
+    void ConvertFrameProc();
+    static void ConvertFrameTask(void* context);
+    void ConvertNextFrame(std::unique_lock<std::mutex>& lock);
+    void DeliverConvertedFrames(std::unique_lock<std::mutex>& lock);
+    void ReturnFrame(Slot& slot, ParallelFrame& frame);
+    void ReleaseInput(uint64_t sequence);
+    Slot& GetSlot(uint64_t sequence) { return _slots[sequence % _slots.size()]; }
+
+    FramePipeline& _framePipeline;
+    std::vector<Slot> _slots;
+    std::vector<std::thread> _workers;
+    WorkStealingExecutor* _executor;
+    bool _slotOutput;
+    bool _running;
+    ParallelFrameReadyProc _frameReadyProc;
+    void* _frameReadyContext;
+    ParallelInputReleasedProc _inputReleasedProc;
+    void* _inputReleasedContext;
+
+    mutable std::mutex _lock;
+    std::condition_variable _frameQueued;
+    std::condition_variable _frameConverted;
+    bool _stopping;
+    uint64_t _submitSequence;           // Number of frames submitted since Start
+    uint64_t _convertSequence;          // Number of frames taken by a worker
+    uint64_t _returnSequence;           // Number of frames returned by Next
+    uint32_t _tasksPending;             // Tasks queued on the executor that haven't finished
+    bool _delivering;                   // A thread is calling _frameReadyProc
+};
+
+} // end namespace
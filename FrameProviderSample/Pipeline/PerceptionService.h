@@ -0,0 +1,67 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace MediaFoundationProvider {
+
+// Mirrors Windows::Devices::Perception::PerceptionFrameSourcePropertyChangeStatus
+enum class PropertyChangeStatus
+{
+    Unknown,
+    Accepted,
+    LostControl,
+    PropertyNotSupported,
+    PropertyReadOnly,
+    ValueOutOfRange,
+};
+
+// A Gray8 frame as it's handed to the service
+// NOTE: Data is only valid for the duration of the PublishFrameForProvider call
+struct PublishedFrame
+{
+    uint64_t Sequence;              // See ProcessedFrame::Sequence
+    int64_t SourceTimestamp;        // See ProcessedFrame::SourceTimestamp
+    int64_t ReadTime;               // GetPipelineTime when the frame was read from its source
+    int64_t PresentationTime;       // Frame time in the GetPipelineTime domain assigned by FramePacer, i.e. RelativeTime
+    const uint8_t* Data;
+    uint32_t Length;
+    uint32_t Width;
+    uint32_t Height;
+    bool IlluminationEnabled;
+};
+
+// Monotonic time in 100 nanosecond units, the unit used by MediaFoundation and the frame timestamps
+inline int64_t GetPipelineTime()
+{
+    return std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The part of Windows::Devices::Perception::Provider::PerceptionFrameProviderManagerService a provider calls
+// Implemented by PerceptionServiceStandIn to run providers outside of SensorDataService
+class IPerceptionService
+{
+public:
+
+    virtual ~IPerceptionService() {}
+
+    virtual void RegisterFrameProvider(const std::string& providerId) = 0;
+    virtual void UnregisterFrameProvider(const std::string& providerId) = 0;
+    virtual void PublishFrameForProvider(const std::string& providerId, const PublishedFrame& frame) = 0;
+    virtual void UpdateAvailabilityForProvider(const std::string& providerId, bool available) = 0;
+};
+
+} // end namespace
@@ -0,0 +1,196 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "PerceptionServiceStandIn.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace MediaFoundationProvider {
+
+PerceptionServiceStandIn::PerceptionServiceStandIn() :
+    _callLogLimit(std::numeric_limits<size_t>::max())
+{
+}
+
+void PerceptionServiceStandIn::RegisterFrameProvider(const std::string& providerId)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // A provider registered again, e.g. after its device was removed, starts a new publish sequence
+    ProviderRecord& provider = _providers[providerId];
+    provider.Registered = true;
+    provider.NextSequence = 0;
+
+    RecordCall(CreateCall(ServiceCallKind::RegisterFrameProvider, providerId));
+}
+
+void PerceptionServiceStandIn::UnregisterFrameProvider(const std::string& providerId)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    ProviderRecord& provider = _providers[providerId];
+    provider.Registered = false;
+    provider.Available = false;
+
+    RecordCall(CreateCall(ServiceCallKind::UnregisterFrameProvider, providerId));
+}
+
+void PerceptionServiceStandIn::PublishFrameForProvider(const std::string& providerId, const PublishedFrame& frame)
+{
+    const int64_t publishTime = GetPipelineTime();
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        // Sequence numbers are consecutive, so a jump means frames were lost and a step back means reordering
+        ProviderRecord& provider = _providers[providerId];
+        FrameDeliveryStats& stats = provider.Stats;
+
+        if (frame.Sequence < provider.NextSequence)
+        {
+            stats.FramesOutOfOrder++;
+        }
+        else
+        {
+            stats.FramesLost += frame.Sequence - provider.NextSequence;
+            provider.NextSequence = frame.Sequence + 1;
+        }
+
+        const int64_t latency = publishTime - frame.ReadTime;
+        stats.MinLatency = (stats.FramesPublished == 0) ? latency : (std::min)(stats.MinLatency, latency);
+        stats.MaxLatency = (stats.FramesPublished == 0) ? latency : (std::max)(stats.MaxLatency, latency);
+        stats.FramesPublished++;
+        provider.TotalLatency += latency;
+        stats.AverageLatency = provider.TotalLatency / static_cast<int64_t>(stats.FramesPublished);
+
+        // The call is only created if it's logged since copying the provider ID may allocate
+        if (_calls.size() < _callLogLimit)
+        {
+            ServiceCall call = CreateCall(ServiceCallKind::PublishFrame, providerId);
+            call.Time = publishTime;
+            call.Sequence = frame.Sequence;
+            call.SourceTimestamp = frame.SourceTimestamp;
+            call.ReadTime = frame.ReadTime;
+            call.PresentationTime = frame.PresentationTime;
+            call.IlluminationEnabled = frame.IlluminationEnabled;
+            RecordCall(call);
+        }
+    }
+
+    _frameDelivered.notify_all();
+}
+
+void PerceptionServiceStandIn::UpdateAvailabilityForProvider(const std::string& providerId, bool available)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    _providers[providerId].Available = available;
+
+    ServiceCall call = CreateCall(ServiceCallKind::UpdateAvailability, providerId);
+    call.Available = available;
+    RecordCall(call);
+}
+
+PropertyChangeStatus PerceptionServiceStandIn::RequestPropertyChange(HeadlessFrameProvider& provider, const std::string& name, double value)
+{
+    // The request is made outside of the lock since providers may call back into the service while handling it
+    const PropertyChangeStatus status = provider.SetProperty(name, value);
+
+    std::lock_guard<std::mutex> lock(_lock);
+
+    ServiceCall call = CreateCall(ServiceCallKind::PropertyChange, provider.GetProviderId());
+    call.PropertyName = name;
+    call.Status = status;
+    RecordCall(call);
+
+    return status;
+}
+
+bool PerceptionServiceStandIn::WaitForFrames(const std::string& providerId, uint64_t frameCount, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    return _frameDelivered.wait_for(lock, timeout, [&]
+    {
+        return _providers[providerId].Stats.FramesPublished >= frameCount;
+    });
+}
+
+std::vector<ServiceCall> PerceptionServiceStandIn::GetCalls()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _calls;
+}
+
+FrameDeliveryStats PerceptionServiceStandIn::GetDeliveryStats(const std::string& providerId)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _providers[providerId].Stats;
+}
+
+bool PerceptionServiceStandIn::IsRegistered(const std::string& providerId)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _providers[providerId].Registered;
+}
+
+bool PerceptionServiceStandIn::IsAvailable(const std::string& providerId)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _providers[providerId].Available;
+}
+
+void PerceptionServiceStandIn::Reset()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    for (auto& provider : _providers)
+    {
+        provider.second.NextSequence = 0;
+        provider.second.Stats = FrameDeliveryStats();
+        provider.second.TotalLatency = 0;
+    }
+
+    _calls.clear();
+}
+
+void PerceptionServiceStandIn::SetCallLogLimit(size_t callLogLimit)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    _callLogLimit = callLogLimit;
+    if (_calls.size() > _callLogLimit)
+    {
+        _calls.resize(_callLogLimit);
+    }
+}
+
+void PerceptionServiceStandIn::RecordCall(const ServiceCall& call)
+{
+    // NOTE: Must be called with _lock held
+    if (_calls.size() < _callLogLimit)
+    {
+        _calls.push_back(call);
+    }
+}
+
+ServiceCall PerceptionServiceStandIn::CreateCall(ServiceCallKind kind, const std::string& providerId)
+{
+    ServiceCall call = {};
+    call.Kind = kind;
+    call.ProviderId = providerId;
+    call.Time = GetPipelineTime();
+
+    return call;
+}
+
+} // end namespace
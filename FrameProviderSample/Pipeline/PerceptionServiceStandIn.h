@@ -0,0 +1,118 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "PerceptionService.h"
+#include "HeadlessFrameProvider.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+enum class ServiceCallKind
+{
+    RegisterFrameProvider,
+    UnregisterFrameProvider,
+    PublishFrame,
+    UpdateAvailability,
+    PropertyChange,
+};
+
+// A single call made to PerceptionServiceStandIn; only the fields of the call's kind are set
+struct ServiceCall
+{
+    ServiceCallKind Kind;
+    std::string ProviderId;
+    int64_t Time;                       // GetPipelineTime when the call was made
+
+    uint64_t Sequence;                  // PublishFrame
+    int64_t SourceTimestamp;            // PublishFrame
+    int64_t ReadTime;                   // PublishFrame
+    int64_t PresentationTime;           // PublishFrame
+    bool IlluminationEnabled;           // PublishFrame
+    bool Available;                     // UpdateAvailability
+    std::string PropertyName;           // PropertyChange
+    PropertyChangeStatus Status;        // PropertyChange
+};
+
+// Frame delivery of a single provider as seen by the service
+// NOTE: Latency is the time from reading a frame from its source until it was published, in 100 nanosecond units
+struct FrameDeliveryStats
+{
+    uint64_t FramesPublished;
+    uint64_t FramesLost;                // Frames skipped in the publish sequence
+    uint64_t FramesOutOfOrder;          // Frames published after a frame with a higher sequence number
+    int64_t MinLatency;
+    int64_t MaxLatency;
+    int64_t AverageLatency;
+};
+
+// Records and timestamps every call providers make to the perception service so pipeline latency, ordering and
+// frame loss can be checked without SensorDataService, e.g. in automated tests
+// NOTE: Frame data isn't kept, only the frame's metadata
+class PerceptionServiceStandIn : public IPerceptionService
+{
+public:
+
+    PerceptionServiceStandIn();
+
+    // IPerceptionService
+    virtual void RegisterFrameProvider(const std::string& providerId) override;
+    virtual void UnregisterFrameProvider(const std::string& providerId) override;
+    virtual void PublishFrameForProvider(const std::string& providerId, const PublishedFrame& frame) override;
+    virtual void UpdateAvailabilityForProvider(const std::string& providerId, bool available) override;
+
+    // Sends a property change request to the provider the way the service does on behalf of a client app
+    PropertyChangeStatus RequestPropertyChange(HeadlessFrameProvider& provider, const std::string& name, double value);
+
+    // Waits until the provider published at least frameCount frames in total, returns false on timeout
+    bool WaitForFrames(const std::string& providerId, uint64_t frameCount, std::chrono::milliseconds timeout);
+
+    std::vector<ServiceCall> GetCalls();
+    FrameDeliveryStats GetDeliveryStats(const std::string& providerId);
+    bool IsRegistered(const std::string& providerId);
+    bool IsAvailable(const std::string& providerId);
+
+    // Forgets all recorded calls and statistics, registrations are kept
+    void Reset();
+
+    // Limits the number of recorded calls, e.g. for long runs; statistics keep counting every call
+    void SetCallLogLimit(size_t callLogLimit);
+
+private:
+
+    struct ProviderRecord
+    {
+        bool Registered;
+        bool Available;
+        uint64_t NextSequence;
+        FrameDeliveryStats Stats;
+        int64_t TotalLatency;
+    };
+
+    void RecordCall(const ServiceCall& call);
+    static ServiceCall CreateCall(ServiceCallKind kind, const std::string& providerId);
+
+    std::mutex _lock;
+    std::condition_variable _frameDelivered;
+
+    std::map<std::string, ProviderRecord> _providers;
+    std::vector<ServiceCall> _calls;
+    size_t _callLogLimit;
+};
+
+} // end namespace
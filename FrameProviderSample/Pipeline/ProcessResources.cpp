@@ -0,0 +1,104 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "ProcessResources.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <cstdio>
+#include <dirent.h>
+#endif
+
+namespace MediaFoundationProvider {
+
+#ifdef _WIN32
+
+bool SampleProcessResources(ProcessResources& resources)
+{
+    const HANDLE process = GetCurrentProcess();
+
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    DWORD handleCount;
+    if (!GetProcessMemoryInfo(process, &memoryCounters, sizeof(memoryCounters)) ||
+        !GetProcessHandleCount(process, &handleCount))
+    {
+        return false;
+    }
+
+    resources.ResidentBytes = memoryCounters.WorkingSetSize;
+    resources.HandleCount = handleCount;
+    resources.ThreadCount = 0;
+
+    // The snapshot covers every thread in the system, so only count the ones owned by this process
+    const HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return false;
+
+    THREADENTRY32 threadEntry;
+    threadEntry.dwSize = sizeof(threadEntry);
+    for (BOOL found = Thread32First(snapshot, &threadEntry); found; found = Thread32Next(snapshot, &threadEntry))
+    {
+        if (threadEntry.th32OwnerProcessID == GetCurrentProcessId())
+        {
+            resources.ThreadCount++;
+        }
+    }
+
+    CloseHandle(snapshot);
+    return true;
+}
+
+#else
+
+bool SampleProcessResources(ProcessResources& resources)
+{
+    FILE* status = fopen("/proc/self/status", "r");
+    if (status == nullptr) return false;
+
+    resources = ProcessResources();
+
+    char line[256];
+    unsigned long long value;
+    while (fgets(line, sizeof(line), status) != nullptr)
+    {
+        if (sscanf(line, "VmRSS: %llu kB", &value) == 1)
+        {
+            resources.ResidentBytes = value * 1024;
+        }
+        else if (sscanf(line, "Threads: %llu", &value) == 1)
+        {
+            resources.ThreadCount = value;
+        }
+    }
+    fclose(status);
+
+    // Every entry of /proc/self/fd other than . and .. is an open descriptor, including the one used to read it
+    DIR* descriptors = opendir("/proc/self/fd");
+    if (descriptors == nullptr) return false;
+
+    for (dirent* entry = readdir(descriptors); entry != nullptr; entry = readdir(descriptors))
+    {
+        if (entry->d_name[0] != '.')
+        {
+            resources.HandleCount++;
+        }
+    }
+    closedir(descriptors);
+
+    return true;
+}
+
+#endif
+
+} // end namespace
@@ -0,0 +1,29 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+namespace MediaFoundationProvider {
+
+// Resource usage of the current process, used to detect leaks in long runs
+struct ProcessResources
+{
+    uint64_t ResidentBytes;     // Working set on Windows, VmRSS elsewhere
+    uint64_t HandleCount;       // Kernel handles on Windows, open file descriptors elsewhere
+    uint64_t ThreadCount;
+};
+
+// Returns false if the resources can't be queried on this platform
+bool SampleProcessResources(ProcessResources& resources);
+
+} // end namespace
@@ -0,0 +1,89 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Command line host for SoakRunner, built separately from the provider DLL, e.g.
+//     g++ -std=c++14 -O2 -pthread -DFRAME_PIPELINE_SOAK -DFRAME_PIPELINE_COUNT_ALLOCATIONS Pipeline/*.cpp -o FrameProviderSoak
+// FRAME_PIPELINE_SOAK selects this main, so Pipeline/*.cpp can be linked into other hosts and tests as they are
+// With FRAME_PIPELINE_COUNT_ALLOCATIONS defined the run also fails if the steady-state frame path allocates
+//
+// Usage: FrameProviderSoak [durationMinutes [sampleIntervalSeconds [conversionWorkers]]]
+// Prints one CSV line per sample and exits with 1 if the run failed
+
+#ifdef FRAME_PIPELINE_SOAK
+
+#include "SoakRunner.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace MediaFoundationProvider;
+
+static void PrintSample(const SoakSample& sample)
+{
+    printf("%lld,%llu,%llu,%llu,%llu,%llu,%lld,%lld,%lld\n",
+        static_cast<long long>(sample.ElapsedSeconds),
+        static_cast<unsigned long long>(sample.Resources.ResidentBytes),
+        static_cast<unsigned long long>(sample.Resources.HandleCount),
+        static_cast<unsigned long long>(sample.Resources.ThreadCount),
+        static_cast<unsigned long long>(sample.FramesPublished),
+        static_cast<unsigned long long>(sample.FramesLost),
+        static_cast<long long>(sample.LatencyP50),
+        static_cast<long long>(sample.LatencyP99),
+        static_cast<long long>(sample.LatencyMax));
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[])
+{
+    SoakSettings settings = GetDefaultSoakSettings();
+
+    // Shorter runs scale the Start/Stop and device loss intervals down with the duration
+    if (argc > 1)
+    {
+        settings.Duration = std::chrono::minutes(atoi(argv[1]));
+        settings.StartStopInterval = (std::min)(settings.StartStopInterval, std::chrono::duration_cast<std::chrono::seconds>(settings.Duration / 10));
+        settings.DeviceLossInterval = (std::min)(settings.DeviceLossInterval, std::chrono::duration_cast<std::chrono::seconds>(settings.Duration / 7));
+    }
+    if (argc > 2)
+    {
+        settings.SampleInterval = std::chrono::seconds(atoi(argv[2]));
+    }
+    if (argc > 3)
+    {
+        settings.ConversionWorkers = static_cast<uint32_t>(atoi(argv[3]));
+    }
+
+    if (settings.Duration.count() <= 0 || settings.SampleInterval.count() <= 0 ||
+        settings.ConversionWorkers == 0 || settings.ConversionWorkers > ParallelFramePipeline::MaxWorkers)
+    {
+        fprintf(stderr, "Usage: %s [durationMinutes [sampleIntervalSeconds [conversionWorkers]]]\n", argv[0]);
+        return 2;
+    }
+
+    printf("elapsed_s,resident_bytes,handles,threads,frames,frames_lost,latency_p50,latency_p99,latency_max\n");
+
+    SoakRunner runner(settings);
+    const SoakResult result = runner.Run(PrintSample);
+
+    for (const std::string& failure : result.Failures)
+    {
+        fprintf(stderr, "FAILED: %s\n", failure.c_str());
+    }
+    if (IsAllocationCountingEnabled())
+    {
+        fprintf(stderr, "steady-state allocations: %llu\n", static_cast<unsigned long long>(result.SteadyStateAllocations));
+    }
+    fprintf(stderr, "%s\n", result.Passed ? "PASSED" : "FAILED");
+
+    return result.Passed ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,284 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SoakRunner.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace MediaFoundationProvider {
+
+static const char SoakProviderId[] = "SoakProvider";
+static const std::chrono::seconds DeviceLossTimeout(5);
+
+// Growth below these absolute amounts is never reported, e.g. a few handles opened by the runtime on first use
+static const double ResidentBytesSlack = 1024.0 * 1024.0;
+static const double HandleCountSlack = 8.0;
+static const double ThreadCountSlack = 2.0;
+static const double LatencySlack = 1000.0;              // 100 microseconds
+
+SoakSettings GetDefaultSoakSettings()
+{
+    SoakSettings settings;
+    settings.Source.Format = FramePixelFormat::YUY2;
+    settings.Source.Width = 640;
+    settings.Source.Height = 480;
+    settings.Source.FrameRate = 30;
+    settings.Source.Paced = false;
+    settings.Source.AlternateIllumination = true;
+    settings.Duration = std::chrono::hours(4);
+    settings.SampleInterval = std::chrono::minutes(1);
+    settings.WarmupSamples = 5;
+    settings.StartStopInterval = std::chrono::minutes(5);
+    settings.DeviceLossInterval = std::chrono::minutes(17);
+    settings.MaxRelativeGrowth = 0.1;
+    settings.ConversionWorkers = 1;
+
+    return settings;
+}
+
+SoakRunner::SoakRunner(const SoakSettings& settings) :
+    _settings(settings),
+    _deviceLost(false),
+    _steadyStateAllocations(0),
+    _previousFramesPublished(0),
+    _previousFramesLost(0)
+{
+    // Only the delivery statistics are needed, recording every frame would look like a leak
+    _service.SetCallLogLimit(0);
+}
+
+SoakRunner::~SoakRunner()
+{
+    _provider.reset();
+}
+
+SoakResult SoakRunner::Run(void (*sampleCallback)(const SoakSample& sample))
+{
+    SoakResult result;
+    result.Passed = false;
+    result.SteadyStateAllocations = 0;
+
+    if (!_syntheticSource.Open(_settings.Source))
+    {
+        result.Failures.push_back("invalid synthetic source settings");
+        return result;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point startTime = Clock::now();
+    const Clock::time_point endTime = startTime + _settings.Duration;
+    const bool startStopEnabled = (_settings.StartStopInterval.count() > 0);
+    const bool deviceLossEnabled = (_settings.DeviceLossInterval.count() > 0);
+
+    Clock::time_point nextSample = startTime + _settings.SampleInterval;
+    Clock::time_point nextStartStop = startStopEnabled ? startTime + _settings.StartStopInterval : Clock::time_point::max();
+    Clock::time_point nextDeviceLoss = deviceLossEnabled ? startTime + _settings.DeviceLossInterval : Clock::time_point::max();
+
+    CreateProvider();
+
+    while (Clock::now() < endTime)
+    {
+        std::this_thread::sleep_until((std::min)({ nextSample, nextStartStop, nextDeviceLoss, endTime }));
+        const Clock::time_point now = Clock::now();
+
+        if (now >= nextDeviceLoss)
+        {
+            SimulateDeviceLoss();
+            nextDeviceLoss += _settings.DeviceLossInterval;
+        }
+
+        if (now >= nextStartStop)
+        {
+            _provider->Stop();
+            _provider->Start();
+            nextStartStop += _settings.StartStopInterval;
+        }
+
+        if (now >= nextSample)
+        {
+            result.Samples.push_back(TakeSample(startTime));
+            nextSample += _settings.SampleInterval;
+
+            if (sampleCallback != nullptr)
+            {
+                sampleCallback(result.Samples.back());
+            }
+        }
+    }
+
+    ReleaseProvider();
+
+    CheckDrift(result);
+
+    result.SteadyStateAllocations = _steadyStateAllocations;
+    if (_steadyStateAllocations != 0)
+    {
+        result.Failures.push_back(std::to_string(_steadyStateAllocations) + " heap allocations on the steady-state frame path");
+    }
+
+    result.Passed = result.Failures.empty();
+
+    return result;
+}
+
+void SoakRunner::RegisterFrameProvider(const std::string& providerId)
+{
+    _service.RegisterFrameProvider(providerId);
+}
+
+void SoakRunner::UnregisterFrameProvider(const std::string& providerId)
+{
+    _service.UnregisterFrameProvider(providerId);
+}
+
+void SoakRunner::PublishFrameForProvider(const std::string& providerId, const PublishedFrame& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(_latencyLock);
+        _latencies.Record(GetPipelineTime() - frame.ReadTime);
+    }
+
+    _service.PublishFrameForProvider(providerId, frame);
+}
+
+void SoakRunner::UpdateAvailabilityForProvider(const std::string& providerId, bool available)
+{
+    _service.UpdateAvailabilityForProvider(providerId, available);
+}
+
+void SoakRunner::CreateProvider()
+{
+    _deviceLost = false;
+
+    auto frameSource = std::make_shared<SoakFrameSource>(_syntheticSource, _deviceLost);
+    _provider.reset(new HeadlessFrameProvider(SoakProviderId, this, frameSource, _syntheticSource.GetFrameLayout()));
+    _provider->SetConversionWorkers(_settings.ConversionWorkers);
+    _provider->Start();
+}
+
+void SoakRunner::SimulateDeviceLoss()
+{
+    // The provider notices the removal on its next read and reports itself unavailable
+    _deviceLost = true;
+
+    const std::chrono::steady_clock::time_point timeout = std::chrono::steady_clock::now() + DeviceLossTimeout;
+    while (_service.IsAvailable(SoakProviderId) && _provider->IsRunning() && std::chrono::steady_clock::now() < timeout)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Release the provider and create a new one for the re-added device
+    ReleaseProvider();
+    CreateProvider();
+}
+
+void SoakRunner::ReleaseProvider()
+{
+    // Stop the provider first so its allocation count is final
+    _provider->Stop();
+    _steadyStateAllocations += _provider->GetSteadyStateAllocations();
+
+    _provider.reset();
+}
+
+SoakSample SoakRunner::TakeSample(std::chrono::steady_clock::time_point startTime)
+{
+    SoakSample sample = {};
+    sample.ElapsedSeconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - startTime).count();
+    SampleProcessResources(sample.Resources);
+
+    // Delivery statistics are kept across provider instances, so the interval's share is the difference to the previous sample
+    const FrameDeliveryStats stats = _service.GetDeliveryStats(SoakProviderId);
+    sample.FramesPublished = stats.FramesPublished - _previousFramesPublished;
+    sample.FramesLost = stats.FramesLost - _previousFramesLost;
+    _previousFramesPublished = stats.FramesPublished;
+    _previousFramesLost = stats.FramesLost;
+
+    std::lock_guard<std::mutex> lock(_latencyLock);
+    sample.LatencyP50 = _latencies.GetPercentile(50.0);
+    sample.LatencyP99 = _latencies.GetPercentile(99.0);
+    sample.LatencyMax = _latencies.GetMaximum();
+    _latencies.Reset();
+
+    return sample;
+}
+
+void SoakRunner::CheckDrift(SoakResult& result)
+{
+    for (const SoakSample& sample : result.Samples)
+    {
+        if (sample.FramesPublished == 0)
+        {
+            result.Failures.push_back("no frames published in the interval ending at " + std::to_string(sample.ElapsedSeconds) + " s");
+        }
+        if (sample.FramesLost != 0)
+        {
+            result.Failures.push_back(std::to_string(sample.FramesLost) + " frames lost in the interval ending at " + std::to_string(sample.ElapsedSeconds) + " s");
+        }
+    }
+
+    if (result.Samples.size() < _settings.WarmupSamples + 3)
+    {
+        result.Failures.push_back("too few samples to detect a trend, increase the duration or reduce the sample interval");
+        return;
+    }
+
+    struct DriftMetric
+    {
+        const char* Name;
+        double (*GetValue)(const SoakSample& sample);
+        double Slack;
+    };
+
+    static const DriftMetric metrics[] =
+    {
+        { "resident memory", [](const SoakSample& sample) { return static_cast<double>(sample.Resources.ResidentBytes); }, ResidentBytesSlack },
+        { "handle count", [](const SoakSample& sample) { return static_cast<double>(sample.Resources.HandleCount); }, HandleCountSlack },
+        { "thread count", [](const SoakSample& sample) { return static_cast<double>(sample.Resources.ThreadCount); }, ThreadCountSlack },
+        { "latency p50", [](const SoakSample& sample) { return static_cast<double>(sample.LatencyP50); }, LatencySlack },
+        { "latency p99", [](const SoakSample& sample) { return static_cast<double>(sample.LatencyP99); }, LatencySlack },
+    };
+
+    const auto first = result.Samples.begin() + _settings.WarmupSamples;
+    const double sampleCount = static_cast<double>(result.Samples.end() - first);
+
+    for (const DriftMetric& metric : metrics)
+    {
+        // Least squares fit of the metric over the sample index
+        double meanIndex = (sampleCount - 1.0) / 2.0;
+        double meanValue = 0.0;
+        for (auto sample = first; sample != result.Samples.end(); ++sample)
+        {
+            meanValue += metric.GetValue(*sample) / sampleCount;
+        }
+
+        double covariance = 0.0;
+        double variance = 0.0;
+        for (auto sample = first; sample != result.Samples.end(); ++sample)
+        {
+            const double index = static_cast<double>(sample - first);
+            covariance += (index - meanIndex) * (metric.GetValue(*sample) - meanValue);
+            variance += (index - meanIndex) * (index - meanIndex);
+        }
+
+        const double slope = covariance / variance;
+        const double baseline = (std::max)(meanValue - slope * meanIndex, 1.0);
+        const double growth = slope * (sampleCount - 1.0);
+
+        if (growth > (std::max)(baseline * _settings.MaxRelativeGrowth, metric.Slack))
+        {
+            result.Failures.push_back(std::string(metric.Name) + " grew from " + std::to_string(baseline) + " by " + std::to_string(growth));
+        }
+    }
+}
+
+} // end namespace
@@ -0,0 +1,121 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "PerceptionServiceStandIn.h"
+#include "ProcessResources.h"
+#include "SyntheticFrameSource.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+struct SoakSettings
+{
+    SyntheticFrameSettings Source;              // Usually unpaced to run the pipeline at full rate
+    std::chrono::seconds Duration;
+    std::chrono::seconds SampleInterval;
+    uint32_t WarmupSamples;                     // Samples ignored by the drift check, e.g. while caches fill
+    std::chrono::seconds StartStopInterval;     // Stops and restarts the provider, 0 disables
+    std::chrono::seconds DeviceLossInterval;    // Removes the device and recreates the provider, 0 disables
+    double MaxRelativeGrowth;                   // Largest growth of any metric over the run, relative to its baseline
+    uint32_t ConversionWorkers;                 // See HeadlessFrameProvider::SetConversionWorkers
+};
+
+// Resource usage and frame delivery measured over one sample interval
+// NOTE: Latencies are in 100 nanosecond units
+struct SoakSample
+{
+    int64_t ElapsedSeconds;
+    ProcessResources Resources;
+    uint64_t FramesPublished;
+    uint64_t FramesLost;
+    int64_t LatencyP50;
+    int64_t LatencyP99;
+    int64_t LatencyMax;
+};
+
+struct SoakResult
+{
+    bool Passed;
+    uint64_t SteadyStateAllocations;            // Only counted if AllocationCounter is enabled
+    std::vector<SoakSample> Samples;
+    std::vector<std::string> Failures;
+};
+
+SoakSettings GetDefaultSoakSettings();
+
+// Runs a HeadlessFrameProvider from a synthetic source for hours and fails if memory, handles, threads or latency
+// trend upward beyond SoakSettings::MaxRelativeGrowth, i.e. catches slow leaks and latency creep
+//
+// The trend of each metric is the least squares fit over all samples after the warmup, so single spikes don't fail
+// the run. Along the way the provider is periodically stopped and restarted and its device is removed and re-added,
+// like SampleFrameProviderManager recreates providers.
+class SoakRunner : private IPerceptionService
+{
+public:
+
+    explicit SoakRunner(const SoakSettings& settings);
+    ~SoakRunner();
+
+    // Blocks for SoakSettings::Duration; called with every sample, e.g. to print progress
+    SoakResult Run(void (*sampleCallback)(const SoakSample& sample) = nullptr);
+
+private:
+
+    // Returns frames of the synthetic source until the device is removed
+    class SoakFrameSource : public IFrameSource
+    {
+    public:
+
+        SoakFrameSource(SyntheticFrameSource& source, std::atomic<bool>& deviceLost) : _source(source), _deviceLost(deviceLost) {}
+        virtual bool ReadFrame(CapturedFrame& frame) override { return !_deviceLost && _source.ReadFrame(frame); }
+
+    private:
+
+        SyntheticFrameSource& _source;
+        std::atomic<bool>& _deviceLost;
+    };
+
+    // IPerceptionService; forwarded to the stand-in after recording the frame's latency
+    virtual void RegisterFrameProvider(const std::string& providerId) override;
+    virtual void UnregisterFrameProvider(const std::string& providerId) override;
+    virtual void PublishFrameForProvider(const std::string& providerId, const PublishedFrame& frame) override;
+    virtual void UpdateAvailabilityForProvider(const std::string& providerId, bool available) override;
+
+    void CreateProvider();
+    void ReleaseProvider();
+    void SimulateDeviceLoss();
+    SoakSample TakeSample(std::chrono::steady_clock::time_point startTime);
+    void CheckDrift(SoakResult& result);
+
+    const SoakSettings _settings;
+    PerceptionServiceStandIn _service;
+    SyntheticFrameSource _syntheticSource;
+    std::atomic<bool> _deviceLost;
+    std::unique_ptr<HeadlessFrameProvider> _provider;
+
+    std::mutex _latencyLock;
+    LatencyHistogram _latencies;                // Latencies of the current sample interval
+
+    uint64_t _steadyStateAllocations;
+    uint64_t _previousFramesPublished;
+    uint64_t _previousFramesLost;
+};
+
+} // end namespace
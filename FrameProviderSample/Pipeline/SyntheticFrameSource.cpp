@@ -0,0 +1,143 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SyntheticFrameSource.h"
+
+#include <thread>
+
+namespace MediaFoundationProvider {
+
+static const uint8_t NeutralChroma = 128;
+static const uint32_t PatternPhaseStep = 4;             // Pixels the pattern moves between two frames
+static const uint32_t AmbientLumaShift = 1;            // Ambient only frames are half as bright as illuminated frames
+
+SyntheticFrameSource::SyntheticFrameSource() :
+    _settings(),
+    _layout(),
+    _frameLength(0),
+    _nextFrame(0)
+{
+}
+
+SyntheticFrameSource::~SyntheticFrameSource()
+{
+    Close();
+}
+
+bool SyntheticFrameSource::Open(const SyntheticFrameSettings& settings)
+{
+    Close();
+
+    // YUY2 pairs two pixels and NV12 subsamples both dimensions, so odd sizes aren't valid for either
+    const bool evenSizeRequired = (settings.Format == FramePixelFormat::YUY2 || settings.Format == FramePixelFormat::NV12);
+    if (settings.Width == 0 || settings.Height == 0 || settings.FrameRate == 0 ||
+        (evenSizeRequired && ((settings.Width % 2) != 0 || (settings.Height % 2) != 0)))
+    {
+        return false;
+    }
+
+    const FrameLayout layout = GetPackedFrameLayout(settings.Format, settings.Width, settings.Height);
+    const uint32_t frameLength = GetFrameLength(layout);
+    if (frameLength == 0) return false;
+
+    _patterns.resize(static_cast<size_t>(frameLength) * PatternCycleLength);
+    for (uint32_t pattern = 0; pattern < PatternCycleLength; pattern++)
+    {
+        const bool illuminated = !settings.AlternateIllumination || (pattern % 2) == 0;
+        RenderPattern(layout, pattern, illuminated, &_patterns[static_cast<size_t>(frameLength) * pattern]);
+    }
+
+    _settings = settings;
+    _layout = layout;
+    _frameLength = frameLength;
+    Rewind();
+
+    return true;
+}
+
+void SyntheticFrameSource::Close()
+{
+    _patterns.clear();
+    _patterns.shrink_to_fit();
+
+    _layout = FrameLayout();
+    _frameLength = 0;
+    _nextFrame = 0;
+}
+
+void SyntheticFrameSource::Rewind()
+{
+    _nextFrame = 0;
+    _startTime = std::chrono::steady_clock::now();
+}
+
+bool SyntheticFrameSource::ReadFrame(CapturedFrame& frame)
+{
+    if (_frameLength == 0) return false;
+
+    const uint64_t frameIndex = _nextFrame++;
+    const uint32_t pattern = static_cast<uint32_t>(frameIndex % PatternCycleLength);
+
+    // NOTE: Timestamps are in 100 nanosecond units
+    frame.Data = &_patterns[static_cast<size_t>(_frameLength) * pattern];
+    frame.Length = _frameLength;
+    frame.Layout = _layout;
+    frame.Timestamp = static_cast<int64_t>(frameIndex * 10000000 / _settings.FrameRate);
+    frame.IlluminationTagged = _settings.AlternateIllumination;
+    frame.IlluminationEnabled = _settings.AlternateIllumination && (pattern % 2) == 0;
+
+    // Wait until the frame is due relative to the first frame
+    if (_settings.Paced)
+    {
+        std::this_thread::sleep_until(_startTime + std::chrono::microseconds(frame.Timestamp / 10));
+    }
+
+    return true;
+}
+
+void SyntheticFrameSource::RenderPattern(const FrameLayout& layout, uint32_t phase, bool illuminated, uint8_t* data)
+{
+    // Diagonal luma ramp moving with the phase, so consecutive frames differ and dropped or repeated frames are visible
+    const uint32_t lumaOffset = phase * PatternPhaseStep;
+    const uint32_t lumaShift = illuminated ? 0 : AmbientLumaShift;
+
+    for (uint32_t y = 0; y < layout.Height; y++)
+    {
+        uint8_t* row = data + static_cast<size_t>(layout.Stride) * y;
+
+        for (uint32_t x = 0; x < layout.Width; x++)
+        {
+            const uint8_t luma = static_cast<uint8_t>(((x + y + lumaOffset) & 0xFF) >> lumaShift);
+
+            if (layout.Format == FramePixelFormat::YUY2)
+            {
+                row[x * 2] = luma;
+                row[x * 2 + 1] = NeutralChroma;
+            }
+            else
+            {
+                row[x] = luma;
+            }
+        }
+    }
+
+    // NV12's interleaved chroma plane follows the luma plane and has half as many rows
+    if (layout.Format == FramePixelFormat::NV12)
+    {
+        uint8_t* chroma = data + static_cast<size_t>(layout.Stride) * layout.Height;
+        for (size_t i = 0; i < static_cast<size_t>(layout.Stride) * (layout.Height / 2); i++)
+        {
+            chroma[i] = NeutralChroma;
+        }
+    }
+}
+
+} // end namespace
@@ -0,0 +1,69 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "FrameSource.h"
+
+#include <chrono>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+struct SyntheticFrameSettings
+{
+    FramePixelFormat Format;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t FrameRate;             // Frames per second, determines the frame timestamps
+    bool Paced;                     // If not set frames are returned as fast as they're read, e.g. to find the maximum throughput
+    bool AlternateIllumination;     // Toggles the illumination state every frame like the MFT0 sample does
+};
+
+// Generates frames of a deterministic test pattern in place of a capture device
+//
+// Frame n always has the same content, timestamp and illumination state so runs can be compared. A short cycle of
+// patterns is rendered up front and ReadFrame only hands out pointers to them, so generating frames costs next to
+// nothing compared to converting and publishing them.
+class SyntheticFrameSource : public IFrameSource
+{
+public:
+
+    static const uint32_t PatternCycleLength = 8;       // Must be even so every pattern keeps its illumination state
+
+    SyntheticFrameSource();
+    virtual ~SyntheticFrameSource();
+
+    // Returns false if the format isn't supported or the frame size or rate is invalid
+    bool Open(const SyntheticFrameSettings& settings);
+    void Close();
+    void Rewind();
+
+    const FrameLayout& GetFrameLayout() const { return _layout; }
+    uint64_t GetFramesGenerated() const { return _nextFrame; }
+
+    // IFrameSource
+    virtual bool ReadFrame(CapturedFrame& frame) override;
+
+private:
+
+    static void RenderPattern(const FrameLayout& layout, uint32_t phase, bool illuminated, uint8_t* data);
+
+    SyntheticFrameSettings _settings;
+    FrameLayout _layout;
+    uint32_t _frameLength;
+    std::vector<uint8_t> _patterns;                     // PatternCycleLength frames of _frameLength bytes
+
+    uint64_t _nextFrame;
+    std::chrono::steady_clock::time_point _startTime;
+};
+
+} // end namespace
@@ -0,0 +1,159 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "PipelineTest.h"
+#include "../AutoExposureController.h"
+
+#include <cmath>
+
+namespace MediaFoundationProvider {
+
+static const int64_t FrameInterval = 333333;       // 30 fps
+static const uint32_t ApplyLatencyFrames = 2;       // Frames until the device applied a value
+static const uint32_t SimulatedFrames = 150;
+
+// A sensor whose frames get twice as bright per EV of exposure compensation; each frame's pixels are spread evenly
+// over 17 levels around its median
+struct SimulatedSensor
+{
+    double SceneLevel;              // Median luminance at 0 EV
+    float Value;
+
+    uint8_t GetMedian() const
+    {
+        const double level = SceneLevel * std::pow(2.0, Value);
+        return static_cast<uint8_t>((level > 247.0) ? 247.0 : ((level < 8.0) ? 8.0 : std::floor(level + 0.5)));
+    }
+
+    void Capture(LuminanceStatistics& statistics) const
+    {
+        const uint32_t median = GetMedian();
+        statistics.Reset();
+        for (uint32_t level = median - 8; level <= median + 8; level++)
+        {
+            statistics.Histogram[level] = 1000;
+            statistics.Pixels += 1000;
+            statistics.Sum += 1000 * level;
+            statistics.Saturated += (level >= LuminanceStatistics::SaturationLevel) ? 1000 : 0;
+        }
+    }
+};
+
+static AutoExposureSettings GetSensorSettings()
+{
+    AutoExposureSettings settings = AutoExposureController::GetDefaultSettings();
+    settings.MinValue = -2.0f;
+    settings.MaxValue = 2.0f;
+    settings.Step = 1.0f / 6.0f;
+    return settings;
+}
+
+static bool IsWellExposed(const SimulatedSensor& sensor, const AutoExposureSettings& settings)
+{
+    return std::fabs(std::log2(static_cast<double>(settings.TargetLevel) / sensor.GetMedian())) < settings.Deadband;
+}
+
+// Streams frames of the scene with the controller driving the sensor like SampleFrameProvider does, and returns the
+// number of frames until the sensor stayed well exposed for the rest of the run, or SimulatedFrames if it never did
+static uint32_t RunClosedLoop(SimulatedSensor& sensor, AutoExposureController& controller)
+{
+    const AutoExposureSettings settings = GetSensorSettings();
+    controller.Configure(settings, sensor.Value);
+
+    uint32_t applyFrame = 0;
+    uint32_t framesToExposure = SimulatedFrames;
+
+    for (uint32_t frame = 0; frame < SimulatedFrames; frame++)
+    {
+        LuminanceStatistics statistics;
+        sensor.Capture(statistics);
+
+        if (IsWellExposed(sensor, settings))
+        {
+            framesToExposure = (framesToExposure == SimulatedFrames) ? frame : framesToExposure;
+        }
+        else
+        {
+            framesToExposure = SimulatedFrames;
+        }
+
+        float newValue;
+        if (controller.Evaluate(statistics, frame * FrameInterval, newValue))
+        {
+            TEST_CHECK(newValue >= settings.MinValue && newValue <= settings.MaxValue);
+            sensor.Value = newValue;
+            applyFrame = frame + ApplyLatencyFrames;
+        }
+        if (controller.IsPending() && frame == applyFrame)
+        {
+            controller.Commit();
+        }
+    }
+
+    return framesToExposure;
+}
+
+PIPELINE_TEST(AutoExposureBrightensDarkScene)
+{
+    SimulatedSensor sensor = { 30.0, 0.0f };
+    const AutoExposureSettings settings = GetSensorSettings();
+    TEST_CHECK(!IsWellExposed(sensor, settings));
+
+    // Without the controller the frames would stay too dark; with it they're well exposed within a second
+    AutoExposureController controller;
+    const uint32_t frames = RunClosedLoop(sensor, controller);
+    TEST_CHECK(frames <= 30);
+    TEST_CHECK(controller.GetCurrentValue() == sensor.Value);
+    TEST_CHECK(controller.GetUpdates() <= 4);
+}
+
+PIPELINE_TEST(AutoExposureDarkensSaturatedScene)
+{
+    // Most of the brightest levels are saturated
+    SimulatedSensor sensor = { 245.0, 0.0f };
+
+    AutoExposureController controller;
+    const uint32_t frames = RunClosedLoop(sensor, controller);
+    TEST_CHECK(frames <= 30);
+    TEST_CHECK(controller.GetCurrentValue() == sensor.Value && sensor.Value < 0.0f);
+}
+
+PIPELINE_TEST(AutoExposureKeepsValueTheDeviceRefused)
+{
+    SimulatedSensor sensor = { 30.0, 0.0f };
+    LuminanceStatistics statistics;
+    sensor.Capture(statistics);
+
+    AutoExposureController controller;
+    controller.Configure(GetSensorSettings(), 0.0f);
+
+    float newValue = 0.0f;
+    TEST_CHECK(controller.Evaluate(statistics, 0, newValue));
+    TEST_CHECK(newValue > 0.0f && controller.IsPending());
+
+    // Nothing else is evaluated while the device applies the value
+    float otherValue;
+    TEST_CHECK(!controller.Evaluate(statistics, 10 * FrameInterval, otherValue));
+
+    controller.Revert();
+    TEST_CHECK(controller.GetCurrentValue() == 0.0f && controller.GetUpdates() == 0);
+
+    // The value is proposed again once the update interval passed
+    TEST_CHECK(!controller.Evaluate(statistics, FrameInterval, otherValue));
+    TEST_CHECK(controller.Evaluate(statistics, GetSensorSettings().MinUpdateInterval, otherValue));
+    TEST_CHECK(otherValue == newValue);
+
+    controller.Commit();
+    TEST_CHECK(controller.GetCurrentValue() == newValue && controller.GetUpdates() == 1);
+}
+
+} // end namespace
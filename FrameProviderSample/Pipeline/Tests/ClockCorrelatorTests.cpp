@@ -0,0 +1,167 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "PipelineTest.h"
+#include "../ClockCorrelator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+namespace MediaFoundationProvider {
+
+static const int64_t FrameInterval = 333333;            // 30 fps
+static const int64_t DeviceClockStart = 123456789;      // The device clock has its own epoch
+
+// Simulates a device whose clock runs DriftPpm faster than the system clock and whose frames arrive after a delay of
+// at least MinDelay plus an exponentially distributed part, like frames passing through the capture pipeline
+// NOTE: The delays are drawn from a fixed seed with the inverse distribution, so every platform sees the same delays
+class SimulatedDevice
+{
+public:
+
+    static const int64_t MinDelay = 20000;             // 2 ms
+    static const int64_t MeanExtraDelay = 30000;       // 3 ms
+
+    explicit SimulatedDevice(double driftPpm) :
+        _driftPpm(driftPpm),
+        _random(38),
+        _frame(0)
+    {
+    }
+
+    // Returns the next frame's device timestamp and arrival time and the system time it was captured at
+    void NextFrame(int64_t& deviceTime, int64_t& arrivalTime, int64_t& captureTime)
+    {
+        captureTime = 1000000000 + _frame * FrameInterval;
+        deviceTime = DeviceClockStart + static_cast<int64_t>(std::llround(_frame * FrameInterval * (1.0 + _driftPpm * 1.0e-6)));
+
+        const double uniform = (static_cast<double>(_random()) + 0.5) / 4294967296.0;
+        arrivalTime = captureTime + MinDelay + static_cast<int64_t>(-std::log(uniform) * MeanExtraDelay);
+        _frame++;
+    }
+
+private:
+
+    double _driftPpm;
+    std::mt19937 _random;
+    int64_t _frame;
+};
+
+PIPELINE_TEST(ClockCorrelatorEstimatesDrift)
+{
+    ClockCorrelator correlator;
+    SimulatedDevice device(50.0);
+    int64_t deviceTime, arrivalTime, captureTime;
+
+    // Five minutes of frames
+    int64_t maxError = 0;
+    for (uint32_t frame = 0; frame < 5 * 60 * 30; frame++)
+    {
+        device.NextFrame(deviceTime, arrivalTime, captureTime);
+        const int64_t mappedTime = correlator.Correlate(deviceTime, arrivalTime);
+
+        // Once the window is full the frames map to their capture time plus the least delay
+        if (frame >= ClockCorrelator::WindowSize * ClockCorrelator::ObservationsPerBlock)
+        {
+            maxError = (std::max)(maxError, static_cast<int64_t>(std::llabs(mappedTime - (captureTime + SimulatedDevice::MinDelay))));
+        }
+    }
+
+    const ClockCorrelation correlation = correlator.GetCorrelation();
+    TEST_CHECK(std::fabs(correlation.DriftPpm - 50.0) < 2.0);
+    TEST_CHECK(correlation.Samples == ClockCorrelator::WindowSize);
+    TEST_CHECK(correlation.Resets == 0);
+    TEST_CHECK(maxError < 5000);
+}
+
+PIPELINE_TEST(ClockCorrelatorIgnoresLateFrames)
+{
+    ClockCorrelator correlator;
+    SimulatedDevice device(50.0);
+    int64_t deviceTime, arrivalTime, captureTime;
+
+    for (uint32_t frame = 0; frame < 2000; frame++)
+    {
+        device.NextFrame(deviceTime, arrivalTime, captureTime);
+        correlator.Correlate(deviceTime, arrivalTime);
+    }
+    const ClockCorrelation before = correlator.GetCorrelation();
+
+    // A 500 ms stall holds up the frames captured during it, they all arrive when it ends
+    const int64_t stallEnd = captureTime + 5000000;
+    for (uint32_t frame = 0; frame < 15; frame++)
+    {
+        device.NextFrame(deviceTime, arrivalTime, captureTime);
+        const int64_t mappedTime = correlator.Correlate(deviceTime, (std::max)(arrivalTime, stallEnd));
+        TEST_CHECK(std::llabs(mappedTime - (captureTime + SimulatedDevice::MinDelay)) < 5000);
+    }
+
+    for (uint32_t frame = 0; frame < 100; frame++)
+    {
+        device.NextFrame(deviceTime, arrivalTime, captureTime);
+        correlator.Correlate(deviceTime, arrivalTime);
+    }
+
+    const ClockCorrelation after = correlator.GetCorrelation();
+    TEST_CHECK(after.Resets == 0);
+    TEST_CHECK(after.Samples > before.Samples);
+    TEST_CHECK(std::fabs(after.DriftPpm - before.DriftPpm) < 2.0);
+}
+
+PIPELINE_TEST(ClockCorrelatorStartsOverWhenDeviceClockGoesBackwards)
+{
+    ClockCorrelator correlator;
+
+    for (int64_t frame = 0; frame < 100; frame++)
+    {
+        correlator.Correlate(DeviceClockStart + frame * FrameInterval, frame * FrameInterval);
+    }
+    TEST_CHECK(correlator.GetCorrelation().Resets == 0);
+
+    // The stream was restarted and the device clock starts from zero
+    const int64_t restartTime = 100 * FrameInterval;
+    TEST_CHECK(correlator.Correlate(0, restartTime) == restartTime);
+    TEST_CHECK(correlator.GetCorrelation().Resets == 1);
+    TEST_CHECK(correlator.Correlate(FrameInterval, restartTime + FrameInterval) == restartTime + FrameInterval);
+}
+
+PIPELINE_TEST(ClockCorrelatorStartsOverWhenDeviceClockJumps)
+{
+    ClockCorrelator correlator;
+    int64_t frame = 0;
+
+    for (; frame < 100; frame++)
+    {
+        correlator.Correlate(DeviceClockStart + frame * FrameInterval, frame * FrameInterval);
+    }
+
+    // The device clock jumps ahead by an hour; frames aren't mapped past their arrival until the estimate starts over
+    const int64_t jump = 36000000000;
+    uint32_t framesUntilReset = 0;
+    for (; correlator.GetCorrelation().Resets == 0 && frame < 200; frame++)
+    {
+        const int64_t arrivalTime = frame * FrameInterval;
+        TEST_CHECK(correlator.Correlate(DeviceClockStart + jump + frame * FrameInterval, arrivalTime) <= arrivalTime);
+        framesUntilReset++;
+    }
+
+    TEST_CHECK(correlator.GetCorrelation().Resets == 1);
+    TEST_CHECK(framesUntilReset * FrameInterval >= ClockCorrelator::JumpDuration);
+    TEST_CHECK(framesUntilReset * FrameInterval <= ClockCorrelator::JumpDuration + 2 * FrameInterval);
+
+    const int64_t arrivalTime = frame * FrameInterval;
+    TEST_CHECK(correlator.Correlate(DeviceClockStart + jump + frame * FrameInterval, arrivalTime) == arrivalTime);
+}
+
+} // end namespace
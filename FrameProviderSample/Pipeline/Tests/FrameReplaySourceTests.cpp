@@ -0,0 +1,133 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "PipelineTest.h"
+#include "../FrameRecorder.h"
+#include "../FrameReplaySource.h"
+
+#include <cstring>
+
+namespace MediaFoundationProvider {
+
+static const uint32_t RecordedFrames = 8;
+static const int64_t RecordedFrameInterval = 333333;
+
+// Records RecordedFrames frames of 16x4 Gray8 pixels; every pixel of frame i is i and odd frames are lit
+static bool WriteRecording(const TestFile& file)
+{
+    const FrameLayout layout = GetPackedFrameLayout(FramePixelFormat::Gray8, 16, 4);
+    std::vector<uint8_t> data(GetFrameLength(layout));
+
+    FrameRecorder recorder;
+    if (!recorder.Open(file.GetPath(), static_cast<uint32_t>(data.size()), RecordedFrames)) return false;
+
+    for (uint32_t i = 0; i < RecordedFrames; i++)
+    {
+        memset(data.data(), static_cast<int>(i), data.size());
+
+        CapturedFrame frame = {};
+        frame.Data = data.data();
+        frame.Length = static_cast<uint32_t>(data.size());
+        frame.Layout = layout;
+        frame.Timestamp = 1000000 + i * RecordedFrameInterval;
+        frame.IlluminationTagged = true;
+        frame.IlluminationEnabled = (i & 1) != 0;
+
+        if (!recorder.Append(frame)) return false;
+    }
+
+    recorder.Close();
+    return recorder.GetFramesWritten() == RecordedFrames;
+}
+
+PIPELINE_TEST(FrameReplaySourceReplaysRecording)
+{
+    TestFile file("Replay.frec");
+    TEST_CHECK(WriteRecording(file));
+
+    FrameReplaySource source;
+    TEST_CHECK(source.Open(file.GetPath(), ReplayPacing::FlatOut, false));
+    TEST_CHECK(source.GetFrameCount() == RecordedFrames);
+    TEST_CHECK(source.GetAverageFrameInterval() == RecordedFrameInterval);
+
+    FrameLayout layout;
+    TEST_CHECK(source.GetFrameLayout(layout));
+    TEST_CHECK(layout.Format == FramePixelFormat::Gray8 && layout.Width == 16 && layout.Height == 4);
+
+    CapturedFrame frame;
+    for (uint32_t i = 0; i < RecordedFrames; i++)
+    {
+        TEST_CHECK(source.ReadFrame(frame));
+        TEST_CHECK(frame.Timestamp == 1000000 + i * RecordedFrameInterval);
+        TEST_CHECK(frame.Length == 16 * 4);
+        TEST_CHECK(frame.Data[0] == i && frame.Data[frame.Length - 1] == i);
+        TEST_CHECK(frame.IlluminationTagged);
+        TEST_CHECK(frame.IlluminationEnabled == ((i & 1) != 0));
+    }
+    TEST_CHECK(!source.ReadFrame(frame));
+}
+
+PIPELINE_TEST(FrameReplaySourceRecoversCutShortRecording)
+{
+    TestFile file("CutShort.frec");
+    TEST_CHECK(WriteRecording(file));
+
+    // Drop the index and half of the last record, like a recording whose writer didn't get to close it
+    std::vector<uint8_t> data;
+    TEST_CHECK(file.Read(data));
+    RecordingFileTrailer trailer;
+    memcpy(&trailer, data.data() + data.size() - sizeof(trailer), sizeof(trailer));
+    TEST_CHECK(trailer.Magic == RecordingTrailerMagic && trailer.FrameCount == RecordedFrames);
+
+    data.resize(static_cast<size_t>(trailer.IndexOffset) - 8);
+    TEST_CHECK(file.Write(data));
+
+    FrameReplaySource source;
+    TEST_CHECK(source.Open(file.GetPath(), ReplayPacing::FlatOut, false));
+    TEST_CHECK(source.GetFrameCount() == RecordedFrames - 1);
+}
+
+PIPELINE_TEST(FrameReplaySourceRejectsCorruptIndex)
+{
+    TestFile file("CorruptIndex.frec");
+    TEST_CHECK(WriteRecording(file));
+
+    std::vector<uint8_t> data;
+    TEST_CHECK(file.Read(data));
+
+    // An index offset that wraps around when the index length is added to it; the records are walked instead
+    RecordingFileTrailer trailer;
+    memcpy(&trailer, data.data() + data.size() - sizeof(trailer), sizeof(trailer));
+    trailer.FrameCount = 1u << 28;
+    trailer.IndexOffset -= static_cast<uint64_t>(trailer.FrameCount) * sizeof(RecordIndexEntry);
+    memcpy(data.data() + data.size() - sizeof(trailer), &trailer, sizeof(trailer));
+    TEST_CHECK(file.Write(data));
+
+    FrameReplaySource source;
+    TEST_CHECK(source.Open(file.GetPath(), ReplayPacing::FlatOut, false));
+    TEST_CHECK(source.GetFrameCount() == RecordedFrames);
+
+    // A file holding nothing but a header and a trailer pointing 4 GB before it
+    std::vector<uint8_t> crafted(64, 0);
+    const RecordingFileHeader header = { RecordingFileMagic, RecordingFileVersion, RecordAlignment, 0 };
+    const RecordingFileTrailer craftedTrailer = { RecordingTrailerMagic, 1u << 28, 48 - (1ull << 32) };
+    memcpy(crafted.data(), &header, sizeof(header));
+    memcpy(crafted.data() + crafted.size() - sizeof(craftedTrailer), &craftedTrailer, sizeof(craftedTrailer));
+    TEST_CHECK(file.Write(crafted));
+
+    CapturedFrame frame;
+    TEST_CHECK(source.Open(file.GetPath(), ReplayPacing::FlatOut, false));
+    TEST_CHECK(source.GetFrameCount() == 0);
+    TEST_CHECK(!source.ReadFrame(frame));
+}
+
+} // end namespace
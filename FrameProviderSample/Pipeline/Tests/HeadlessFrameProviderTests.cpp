@@ -0,0 +1,86 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "PipelineTest.h"
+#include "../HeadlessFrameProvider.h"
+#include "../PerceptionServiceStandIn.h"
+#include "../SyntheticFrameSource.h"
+
+namespace MediaFoundationProvider {
+
+static const uint64_t PublishedFrames = 200;
+
+// Publishes PublishedFrames synthetic frames and checks the service saw all of them in order and that reading,
+// converting and publishing them didn't allocate once the provider was warmed up
+static void CheckFrameDelivery(uint32_t conversionWorkers, bool pairIllumination)
+{
+    SyntheticFrameSettings settings = {};
+    settings.Format = FramePixelFormat::YUY2;
+    settings.Width = 64;
+    settings.Height = 48;
+    settings.FrameRate = 30;
+    settings.Paced = false;
+    settings.AlternateIllumination = true;
+
+    std::shared_ptr<SyntheticFrameSource> source = std::make_shared<SyntheticFrameSource>();
+    TEST_CHECK(source->Open(settings));
+
+    // The service's call log grows with every frame, which would count as allocations of the frame path
+    PerceptionServiceStandIn service;
+    service.SetCallLogLimit(0);
+    {
+        HeadlessFrameProvider provider("Provider", &service, source, source->GetFrameLayout());
+        TEST_CHECK(service.IsRegistered("Provider"));
+
+        provider.SetIlluminationPairing(pairIllumination, 10000000 / settings.FrameRate);
+        TEST_CHECK(provider.SetConversionWorkers(conversionWorkers));
+        TEST_CHECK(provider.Start());
+        TEST_CHECK(service.WaitForFrames("Provider", PublishedFrames, std::chrono::seconds(30)));
+        provider.Stop();
+
+        TEST_CHECK(provider.GetSteadyStateAllocations() == 0);
+
+        if (pairIllumination)
+        {
+            TEST_CHECK(provider.GetPairingStats().PairsPublished >= PublishedFrames / 2);
+        }
+    }
+
+    const FrameDeliveryStats stats = service.GetDeliveryStats("Provider");
+    TEST_CHECK(stats.FramesPublished >= PublishedFrames);
+    TEST_CHECK(stats.FramesOutOfOrder == 0);
+    TEST_CHECK(stats.FramesLost == 0);
+}
+
+// The steady-state allocation checks only count with FRAME_PIPELINE_COUNT_ALLOCATIONS, see PipelineTest.h
+PIPELINE_TEST(HeadlessFrameProviderAllocationsAreCounted)
+{
+    TEST_CHECK(IsAllocationCountingEnabled());
+}
+
+PIPELINE_TEST(HeadlessFrameProviderPublishesEveryFrameInOrder)
+{
+    CheckFrameDelivery(1, false);
+}
+
+PIPELINE_TEST(HeadlessFrameProviderPublishesConvertedInParallelInOrder)
+{
+    CheckFrameDelivery(3, false);
+}
+
+PIPELINE_TEST(HeadlessFrameProviderPublishesPairsInOrder)
+{
+    CheckFrameDelivery(1, true);
+    CheckFrameDelivery(3, true);
+}
+
+} // end namespace
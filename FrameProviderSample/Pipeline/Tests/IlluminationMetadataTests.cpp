@@ -0,0 +1,189 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "PipelineTest.h"
+#include "../IlluminationMetadata.h"
+
+#include <cstring>
+
+namespace MediaFoundationProvider {
+
+// UVC metadata buffer of a lit frame as MF_CAPTURE_METADATA_FRAME_RAWSTREAM hands it over: the standard UVC payload
+// header item (MetadataId_UsbVideoHeader, 12 bytes of payload header padded to 8 bytes) followed by the sample
+// sensor's item holding the illumination flags and its frame counter
+static const uint8_t LitCaptureMetadata[] =
+{
+    0x02, 0x00, 0x00, 0x00,  0x14, 0x00, 0x00, 0x00,                   // MetadataId_UsbVideoHeader, Size 20
+    0x0C, 0x8D, 0x40, 0x1F,  0x6B, 0x02, 0x5A, 0x31,  0x9C, 0x27, 0xE5, 0x03,
+    0x00, 0x00, 0x00, 0x00,                                             // Padding
+    0x00, 0x10, 0x00, 0x80,  0x10, 0x00, 0x00, 0x00,                   // SampleCaptureMetadataId, Size 16
+    0x01, 0x00, 0x00, 0x00,  0x2A, 0x00, 0x00, 0x00,                   // Illumination enabled, frame 42
+};
+
+static const uint8_t UnlitCaptureMetadata[] =
+{
+    0x02, 0x00, 0x00, 0x00,  0x14, 0x00, 0x00, 0x00,
+    0x0C, 0x8D, 0x60, 0x20,  0x6B, 0x02, 0x7A, 0x42,  0x9C, 0x27, 0xE6, 0x03,
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x10, 0x00, 0x80,  0x10, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00,  0x2B, 0x00, 0x00, 0x00,                   // Illumination disabled, frame 43
+};
+
+static IlluminationMetadataInput GetCaptureMetadataInput(const uint8_t* metadata, uint32_t length)
+{
+    IlluminationMetadataInput input = {};
+    input.CaptureMetadata = metadata;
+    input.CaptureMetadataLength = length;
+    return input;
+}
+
+static const IlluminationMetadataParser* FindParser(uint32_t subtypeFourCC, IlluminationMetadataLocation location)
+{
+    const IlluminationMetadataParser* parsers[MaxIlluminationMetadataParsers];
+    const uint32_t parserCount = FindIlluminationMetadataParsers(subtypeFourCC, parsers, MaxIlluminationMetadataParsers);
+
+    for (uint32_t i = 0; i < parserCount; i++)
+    {
+        if (parsers[i]->Location == location) return parsers[i];
+    }
+    return nullptr;
+}
+
+PIPELINE_TEST(IlluminationMetadataParsersAreSelectedBySubtype)
+{
+    const IlluminationMetadataParser* parsers[MaxIlluminationMetadataParsers];
+
+    // Capture metadata is tried first and for any subtype
+    TEST_CHECK(FindIlluminationMetadataParsers(FourCCYUY2, parsers, MaxIlluminationMetadataParsers) == 2);
+    TEST_CHECK(parsers[0]->Location == IlluminationMetadataLocation::CaptureMetadata);
+    TEST_CHECK(parsers[1]->Location == IlluminationMetadataLocation::EmbeddedLine);
+    TEST_CHECK(parsers[1]->SubtypeFourCC == FourCCYUY2);
+
+    TEST_CHECK(FindIlluminationMetadataParsers(0x47504A4D /* MJPG */, parsers, MaxIlluminationMetadataParsers) == 1);
+    TEST_CHECK(parsers[0]->Location == IlluminationMetadataLocation::CaptureMetadata);
+
+    TEST_CHECK(FindIlluminationMetadataParsers(FourCCNV12, parsers, 1) == 1);
+}
+
+PIPELINE_TEST(IlluminationMetadataReadsCaptureMetadata)
+{
+    const IlluminationMetadataParser* parser = FindParser(FourCCYUY2, IlluminationMetadataLocation::CaptureMetadata);
+    TEST_CHECK(parser != nullptr);
+    if (parser == nullptr) return;
+
+    bool illuminated = false;
+    TEST_CHECK(parser->Parse(GetCaptureMetadataInput(LitCaptureMetadata, sizeof(LitCaptureMetadata)), illuminated));
+    TEST_CHECK(illuminated);
+
+    TEST_CHECK(parser->Parse(GetCaptureMetadataInput(UnlitCaptureMetadata, sizeof(UnlitCaptureMetadata)), illuminated));
+    TEST_CHECK(!illuminated);
+
+    // Without the sensor's item, e.g. a frame from a camera that only sends the standard header
+    TEST_CHECK(!parser->Parse(GetCaptureMetadataInput(LitCaptureMetadata, 24), illuminated));
+    TEST_CHECK(!parser->Parse(GetCaptureMetadataInput(nullptr, 0), illuminated));
+}
+
+PIPELINE_TEST(IlluminationMetadataRejectsMalformedCaptureMetadata)
+{
+    const IlluminationMetadataParser* parser = FindParser(FourCCYUY2, IlluminationMetadataLocation::CaptureMetadata);
+    TEST_CHECK(parser != nullptr);
+    if (parser == nullptr) return;
+
+    bool illuminated = false;
+    uint8_t metadata[sizeof(LitCaptureMetadata)];
+
+    // The sensor's item is cut short
+    TEST_CHECK(!parser->Parse(GetCaptureMetadataInput(LitCaptureMetadata, sizeof(LitCaptureMetadata) - 4), illuminated));
+
+    // An item smaller than its header would never advance
+    memcpy(metadata, LitCaptureMetadata, sizeof(metadata));
+    metadata[4] = 0x04;
+    TEST_CHECK(!parser->Parse(GetCaptureMetadataInput(metadata, sizeof(metadata)), illuminated));
+
+    // An item larger than the buffer
+    memcpy(metadata, LitCaptureMetadata, sizeof(metadata));
+    metadata[7] = 0x80;
+    TEST_CHECK(!parser->Parse(GetCaptureMetadataInput(metadata, sizeof(metadata)), illuminated));
+}
+
+// A YUY2 frame of 8x4 pixels whose last line is the sample sensor's embedded line
+static void FillEmbeddedLineFrame(uint8_t (&frame)[16 * 4], bool illuminated)
+{
+    static const uint8_t EmbeddedLine[] =
+    {
+        0x49, 0x4C, 0x4C, 0x4D,  0x07, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00,   // "ILLM", frame 7, flags
+        0x10, 0x80, 0x10, 0x80,
+    };
+
+    memset(frame, 0x80, sizeof(frame));
+    memcpy(frame + 16 * 3, EmbeddedLine, sizeof(EmbeddedLine));
+    frame[16 * 3 + 8] = illuminated ? 0x01 : 0x00;
+}
+
+PIPELINE_TEST(IlluminationMetadataReadsEmbeddedLine)
+{
+    const IlluminationMetadataParser* parser = FindParser(FourCCYUY2, IlluminationMetadataLocation::EmbeddedLine);
+    TEST_CHECK(parser != nullptr);
+    if (parser == nullptr) return;
+
+    uint8_t frame[16 * 4];
+    IlluminationMetadataInput input = {};
+    input.Frame = frame;
+    input.FrameLength = sizeof(frame);
+    input.Layout.Format = FramePixelFormat::YUY2;
+    input.Layout.Width = 8;
+    input.Layout.Height = 4;
+    input.Layout.Stride = 16;
+
+    bool illuminated = false;
+    FillEmbeddedLineFrame(frame, true);
+    TEST_CHECK(parser->Parse(input, illuminated));
+    TEST_CHECK(illuminated);
+
+    FillEmbeddedLineFrame(frame, false);
+    TEST_CHECK(parser->Parse(input, illuminated));
+    TEST_CHECK(!illuminated);
+
+    // A frame without the embedded line
+    frame[16 * 3] = 0x10;
+    TEST_CHECK(!parser->Parse(input, illuminated));
+}
+
+PIPELINE_TEST(IlluminationMetadataDoesntReadPastFrame)
+{
+    const IlluminationMetadataParser* parser = FindParser(FourCCYUY2, IlluminationMetadataLocation::EmbeddedLine);
+    TEST_CHECK(parser != nullptr);
+    if (parser == nullptr) return;
+
+    uint8_t frame[16 * 4];
+    FillEmbeddedLineFrame(frame, true);
+
+    IlluminationMetadataInput input = {};
+    input.Frame = frame;
+    input.Layout.Format = FramePixelFormat::YUY2;
+    input.Layout.Width = 8;
+    input.Layout.Height = 4;
+    input.Layout.Stride = 16;
+
+    // The buffer ends inside the embedded line
+    bool illuminated = false;
+    input.FrameLength = 16 * 3 + 8;
+    TEST_CHECK(!parser->Parse(input, illuminated));
+
+    // Rows too short to hold the metadata
+    input.FrameLength = sizeof(frame);
+    input.Layout.Stride = 8;
+    input.Layout.Width = 4;
+    TEST_CHECK(!parser->Parse(input, illuminated));
+}
+
+} // end namespace
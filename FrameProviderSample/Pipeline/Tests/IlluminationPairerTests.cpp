@@ -0,0 +1,80 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "PipelineTest.h"
+#include "../IlluminationPairer.h"
+
+namespace MediaFoundationProvider {
+
+static const int64_t FrameInterval = 333333;    // 30 fps
+
+PIPELINE_TEST(IlluminationPairerPublishesAlternatingFrames)
+{
+    IlluminationPairer pairer;
+    pairer.SetFrameInterval(FrameInterval);
+
+    for (int64_t pair = 0; pair < 10; pair++)
+    {
+        const int64_t timestamp = pair * 2 * FrameInterval;
+        TEST_CHECK(pairer.Submit(timestamp, true) == PairingDecision::HoldFirst);
+        TEST_CHECK(pairer.IsHoldingFrame());
+        TEST_CHECK(pairer.Submit(timestamp + FrameInterval, false) == PairingDecision::PublishPair);
+        TEST_CHECK(!pairer.IsHoldingFrame());
+    }
+
+    TEST_CHECK(pairer.GetStats().PairsPublished == 10);
+    TEST_CHECK(pairer.GetStats().OrphansDropped == 0);
+}
+
+PIPELINE_TEST(IlluminationPairerDropsOrphans)
+{
+    IlluminationPairer pairer;
+    pairer.SetFrameInterval(FrameInterval);
+
+    // A pair never starts with an unilluminated frame
+    TEST_CHECK(pairer.Submit(0, false) == PairingDecision::DropFrame);
+
+    // The unilluminated frame of the first pair was lost, the next illuminated frame takes the held frame's place
+    TEST_CHECK(pairer.Submit(FrameInterval, true) == PairingDecision::HoldFirst);
+    TEST_CHECK(pairer.Submit(3 * FrameInterval, true) == PairingDecision::DropHeldAndHoldFirst);
+    TEST_CHECK(pairer.Submit(4 * FrameInterval, false) == PairingDecision::PublishPair);
+
+    // A partner more than 1.5 frame intervals late belongs to neither pair
+    TEST_CHECK(pairer.Submit(5 * FrameInterval, true) == PairingDecision::HoldFirst);
+    TEST_CHECK(pairer.Submit(7 * FrameInterval, false) == PairingDecision::DropHeldAndFrame);
+
+    // So does one from before the held frame
+    TEST_CHECK(pairer.Submit(9 * FrameInterval, true) == PairingDecision::HoldFirst);
+    TEST_CHECK(pairer.Submit(8 * FrameInterval, false) == PairingDecision::DropHeldAndFrame);
+
+    const PairingStats stats = pairer.GetStats();
+    TEST_CHECK(stats.PairsPublished == 1);
+    TEST_CHECK(stats.OrphansDropped == 6);
+}
+
+PIPELINE_TEST(IlluminationPairerResetDropsHeldFrame)
+{
+    IlluminationPairer pairer;
+    pairer.SetFrameInterval(FrameInterval);
+
+    TEST_CHECK(pairer.Submit(0, true) == PairingDecision::HoldFirst);
+    pairer.Reset();
+    TEST_CHECK(!pairer.IsHoldingFrame());
+    TEST_CHECK(pairer.GetStats().OrphansDropped == 1);
+
+    // The stream restarts with new timestamps
+    TEST_CHECK(pairer.Submit(-FrameInterval, false) == PairingDecision::DropFrame);
+    TEST_CHECK(pairer.Submit(0, true) == PairingDecision::HoldFirst);
+    TEST_CHECK(pairer.Submit(FrameInterval, false) == PairingDecision::PublishPair);
+}
+
+} // end namespace
@@ -0,0 +1,96 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "PipelineTest.h"
+#include "../IlluminationPhaseDetector.h"
+
+namespace MediaFoundationProvider {
+
+static const double LitLuminance = 120.0;
+static const double UnlitLuminance = 60.0;
+
+PIPELINE_TEST(IlluminationPhaseDetectorLocksOntoAlternatingFrames)
+{
+    IlluminationPhaseDetector detector;
+    uint32_t framesUntilLocked = 0;
+
+    // Frames 1, 3, 5, ... are lit
+    for (uint32_t frame = 0; frame < 20; frame++)
+    {
+        const bool lit = (frame & 1) != 0;
+        bool illuminated = false;
+        const bool locked = detector.Submit(lit ? LitLuminance : UnlitLuminance, illuminated);
+
+        if (!locked)
+        {
+            framesUntilLocked++;
+        }
+        else
+        {
+            TEST_CHECK(illuminated == lit);
+        }
+    }
+
+    TEST_CHECK(detector.IsLocked());
+    TEST_CHECK(framesUntilLocked <= IlluminationPhaseDetector::LockFrames + 1);
+    TEST_CHECK(detector.GetRephases() == 0);
+}
+
+PIPELINE_TEST(IlluminationPhaseDetectorRephasesAfterDroppedFrame)
+{
+    IlluminationPhaseDetector detector;
+    bool illuminated = false;
+    uint32_t frame = 0;
+
+    for (; frame < 10; frame++)
+    {
+        detector.Submit(((frame & 1) != 0) ? LitLuminance : UnlitLuminance, illuminated);
+    }
+    TEST_CHECK(detector.IsLocked());
+
+    // Frame 10 was dropped, so from here on the frames the detector counts as even are lit
+    uint32_t wrongFrames = 0;
+    for (frame = 11; frame < 30; frame++)
+    {
+        const bool lit = (frame & 1) != 0;
+        detector.Submit(lit ? LitLuminance : UnlitLuminance, illuminated);
+        wrongFrames += (illuminated != lit) ? 1 : 0;
+    }
+
+    TEST_CHECK(detector.IsLocked());
+    TEST_CHECK(detector.GetRephases() == 1);
+    TEST_CHECK(wrongFrames <= IlluminationPhaseDetector::RephaseFrames);
+}
+
+PIPELINE_TEST(IlluminationPhaseDetectorUnlocksWithoutIllumination)
+{
+    IlluminationPhaseDetector detector;
+    bool illuminated = false;
+
+    for (uint32_t frame = 0; frame < 10; frame++)
+    {
+        detector.Submit(((frame & 1) != 0) ? LitLuminance : UnlitLuminance, illuminated);
+    }
+    TEST_CHECK(detector.IsLocked());
+
+    // The illuminator is off; after the change from the last lit frame, brightness changes too little to tell the
+    // frames apart
+    detector.Submit(UnlitLuminance, illuminated);
+    for (uint32_t frame = 0; frame < IlluminationPhaseDetector::UnlockFrames; frame++)
+    {
+        TEST_CHECK(detector.IsLocked());
+        detector.Submit(UnlitLuminance + ((frame & 1) != 0 ? 1.0 : 0.0), illuminated);
+    }
+    TEST_CHECK(!detector.IsLocked());
+}
+
+} // end namespace
@@ -0,0 +1,291 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "PipelineTest.h"
+#include "../Mft0SampleProcessor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+static const uint32_t TestWidth = 8;
+static const uint32_t TestHeight = 4;
+static const int32_t TestStride = 2 * TestWidth;            // YUY2 without padding
+
+// A YUY2 frame whose luma in row y, column x is 16 * y + x; chroma is 0x80
+static void FillYUY2Frame(uint8_t (&frame)[TestStride * TestHeight])
+{
+    for (uint32_t y = 0; y < TestHeight; y++)
+    {
+        for (uint32_t x = 0; x < TestWidth; x++)
+        {
+            frame[y * TestStride + 2 * x] = static_cast<uint8_t>(16 * y + x);
+            frame[y * TestStride + 2 * x + 1] = 0x80;
+        }
+    }
+}
+
+static bool IsGray8OfYUY2Frame(const uint8_t* gray8, int32_t stride)
+{
+    for (uint32_t y = 0; y < TestHeight; y++)
+    {
+        for (uint32_t x = 0; x < TestWidth; x++)
+        {
+            if (gray8[static_cast<intptr_t>(y) * stride + x] != 16 * y + x) return false;
+        }
+    }
+    return true;
+}
+
+PIPELINE_TEST(Mft0SettingsFollowInputType)
+{
+    Mft0ProcessingSettings settings;
+
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, TestWidth, TestHeight, TestStride, true, true, settings));
+    TEST_CHECK(settings.ConvertToGray8 && settings.MeasureLuma);
+    TEST_CHECK(settings.Layout.Format == FramePixelFormat::YUY2 && settings.Layout.Stride == TestStride);
+
+    // L8 frames don't need converting, which fails a required conversion but still measures them
+    TEST_CHECK(!GetMft0ProcessingSettings(FourCCL8, TestWidth, TestHeight, TestWidth, true, true, settings));
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCL8, TestWidth, TestHeight, TestWidth, false, true, settings));
+    TEST_CHECK(!settings.ConvertToGray8 && settings.MeasureLuma);
+
+    // Without a known stride the luma plane can't be found
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCNV12, TestWidth, TestHeight, 0, false, true, settings));
+    TEST_CHECK(!settings.MeasureLuma);
+}
+
+PIPELINE_TEST(Mft0ConvertsAndMeasuresYUY2)
+{
+    Mft0ProcessingSettings settings;
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, TestWidth, TestHeight, TestStride, true, true, settings));
+
+    uint8_t input[TestStride * TestHeight];
+    uint8_t output[TestWidth * TestHeight];
+    FillYUY2Frame(input);
+    memset(output, 0, sizeof(output));
+
+    Mft0SampleFrame frame = { input, TestStride, sizeof(input), nullptr, 0 };
+    Mft0Gray8Frame gray8 = { output, TestWidth };
+    Mft0SampleResult result;
+
+    TEST_CHECK(ProcessMft0Sample(settings, frame, &gray8, result));
+    TEST_CHECK(result.Converted && result.LumaMeasured);
+    TEST_CHECK(!result.IlluminationTagged);
+    TEST_CHECK(IsGray8OfYUY2Frame(output, TestWidth));
+
+    TEST_CHECK(result.Statistics.Pixels == TestWidth * TestHeight);
+    TEST_CHECK(result.Statistics.Minimum == 0 && result.Statistics.Maximum == 16 * (TestHeight - 1) + TestWidth - 1);
+    TEST_CHECK(result.Statistics.Histogram[0] == TestWidth && result.Statistics.Histogram[3] == TestWidth);
+}
+
+PIPELINE_TEST(Mft0ConvertsBottomUpFrames)
+{
+    Mft0ProcessingSettings settings;
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, TestWidth, TestHeight, -TestStride, true, false, settings));
+
+    // The top row is last in memory
+    uint8_t topDown[TestStride * TestHeight];
+    uint8_t input[TestStride * TestHeight];
+    uint8_t output[TestWidth * TestHeight];
+    FillYUY2Frame(topDown);
+    for (uint32_t y = 0; y < TestHeight; y++)
+    {
+        memcpy(input + (TestHeight - 1 - y) * TestStride, topDown + y * TestStride, TestStride);
+    }
+
+    Mft0SampleFrame frame = { input + (TestHeight - 1) * TestStride, -TestStride, sizeof(input), nullptr, 0 };
+    Mft0Gray8Frame gray8 = { output, TestWidth };
+    Mft0SampleResult result;
+
+    TEST_CHECK(ProcessMft0Sample(settings, frame, &gray8, result));
+    TEST_CHECK(result.Converted && !result.LumaMeasured);
+    TEST_CHECK(IsGray8OfYUY2Frame(output, TestWidth));
+}
+
+PIPELINE_TEST(Mft0TagsFramesFromEmbeddedLine)
+{
+    Mft0ProcessingSettings settings;
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, TestWidth, TestHeight, TestStride, false, false, settings));
+
+    uint8_t input[TestStride * TestHeight];
+    const uint32_t embeddedLine[] = { SampleEmbeddedLineMagic, 7, SampleIlluminationFlagEnabled };
+    FillYUY2Frame(input);
+    memcpy(input + (TestHeight - 1) * TestStride, embeddedLine, sizeof(embeddedLine));
+
+    Mft0SampleFrame frame = { input, TestStride, sizeof(input), nullptr, 0 };
+    Mft0SampleResult result;
+
+    TEST_CHECK(ProcessMft0Sample(settings, frame, nullptr, result));
+    TEST_CHECK(result.IlluminationTagged && result.IlluminationEnabled);
+    TEST_CHECK(!result.Converted && !result.LumaMeasured);
+
+    // Embedded lines aren't looked for in bottom-up frames
+    frame.ScanLine0 = input + (TestHeight - 1) * TestStride;
+    frame.Stride = -TestStride;
+    TEST_CHECK(ProcessMft0Sample(settings, frame, nullptr, result));
+    TEST_CHECK(!result.IlluminationTagged);
+}
+
+PIPELINE_TEST(Mft0DropsFramesItCantConvert)
+{
+    Mft0ProcessingSettings settings;
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, TestWidth, TestHeight, TestStride, true, false, settings));
+
+    uint8_t input[TestStride * TestHeight];
+    FillYUY2Frame(input);
+
+    Mft0SampleFrame frame = { input, TestStride, sizeof(input), nullptr, 0 };
+    Mft0Gray8Frame gray8 = { nullptr, TestWidth };
+    Mft0SampleResult result;
+
+    // No output frame to convert into, or no input frame to convert
+    TEST_CHECK(!ProcessMft0Sample(settings, frame, nullptr, result));
+    TEST_CHECK(!ProcessMft0Sample(settings, frame, &gray8, result));
+
+    uint8_t output[TestWidth * TestHeight];
+    gray8.ScanLine0 = output;
+    frame.ScanLine0 = nullptr;
+    TEST_CHECK(!ProcessMft0Sample(settings, frame, &gray8, result));
+}
+
+PIPELINE_TEST(Mft0SkipsFramesShorterThanTheirPlane)
+{
+    Mft0ProcessingSettings settings;
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, TestWidth, TestHeight, TestStride, true, true, settings));
+
+    // A truncated sample on the heap, so reading past it is caught by the address sanitizer
+    uint8_t frameData[TestStride * TestHeight];
+    const uint32_t embeddedLine[] = { SampleEmbeddedLineMagic, 7, SampleIlluminationFlagEnabled };
+    FillYUY2Frame(frameData);
+    memcpy(frameData + (TestHeight - 1) * TestStride, embeddedLine, sizeof(embeddedLine));
+    std::vector<uint8_t> input(frameData, frameData + TestStride * TestHeight - 1);
+
+    uint8_t output[TestWidth * TestHeight];
+    Mft0SampleFrame frame = { input.data(), TestStride, static_cast<uint32_t>(input.size()), nullptr, 0 };
+    Mft0Gray8Frame gray8 = { output, TestWidth };
+    Mft0SampleResult result;
+
+    // The frame can't be converted, but the embedded line is still within the buffer
+    TEST_CHECK(!ProcessMft0Sample(settings, frame, &gray8, result));
+    TEST_CHECK(result.IlluminationTagged && !result.Converted);
+
+    // Without converting the frame is passed on unmeasured
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, TestWidth, TestHeight, TestStride, false, true, settings));
+    TEST_CHECK(ProcessMft0Sample(settings, frame, nullptr, result));
+    TEST_CHECK(!result.LumaMeasured);
+
+    // Without room for the embedded line the frame isn't tagged either
+    input.resize(TestStride * (TestHeight - 1) + 4);
+    frame.ScanLine0 = input.data();
+    frame.Length = static_cast<uint32_t>(input.size());
+    TEST_CHECK(ProcessMft0Sample(settings, frame, nullptr, result));
+    TEST_CHECK(!result.IlluminationTagged && !result.LumaMeasured);
+
+    // A padded frame only needs the pixels of its last row
+    const int32_t paddedStride = TestStride + 16;
+    input.assign(paddedStride * (TestHeight - 1) + TestStride, 0x10);
+    frame.ScanLine0 = input.data();
+    frame.Stride = paddedStride;
+    frame.Length = static_cast<uint32_t>(input.size());
+    TEST_CHECK(ProcessMft0Sample(settings, frame, nullptr, result));
+    TEST_CHECK(result.LumaMeasured && result.Statistics.Pixels == TestWidth * TestHeight);
+}
+
+// Wide enough for the SIMD kernels to flush their histogram lanes, 255 steps of 16 pixels, with a tail of 3 pixels
+static const uint32_t WideWidth = 4099;
+static const uint32_t WideHeight = 3;
+
+// Statistics of the luma samples computed one pixel at a time, the reference for the kernels
+static LumaStatistics MeasureLumaReference(const std::vector<uint8_t>& luma)
+{
+    LumaStatistics statistics;
+    statistics.Reset();
+    for (uint8_t value : luma)
+    {
+        statistics.Sum += value;
+        statistics.Pixels++;
+        statistics.Saturated += (value >= LumaStatistics::SaturationLevel) ? 1 : 0;
+        if (value < statistics.Minimum) statistics.Minimum = value;
+        if (value > statistics.Maximum) statistics.Maximum = value;
+        statistics.Histogram[value >> 4]++;
+    }
+    return statistics;
+}
+
+static bool IsSameStatistics(const LumaStatistics& statistics, const LumaStatistics& reference)
+{
+    return statistics.Sum == reference.Sum &&
+        statistics.Pixels == reference.Pixels &&
+        statistics.Saturated == reference.Saturated &&
+        statistics.Minimum == reference.Minimum &&
+        statistics.Maximum == reference.Maximum &&
+        memcmp(statistics.Histogram, reference.Histogram, sizeof(reference.Histogram)) == 0;
+}
+
+// Converts and measures a wide YUY2 frame of the given luma every way MFT0 does and compares the results to the reference
+static void CheckWideFrame(const std::vector<uint8_t>& luma)
+{
+    const int32_t stride = 2 * WideWidth;
+    std::vector<uint8_t> input(static_cast<size_t>(stride) * WideHeight);
+    for (size_t i = 0; i < luma.size(); i++)
+    {
+        input[2 * i] = luma[i];
+        input[2 * i + 1] = 0x80;
+    }
+    const LumaStatistics reference = MeasureLumaReference(luma);
+
+    Mft0ProcessingSettings settings;
+    std::vector<uint8_t> output(luma.size(), 0);
+    Mft0SampleFrame frame = { input.data(), stride, static_cast<uint32_t>(input.size()), nullptr, 0 };
+    Mft0Gray8Frame gray8 = { output.data(), WideWidth };
+    Mft0SampleResult result;
+
+    // ExtractLumaYUY2, then MeasureLuma on the converted rows
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, WideWidth, WideHeight, stride, true, true, settings));
+    TEST_CHECK(ProcessMft0Sample(settings, frame, &gray8, result));
+    TEST_CHECK(output == luma);
+    TEST_CHECK(result.LumaMeasured && IsSameStatistics(result.Statistics, reference));
+
+    // MeasureLumaYUY2
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCYUY2, WideWidth, WideHeight, stride, false, true, settings));
+    TEST_CHECK(ProcessMft0Sample(settings, frame, nullptr, result));
+    TEST_CHECK(result.LumaMeasured && IsSameStatistics(result.Statistics, reference));
+
+    // MeasureLuma on L8 rows
+    Mft0SampleFrame l8Frame = { output.data(), static_cast<int32_t>(WideWidth), static_cast<uint32_t>(output.size()), nullptr, 0 };
+    TEST_CHECK(GetMft0ProcessingSettings(FourCCL8, WideWidth, WideHeight, WideWidth, false, true, settings));
+    TEST_CHECK(ProcessMft0Sample(settings, l8Frame, nullptr, result));
+    TEST_CHECK(result.LumaMeasured && IsSameStatistics(result.Statistics, reference));
+}
+
+PIPELINE_TEST(Mft0KernelsMatchScalarReferenceOnWideFrames)
+{
+    std::vector<uint8_t> luma(static_cast<size_t>(WideWidth) * WideHeight);
+
+    // Every level in a scattered order, so each lane sees every histogram bin and the saturation level
+    uint32_t state = 1;
+    for (uint8_t& value : luma)
+    {
+        state = state * 1664525u + 1013904223u;
+        value = static_cast<uint8_t>(state >> 24);
+    }
+    CheckWideFrame(luma);
+
+    // A saturated frame fills a single bin in every lane, which wraps if the lanes aren't flushed in time
+    std::fill(luma.begin(), luma.end(), static_cast<uint8_t>(255));
+    CheckWideFrame(luma);
+}
+
+} // end namespace
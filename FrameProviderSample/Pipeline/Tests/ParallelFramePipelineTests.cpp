@@ -0,0 +1,183 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "PipelineTest.h"
+#include "../ParallelFramePipeline.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace MediaFoundationProvider {
+
+static const uint32_t TestWidth = 8;
+static const uint32_t TestHeight = 4;
+static const uint32_t TestWorkers = 2;
+static const uint32_t TestSlots = TestWorkers + ParallelFramePipeline::ReorderSlots;
+static const uint32_t TestFrames = 200;
+
+// Frames converted into buffers owned by the test, like the frames SampleFrameProvider publishes
+struct DestinationFrames
+{
+    ParallelFramePipeline* Pipeline;
+    uint8_t Inputs[TestSlots][TestWidth * TestHeight];
+    uint8_t Destinations[TestSlots][TestWidth * TestHeight];
+    std::atomic<uint32_t> FramesReturned;  // Also read by the submitting thread while frames are handed to the proc
+    std::atomic<uint32_t> InputsReleased;
+    bool InOrder;
+};
+
+// Checks that the frame is the next one in capture order and was converted into the destination of its slot
+static void ReleaseReturnedFrame(DestinationFrames& frames, const ParallelFrame& frame)
+{
+    const uint32_t sequence = frames.FramesReturned;
+
+    frames.InOrder &= frame.Processed && frame.Result.Sequence == sequence && frame.ReadTime == sequence;
+    frames.InOrder &= frame.Data == frames.Destinations[frame.Slot] && frame.Data[0] == static_cast<uint8_t>(sequence);
+    frames.FramesReturned = sequence + 1;
+    frames.Pipeline->Release(frame);
+}
+
+static void OnFrameReady(void* context, const ParallelFrame& frame)
+{
+    ReleaseReturnedFrame(*static_cast<DestinationFrames*>(context), frame);
+}
+
+// Overwrites the slot's input, which the pipeline must no longer read once the frame was converted
+static void OnInputReleased(void* context, uint32_t slot)
+{
+    DestinationFrames& frames = *static_cast<DestinationFrames*>(context);
+
+    memset(frames.Inputs[slot], 0xFF, sizeof(frames.Inputs[slot]));
+    frames.InputsReleased++;
+}
+
+// Submits TestFrames Gray8 frames whose pixels are their sequence number; each slot's frame is read in place from an
+// input of its own until the pipeline releases it
+static void ConvertIntoDestinations(WorkStealingExecutor* executor, bool frameReady)
+{
+    FramePipeline framePipeline;
+    TEST_CHECK(framePipeline.Configure(GetPackedFrameLayout(FramePixelFormat::Gray8, TestWidth, TestHeight)));
+
+    ParallelFramePipeline parallelPipeline(framePipeline);
+    DestinationFrames frames;
+    frames.Pipeline = &parallelPipeline;
+    frames.FramesReturned = 0;
+    frames.InputsReleased = 0;
+    frames.InOrder = true;
+    if (frameReady)
+    {
+        parallelPipeline.SetFrameReadyProc(&OnFrameReady, &frames);
+    }
+    parallelPipeline.SetInputReleasedProc(&OnInputReleased, &frames);
+    TEST_CHECK(parallelPipeline.Start(TestWorkers, executor, false));
+
+    CapturedFrame frame = {};
+    frame.Data = frames.Inputs[0];
+    frame.Length = sizeof(frames.Inputs[0]);
+    frame.Layout = framePipeline.GetSourceLayout();
+
+    // Without a destination there's nothing to convert into
+    TEST_CHECK(!parallelPipeline.Submit(frame, 0));
+
+    ParallelFrame returned;
+    for (uint32_t i = 0; i < TestFrames; i++)
+    {
+        // Slots are released by the frame ready proc on the converting threads
+        while (!parallelPipeline.CanSubmit())
+        {
+            if (frameReady)
+            {
+                std::this_thread::yield();
+            }
+            else if (parallelPipeline.Next(returned, true))
+            {
+                ReleaseReturnedFrame(frames, returned);
+            }
+        }
+
+        const uint32_t slot = parallelPipeline.GetNextSlot();
+        memset(frames.Inputs[slot], static_cast<int>(i & 0xFF), sizeof(frames.Inputs[slot]));
+        frame.Data = frames.Inputs[slot];
+        TEST_CHECK(parallelPipeline.Submit(frame, i, frames.Destinations[slot], sizeof(frames.Destinations[slot])));
+    }
+
+    if (frameReady)
+    {
+        // Next doesn't return frames that are handed to the proc
+        TEST_CHECK(!parallelPipeline.Next(returned, false));
+        while (frames.FramesReturned != TestFrames)
+        {
+            std::this_thread::yield();
+        }
+    }
+    while (parallelPipeline.Next(returned, true))
+    {
+        ReleaseReturnedFrame(frames, returned);
+    }
+    parallelPipeline.Stop();
+
+    TEST_CHECK(frames.InOrder);
+    TEST_CHECK(frames.FramesReturned == TestFrames);
+    TEST_CHECK(frames.InputsReleased == TestFrames);
+}
+
+PIPELINE_TEST(ParallelPipelineConvertsIntoDestinations)
+{
+    ConvertIntoDestinations(nullptr, false);
+}
+
+PIPELINE_TEST(ParallelPipelineHandsFramesToFrameReadyProc)
+{
+    ConvertIntoDestinations(nullptr, true);
+
+    // Workers added while the executor runs take part like the ones it started with
+    WorkStealingExecutor executor;
+    TEST_CHECK(executor.Start(1));
+    ConvertIntoDestinations(&executor, true);
+    TEST_CHECK(executor.AddWorkers(2));
+    TEST_CHECK(executor.GetWorkerCount() == 3);
+    ConvertIntoDestinations(&executor, true);
+    executor.Stop();
+}
+
+PIPELINE_TEST(ParallelPipelineReleasesInputsOfDroppedFrames)
+{
+    FramePipeline framePipeline;
+    TEST_CHECK(framePipeline.Configure(GetPackedFrameLayout(FramePixelFormat::Gray8, TestWidth, TestHeight)));
+
+    ParallelFramePipeline parallelPipeline(framePipeline);
+    DestinationFrames frames;
+    frames.Pipeline = &parallelPipeline;
+    frames.InputsReleased = 0;
+    parallelPipeline.SetInputReleasedProc(&OnInputReleased, &frames);
+    TEST_CHECK(parallelPipeline.Start(TestWorkers, nullptr, false));
+
+    CapturedFrame frame = {};
+    frame.Length = sizeof(frames.Inputs[0]);
+    frame.Layout = framePipeline.GetSourceLayout();
+
+    // Fill every slot and stop without taking a frame; whether or not a frame was converted, its input is released
+    uint32_t submitted = 0;
+    while (parallelPipeline.CanSubmit())
+    {
+        const uint32_t slot = parallelPipeline.GetNextSlot();
+        frame.Data = frames.Inputs[slot];
+        TEST_CHECK(parallelPipeline.Submit(frame, submitted, frames.Destinations[slot], sizeof(frames.Destinations[slot])));
+        submitted++;
+    }
+    parallelPipeline.Stop();
+
+    TEST_CHECK(submitted == TestSlots);
+    TEST_CHECK(frames.InputsReleased == submitted);
+}
+
+} // end namespace
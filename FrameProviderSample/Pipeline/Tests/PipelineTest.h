@@ -0,0 +1,66 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+// Deterministic tests of the portable frame processing logic in the Pipeline folder, built separately from the
+// provider DLL and MFT0, e.g.
+//     g++ -std=c++14 -g -pthread -fsanitize=address,undefined -DFRAME_PIPELINE_COUNT_ALLOCATIONS Pipeline/*.cpp Pipeline/Tests/*.cpp -o PipelineTests
+// FRAME_PIPELINE_COUNT_ALLOCATIONS is required, the tests fail if the steady-state frame path allocates
+// Each test registers itself with PIPELINE_TEST and reports failed checks with TEST_CHECK; see PipelineTestMain.cpp
+
+#include "../FrameSource.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MediaFoundationProvider {
+
+typedef void (*PipelineTestProc)();
+
+// Adds a test to the ones PipelineTestMain.cpp runs, in the order the tests are registered
+struct PipelineTestRegistration
+{
+    PipelineTestRegistration(const char* name, PipelineTestProc proc);
+};
+
+// Marks the running test as failed and prints the failed check
+void ReportTestFailure(const char* file, int line, const char* expression);
+
+// A file in the system's temporary directory that's deleted when the test is done with it
+class TestFile
+{
+public:
+
+    explicit TestFile(const char* name);
+    ~TestFile();
+
+    const PathChar* GetPath() const { return _path.c_str(); }
+
+    bool Read(std::vector<uint8_t>& data) const;
+    bool Write(const std::vector<uint8_t>& data) const;
+
+private:
+
+    std::basic_string<PathChar> _path;
+};
+
+} // end namespace
+
+#define PIPELINE_TEST(name) \
+    static void name(); \
+    static const ::MediaFoundationProvider::PipelineTestRegistration name##Registration(#name, name); \
+    static void name()
+
+#define TEST_CHECK(expression) \
+    ((expression) ? static_cast<void>(0) : ::MediaFoundationProvider::ReportTestFailure(__FILE__, __LINE__, #expression))
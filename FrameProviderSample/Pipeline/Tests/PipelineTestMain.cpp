@@ -0,0 +1,143 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+// Runs the tests registered with PIPELINE_TEST, see PipelineTest.h
+//
+// Usage: PipelineTests [test]
+// Prints one line per test and exits with 1 if any test failed
+
+#include "PipelineTest.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace MediaFoundationProvider {
+
+struct PipelineTest
+{
+    const char* Name;
+    PipelineTestProc Proc;
+};
+
+// Tests register from static initializers in other files, so the list is created on first use
+static std::vector<PipelineTest>& GetPipelineTests()
+{
+    static std::vector<PipelineTest> tests;
+    return tests;
+}
+
+static uint32_t s_failedChecks = 0;
+
+PipelineTestRegistration::PipelineTestRegistration(const char* name, PipelineTestProc proc)
+{
+    PipelineTest test = { name, proc };
+    GetPipelineTests().push_back(test);
+}
+
+void ReportTestFailure(const char* file, int line, const char* expression)
+{
+    s_failedChecks++;
+    printf("    %s(%d): check failed: %s\n", file, line, expression);
+}
+
+TestFile::TestFile(const char* name)
+{
+    // Named after the process as well, so test runs don't interfere with each other
+#ifdef _WIN32
+    wchar_t directory[MAX_PATH];
+    const DWORD length = GetTempPathW(MAX_PATH, directory);
+    _path.assign(directory, (length > 0 && length < MAX_PATH) ? length : 0);
+    _path += L"PipelineTests" + std::to_wstring(GetCurrentProcessId()) + L"_";
+    for (const char* current = name; *current != '\0'; current++)
+    {
+        _path += static_cast<wchar_t>(*current);
+    }
+#else
+    _path = "/tmp/PipelineTests" + std::to_string(getpid()) + "_" + name;
+#endif
+}
+
+TestFile::~TestFile()
+{
+#ifdef _WIN32
+    DeleteFileW(_path.c_str());
+#else
+    unlink(_path.c_str());
+#endif
+}
+
+bool TestFile::Read(std::vector<uint8_t>& data) const
+{
+#ifdef _WIN32
+    FILE* file = _wfopen(_path.c_str(), L"rb");
+#else
+    FILE* file = fopen(_path.c_str(), "rb");
+#endif
+    if (file == nullptr) return false;
+
+    data.clear();
+    uint8_t buffer[4096];
+    for (size_t read = fread(buffer, 1, sizeof(buffer), file); read > 0; read = fread(buffer, 1, sizeof(buffer), file))
+    {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+
+    const bool succeeded = ferror(file) == 0;
+    fclose(file);
+    return succeeded;
+}
+
+bool TestFile::Write(const std::vector<uint8_t>& data) const
+{
+#ifdef _WIN32
+    FILE* file = _wfopen(_path.c_str(), L"wb");
+#else
+    FILE* file = fopen(_path.c_str(), "wb");
+#endif
+    if (file == nullptr) return false;
+
+    const bool succeeded = data.empty() || fwrite(data.data(), data.size(), 1, file) == 1;
+    return (fclose(file) == 0) && succeeded;
+}
+
+} // end namespace
+
+using namespace MediaFoundationProvider;
+
+int main(int argc, char* argv[])
+{
+    const char* selectedTest = (argc > 1) ? argv[1] : nullptr;
+    uint32_t testsRun = 0;
+    uint32_t testsFailed = 0;
+
+    for (const PipelineTest& test : GetPipelineTests())
+    {
+        if (selectedTest != nullptr && strcmp(selectedTest, test.Name) != 0) continue;
+
+        const uint32_t failedChecks = s_failedChecks;
+        test.Proc();
+
+        const bool passed = (s_failedChecks == failedChecks);
+        printf("%s %s\n", passed ? "PASS" : "FAIL", test.Name);
+        testsRun++;
+        testsFailed += passed ? 0 : 1;
+    }
+
+    printf("%u of %u tests passed\n", testsRun - testsFailed, testsRun);
+    return (testsFailed == 0 && testsRun > 0) ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "WorkStealingExecutor.h"
+
+#include <algorithm>
+
+namespace MediaFoundationProvider {
+
+// The executor and index of the worker running on the current thread, see GetCurrentWorker
+static thread_local const WorkStealingExecutor* CurrentExecutor = nullptr;
+static thread_local uint32_t CurrentWorker = WorkStealingExecutor::AnyWorker;
+
+WorkStealingExecutor::WorkStealingExecutor() :
+    _workerCount(0),
+    _running(false),
+    _nextWorker(0),
+    _queuedTasks(0),
+    _idleWorkers(0),
+    _stopping(false),
+    _tasksRun(0),
+    _tasksStolen(0),
+    _tasksRejected(0)
+{
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    Stop();
+}
+
+bool WorkStealingExecutor::Start(uint32_t workerCount)
+{
+    if (IsRunning() || GetWorkerCount() != 0) return false;
+
+    if (workerCount == 0)
+    {
+        workerCount = GetDefaultWorkerCount();
+    }
+    if (workerCount > MaxWorkers) return false;
+
+    _stopping = false;
+    _running = true;
+
+    return AddWorkers(workerCount);
+}
+
+bool WorkStealingExecutor::AddWorkers(uint32_t workerCount)
+{
+    const uint32_t firstWorker = GetWorkerCount();
+    if (!IsRunning() || workerCount > MaxWorkers - firstWorker) return false;
+
+    for (uint32_t i = firstWorker; i < firstWorker + workerCount; i++)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+        for (TaskDeque& deque : worker->Deques)
+        {
+            deque.Front = 0;
+            deque.Count = 0;
+        }
+        _workers[i] = std::move(worker);
+    }
+
+    // The new deques are only used once they exist, since every worker steals from all of them
+    _workerCount.store(firstWorker + workerCount, std::memory_order_release);
+
+    for (uint32_t i = firstWorker; i < firstWorker + workerCount; i++)
+    {
+        _workers[i]->Thread = std::thread(&WorkStealingExecutor::WorkerProc, this, i);
+    }
+
+    return true;
+}
+
+void WorkStealingExecutor::Stop()
+{
+    const uint32_t workerCount = GetWorkerCount();
+    if (workerCount == 0) return;
+
+    _running = false;
+    {
+        std::lock_guard<std::mutex> lock(_idleLock);
+        _stopping = true;
+    }
+    _taskQueued.notify_all();
+
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        if (_workers[i]->Thread.joinable())
+        {
+            _workers[i]->Thread.join();
+        }
+    }
+
+    _workerCount.store(0, std::memory_order_release);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        _workers[i].reset();
+    }
+}
+
+bool WorkStealingExecutor::Submit(TaskPriority priority, ExecutorTaskProc proc, void* context, uint32_t preferredWorker)
+{
+    if (!_running || proc == nullptr) return false;
+
+    const uint32_t workerCount = GetWorkerCount();
+    const uint32_t priorityIndex = static_cast<uint32_t>(priority);
+    if (priorityIndex >= TaskPriorityCount) return false;
+
+    uint32_t workerIndex = GetCurrentWorker();
+    if (workerIndex == AnyWorker)
+    {
+        workerIndex = (preferredWorker != AnyWorker) ? preferredWorker : _nextWorker++;
+    }
+
+    // Counted before it's pushed so a worker that takes the task right away never sees the count drop below zero
+    _queuedTasks++;
+
+    // A full deque passes the task on to the next worker
+    ExecutorTask task = { proc, context };
+    bool queued = false;
+    for (uint32_t i = 0; i < workerCount && !queued; i++)
+    {
+        queued = PushTask((workerIndex + i) % workerCount, priorityIndex, task);
+    }
+    if (!queued)
+    {
+        _queuedTasks--;
+        _tasksRejected++;
+        return false;
+    }
+
+    // Idle workers check _queuedTasks under the lock after announcing themselves, so either they see the task or
+    // Submit sees them and wakes one
+    if (_idleWorkers != 0)
+    {
+        std::lock_guard<std::mutex> lock(_idleLock);
+        _taskQueued.notify_one();
+    }
+
+    return true;
+}
+
+uint32_t WorkStealingExecutor::GetDefaultWorkerCount()
+{
+    const uint32_t workerCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+    return (workerCount < MaxWorkers) ? workerCount : MaxWorkers;
+}
+
+uint32_t WorkStealingExecutor::GetCurrentWorker() const
+{
+    return (CurrentExecutor == this) ? CurrentWorker : AnyWorker;
+}
+
+ExecutorStats WorkStealingExecutor::GetStats() const
+{
+    ExecutorStats stats;
+    stats.TasksRun = _tasksRun;
+    stats.TasksStolen = _tasksStolen;
+    stats.TasksRejected = _tasksRejected;
+
+    return stats;
+}
+
+void WorkStealingExecutor::WorkerProc(uint32_t workerIndex)
+{
+    CurrentExecutor = this;
+    CurrentWorker = workerIndex;
+
+    for (;;)
+    {
+        ExecutorTask task;
+        if (TakeTask(workerIndex, task))
+        {
+            _queuedTasks--;
+            task.Proc(task.Context);
+            _tasksRun++;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_idleLock);
+
+        // Queued tasks are still run after Stop, so whoever waits for them isn't left hanging
+        _idleWorkers++;
+        _taskQueued.wait(lock, [this]() { return _queuedTasks != 0 || _stopping; });
+        _idleWorkers--;
+
+        if (_queuedTasks == 0 && _stopping) break;
+    }
+
+    CurrentExecutor = nullptr;
+    CurrentWorker = AnyWorker;
+}
+
+bool WorkStealingExecutor::TakeTask(uint32_t workerIndex, ExecutorTask& task)
+{
+    const uint32_t workerCount = GetWorkerCount();
+
+    for (uint32_t priority = 0; priority < TaskPriorityCount; priority++)
+    {
+        // The newest task of our own deque is the most likely to still be in the cache
+        {
+            Worker& worker = *_workers[workerIndex];
+            std::lock_guard<std::mutex> lock(worker.Lock);
+
+            TaskDeque& deque = worker.Deques[priority];
+            if (deque.Count != 0)
+            {
+                deque.Count--;
+                task = deque.Tasks[(deque.Front + deque.Count) % DequeCapacity];
+                return true;
+            }
+        }
+
+        // Steal the oldest task of the next worker that has one
+        for (uint32_t i = 1; i < workerCount; i++)
+        {
+            Worker& victim = *_workers[(workerIndex + i) % workerCount];
+            std::lock_guard<std::mutex> lock(victim.Lock);
+
+            TaskDeque& deque = victim.Deques[priority];
+            if (deque.Count != 0)
+            {
+                task = deque.Tasks[deque.Front];
+                deque.Front = (deque.Front + 1) % DequeCapacity;
+                deque.Count--;
+                _tasksStolen++;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool WorkStealingExecutor::PushTask(uint32_t workerIndex, uint32_t priority, const ExecutorTask& task)
+{
+    Worker& worker = *_workers[workerIndex];
+    std::lock_guard<std::mutex> lock(worker.Lock);
+
+    TaskDeque& deque = worker.Deques[priority];
+    if (deque.Count == DequeCapacity) return false;
+
+    deque.Tasks[(deque.Front + deque.Count) % DequeCapacity] = task;
+    deque.Count++;
+
+    return true;
+}
+
+} // end namespace
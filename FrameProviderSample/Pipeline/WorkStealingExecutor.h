@@ -0,0 +1,132 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace MediaFoundationProvider {
+
+// Order in which queued tasks run; a worker only runs a lower priority task once no deque holds a higher one
+enum class TaskPriority : uint32_t
+{
+    Capture = 0,        // On the path of a frame to the service, e.g. converting it
+    Normal = 1,
+    Background = 2,     // May lag behind, e.g. gathering statistics
+};
+
+static const uint32_t TaskPriorityCount = 3;
+
+typedef void (*ExecutorTaskProc)(void* context);
+
+struct ExecutorStats
+{
+    uint64_t TasksRun;
+    uint64_t TasksStolen;           // Tasks run by a worker other than the one they were queued on
+    uint64_t TasksRejected;         // Submit failed because every deque of the priority was full
+};
+
+// Runs the tasks of every provider on a single set of worker threads, at most one per processor
+//
+// Each worker owns a bounded deque per priority. A task is queued on the deque of the worker that submitted it, or of
+// the preferred worker passed by other threads, e.g. the provider's worker slot, so the frames of one device tend to
+// stay on one processor's cache. Workers take their own newest task first and steal the oldest task of another worker
+// when they run out, and a Capture task queued anywhere runs before any Normal or Background task. Tasks are a
+// function and a context pointer and the deques are preallocated, so submitting a task never allocates.
+// NOTE: Tasks should not block for long; blocking reads, e.g. IMFSourceReader::ReadSample, belong on the system
+// thread pool, which adds threads while its callbacks are blocked, and disk writes, e.g. FrameRecorder's, on a thread
+// of their own.
+class WorkStealingExecutor
+{
+public:
+
+    static const uint32_t MaxWorkers = 64;
+    static const uint32_t DequeCapacity = 256;          // Tasks per worker and priority, a power of two
+    static const uint32_t AnyWorker = 0xFFFFFFFF;
+
+    WorkStealingExecutor();
+    ~WorkStealingExecutor();
+
+    // Starts workerCount workers, or GetDefaultWorkerCount if workerCount is 0
+    bool Start(uint32_t workerCount);
+    // Starts workerCount more workers while the executor runs, e.g. as more providers submit tasks
+    // NOTE: Must not be called concurrently with Start, Stop or another AddWorkers
+    bool AddWorkers(uint32_t workerCount);
+    // Runs the tasks already queued, then joins the workers; tasks can't be submitted from then on
+    // NOTE: Other threads must have stopped submitting tasks, only the executor's own tasks may still call Submit
+    void Stop();
+    bool IsRunning() const { return _running; }
+    uint32_t GetWorkerCount() const { return _workerCount.load(std::memory_order_acquire); }
+
+    // One worker per hardware thread, up to MaxWorkers
+    static uint32_t GetDefaultWorkerCount();
+
+    // Queues the task; returns false if the executor isn't running or every deque of the priority is full, in which
+    // case the task won't run
+    bool Submit(TaskPriority priority, ExecutorTaskProc proc, void* context, uint32_t preferredWorker = AnyWorker);
+
+    // Index of the worker running the calling thread, or AnyWorker if it isn't a worker of this executor
+    uint32_t GetCurrentWorker() const;
+
+    ExecutorStats GetStats() const;
+
+private:
+
+    struct ExecutorTask
+    {
+        ExecutorTaskProc Proc;
+        void* Context;
+    };
+
+    // Tasks are pushed and popped at the back by their owner and stolen from the front
+    struct TaskDeque
+    {
+        ExecutorTask Tasks[DequeCapacity];
+        uint32_t Front;
+        uint32_t Count;
+    };
+
+    struct Worker
+    {
+        std::mutex Lock;
+        TaskDeque Deques[TaskPriorityCount];
+        std::thread Thread;
+    };
+
+    void WorkerProc(uint32_t workerIndex);
+    bool TakeTask(uint32_t workerIndex, ExecutorTask& task);
+    bool PushTask(uint32_t workerIndex, uint32_t priority, const ExecutorTask& task);
+
+    // Workers are only added while running, so the array never moves under the threads reading it
+    std::unique_ptr<Worker> _workers[MaxWorkers];
+    std::atomic<uint32_t> _workerCount;
+    std::atomic<bool> _running;
+    std::atomic<uint32_t> _nextWorker;          // Spreads tasks without a preferred worker
+    std::atomic<uint64_t> _queuedTasks;
+
+    // Idle workers wait here; Submit only takes the lock if a worker is idle
+    std::mutex _idleLock;
+    std::condition_variable _taskQueued;
+    std::atomic<uint32_t> _idleWorkers;
+    bool _stopping;
+
+    std::atomic<uint64_t> _tasksRun;
+    std::atomic<uint64_t> _tasksStolen;
+    std::atomic<uint64_t> _tasksRejected;
+};
+
+} // end namespace
@@ -120,4 +120,16 @@ bool VideoSourceDescription::IsEqual(VideoSourceDescription^ videoDescription)
         (_frameDuration.Duration == videoDescription->FrameDuration.Duration);
 }
 
+// Compares only the values stored by AsPropertySet, i.e. everything except the pixel aspect ratio, so a
+// description created from a profile's PropertySet can be matched against the provider's own descriptions
+bool VideoSourceDescription::IsSameVideoMode(VideoSourceDescription^ videoDescription)
+{
+    return  (videoDescription != nullptr) &&
+        (_bitmapPixelFormat == videoDescription->BitmapPixelFormat) &&
+        (_bitmapAlphaMode == videoDescription->BitmapAlphaMode) &&
+        (_pixelWidth == videoDescription->_pixelWidth) &&
+        (_pixelHeight == videoDescription->_pixelHeight) &&
+        (_frameDuration.Duration == videoDescription->FrameDuration.Duration);
+}
+
 } // end namespace
\ No newline at end of file
@@ -38,6 +38,7 @@ public:
 internal:
 
     bool IsEqual(VideoSourceDescription^ videoDescription);
+    bool IsSameVideoMode(VideoSourceDescription^ videoDescription);
     Windows::Foundation::Collections::IPropertySet^ AsPropertySet();
 
 private:
@@ -11,9 +11,16 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
+#include <memory>
+#include <map>
+#include <string>
+#include <cstdarg>
 #include <collection.h>
 #include <ppltasks.h>
+#include <pplawait.h>
+#include <experimental/resumable>
 
 #include <mfapi.h>
 #include <mfidl.h>
@@ -25,6 +32,8 @@
 #pragma comment(lib, "mfreadwrite.lib")
 #pragma comment(lib, "Mfuuid.lib")
 #pragma comment(lib, "runtimeobject.lib")
+#pragma comment(lib, "cfgmgr32.lib")
+#pragma comment(lib, "advapi32.lib")
 
 #include <agile.h>
 #include <Windows.Foundation.Numerics.h>
@@ -81,10 +90,41 @@ inline void ThrowIfFailed(HRESULT hr, Platform::String^ message)
     }
 }
 
+// Writes a formatted message to the debugger output, messages longer than the buffer are truncated
+inline void TraceDiagnostic(_In_z_ _Printf_format_string_ LPCWSTR format, ...)
+{
+    WCHAR message[512];
+    va_list args;
+
+    va_start(args, format);
+    _vsnwprintf_s(message, _countof(message), _TRUNCATE, format, args);
+    va_end(args);
+
+    OutputDebugStringW(message);
+}
+
 } // end namespace
 
+#include "Pipeline/FrameConversion.h"
+#include "Pipeline/FrameSource.h"
+#include "Pipeline/FrameRecording.h"
+#include "Pipeline/WorkStealingExecutor.h"
+#include "Pipeline/FrameRecorder.h"
+#include "Pipeline/FrameReplaySource.h"
+#include "Pipeline/SyntheticFrameSource.h"
+#include "Pipeline/IlluminationPhaseDetector.h"
+#include "Pipeline/FramePipeline.h"
+#include "Pipeline/ParallelFramePipeline.h"
+#include "Pipeline/ClockCorrelator.h"
+#include "Pipeline/FramePacer.h"
+#include "Pipeline/IlluminationPairer.h"
+#include "Pipeline/AutoExposureController.h"
+#include "Pipeline/LatencyHistogram.h"
+#include "Pipeline/ExposureLatencyTracker.h"
 #include "VideoSourceDescription.h"
+#include "MediaProfileCache.h"
 #include "MediaDeviceManager.h"
 #include "MediaFoundationWrapper.h"
+#include "MemoryBufferAccess.h"
 #include "FrameProvider.h"
 #include "FrameManager.h"